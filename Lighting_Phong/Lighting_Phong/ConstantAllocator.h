@@ -0,0 +1,57 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Constant Allocator DirectX12
+//======================================================================================
+
+#ifndef _CONSTANTALLOCATOR_
+#define _CONSTANTALLOCATOR_
+
+#include <windows.h>
+#include <wrl.h>
+#include <d3d12.h>
+#include "d3dx12.h"
+#include <cstring>
+
+#include "d3dUtil.h"
+#include "LinearAllocator.h"
+
+//constant blocks for one frame in a persistently mapped upload
+//buffer, each block starts on a 256 byte boundary so its address
+//can go straight to a root CBV, Reset only after the fence of
+//the frame that used the blocks has completed
+class CConstantAllocator
+{
+public:
+	CConstantAllocator() = default;
+	~CConstantAllocator();
+
+	CConstantAllocator(const CConstantAllocator& rhs) = delete;
+	CConstantAllocator& operator=(const CConstantAllocator& rhs) = delete;
+
+	void Init(ID3D12Device* Device, UINT64 Capacity);
+
+	//copies Data to a new block, returns its GPU address
+	template<typename T>
+	D3D12_GPU_VIRTUAL_ADDRESS Push(const T& Data)
+	{
+		UINT64 Offset = Allocate(sizeof(T));
+		memcpy(m_MappedData + Offset, &Data, sizeof(T));
+		return m_GpuAddress + Offset;
+	}
+
+	void Reset() { m_Allocator.Reset(); }
+
+	UINT64 Used() const { return m_Allocator.Used(); }
+	UINT64 Peak() const { return m_Allocator.Peak(); }
+
+private:
+	//throws when the frame runs out of space
+	UINT64 Allocate(UINT64 Size);
+
+	Microsoft::WRL::ComPtr<ID3D12Resource> m_Buffer;
+	BYTE* m_MappedData = nullptr;
+	D3D12_GPU_VIRTUAL_ADDRESS m_GpuAddress = 0;
+
+	CLinearAllocator m_Allocator;
+};
+
+#endif
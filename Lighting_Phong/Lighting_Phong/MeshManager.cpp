@@ -12,6 +12,14 @@ CMeshManager::~CMeshManager()
 {
 	if (m_d3dDevice != nullptr)
 		FlushCommandQueue();
+
+	Export_Frame_Stats();
+	CProfiler::Write_Trace(PROFILER_TRACE_FILE);
+}
+
+void CMeshManager::Export_Frame_Stats()
+{
+	m_Timer.Export_Frame_Stats();
 }
 
 void CMeshManager::EnableDebugLayer_CreateFactory()
@@ -29,6 +37,8 @@ void CMeshManager::EnableDebugLayer_CreateFactory()
 
 void CMeshManager::Create_Device()
 {
+	PROFILE_FUNCTION();
+
 	HRESULT hardwareResult = D3D12CreateDevice(
 		nullptr,             // default adapter
 		D3D_FEATURE_LEVEL_11_0,
@@ -49,8 +59,7 @@ void CMeshManager::Create_Device()
 
 void CMeshManager::CreateFence_GetDescriptorsSize()
 {
-	ThrowIfFailed(m_d3dDevice->CreateFence(0, D3D12_FENCE_FLAG_NONE,
-		IID_PPV_ARGS(&m_Fence)));
+	m_Fence.Init(m_d3dDevice.Get());
 
 	m_RtvDescriptorSize = m_d3dDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
 	m_DsvDescriptorSize = m_d3dDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_DSV);
@@ -97,6 +106,8 @@ void CMeshManager::Create_CommandList_Allocator_Queue()
 
 void CMeshManager::Create_SwapChain()
 {
+	PROFILE_FUNCTION();
+
 	m_SwapChain.Reset();
 
 	DXGI_SWAP_CHAIN_DESC sd;
@@ -155,6 +166,7 @@ void CMeshManager::Resize_SwapChainBuffers()
 		m_SwapChainBuffer[i].Reset();
 
 	m_DepthStencilBuffer.Reset();
+	m_GpuMemory.Free(m_DepthStencilMemory);
 
 	ThrowIfFailed(m_SwapChain->ResizeBuffers(
 		m_SwapChainBufferCount,
@@ -165,19 +177,9 @@ void CMeshManager::Resize_SwapChainBuffers()
 
 void CMeshManager::FlushCommandQueue()
 {
-	m_CurrentFence++;
+	PROFILE_FUNCTION();
 
-	ThrowIfFailed(m_CommandQueue->Signal(m_Fence.Get(), m_CurrentFence));
-
-	if (m_Fence->GetCompletedValue() < m_CurrentFence)
-	{
-		HANDLE eventHandle = CreateEventEx(nullptr, false, false, EVENT_ALL_ACCESS);
-
-		ThrowIfFailed(m_Fence->SetEventOnCompletion(m_CurrentFence, eventHandle));
-
-		WaitForSingleObject(eventHandle, INFINITE);
-		CloseHandle(eventHandle);
-	}
+	m_Fence.Flush(m_CommandQueue.Get());
 }
 
 void CMeshManager::Create_RenderTarget()
@@ -216,13 +218,8 @@ void CMeshManager::Create_DepthStencil_Buff_And_View()
 	optClear.Format = m_DepthStencilFormat;
 	optClear.DepthStencil.Depth = 1.0f;
 	optClear.DepthStencil.Stencil = 0;
-	ThrowIfFailed(m_d3dDevice->CreateCommittedResource(
-		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
-		D3D12_HEAP_FLAG_NONE,
-		&depthStencilDesc,
-		D3D12_RESOURCE_STATE_COMMON,
-		&optClear,
-		IID_PPV_ARGS(m_DepthStencilBuffer.GetAddressOf())));
+	m_DepthStencilMemory = m_GpuMemory.Create_Texture(depthStencilDesc, D3D12_RESOURCE_STATE_COMMON, &optClear);
+	m_DepthStencilBuffer = m_DepthStencilMemory.Resource;
 
 	D3D12_DEPTH_STENCIL_VIEW_DESC dsvDesc;
 	dsvDesc.Flags = D3D12_DSV_FLAG_NONE;
@@ -242,6 +239,8 @@ D3D12_CPU_DESCRIPTOR_HANDLE CMeshManager::DepthStencilView()
 
 void CMeshManager::Execute_Init_Commands()
 {
+	PROFILE_FUNCTION();
+
 	ThrowIfFailed(m_CommandList->Close());
 	ID3D12CommandList* cmdsLists[] = { m_CommandList.Get() };
 	m_CommandQueue->ExecuteCommandLists(_countof(cmdsLists), cmdsLists);
@@ -261,42 +260,22 @@ void CMeshManager::Update_ViewPort_And_Scissor()
 	m_ScissorRect = { 0, 0, m_ClientWidth, m_ClientHeight };
 }
 
-void CMeshManager::Create_CBHeap_And_View()
+void CMeshManager::Create_Frame_Resources()
 {
 	ThrowIfFailed(m_CommandList->Reset(m_DirectCmdListAlloc.Get(), nullptr));
 
-	D3D12_DESCRIPTOR_HEAP_DESC cbvHeapDesc;
-	cbvHeapDesc.NumDescriptors = 1;
-	cbvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-	cbvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-	cbvHeapDesc.NodeMask = 0;
-	ThrowIfFailed(m_d3dDevice->CreateDescriptorHeap(&cbvHeapDesc,
-		IID_PPV_ARGS(&m_CbvHeap)));
-
-	m_ObjectCB = std::make_unique<UploadBuffer<ObjectConstants>>(m_d3dDevice.Get(), 1, true);
-
-	UINT objCBByteSize = d3dUtil::CalcConstantBufferByteSize(sizeof(ObjectConstants));
-
-	D3D12_GPU_VIRTUAL_ADDRESS cbAddress = m_ObjectCB->Resource()->GetGPUVirtualAddress();
-	int boxCBufIndex = 0;
-	cbAddress += boxCBufIndex * objCBByteSize;
-
-	D3D12_CONSTANT_BUFFER_VIEW_DESC cbvDesc;
-	cbvDesc.BufferLocation = cbAddress;
-	cbvDesc.SizeInBytes = d3dUtil::CalcConstantBufferByteSize(sizeof(ObjectConstants));
-
-	m_d3dDevice->CreateConstantBufferView(
-		&cbvDesc,
-		m_CbvHeap->GetCPUDescriptorHandleForHeapStart());
+	for (int i = 0; i < FRAME_RESOURCE_COUNT; i++)
+		m_FrameResources.push_back(std::make_unique<FrameResource>(m_d3dDevice.Get()));
 }
 
 void CMeshManager::Create_Root_Signature()
 {
+	PROFILE_FUNCTION();
+
 	CD3DX12_ROOT_PARAMETER slotRootParameter[1];
 
-	CD3DX12_DESCRIPTOR_RANGE cbvTable;
-	cbvTable.Init(D3D12_DESCRIPTOR_RANGE_TYPE_CBV, 1, 0);
-	slotRootParameter[0].InitAsDescriptorTable(1, &cbvTable, D3D12_SHADER_VISIBILITY_ALL);
+	//root CBV, the address changes every frame
+	slotRootParameter[0].InitAsConstantBufferView(0);
 
 	CD3DX12_ROOT_SIGNATURE_DESC rootSigDesc(1, slotRootParameter, 0, nullptr,
 		D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
@@ -317,10 +296,15 @@ void CMeshManager::Create_Root_Signature()
 		serializedRootSig->GetBufferPointer(),
 		serializedRootSig->GetBufferSize(),
 		IID_PPV_ARGS(&m_RootSignature)));
+
+	m_PipelineCache.Add_Root_Signature(m_RootSignature.Get(),
+		serializedRootSig->GetBufferPointer(), serializedRootSig->GetBufferSize());
 }
 
 void CMeshManager::Build_Shaders_And_InputLayout()
 {
+	PROFILE_FUNCTION();
+
 	m_vsByteCode = d3dUtil::CompileShader(L"Shaders\\light_phong.hlsl", nullptr, "VS", "vs_5_0");
 	m_psByteCode = d3dUtil::CompileShader(L"Shaders\\light_phong.hlsl", nullptr, "PS", "ps_5_0");
 
@@ -331,8 +315,30 @@ void CMeshManager::Build_Shaders_And_InputLayout()
 	};
 }
 
+GpuAllocation CMeshManager::Create_Default_Buffer(const void* Data, UINT64 ByteSize, GpuAllocation& Uploader)
+{
+	//buffers promote to COPY_DEST for the copy and decay back to
+	//COMMON when the init list is done, so no barriers, small ones
+	//share a placed buffer with others and must not have any
+	GpuAllocation Buffer = m_GpuMemory.Create_Buffer(D3D12_HEAP_TYPE_DEFAULT, ByteSize, D3D12_RESOURCE_STATE_COMMON);
+	Uploader = m_GpuMemory.Create_Buffer(D3D12_HEAP_TYPE_UPLOAD, ByteSize, D3D12_RESOURCE_STATE_GENERIC_READ);
+
+	BYTE* Mapped = nullptr;
+	CD3DX12_RANGE ReadRange(0, 0);
+	ThrowIfFailed(Uploader.Resource->Map(0, &ReadRange, (void**)&Mapped));
+	memcpy(Mapped + Uploader.Offset, Data, (size_t)ByteSize);
+	Uploader.Resource->Unmap(0, nullptr);
+
+	m_CommandList->CopyBufferRegion(Buffer.Resource.Get(), Buffer.Offset,
+		Uploader.Resource.Get(), Uploader.Offset, ByteSize);
+
+	return Buffer;
+}
+
 void CMeshManager::Create_Cube_Geometry()
 {
+	PROFILE_FUNCTION();
+
 	std::array<Vertex, 24> Vertices =
 	{
 		Vertex({ DirectX::XMFLOAT3(-15.000000, -15.000000, -15.000000), DirectX::XMFLOAT3(0.000000, -1.000000, 0.000000) }),
@@ -382,11 +388,9 @@ void CMeshManager::Create_Cube_Geometry()
 	m_Cube = std::make_unique<MeshGeometry>();
 	m_Cube->Name = "Cube";
 
-	m_Cube->VertexBufferGPU = d3dUtil::CreateDefaultBuffer(m_d3dDevice.Get(),
-		m_CommandList.Get(), Vertices.data(), VbByteSize, m_Cube->VertexBufferUploader);
+	m_Cube->VertexBufferGPU = Create_Default_Buffer(Vertices.data(), VbByteSize, m_Cube->VertexBufferUploader);
 
-	m_Cube->IndexBufferGPU = d3dUtil::CreateDefaultBuffer(m_d3dDevice.Get(),
-		m_CommandList.Get(), Indices.data(), IbByteSize, m_Cube->IndexBufferUploader);
+	m_Cube->IndexBufferGPU = Create_Default_Buffer(Indices.data(), IbByteSize, m_Cube->IndexBufferUploader);
 
 	m_Cube->VertexByteStride = sizeof(Vertex);
 	m_Cube->VertexBufferByteSize = VbByteSize;
@@ -403,6 +407,8 @@ void CMeshManager::Create_Cube_Geometry()
 
 void CMeshManager::Create_PipelineStateObject()
 {
+	PROFILE_FUNCTION();
+
 
 	D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc;
 	ZeroMemory(&psoDesc, sizeof(D3D12_GRAPHICS_PIPELINE_STATE_DESC));
@@ -428,7 +434,7 @@ void CMeshManager::Create_PipelineStateObject()
 	psoDesc.SampleDesc.Count = m_4xMsaaState ? 4 : 1;
 	psoDesc.SampleDesc.Quality = m_4xMsaaState ? (m_4xMsaaQuality - 1) : 0;
 	psoDesc.DSVFormat = m_DepthStencilFormat;
-	ThrowIfFailed(m_d3dDevice->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&m_PSO)));
+	m_PSO = m_PipelineCache.Create_Graphics(psoDesc);
 }
 
 D3D12_CPU_DESCRIPTOR_HANDLE CMeshManager::CurrentBackBufferView()
@@ -447,12 +453,24 @@ ID3D12Resource* CMeshManager::CurrentBackBuffer()
 
 void CMeshManager::Init_MeshManager(HWND hWnd)
 {
+	PROFILE_THREAD_NAME("Main");
+	PROFILE_FUNCTION();
+
 	m_hWnd = hWnd;
 
 	EnableDebugLayer_CreateFactory();
 
 	Create_Device();
 
+	//the adapter of the device, for the pipeline cache id
+	//and the memory budget
+	Microsoft::WRL::ComPtr<IDXGIAdapter> Adapter;
+	m_dxgiFactory->EnumAdapterByLuid(m_d3dDevice->GetAdapterLuid(), IID_PPV_ARGS(&Adapter));
+
+	m_PipelineCache.Init(m_d3dDevice.Get(), Adapter.Get(), PIPELINE_CACHE_FILE);
+
+	m_GpuMemory.Init(m_d3dDevice.Get(), Adapter.Get());
+
 	CreateFence_GetDescriptorsSize();
 
 	Check_Multisample_Quality();
@@ -473,7 +491,7 @@ void CMeshManager::Init_MeshManager(HWND hWnd)
 
 	Update_ViewPort_And_Scissor();
 
-	Create_CBHeap_And_View();
+	Create_Frame_Resources();
 
 	Create_Root_Signature();
 
@@ -483,8 +501,17 @@ void CMeshManager::Init_MeshManager(HWND hWnd)
 
 	Create_PipelineStateObject();
 
+	//the next run loads what was compiled here
+	m_PipelineCache.Save();
+	m_PipelineCache.Log_Stats();
+
 	Execute_Init_Commands();
 
+	//the copies are done, their upload heap buffers can go
+	m_Cube->DisposeUploaders(m_GpuMemory);
+
+	m_GpuMemory.Log_Stats();
+
 	DirectX::XMVECTOR Pos = DirectX::XMVectorSet(0, 0.0f, -80.0f, 1.0f);
 	DirectX::XMVECTOR Target = DirectX::XMVectorZero();
 	DirectX::XMVECTOR Up = DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
@@ -495,11 +522,20 @@ void CMeshManager::Init_MeshManager(HWND hWnd)
 	DirectX::XMMATRIX MatProj = DirectX::XMMatrixPerspectiveFovLH(0.25f * DirectX::XM_PI, 4.0f / 3.0f, 1.0f, 1000.0f);
 	XMStoreFloat4x4(&m_Proj, MatProj);
 
+#ifdef FRAME_TIME_COMPARE
+	//the 30 fps cap would hide the difference
+	m_Timer.TimerStart(0);
+#else
 	m_Timer.TimerStart(30);
+#endif
 }
 
 void CMeshManager::Update_MeshManager()
 {
+	PROFILE_FUNCTION();
+
+	Next_Frame_Resource();
+
 	m_Timer.CalculateFPS();
 	float ElapsedTime = m_Timer.GetElaspedTime();
 
@@ -534,14 +570,17 @@ void CMeshManager::Update_MeshManager()
 	DirectX::XMStoreFloat4x4(&ObjConstants.WorldView, DirectX::XMMatrixTranspose(MatWorldView));
 
 	//        
-	m_ObjectCB->CopyData(0, ObjConstants);
+	m_ObjectCBAddress = m_CurrFrameResource->Constants.Push(ObjConstants);
 }
 
 void CMeshManager::Draw_MeshManager()
 {
-	ThrowIfFailed(m_DirectCmdListAlloc->Reset());
+	PROFILE_FUNCTION();
 
-	ThrowIfFailed(m_CommandList->Reset(m_DirectCmdListAlloc.Get(), m_PSO.Get()));
+	//the GPU is done with this allocator, Next_Frame_Resource waited for it
+	ThrowIfFailed(m_CurrFrameResource->CmdListAlloc->Reset());
+
+	ThrowIfFailed(m_CommandList->Reset(m_CurrFrameResource->CmdListAlloc.Get(), m_PSO.Get()));
 
 	m_CommandList->RSSetViewports(1, &m_ScreenViewport);
 	m_CommandList->RSSetScissorRects(1, &m_ScissorRect);
@@ -557,10 +596,7 @@ void CMeshManager::Draw_MeshManager()
 
 	m_CommandList->SetGraphicsRootSignature(m_RootSignature.Get());
 
-	ID3D12DescriptorHeap* descriptorHeaps[] = { m_CbvHeap.Get() };
-	m_CommandList->SetDescriptorHeaps(_countof(descriptorHeaps), descriptorHeaps);
-
-	m_CommandList->SetGraphicsRootDescriptorTable(0, m_CbvHeap->GetGPUDescriptorHandleForHeapStart());
+	m_CommandList->SetGraphicsRootConstantBufferView(0, m_ObjectCBAddress);
 
 	m_CommandList->IASetVertexBuffers(0, 1, &m_Cube->VertexBufferView());
 	m_CommandList->IASetIndexBuffer(&m_Cube->IndexBufferView());
@@ -582,7 +618,60 @@ void CMeshManager::Draw_MeshManager()
 
 	m_CurrBackBuffer = (m_CurrBackBuffer + 1) % m_SwapChainBufferCount;
 
-	FlushCommandQueue();
+	//no wait here, the frame resource is reused once the GPU gets to this fence
+	m_CurrFrameResource->Fence = m_Fence.Signal(m_CommandQueue.Get());
+
+#ifdef FRAME_TIME_COMPARE
+	Compare_Frame_Time();
+#endif
+}
+
+void CMeshManager::Next_Frame_Resource()
+{
+	PROFILE_FUNCTION();
+
+	m_CurrFrameResourceIndex = (m_CurrFrameResourceIndex + 1) % FRAME_RESOURCE_COUNT;
+	m_CurrFrameResource = m_FrameResources[m_CurrFrameResourceIndex].get();
+
+	//blocks only if the CPU is FRAME_RESOURCE_COUNT frames ahead of the GPU
+	m_Fence.Wait(m_CurrFrameResource->Fence);
+
+	//the GPU has read every block of that frame
+	m_CurrFrameResource->Constants.Reset();
+}
+
+void CMeshManager::Compare_Frame_Time()
+{
+	//the old way, CPU waits for the GPU to go idle every frame
+	if (m_CompareFlush)
+		FlushCommandQueue();
+
+	auto Now = std::chrono::steady_clock::now();
+
+	if (m_CompareFrames++ > 0)
+	{
+		std::chrono::duration<double, std::milli> FrameTime = Now - m_CompareLast;
+		m_CompareFrameTime += FrameTime.count();
+	}
+
+	m_CompareLast = Now;
+
+	if (m_CompareFrames == FRAME_COMPARE_FRAMES)
+	{
+		char Msg[128];
+		if (m_CompareFlush)
+			sprintf_s(Msg, "Frames: flush per frame, %.3f ms per frame, %.3f ms waiting for the GPU\n",
+				m_CompareFrameTime / (FRAME_COMPARE_FRAMES - 1), m_Fence.Blocked_Time() / FRAME_COMPARE_FRAMES);
+		else
+			sprintf_s(Msg, "Frames: %d in flight, %.3f ms per frame, %.3f ms waiting for the GPU\n",
+				FRAME_RESOURCE_COUNT, m_CompareFrameTime / (FRAME_COMPARE_FRAMES - 1), m_Fence.Blocked_Time() / FRAME_COMPARE_FRAMES);
+		OutputDebugStringA(Msg);
+
+		m_CompareFlush = !m_CompareFlush;
+		m_CompareFrames = 0;
+		m_CompareFrameTime = 0.0;
+		m_Fence.Reset_Stats();
+	}
 }
 
 
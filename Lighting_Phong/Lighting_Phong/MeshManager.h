@@ -22,67 +22,33 @@
 #include <array>
 #include <unordered_map>
 #include <DirectXCollision.h>
+#include <chrono>
 
 #include <directxmath.h>
 
 #include "d3dUtil.h"
+#include "ConstantAllocator.h"
+#include "GpuFence.h"
+#include "GpuMemory.h"
+#include "Profiler.h"
+#include "PipelineCache.h"
 
 #include "Timer.h"
 
-#pragma comment(lib,"d3dcompiler.lib")
-#pragma comment(lib, "D3D12.lib")
-#pragma comment(lib, "dxgi.lib")
-
-template<typename T>
-class UploadBuffer
-{
-public:
-	UploadBuffer(ID3D12Device* device, UINT elementCount, bool isConstantBuffer) :
-		mIsConstantBuffer(isConstantBuffer)
-	{
-		mElementByteSize = sizeof(T);
-
-		if (isConstantBuffer)
-			mElementByteSize = d3dUtil::CalcConstantBufferByteSize(sizeof(T));
-
-		ThrowIfFailed(device->CreateCommittedResource(
-			&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
-			D3D12_HEAP_FLAG_NONE,
-			&CD3DX12_RESOURCE_DESC::Buffer(mElementByteSize * elementCount),
-			D3D12_RESOURCE_STATE_GENERIC_READ,
-			nullptr,
-			IID_PPV_ARGS(&mUploadBuffer)));
-
-		ThrowIfFailed(mUploadBuffer->Map(0, nullptr, reinterpret_cast<void**>(&mMappedData)));
-	}
-
-	UploadBuffer(const UploadBuffer& rhs) = delete;
-	UploadBuffer& operator=(const UploadBuffer& rhs) = delete;
-	~UploadBuffer()
-	{
-		if (mUploadBuffer != nullptr)
-			mUploadBuffer->Unmap(0, nullptr);
-
-		mMappedData = nullptr;
-	}
+//frames the CPU may record ahead of the GPU, 2 or 3
+#define FRAME_RESOURCE_COUNT 3
 
-	ID3D12Resource* Resource()const
-	{
-		return mUploadBuffer.Get();
-	}
+//constant blocks one frame can allocate, in bytes
+#define FRAME_CONSTANT_SIZE (64 * 1024)
 
-	void CopyData(int elementIndex, const T& data)
-	{
-		memcpy(&mMappedData[elementIndex * mElementByteSize], &data, sizeof(T));
-	}
+//switches between a flush per frame and frames in flight every
+//FRAME_COMPARE_FRAMES frames and logs the frame time of each
+//#define FRAME_TIME_COMPARE
+#define FRAME_COMPARE_FRAMES 256
 
-private:
-	Microsoft::WRL::ComPtr<ID3D12Resource> mUploadBuffer;
-	BYTE* mMappedData = nullptr;
-
-	UINT mElementByteSize = 0;
-	bool mIsConstantBuffer = false;
-};
+#pragma comment(lib,"d3dcompiler.lib")
+#pragma comment(lib, "D3D12.lib")
+#pragma comment(lib, "dxgi.lib")
 
 static DirectX::XMFLOAT4X4 Identity4x4()
 {
@@ -120,11 +86,11 @@ struct MeshGeometry
 {
 	std::string Name;
 
-	Microsoft::WRL::ComPtr<ID3D12Resource> VertexBufferGPU = nullptr;
-	Microsoft::WRL::ComPtr<ID3D12Resource> IndexBufferGPU = nullptr;
+	GpuAllocation VertexBufferGPU;
+	GpuAllocation IndexBufferGPU;
 
-	Microsoft::WRL::ComPtr<ID3D12Resource> VertexBufferUploader = nullptr;
-	Microsoft::WRL::ComPtr<ID3D12Resource> IndexBufferUploader = nullptr;
+	GpuAllocation VertexBufferUploader;
+	GpuAllocation IndexBufferUploader;
 
 	UINT VertexByteStride = 0;
 	UINT VertexBufferByteSize = 0;
@@ -136,7 +102,7 @@ struct MeshGeometry
 	D3D12_VERTEX_BUFFER_VIEW VertexBufferView()const
 	{
 		D3D12_VERTEX_BUFFER_VIEW vbv;
-		vbv.BufferLocation = VertexBufferGPU->GetGPUVirtualAddress();
+		vbv.BufferLocation = VertexBufferGPU.GpuAddress;
 		vbv.StrideInBytes = VertexByteStride;
 		vbv.SizeInBytes = VertexBufferByteSize;
 
@@ -146,20 +112,42 @@ struct MeshGeometry
 	D3D12_INDEX_BUFFER_VIEW IndexBufferView()const
 	{
 		D3D12_INDEX_BUFFER_VIEW ibv;
-		ibv.BufferLocation = IndexBufferGPU->GetGPUVirtualAddress();
+		ibv.BufferLocation = IndexBufferGPU.GpuAddress;
 		ibv.Format = IndexFormat;
 		ibv.SizeInBytes = IndexBufferByteSize;
 
 		return ibv;
 	}
 
-	void DisposeUploaders()
+	void DisposeUploaders(CGpuMemory& Memory)
 	{
-		VertexBufferUploader = nullptr;
-		IndexBufferUploader = nullptr;
+		Memory.Free(VertexBufferUploader);
+		Memory.Free(IndexBufferUploader);
 	}
 };
 
+//what one frame in flight owns, reused when
+//the GPU has passed Fence
+struct FrameResource
+{
+	FrameResource(ID3D12Device* device)
+	{
+		ThrowIfFailed(device->CreateCommandAllocator(
+			D3D12_COMMAND_LIST_TYPE_DIRECT,
+			IID_PPV_ARGS(CmdListAlloc.GetAddressOf())));
+
+		Constants.Init(device, FRAME_CONSTANT_SIZE);
+	}
+
+	FrameResource(const FrameResource& rhs) = delete;
+	FrameResource& operator=(const FrameResource& rhs) = delete;
+
+	Microsoft::WRL::ComPtr<ID3D12CommandAllocator> CmdListAlloc;
+	CConstantAllocator Constants;
+
+	UINT64 Fence = 0;
+};
+
 class CMeshManager
 {
 public:
@@ -170,6 +158,9 @@ public:
 	void Update_MeshManager();
 	void Draw_MeshManager();
 
+	//frame time percentiles to the debug output and files
+	void Export_Frame_Stats();
+
 private:
 	void EnableDebugLayer_CreateFactory();
 	void Create_Device();
@@ -180,15 +171,19 @@ private:
 	void Create_RtvAndDsv_DescriptorHeaps();
 	void Resize_SwapChainBuffers();
 	void FlushCommandQueue();
+	void Next_Frame_Resource();
+	void Compare_Frame_Time();
 	void Create_RenderTarget();
 	void Create_DepthStencil_Buff_And_View();
 	D3D12_CPU_DESCRIPTOR_HANDLE DepthStencilView();
 	void Execute_Init_Commands();
 	void Update_ViewPort_And_Scissor();
-	void Create_CBHeap_And_View();
+	void Create_Frame_Resources();
 	void Create_Root_Signature();
 	void Build_Shaders_And_InputLayout();
 	void Create_Cube_Geometry();
+	//buffer and its upload buffer, the copy is recorded on m_CommandList
+	GpuAllocation Create_Default_Buffer(const void* Data, UINT64 ByteSize, GpuAllocation& Uploader);
 	void Create_PipelineStateObject();
 	D3D12_CPU_DESCRIPTOR_HANDLE CurrentBackBufferView();
 	ID3D12Resource* CurrentBackBuffer();
@@ -197,7 +192,13 @@ private:
 
 	Microsoft::WRL::ComPtr<IDXGIFactory4> m_dxgiFactory;
 	Microsoft::WRL::ComPtr<ID3D12Device> m_d3dDevice;
-	Microsoft::WRL::ComPtr<ID3D12Fence> m_Fence;
+	CGpuFence m_Fence;
+
+	//pipeline states of the last run, goes before the states it makes
+	CPipelineCache m_PipelineCache;
+
+	//heaps of the placed resources, goes after everything placed in it
+	CGpuMemory m_GpuMemory;
 
 	UINT m_RtvDescriptorSize = 0;
 	UINT m_DsvDescriptorSize = 0;
@@ -226,8 +227,8 @@ private:
 
 	Microsoft::WRL::ComPtr<ID3D12Resource> m_SwapChainBuffer[m_SwapChainBufferCount];
 	Microsoft::WRL::ComPtr<ID3D12Resource> m_DepthStencilBuffer;
+	GpuAllocation m_DepthStencilMemory;
 		
-	UINT64 m_CurrentFence = 0;
 	int m_CurrBackBuffer = 0;
 
 	DXGI_FORMAT m_DepthStencilFormat = DXGI_FORMAT_D24_UNORM_S8_UINT;
@@ -235,8 +236,17 @@ private:
 	D3D12_VIEWPORT m_ScreenViewport;
 	D3D12_RECT m_ScissorRect;
 
-	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> m_CbvHeap = nullptr;
-	std::unique_ptr<UploadBuffer<ObjectConstants>> m_ObjectCB = nullptr;
+	std::vector<std::unique_ptr<FrameResource>> m_FrameResources;
+	FrameResource* m_CurrFrameResource = nullptr;
+	int m_CurrFrameResourceIndex = 0;
+
+	//object constants of the current frame
+	D3D12_GPU_VIRTUAL_ADDRESS m_ObjectCBAddress = 0;
+
+	bool m_CompareFlush = false;
+	UINT m_CompareFrames = 0;
+	double m_CompareFrameTime = 0.0;
+	std::chrono::steady_clock::time_point m_CompareLast;
 
 	Microsoft::WRL::ComPtr<ID3D12RootSignature> m_RootSignature = nullptr;
 
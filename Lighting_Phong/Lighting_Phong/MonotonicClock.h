@@ -0,0 +1,33 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Monotonic Clock
+//======================================================================================
+
+#ifndef _MONOTONICCLOCK_
+#define _MONOTONICCLOCK_
+
+#include <cstdint>
+
+//integer tick source for CTimer, QueryPerformanceCounter on
+//Windows and CLOCK_MONOTONIC_RAW elsewhere, a derived clock
+//can feed simulated time
+class CMonotonicClock
+{
+public:
+	virtual ~CMonotonicClock() = default;
+
+	virtual int64_t Ticks() const;
+	//ticks per second
+	virtual int64_t Frequency() const;
+
+	static const CMonotonicClock& System();
+
+	//splits whole seconds off first, so the result keeps
+	//full precision however many ticks have passed
+	static double To_Seconds(int64_t Ticks, int64_t Frequency);
+
+	//whole microseconds, rounded down, without the overflow
+	//of Ticks * 1000000
+	static int64_t To_Microseconds(int64_t Ticks, int64_t Frequency);
+};
+
+#endif
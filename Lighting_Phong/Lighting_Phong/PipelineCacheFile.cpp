@@ -0,0 +1,132 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Pipeline Cache File
+//======================================================================================
+
+#include "PipelineCacheFile.h"
+#include "AssetCache.h"
+
+#include <cstdio>
+#include <string>
+
+static FILE* Open_File(const char* FileName, const char* Mode)
+{
+	FILE* Fp = NULL;
+#ifdef _WIN32
+	fopen_s(&Fp, FileName, Mode);
+#else
+	Fp = fopen(FileName, Mode);
+#endif
+	return Fp;
+}
+
+bool SamePipelineCacheId(const PipelineCacheId& a, const PipelineCacheId& b)
+{
+	return a.VendorId == b.VendorId && a.DeviceId == b.DeviceId &&
+		a.SubSysId == b.SubSysId && a.Revision == b.Revision &&
+		a.DriverVersion == b.DriverVersion;
+}
+
+//sizes are checked against the file size first, a corrupt
+//header must not make a huge allocation
+static bool Read_Entries(FILE* Fp, uint64_t FileSize, const PipelineCacheHeader& Header,
+	std::vector<uint8_t>& Library, PipelineCacheEntries& Entries)
+{
+	if (Header.LibrarySize > FileSize || Header.EntryCount > FileSize / sizeof(PipelineCacheRecord))
+		return false;
+
+	Library.resize((size_t)Header.LibrarySize);
+
+	if (Header.LibrarySize != 0 && fread(Library.data(), 1, Library.size(), Fp) != Library.size())
+		return false;
+
+	for (uint32_t i = 0; i < Header.EntryCount; i++)
+	{
+		PipelineCacheRecord Record;
+		if (fread(&Record, sizeof(Record), 1, Fp) != 1)
+			return false;
+
+		if (Record.BlobSize > FileSize)
+			return false;
+
+		PipelineCacheEntry& Entry = Entries[Record.Key];
+		Entry.CompileTime = Record.CompileTime;
+		Entry.Blob.resize((size_t)Record.BlobSize);
+
+		if (Record.BlobSize != 0 && fread(Entry.Blob.data(), 1, Entry.Blob.size(), Fp) != Entry.Blob.size())
+			return false;
+	}
+
+	return true;
+}
+
+bool ReadPipelineCache(const char* FileName, const PipelineCacheId& Id,
+	std::vector<uint8_t>& Library, PipelineCacheEntries& Entries)
+{
+	Library.clear();
+	Entries.clear();
+
+	FILE* Fp = Open_File(FileName, "rb");
+	if (!Fp)
+		return false;
+
+	fseek(Fp, 0, SEEK_END);
+	uint64_t FileSize = (uint64_t)ftell(Fp);
+	fseek(Fp, 0, SEEK_SET);
+
+	PipelineCacheHeader Header;
+
+	bool Result = fread(&Header, sizeof(Header), 1, Fp) == 1 &&
+		Header.Magic == PIPELINECACHE_MAGIC &&
+		Header.Version == PIPELINECACHE_VERSION &&
+		SamePipelineCacheId(Header.Id, Id) &&
+		Read_Entries(Fp, FileSize, Header, Library, Entries);
+
+	fclose(Fp);
+
+	if (!Result)
+	{
+		Library.clear();
+		Entries.clear();
+	}
+
+	return Result;
+}
+
+bool WritePipelineCache(const char* FileName, const PipelineCacheId& Id,
+	const void* Library, size_t LibrarySize, const PipelineCacheEntries& Entries)
+{
+	std::string TempFileName = std::string(FileName) + ".tmp";
+
+	FILE* Fp = Open_File(TempFileName.c_str(), "wb");
+	if (!Fp)
+		return false;
+
+	PipelineCacheHeader Header;
+	Header.Id = Id;
+	Header.LibrarySize = LibrarySize;
+	Header.EntryCount = (uint32_t)Entries.size();
+
+	bool Result = fwrite(&Header, sizeof(Header), 1, Fp) == 1 &&
+		(LibrarySize == 0 || fwrite(Library, 1, LibrarySize, Fp) == LibrarySize);
+
+	for (auto It = Entries.begin(); Result && It != Entries.end(); ++It)
+	{
+		PipelineCacheRecord Record;
+		Record.Key = It->first;
+		Record.CompileTime = It->second.CompileTime;
+		Record.BlobSize = It->second.Blob.size();
+
+		Result = fwrite(&Record, sizeof(Record), 1, Fp) == 1 &&
+			(Record.BlobSize == 0 || fwrite(It->second.Blob.data(), 1, It->second.Blob.size(), Fp) == It->second.Blob.size());
+	}
+
+	Result = fclose(Fp) == 0 && Result;
+
+	if (!Result)
+	{
+		remove(TempFileName.c_str());
+		return false;
+	}
+
+	return CommitCacheFile(TempFileName.c_str(), FileName);
+}
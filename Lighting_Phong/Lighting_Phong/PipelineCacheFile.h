@@ -0,0 +1,72 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Pipeline Cache File
+//======================================================================================
+
+#ifndef _PIPELINECACHEFILE_
+#define _PIPELINECACHEFILE_
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <unordered_map>
+
+//pipeline cache container
+//
+//	PipelineCacheHeader
+//	pipeline library bytes (LibrarySize, may be 0)
+//	EntryCount times: PipelineCacheRecord, blob bytes (BlobSize)
+
+#define PIPELINECACHE_MAGIC 0x434F5350	//'PSOC'
+#define PIPELINECACHE_VERSION 1
+
+//what the pipelines were compiled for, another adapter or
+//driver makes the whole file stale
+struct PipelineCacheId
+{
+	uint32_t VendorId = 0;
+	uint32_t DeviceId = 0;
+	uint32_t SubSysId = 0;
+	uint32_t Revision = 0;
+	uint64_t DriverVersion = 0;
+};
+
+struct PipelineCacheHeader
+{
+	uint32_t Magic = PIPELINECACHE_MAGIC;
+	uint32_t Version = PIPELINECACHE_VERSION;
+	PipelineCacheId Id;
+	uint64_t LibrarySize = 0;
+	uint32_t EntryCount = 0;
+	uint32_t Reserved = 0;
+};
+
+struct PipelineCacheRecord
+{
+	uint64_t Key = 0;
+	//ms the driver took to compile it the first time
+	double CompileTime = 0.0;
+	uint64_t BlobSize = 0;
+};
+
+//one pipeline, Blob is its CachedPSO, empty when the
+//pipeline library holds it
+struct PipelineCacheEntry
+{
+	double CompileTime = 0.0;
+	std::vector<uint8_t> Blob;
+};
+
+typedef std::unordered_map<uint64_t, PipelineCacheEntry> PipelineCacheEntries;
+
+bool SamePipelineCacheId(const PipelineCacheId& a, const PipelineCacheId& b);
+
+//false if the file is missing, truncated or made for another
+//Id, Library and Entries are left empty then
+bool ReadPipelineCache(const char* FileName, const PipelineCacheId& Id,
+	std::vector<uint8_t>& Library, PipelineCacheEntries& Entries);
+
+//writes a temp file and moves it over FileName
+bool WritePipelineCache(const char* FileName, const PipelineCacheId& Id,
+	const void* Library, size_t LibrarySize, const PipelineCacheEntries& Entries);
+
+#endif
@@ -0,0 +1,32 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Asset Cache
+//======================================================================================
+
+#ifndef _ASSETCACHE_
+#define _ASSETCACHE_
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+//cooked files live here, next to the sources
+#define ASSET_CACHE_DIR "Cache"
+
+//xxHash64 of the bytes
+uint64_t HashBytes(const void* Data, size_t Size, uint64_t Seed = 0);
+
+//key of a cooked asset, Options are the cook settings
+//and the cooker version as plain bytes without padding
+uint64_t AssetCacheKey(const void* Source, size_t SourceSize, const void* Options, size_t OptionsSize);
+
+//Dir/Name-<Key in hex>.Ext
+std::string AssetCachePath(const char* Dir, const char* Name, uint64_t Key, const char* Ext);
+
+//makes Dir if it does not exist
+bool CreateAssetCacheDir(const char* Dir);
+
+//moves fully written TempFileName over FileName, so a process
+//killed while cooking never leaves a truncated entry behind
+bool CommitCacheFile(const char* TempFileName, const char* FileName);
+
+#endif
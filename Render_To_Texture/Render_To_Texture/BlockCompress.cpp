@@ -0,0 +1,871 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Block Compress
+//======================================================================================
+
+#include "BlockCompress.h"
+#include "Profiler.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+//block rows per tile, a tile is one ParallelFor item
+#define BLOCK_TILE_ROWS 8
+
+//least squares passes of BLOCK_QUALITY_HIGH
+#define BLOCK_REFINE_PASSES 2
+
+//part of the color range the endpoints are pulled in by,
+//less for BC7 as it has more colors between the endpoints
+#define BC1_INSET (1.0f / 16.0f)
+#define BC7_INSET (1.0f / 64.0f)
+
+static const int BC7_Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+uint32_t BlockBytes(BlockFormat Format)
+{
+	return Format == BLOCK_BC1 ? 8 : 16;
+}
+
+static int Clamp_Int(int v, int Min, int Max)
+{
+	return v < Min ? Min : (v > Max ? Max : v);
+}
+
+static float Clamp_Float(float v, float Min, float Max)
+{
+	return v < Min ? Min : (v > Max ? Max : v);
+}
+
+//mean and main direction of the block colors, Axis is
+//zero when all pixels are the same
+static void Principal_Axis(const float Px[16][4], int Dims, float* Mean, float* Axis)
+{
+	for (int c = 0; c < Dims; c++)
+	{
+		Mean[c] = 0.0f;
+		for (int i = 0; i < 16; i++)
+			Mean[c] += Px[i][c];
+		Mean[c] /= 16.0f;
+	}
+
+	float Cov[4][4] = {};
+
+	for (int i = 0; i < 16; i++)
+	{
+		float d[4];
+		for (int c = 0; c < Dims; c++)
+			d[c] = Px[i][c] - Mean[c];
+
+		for (int r = 0; r < Dims; r++)
+			for (int c = 0; c < Dims; c++)
+				Cov[r][c] += d[r] * d[c];
+	}
+
+	//power iteration from the row with the biggest variance
+	int Row = 0;
+	for (int c = 1; c < Dims; c++)
+		if (Cov[c][c] > Cov[Row][Row])
+			Row = c;
+
+	float v[4];
+	for (int c = 0; c < Dims; c++)
+		v[c] = Cov[Row][c];
+
+	for (int Iter = 0; Iter < 8; Iter++)
+	{
+		float n[4] = {};
+		for (int r = 0; r < Dims; r++)
+			for (int c = 0; c < Dims; c++)
+				n[r] += Cov[r][c] * v[c];
+
+		float Max = 0.0f;
+		for (int c = 0; c < Dims; c++)
+			Max = fabsf(n[c]) > Max ? fabsf(n[c]) : Max;
+
+		if (Max < 1e-6f)
+		{
+			for (int c = 0; c < Dims; c++)
+				Axis[c] = 0.0f;
+			return;
+		}
+
+		for (int c = 0; c < Dims; c++)
+			v[c] = n[c] / Max;
+	}
+
+	float Len = 0.0f;
+	for (int c = 0; c < Dims; c++)
+		Len += v[c] * v[c];
+	Len = sqrtf(Len);
+
+	for (int c = 0; c < Dims; c++)
+		Axis[c] = v[c] / Len;
+}
+
+//end points of the block colors along the principal axis or with
+//Bounds per channel min / max, both pulled in by Inset of the range
+static void Block_Endpoints(const float Px[16][4], int Dims, bool Bounds, float Inset, float* E0, float* E1)
+{
+	if (Bounds)
+	{
+		for (int c = 0; c < Dims; c++)
+		{
+			float Min = Px[0][c], Max = Px[0][c];
+			for (int i = 1; i < 16; i++)
+			{
+				Min = Px[i][c] < Min ? Px[i][c] : Min;
+				Max = Px[i][c] > Max ? Px[i][c] : Max;
+			}
+
+			E0[c] = Max - (Max - Min) * Inset;
+			E1[c] = Min + (Max - Min) * Inset;
+		}
+		return;
+	}
+
+	float Mean[4], Axis[4];
+	Principal_Axis(Px, Dims, Mean, Axis);
+
+	float TMin = 0.0f, TMax = 0.0f;
+	for (int i = 0; i < 16; i++)
+	{
+		float t = 0.0f;
+		for (int c = 0; c < Dims; c++)
+			t += (Px[i][c] - Mean[c]) * Axis[c];
+
+		TMin = t < TMin ? t : TMin;
+		TMax = t > TMax ? t : TMax;
+	}
+
+	float Range = TMax - TMin;
+	TMin += Range * Inset;
+	TMax -= Range * Inset;
+
+	for (int c = 0; c < Dims; c++)
+	{
+		E0[c] = Clamp_Float(Mean[c] + TMax * Axis[c], 0.0f, 255.0f);
+		E1[c] = Clamp_Float(Mean[c] + TMin * Axis[c], 0.0f, 255.0f);
+	}
+}
+
+//endpoints that best fit the pixels for the given weights of E0,
+//returns false when all pixels use the same weight
+static bool Least_Squares(const float Px[16][4], int Dims, const float* Weight0, float* E0, float* E1)
+{
+	float AA = 0.0f, AB = 0.0f, BB = 0.0f;
+	float AX[4] = {}, BX[4] = {};
+
+	for (int i = 0; i < 16; i++)
+	{
+		float a = Weight0[i];
+		float b = 1.0f - a;
+
+		AA += a * a;
+		AB += a * b;
+		BB += b * b;
+
+		for (int c = 0; c < Dims; c++)
+		{
+			AX[c] += a * Px[i][c];
+			BX[c] += b * Px[i][c];
+		}
+	}
+
+	float Det = AA * BB - AB * AB;
+	if (fabsf(Det) < 1e-6f)
+		return false;
+
+	for (int c = 0; c < Dims; c++)
+	{
+		E0[c] = Clamp_Float((AX[c] * BB - BX[c] * AB) / Det, 0.0f, 255.0f);
+		E1[c] = Clamp_Float((BX[c] * AA - AX[c] * AB) / Det, 0.0f, 255.0f);
+	}
+
+	return true;
+}
+
+static void Load_Block(const unsigned char* Rgba, float Px[16][4])
+{
+	for (int i = 0; i < 16; i++)
+		for (int c = 0; c < 4; c++)
+			Px[i][c] = Rgba[i * 4 + c];
+}
+
+//
+//BC1 color block
+//
+
+static uint16_t Pack_565(const float* Color)
+{
+	int r = Clamp_Int((int)(Color[0] * 31.0f / 255.0f + 0.5f), 0, 31);
+	int g = Clamp_Int((int)(Color[1] * 63.0f / 255.0f + 0.5f), 0, 63);
+	int b = Clamp_Int((int)(Color[2] * 31.0f / 255.0f + 0.5f), 0, 31);
+
+	return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+static void Unpack_565(uint16_t c, int* Color)
+{
+	int r = (c >> 11) & 31;
+	int g = (c >> 5) & 63;
+	int b = c & 31;
+
+	Color[0] = (r << 3) | (r >> 2);
+	Color[1] = (g << 2) | (g >> 4);
+	Color[2] = (b << 3) | (b >> 2);
+}
+
+//4 color palette, 3 color mode is not used by the encoder
+static void BC1_Palette(uint16_t c0, uint16_t c1, bool FourColors, int Palette[4][4])
+{
+	Unpack_565(c0, Palette[0]);
+	Unpack_565(c1, Palette[1]);
+
+	for (int c = 0; c < 3; c++)
+	{
+		if (FourColors)
+		{
+			Palette[2][c] = (2 * Palette[0][c] + Palette[1][c] + 1) / 3;
+			Palette[3][c] = (Palette[0][c] + 2 * Palette[1][c] + 1) / 3;
+		}
+		else
+		{
+			Palette[2][c] = (Palette[0][c] + Palette[1][c] + 1) / 2;
+			Palette[3][c] = 0;
+		}
+	}
+
+	Palette[0][3] = Palette[1][3] = Palette[2][3] = 255;
+	Palette[3][3] = FourColors ? 255 : 0;
+}
+
+//nearest palette entry for each pixel, returns the squared error
+static float BC1_Fit(const float Px[16][4], uint16_t c0, uint16_t c1, uint32_t& Indices)
+{
+	int Palette[4][4];
+	BC1_Palette(c0, c1, true, Palette);
+
+	float Error = 0.0f;
+	Indices = 0;
+
+	for (int i = 0; i < 16; i++)
+	{
+		float Best = std::numeric_limits<float>::max();
+		uint32_t BestIndex = 0;
+
+		for (uint32_t j = 0; j < 4; j++)
+		{
+			float dr = Px[i][0] - Palette[j][0];
+			float dg = Px[i][1] - Palette[j][1];
+			float db = Px[i][2] - Palette[j][2];
+			float d = dr * dr + dg * dg + db * db;
+
+			if (d < Best)
+			{
+				Best = d;
+				BestIndex = j;
+			}
+		}
+
+		Indices |= BestIndex << (i * 2);
+		Error += Best;
+	}
+
+	return Error;
+}
+
+static void Encode_BC1_Color(const float Px[16][4], BlockQuality Quality, unsigned char* Block)
+{
+	float E0[4], E1[4];
+	Block_Endpoints(Px, 3, Quality == BLOCK_QUALITY_FAST, BC1_INSET, E0, E1);
+
+	uint16_t c0 = Pack_565(E0);
+	uint16_t c1 = Pack_565(E1);
+
+	uint32_t Indices;
+	float Error = BC1_Fit(Px, c0, c1, Indices);
+
+	//the axis misses blocks with colors spread in two directions,
+	//the bounds are kept when they fit better
+	if (Quality != BLOCK_QUALITY_FAST)
+	{
+		float B0[4], B1[4];
+		Block_Endpoints(Px, 3, true, BC1_INSET, B0, B1);
+
+		uint16_t n0 = Pack_565(B0);
+		uint16_t n1 = Pack_565(B1);
+
+		uint32_t NewIndices;
+		float NewError = BC1_Fit(Px, n0, n1, NewIndices);
+
+		if (NewError < Error)
+		{
+			c0 = n0;
+			c1 = n1;
+			Indices = NewIndices;
+			Error = NewError;
+		}
+	}
+
+	if (Quality == BLOCK_QUALITY_HIGH)
+	{
+		static const float Weight[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+
+		for (int Pass = 0; Pass < BLOCK_REFINE_PASSES; Pass++)
+		{
+			float Weight0[16];
+			for (int i = 0; i < 16; i++)
+				Weight0[i] = Weight[(Indices >> (i * 2)) & 3];
+
+			if (!Least_Squares(Px, 3, Weight0, E0, E1))
+				break;
+
+			uint16_t n0 = Pack_565(E0);
+			uint16_t n1 = Pack_565(E1);
+
+			uint32_t NewIndices;
+			float NewError = BC1_Fit(Px, n0, n1, NewIndices);
+
+			if (NewError >= Error)
+				break;
+
+			c0 = n0;
+			c1 = n1;
+			Indices = NewIndices;
+			Error = NewError;
+		}
+	}
+
+	//four color mode needs c0 > c1, swap turns 0 <-> 1 and 2 <-> 3
+	if (c0 < c1)
+	{
+		uint16_t t = c0;
+		c0 = c1;
+		c1 = t;
+		Indices ^= 0x55555555;
+	}
+	else if (c0 == c1)
+	{
+		Indices = 0;
+	}
+
+	Block[0] = (unsigned char)(c0 & 0xFF);
+	Block[1] = (unsigned char)(c0 >> 8);
+	Block[2] = (unsigned char)(c1 & 0xFF);
+	Block[3] = (unsigned char)(c1 >> 8);
+	memcpy(Block + 4, &Indices, 4);
+}
+
+static void Decode_BC1_Color(const unsigned char* Block, bool AlwaysFourColors, unsigned char* Rgba)
+{
+	uint16_t c0 = (uint16_t)(Block[0] | (Block[1] << 8));
+	uint16_t c1 = (uint16_t)(Block[2] | (Block[3] << 8));
+
+	uint32_t Indices;
+	memcpy(&Indices, Block + 4, 4);
+
+	int Palette[4][4];
+	BC1_Palette(c0, c1, AlwaysFourColors || c0 > c1, Palette);
+
+	for (int i = 0; i < 16; i++)
+	{
+		const int* p = Palette[(Indices >> (i * 2)) & 3];
+		for (int c = 0; c < 4; c++)
+			Rgba[i * 4 + c] = (unsigned char)p[c];
+	}
+}
+
+//
+//BC3 alpha block
+//
+
+static void Alpha_Palette(int a0, int a1, int Palette[8])
+{
+	Palette[0] = a0;
+	Palette[1] = a1;
+
+	if (a0 > a1)
+	{
+		for (int i = 2; i < 8; i++)
+			Palette[i] = ((8 - i) * a0 + (i - 1) * a1 + 3) / 7;
+	}
+	else
+	{
+		for (int i = 2; i < 6; i++)
+			Palette[i] = ((6 - i) * a0 + (i - 1) * a1 + 2) / 5;
+
+		Palette[6] = 0;
+		Palette[7] = 255;
+	}
+}
+
+static int Alpha_Fit(const unsigned char* Rgba, int a0, int a1, uint64_t& Indices)
+{
+	int Palette[8];
+	Alpha_Palette(a0, a1, Palette);
+
+	int Error = 0;
+	Indices = 0;
+
+	for (int i = 0; i < 16; i++)
+	{
+		int Best = INT32_MAX;
+		uint64_t BestIndex = 0;
+
+		for (int j = 0; j < 8; j++)
+		{
+			int d = Rgba[i * 4 + 3] - Palette[j];
+			if (d * d < Best)
+			{
+				Best = d * d;
+				BestIndex = (uint64_t)j;
+			}
+		}
+
+		Indices |= BestIndex << (i * 3);
+		Error += Best;
+	}
+
+	return Error;
+}
+
+static void Encode_BC3_Alpha(const unsigned char* Rgba, BlockQuality Quality, unsigned char* Block)
+{
+	int Min = 255, Max = 0;
+	//range without 0 and 255, those are in the six value palette
+	int InnerMin = 255, InnerMax = 0;
+
+	for (int i = 0; i < 16; i++)
+	{
+		int a = Rgba[i * 4 + 3];
+		Min = a < Min ? a : Min;
+		Max = a > Max ? a : Max;
+
+		if (a != 0 && a != 255)
+		{
+			InnerMin = a < InnerMin ? a : InnerMin;
+			InnerMax = a > InnerMax ? a : InnerMax;
+		}
+	}
+
+	//a0 > a1 selects the eight value palette
+	int a0 = Max, a1 = Min;
+	uint64_t Indices;
+	int Error = Alpha_Fit(Rgba, a0, a1, Indices);
+
+	if (Quality == BLOCK_QUALITY_HIGH && InnerMin <= InnerMax && Error != 0)
+	{
+		uint64_t InnerIndices;
+		int InnerError = Alpha_Fit(Rgba, InnerMin, InnerMax, InnerIndices);
+
+		if (InnerError < Error)
+		{
+			a0 = InnerMin;
+			a1 = InnerMax;
+			Indices = InnerIndices;
+		}
+	}
+
+	Block[0] = (unsigned char)a0;
+	Block[1] = (unsigned char)a1;
+
+	for (int i = 0; i < 6; i++)
+		Block[2 + i] = (unsigned char)(Indices >> (i * 8));
+}
+
+static void Decode_BC3_Alpha(const unsigned char* Block, unsigned char* Rgba)
+{
+	int Palette[8];
+	Alpha_Palette(Block[0], Block[1], Palette);
+
+	uint64_t Indices = 0;
+	for (int i = 0; i < 6; i++)
+		Indices |= (uint64_t)Block[2 + i] << (i * 8);
+
+	for (int i = 0; i < 16; i++)
+		Rgba[i * 4 + 3] = (unsigned char)Palette[(Indices >> (i * 3)) & 7];
+}
+
+//
+//BC7 mode 6, one subset, 7 bit rgba endpoints
+//with a p-bit each, 4 bit indices
+//
+
+struct Bit_Writer
+{
+	uint64_t Bits[2] = { 0, 0 };
+	int Pos = 0;
+
+	void Put(uint32_t Value, int Count)
+	{
+		for (int i = 0; i < Count; i++, Pos++)
+			Bits[Pos >> 6] |= (uint64_t)((Value >> i) & 1) << (Pos & 63);
+	}
+};
+
+struct Bit_Reader
+{
+	uint64_t Bits[2];
+	int Pos = 0;
+
+	uint32_t Get(int Count)
+	{
+		uint32_t Value = 0;
+		for (int i = 0; i < Count; i++, Pos++)
+			Value |= (uint32_t)((Bits[Pos >> 6] >> (Pos & 63)) & 1) << i;
+		return Value;
+	}
+};
+
+//quantized endpoint, 8 bit value is Q << 1 | P
+struct BC7_Endpoint
+{
+	int Q[4];
+	int P;
+};
+
+static void BC7_Quantize(const float* E, int P, BC7_Endpoint& Out)
+{
+	for (int c = 0; c < 4; c++)
+		Out.Q[c] = Clamp_Int((int)floorf((E[c] - P) / 2.0f + 0.5f), 0, 127);
+
+	Out.P = P;
+}
+
+static float BC7_Fit(const float Px[16][4], const BC7_Endpoint& E0, const BC7_Endpoint& E1, int* Indices)
+{
+	int Palette[16][4];
+
+	for (int c = 0; c < 4; c++)
+	{
+		int v0 = (E0.Q[c] << 1) | E0.P;
+		int v1 = (E1.Q[c] << 1) | E1.P;
+
+		for (int j = 0; j < 16; j++)
+			Palette[j][c] = ((64 - BC7_Weights4[j]) * v0 + BC7_Weights4[j] * v1 + 32) >> 6;
+	}
+
+	float Error = 0.0f;
+
+	for (int i = 0; i < 16; i++)
+	{
+		float Best = std::numeric_limits<float>::max();
+
+		for (int j = 0; j < 16; j++)
+		{
+			float d = 0.0f;
+			for (int c = 0; c < 4; c++)
+				d += (Px[i][c] - Palette[j][c]) * (Px[i][c] - Palette[j][c]);
+
+			if (d < Best)
+			{
+				Best = d;
+				Indices[i] = j;
+			}
+		}
+
+		Error += Best;
+	}
+
+	return Error;
+}
+
+//squared error of one endpoint after quantization with p-bit P
+static float BC7_Endpoint_Error(const float* E, int P)
+{
+	BC7_Endpoint q;
+	BC7_Quantize(E, P, q);
+
+	float Error = 0.0f;
+	for (int c = 0; c < 4; c++)
+	{
+		float d = E[c] - ((q.Q[c] << 1) | P);
+		Error += d * d;
+	}
+
+	return Error;
+}
+
+//best p-bits for the endpoints, Fast picks each p-bit on its own
+static float BC7_Fit_Pbits(const float Px[16][4], const float* E0, const float* E1, bool Fast,
+	BC7_Endpoint& Best0, BC7_Endpoint& Best1, int* BestIndices)
+{
+	float BestError = std::numeric_limits<float>::max();
+
+	for (int p = 0; p < 4; p++)
+	{
+		int P0 = p & 1;
+		int P1 = p >> 1;
+
+		if (Fast)
+		{
+			P0 = BC7_Endpoint_Error(E0, 1) < BC7_Endpoint_Error(E0, 0) ? 1 : 0;
+			P1 = BC7_Endpoint_Error(E1, 1) < BC7_Endpoint_Error(E1, 0) ? 1 : 0;
+		}
+
+		BC7_Endpoint q0, q1;
+		BC7_Quantize(E0, P0, q0);
+		BC7_Quantize(E1, P1, q1);
+
+		int Indices[16];
+		float Error = BC7_Fit(Px, q0, q1, Indices);
+
+		if (Error < BestError)
+		{
+			BestError = Error;
+			Best0 = q0;
+			Best1 = q1;
+			memcpy(BestIndices, Indices, sizeof(Indices));
+		}
+
+		if (Fast)
+			break;
+	}
+
+	return BestError;
+}
+
+static void Encode_BC7(const unsigned char* Rgba, BlockQuality Quality, unsigned char* Block)
+{
+	float Px[16][4];
+	Load_Block(Rgba, Px);
+
+	float E0[4], E1[4];
+	Block_Endpoints(Px, 4, Quality == BLOCK_QUALITY_FAST, BC7_INSET, E0, E1);
+
+	BC7_Endpoint q0, q1;
+	int Indices[16];
+	float Error = BC7_Fit_Pbits(Px, E0, E1, Quality == BLOCK_QUALITY_FAST, q0, q1, Indices);
+
+	if (Quality == BLOCK_QUALITY_HIGH)
+	{
+		for (int Pass = 0; Pass < BLOCK_REFINE_PASSES && Error > 0.0f; Pass++)
+		{
+			float Weight0[16];
+			for (int i = 0; i < 16; i++)
+				Weight0[i] = (64 - BC7_Weights4[Indices[i]]) / 64.0f;
+
+			if (!Least_Squares(Px, 4, Weight0, E0, E1))
+				break;
+
+			BC7_Endpoint n0, n1;
+			int NewIndices[16];
+			float NewError = BC7_Fit_Pbits(Px, E0, E1, false, n0, n1, NewIndices);
+
+			if (NewError >= Error)
+				break;
+
+			q0 = n0;
+			q1 = n1;
+			memcpy(Indices, NewIndices, sizeof(Indices));
+			Error = NewError;
+		}
+	}
+
+	//top bit of the first index is not stored, it must be 0
+	if (Indices[0] & 8)
+	{
+		BC7_Endpoint t = q0;
+		q0 = q1;
+		q1 = t;
+
+		for (int i = 0; i < 16; i++)
+			Indices[i] = 15 - Indices[i];
+	}
+
+	Bit_Writer Writer;
+	Writer.Put(1 << 6, 7);
+
+	for (int c = 0; c < 4; c++)
+	{
+		Writer.Put(q0.Q[c], 7);
+		Writer.Put(q1.Q[c], 7);
+	}
+
+	Writer.Put(q0.P, 1);
+	Writer.Put(q1.P, 1);
+
+	for (int i = 0; i < 16; i++)
+		Writer.Put(Indices[i], i == 0 ? 3 : 4);
+
+	memcpy(Block, Writer.Bits, 16);
+}
+
+//only mode 6 blocks are decoded, other modes come out magenta
+static void Decode_BC7(const unsigned char* Block, unsigned char* Rgba)
+{
+	Bit_Reader Reader;
+	memcpy(Reader.Bits, Block, 16);
+
+	if (Reader.Get(7) != 1 << 6)
+	{
+		for (int i = 0; i < 16; i++)
+		{
+			Rgba[i * 4 + 0] = 255;
+			Rgba[i * 4 + 1] = 0;
+			Rgba[i * 4 + 2] = 255;
+			Rgba[i * 4 + 3] = 255;
+		}
+		return;
+	}
+
+	int Q[2][4];
+	for (int c = 0; c < 4; c++)
+	{
+		Q[0][c] = Reader.Get(7);
+		Q[1][c] = Reader.Get(7);
+	}
+
+	int P0 = Reader.Get(1);
+	int P1 = Reader.Get(1);
+
+	for (int i = 0; i < 16; i++)
+	{
+		int w = BC7_Weights4[Reader.Get(i == 0 ? 3 : 4)];
+
+		for (int c = 0; c < 4; c++)
+		{
+			int v0 = (Q[0][c] << 1) | P0;
+			int v1 = (Q[1][c] << 1) | P1;
+			Rgba[i * 4 + c] = (unsigned char)(((64 - w) * v0 + w * v1 + 32) >> 6);
+		}
+	}
+}
+
+void EncodeBlock(BlockFormat Format, BlockQuality Quality, const unsigned char* Rgba, unsigned char* Block)
+{
+	if (Format == BLOCK_BC7)
+	{
+		Encode_BC7(Rgba, Quality, Block);
+		return;
+	}
+
+	float Px[16][4];
+	Load_Block(Rgba, Px);
+
+	if (Format == BLOCK_BC3)
+	{
+		Encode_BC3_Alpha(Rgba, Quality, Block);
+		Block += 8;
+	}
+
+	Encode_BC1_Color(Px, Quality, Block);
+}
+
+void DecodeBlock(BlockFormat Format, const unsigned char* Block, unsigned char* Rgba)
+{
+	if (Format == BLOCK_BC1)
+	{
+		Decode_BC1_Color(Block, false, Rgba);
+	}
+	else if (Format == BLOCK_BC3)
+	{
+		//color of BC3 is always four color mode
+		Decode_BC1_Color(Block + 8, true, Rgba);
+		Decode_BC3_Alpha(Block, Rgba);
+	}
+	else
+	{
+		Decode_BC7(Block, Rgba);
+	}
+}
+
+//4x4 pixels at block bx, by with the edge pixels repeated
+static void Gather_Block(const unsigned char* Rgba, uint32_t Width, uint32_t Height, uint64_t RowPitch,
+	uint32_t bx, uint32_t by, unsigned char* Block)
+{
+	for (uint32_t y = 0; y < 4; y++)
+	{
+		uint32_t sy = by * 4 + y < Height ? by * 4 + y : Height - 1;
+
+		for (uint32_t x = 0; x < 4; x++)
+		{
+			uint32_t sx = bx * 4 + x < Width ? bx * 4 + x : Width - 1;
+			memcpy(Block + (y * 4 + x) * 4, Rgba + sy * RowPitch + sx * 4, 4);
+		}
+	}
+}
+
+void CompressImage(BlockFormat Format, BlockQuality Quality,
+	const unsigned char* Rgba, uint32_t Width, uint32_t Height, uint64_t RowPitch,
+	unsigned char* Dst, uint64_t DstRowPitch, CThreadPool& Pool)
+{
+	PROFILE_FUNCTION();
+
+	const uint32_t BlocksX = (Width + 3) / 4;
+	const uint32_t BlocksY = (Height + 3) / 4;
+	const uint32_t Bytes = BlockBytes(Format);
+
+	unsigned TileCount = (BlocksY + BLOCK_TILE_ROWS - 1) / BLOCK_TILE_ROWS;
+
+	Pool.ParallelFor(TileCount, [&](unsigned Tile)
+	{
+		uint32_t RowEnd = (Tile + 1) * BLOCK_TILE_ROWS;
+		if (RowEnd > BlocksY)
+			RowEnd = BlocksY;
+
+		unsigned char Pixels[64];
+
+		for (uint32_t by = Tile * BLOCK_TILE_ROWS; by < RowEnd; by++)
+		{
+			unsigned char* Row = Dst + by * DstRowPitch;
+
+			for (uint32_t bx = 0; bx < BlocksX; bx++)
+			{
+				Gather_Block(Rgba, Width, Height, RowPitch, bx, by, Pixels);
+				EncodeBlock(Format, Quality, Pixels, Row + bx * Bytes);
+			}
+		}
+	}, "Compress Tiles");
+}
+
+static double Psnr_From_Error(double Error, double Count)
+{
+	if (Error == 0.0)
+		return std::numeric_limits<double>::infinity();
+
+	return 10.0 * log10(255.0 * 255.0 / (Error / Count));
+}
+
+BlockPsnr CompressedPsnr(BlockFormat Format,
+	const unsigned char* Rgba, uint32_t Width, uint32_t Height, uint64_t RowPitch,
+	const unsigned char* Blocks, uint64_t BlockRowPitch)
+{
+	const uint32_t BlocksX = (Width + 3) / 4;
+	const uint32_t BlocksY = (Height + 3) / 4;
+	const uint32_t Bytes = BlockBytes(Format);
+
+	double RgbError = 0.0;
+	double AlphaError = 0.0;
+
+	unsigned char Decoded[64];
+
+	for (uint32_t by = 0; by < BlocksY; by++)
+	{
+		for (uint32_t bx = 0; bx < BlocksX; bx++)
+		{
+			DecodeBlock(Format, Blocks + by * BlockRowPitch + bx * Bytes, Decoded);
+
+			for (uint32_t y = 0; y < 4 && by * 4 + y < Height; y++)
+			{
+				for (uint32_t x = 0; x < 4 && bx * 4 + x < Width; x++)
+				{
+					const unsigned char* s = Rgba + (by * 4 + y) * RowPitch + (bx * 4 + x) * 4;
+					const unsigned char* d = Decoded + (y * 4 + x) * 4;
+
+					for (int c = 0; c < 3; c++)
+						RgbError += (double)(s[c] - d[c]) * (s[c] - d[c]);
+
+					AlphaError += (double)(s[3] - d[3]) * (s[3] - d[3]);
+				}
+			}
+		}
+	}
+
+	BlockPsnr Result;
+	Result.Rgb = Psnr_From_Error(RgbError, (double)Width * Height * 3);
+	Result.Alpha = Psnr_From_Error(AlphaError, (double)Width * Height);
+
+	return Result;
+}
@@ -0,0 +1,60 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Block Compress
+//======================================================================================
+
+#ifndef _BLOCKCOMPRESS_
+#define _BLOCKCOMPRESS_
+
+#include <cstdint>
+#include <cstddef>
+
+#include "ThreadPool.h"
+
+enum BlockFormat
+{
+	//opaque rgb, 8 bytes per 4x4 block
+	BLOCK_BC1,
+	//rgb as BC1 and interpolated alpha, 16 bytes
+	BLOCK_BC3,
+	//rgba, 16 bytes, the encoder writes mode 6 blocks
+	BLOCK_BC7
+};
+
+//speed / quality of the encoders
+enum BlockQuality
+{
+	//endpoints from the color bounds
+	BLOCK_QUALITY_FAST,
+	//endpoints on the principal axis, BC1 keeps the bounds
+	//when they fit better, BC7 tries all p-bits
+	BLOCK_QUALITY_NORMAL,
+	//as normal plus least squares endpoint refinement
+	BLOCK_QUALITY_HIGH
+};
+
+uint32_t BlockBytes(BlockFormat Format);
+
+//Rgba - 4x4 RGBA8 pixels row by row
+void EncodeBlock(BlockFormat Format, BlockQuality Quality, const unsigned char* Rgba, unsigned char* Block);
+void DecodeBlock(BlockFormat Format, const unsigned char* Block, unsigned char* Rgba);
+
+//encodes RGBA8 image, block rows go DstRowPitch bytes apart,
+//blocks over the right and bottom edge repeat the last pixel,
+//rows of blocks are split into tiles run on Pool
+void CompressImage(BlockFormat Format, BlockQuality Quality,
+	const unsigned char* Rgba, uint32_t Width, uint32_t Height, uint64_t RowPitch,
+	unsigned char* Dst, uint64_t DstRowPitch, CThreadPool& Pool);
+
+//PSNR in dB of the decoded blocks against the source,
+//infinity if they match
+struct BlockPsnr
+{
+	double Rgb = 0.0;
+	double Alpha = 0.0;
+};
+
+BlockPsnr CompressedPsnr(BlockFormat Format,
+	const unsigned char* Rgba, uint32_t Width, uint32_t Height, uint64_t RowPitch,
+	const unsigned char* Blocks, uint64_t BlockRowPitch);
+
+#endif
@@ -0,0 +1,60 @@
+//======================================================================================
+//	Ed Kurlyak 2023 BMP Decoder
+//======================================================================================
+
+#ifndef _BMPDECODER_
+#define _BMPDECODER_
+
+#include <cstdint>
+#include <cstddef>
+
+enum BmpSimd
+{
+	BMP_SIMD_NONE,
+	BMP_SIMD_SSSE3,
+	BMP_SIMD_AVX2
+};
+
+//uncompressed 24 or 32 bit BMP
+struct BmpInfo
+{
+	uint32_t Width = 0;
+	uint32_t Height = 0;
+	uint32_t BitCount = 0;
+
+	//rows in the file go from the bottom of the image up
+	bool BottomUp = true;
+	//32 bit file with alpha mask, otherwise alpha is 255
+	bool HasAlpha = false;
+
+	uint64_t DataOffset = 0;
+	//file row size with padding to 4 bytes
+	uint32_t RowPitch = 0;
+};
+
+//best kernel this CPU runs
+BmpSimd BmpSimdSupport();
+
+//checks headers and that pixel data fits in Size bytes
+bool ParseBmpHeader(const unsigned char* Data, size_t Size, BmpInfo& Info);
+
+//writes RGBA8 rows DstRowPitch bytes apart (upload footprint RowPitch),
+//BottomUpRows - first Dst row is the bottom of the image as the samples
+//uv expect, for any row order in the file
+void DecodeBmp(const unsigned char* Data, const BmpInfo& Info,
+	unsigned char* Dst, uint64_t DstRowPitch, bool BottomUpRows,
+	BmpSimd Simd = BmpSimdSupport());
+
+//decodes a generated Width x Height BMP Runs times with each
+//kernel, Time in ms per decode, 0 - kernel is not supported
+struct BmpBenchResult
+{
+	uint32_t Width = 0;
+	uint32_t Height = 0;
+	uint32_t BitCount = 0;
+	double Time[3] = { 0.0, 0.0, 0.0 };
+};
+
+BmpBenchResult BenchmarkBmpDecode(uint32_t Width, uint32_t Height, uint32_t BitCount, int Runs);
+
+#endif
@@ -0,0 +1,42 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Constant Allocator DirectX12
+//======================================================================================
+
+#include "ConstantAllocator.h"
+
+CConstantAllocator::~CConstantAllocator()
+{
+	if (m_Buffer != nullptr)
+		m_Buffer->Unmap(0, nullptr);
+
+	m_MappedData = nullptr;
+}
+
+void CConstantAllocator::Init(ID3D12Device* Device, UINT64 Capacity)
+{
+	ThrowIfFailed(Device->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+		D3D12_HEAP_FLAG_NONE,
+		&CD3DX12_RESOURCE_DESC::Buffer(Capacity),
+		D3D12_RESOURCE_STATE_GENERIC_READ,
+		nullptr,
+		IID_PPV_ARGS(&m_Buffer)));
+
+	//stays mapped, the CPU only writes to it
+	CD3DX12_RANGE ReadRange(0, 0);
+	ThrowIfFailed(m_Buffer->Map(0, &ReadRange, reinterpret_cast<void**>(&m_MappedData)));
+
+	m_GpuAddress = m_Buffer->GetGPUVirtualAddress();
+
+	m_Allocator.Init(Capacity, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+}
+
+UINT64 CConstantAllocator::Allocate(UINT64 Size)
+{
+	UINT64 Offset = 0;
+
+	if (!m_Allocator.Allocate(Size, Offset))
+		ThrowIfFailed(E_OUTOFMEMORY);
+
+	return Offset;
+}
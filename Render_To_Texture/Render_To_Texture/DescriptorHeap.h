@@ -0,0 +1,71 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Descriptor Heap DirectX12
+//======================================================================================
+
+#ifndef _DESCRIPTORHEAP_
+#define _DESCRIPTORHEAP_
+
+#include <windows.h>
+#include <wrl.h>
+#include <d3d12.h>
+#include "d3dx12.h"
+
+#include "d3dUtil.h"
+#include "DescriptorAllocator.h"
+
+//Count descriptors from Index on, GpuHandle is 0 in a heap
+//that is not shader visible
+struct DescriptorRange
+{
+	UINT Index = 0;
+	UINT Count = 0;
+	D3D12_CPU_DESCRIPTOR_HANDLE CpuHandle = {};
+	D3D12_GPU_DESCRIPTOR_HANDLE GpuHandle = {};
+};
+
+//one descriptor heap for the whole sample instead of a small
+//heap per view, the CBV/SRV/UAV heap is shader visible and set
+//once per command list, RTV and DSV heaps are CPU only with no
+//transient part, see CDescriptorAllocator for the layout
+class CDescriptorHeap
+{
+public:
+	CDescriptorHeap() = default;
+
+	CDescriptorHeap(const CDescriptorHeap& rhs) = delete;
+	CDescriptorHeap& operator=(const CDescriptorHeap& rhs) = delete;
+
+	void Init(ID3D12Device* Device, D3D12_DESCRIPTOR_HEAP_TYPE Type,
+		UINT PersistentCount, UINT TransientCount, bool ShaderVisible);
+
+	//throw when the heap runs out of descriptors
+	DescriptorRange Allocate(UINT Count = 1);
+	DescriptorRange Allocate_Transient(UINT Count);
+
+	void Free(DescriptorRange& Range);
+
+	//transient ranges since the last call are reused after FenceValue
+	void Close_Frame(UINT64 FenceValue) { m_Allocator.Close_Frame(FenceValue); }
+	void Release(UINT64 CompletedValue) { m_Allocator.Release(CompletedValue); }
+
+	D3D12_CPU_DESCRIPTOR_HANDLE Cpu_Handle(UINT Index) const;
+	D3D12_GPU_DESCRIPTOR_HANDLE Gpu_Handle(UINT Index) const;
+
+	ID3D12DescriptorHeap* Heap() const { return m_Heap.Get(); }
+
+	const CDescriptorAllocator& Allocator() const { return m_Allocator; }
+
+private:
+	DescriptorRange Make_Range(UINT Index, UINT Count) const;
+
+	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> m_Heap;
+
+	D3D12_CPU_DESCRIPTOR_HANDLE m_CpuStart = {};
+	D3D12_GPU_DESCRIPTOR_HANDLE m_GpuStart = {};
+	UINT m_Increment = 0;
+	bool m_ShaderVisible = false;
+
+	CDescriptorAllocator m_Allocator;
+};
+
+#endif
@@ -0,0 +1,241 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Frame Histogram
+//======================================================================================
+
+#include "FrameHistogram.h"
+
+#include <cstdio>
+
+static FILE* Open_File(const char* FileName, const char* Mode)
+{
+	FILE* Fp = NULL;
+#ifdef _WIN32
+	fopen_s(&Fp, FileName, Mode);
+#else
+	Fp = fopen(FileName, Mode);
+#endif
+	return Fp;
+}
+
+//percentiles written to the exports
+static const double g_Percentiles[] = { 50.0, 90.0, 95.0, 99.0, 99.9 };
+static const int g_PercentileCount = sizeof(g_Percentiles) / sizeof(g_Percentiles[0]);
+
+CFrameHistogram::CFrameHistogram()
+{
+	m_Budget.store(0, std::memory_order_relaxed);
+
+	Reset();
+}
+
+void CFrameHistogram::Reset()
+{
+	for (int i = 0; i < FRAME_HISTOGRAM_BUCKETS; i++)
+		m_Buckets[i].store(0, std::memory_order_relaxed);
+
+	for (int i = 0; i < FRAME_HISTORY_SIZE; i++)
+		m_History[i].store(0, std::memory_order_relaxed);
+
+	m_Sum.store(0, std::memory_order_relaxed);
+	m_Max.store(0, std::memory_order_relaxed);
+	m_OverBudget.store(0, std::memory_order_relaxed);
+	m_Count.store(0, std::memory_order_release);
+}
+
+int CFrameHistogram::Bucket_Index(int64_t Microseconds)
+{
+	if (Microseconds < FRAME_HISTOGRAM_SUB_COUNT)
+		return Microseconds < 0 ? 0 : (int)Microseconds;
+
+	//position of the top bit picks the magnitude,
+	//the next SUB_BITS bits pick the linear bucket
+	int Top = 63;
+	while (!(Microseconds & ((int64_t)1 << Top)))
+		Top--;
+
+	int Magnitude = Top - FRAME_HISTOGRAM_SUB_BITS + 1;
+	if (Magnitude > FRAME_HISTOGRAM_MAGNITUDES)
+		return FRAME_HISTOGRAM_BUCKETS - 1;
+
+	int Sub = (int)(Microseconds >> (Magnitude - 1)) - FRAME_HISTOGRAM_SUB_COUNT;
+
+	return Magnitude * FRAME_HISTOGRAM_SUB_COUNT + Sub;
+}
+
+int64_t CFrameHistogram::Bucket_Upper(int Index)
+{
+	int Magnitude = Index / FRAME_HISTOGRAM_SUB_COUNT;
+	int64_t Sub = Index % FRAME_HISTOGRAM_SUB_COUNT;
+
+	if (Magnitude == 0)
+		return Sub;
+
+	int64_t Lower = (FRAME_HISTOGRAM_SUB_COUNT + Sub) << (Magnitude - 1);
+
+	return Lower + ((int64_t)1 << (Magnitude - 1)) - 1;
+}
+
+void CFrameHistogram::Record(int64_t Microseconds)
+{
+	if (Microseconds < 0)
+		Microseconds = 0;
+
+	uint64_t Index = m_Count.load(std::memory_order_relaxed);
+
+	m_History[Index & (FRAME_HISTORY_SIZE - 1)].store(Microseconds, std::memory_order_relaxed);
+	m_Buckets[Bucket_Index(Microseconds)].fetch_add(1, std::memory_order_relaxed);
+
+	m_Sum.fetch_add(Microseconds, std::memory_order_relaxed);
+	if (Microseconds > m_Max.load(std::memory_order_relaxed))
+		m_Max.store(Microseconds, std::memory_order_relaxed);
+
+	int64_t Budget = m_Budget.load(std::memory_order_relaxed);
+	if (Budget > 0 && Microseconds > Budget)
+		m_OverBudget.fetch_add(1, std::memory_order_relaxed);
+
+	//publishes the frame to readers
+	m_Count.store(Index + 1, std::memory_order_release);
+}
+
+int64_t CFrameHistogram::Percentile(double P) const
+{
+	uint32_t Counts[FRAME_HISTOGRAM_BUCKETS];
+	uint64_t Total = 0;
+
+	for (int i = 0; i < FRAME_HISTOGRAM_BUCKETS; i++)
+	{
+		Counts[i] = m_Buckets[i].load(std::memory_order_relaxed);
+		Total += Counts[i];
+	}
+
+	if (Total == 0)
+		return 0;
+
+	//rank of the frame, 1 based, rounded up
+	double Rank = P / 100.0 * (double)Total;
+	uint64_t Target = (uint64_t)Rank;
+	if ((double)Target < Rank || Target == 0)
+		Target++;
+	if (Target > Total)
+		Target = Total;
+
+	uint64_t Seen = 0;
+	for (int i = 0; i < FRAME_HISTOGRAM_BUCKETS; i++)
+	{
+		Seen += Counts[i];
+		if (Seen >= Target)
+		{
+			//the bucket edge can be past the longest frame,
+			//the last bucket has no edge at all
+			int64_t Max = m_Max.load(std::memory_order_relaxed);
+			if (i == FRAME_HISTOGRAM_BUCKETS - 1)
+				return Max;
+
+			int64_t Upper = Bucket_Upper(i);
+			return Upper < Max ? Upper : Max;
+		}
+	}
+
+	return m_Max.load(std::memory_order_relaxed);
+}
+
+double CFrameHistogram::Average() const
+{
+	uint64_t Frames = Count();
+	if (Frames == 0)
+		return 0.0;
+
+	return (double)m_Sum.load(std::memory_order_relaxed) / (double)Frames;
+}
+
+uint32_t CFrameHistogram::Copy_History(int64_t* Frames) const
+{
+	uint64_t End = Count();
+	uint64_t Start = End > FRAME_HISTORY_SIZE ? End - FRAME_HISTORY_SIZE : 0;
+
+	uint32_t Num = 0;
+	for (uint64_t i = Start; i < End; i++)
+		Frames[Num++] = m_History[i & (FRAME_HISTORY_SIZE - 1)].load(std::memory_order_relaxed);
+
+	return Num;
+}
+
+bool CFrameHistogram::Write_CSV(const char* FileName) const
+{
+	FILE* Fp = Open_File(FileName, "w");
+	if (Fp == NULL)
+		return false;
+
+	fprintf(Fp, "key,value\n");
+	fprintf(Fp, "frames,%llu\n", (unsigned long long)Count());
+	fprintf(Fp, "avg_us,%.1f\n", Average());
+	fprintf(Fp, "max_us,%lld\n", (long long)Max());
+	fprintf(Fp, "budget_us,%lld\n", (long long)m_Budget.load(std::memory_order_relaxed));
+	fprintf(Fp, "over_budget,%llu\n", (unsigned long long)Over_Budget());
+
+	for (int i = 0; i < g_PercentileCount; i++)
+		fprintf(Fp, "p%g_us,%lld\n", g_Percentiles[i], (long long)Percentile(g_Percentiles[i]));
+
+	fprintf(Fp, "\nbucket_upper_us,frames\n");
+	for (int i = 0; i < FRAME_HISTOGRAM_BUCKETS; i++)
+	{
+		uint32_t Num = m_Buckets[i].load(std::memory_order_relaxed);
+		if (Num != 0)
+			fprintf(Fp, "%lld,%u\n", (long long)Bucket_Upper(i), Num);
+	}
+
+	int64_t Frames[FRAME_HISTORY_SIZE];
+	uint32_t Num = Copy_History(Frames);
+
+	fprintf(Fp, "\nrecent_frame,us\n");
+	for (uint32_t i = 0; i < Num; i++)
+		fprintf(Fp, "%u,%lld\n", i, (long long)Frames[i]);
+
+	fclose(Fp);
+
+	return true;
+}
+
+bool CFrameHistogram::Write_JSON(const char* FileName) const
+{
+	FILE* Fp = Open_File(FileName, "w");
+	if (Fp == NULL)
+		return false;
+
+	fprintf(Fp, "{\n");
+	fprintf(Fp, "\t\"frames\": %llu,\n", (unsigned long long)Count());
+	fprintf(Fp, "\t\"avg_us\": %.1f,\n", Average());
+	fprintf(Fp, "\t\"max_us\": %lld,\n", (long long)Max());
+	fprintf(Fp, "\t\"budget_us\": %lld,\n", (long long)m_Budget.load(std::memory_order_relaxed));
+	fprintf(Fp, "\t\"over_budget\": %llu,\n", (unsigned long long)Over_Budget());
+
+	fprintf(Fp, "\t\"percentiles_us\": {");
+	for (int i = 0; i < g_PercentileCount; i++)
+		fprintf(Fp, "%s\"p%g\": %lld", i ? ", " : " ", g_Percentiles[i], (long long)Percentile(g_Percentiles[i]));
+	fprintf(Fp, " },\n");
+
+	fprintf(Fp, "\t\"histogram\": [");
+	bool First = true;
+	for (int i = 0; i < FRAME_HISTOGRAM_BUCKETS; i++)
+	{
+		uint32_t Num = m_Buckets[i].load(std::memory_order_relaxed);
+		if (Num == 0)
+			continue;
+
+		fprintf(Fp, "%s\n\t\t{ \"upper_us\": %lld, \"frames\": %u }", First ? "" : ",", (long long)Bucket_Upper(i), Num);
+		First = false;
+	}
+	fprintf(Fp, "\n\t],\n");
+
+	int64_t Frames[FRAME_HISTORY_SIZE];
+	uint32_t Num = Copy_History(Frames);
+
+	fprintf(Fp, "\t\"recent_us\": [");
+	for (uint32_t i = 0; i < Num; i++)
+		fprintf(Fp, "%s%lld", i ? ", " : "", (long long)Frames[i]);
+	fprintf(Fp, "]\n}\n");
+
+	fclose(Fp);
+
+	return true;
+}
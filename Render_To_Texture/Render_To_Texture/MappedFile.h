@@ -0,0 +1,39 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Mapped File
+//======================================================================================
+
+#ifndef _MAPPEDFILE_
+#define _MAPPEDFILE_
+
+#include <cstddef>
+
+//read only view of a whole file, the pages are
+//loaded by the OS on first access
+class CMappedFile
+{
+public:
+	CMappedFile() = default;
+	~CMappedFile();
+
+	CMappedFile(const CMappedFile& rhs) = delete;
+	CMappedFile& operator=(const CMappedFile& rhs) = delete;
+
+	bool Open(const char* FileName);
+	void Close();
+
+	const unsigned char* Data() const { return m_Data; }
+	size_t Size() const { return m_Size; }
+
+private:
+	const unsigned char* m_Data = nullptr;
+	size_t m_Size = 0;
+
+#ifdef _WIN32
+	void* m_File = nullptr;
+	void* m_Mapping = nullptr;
+#else
+	int m_File = -1;
+#endif
+};
+
+#endif
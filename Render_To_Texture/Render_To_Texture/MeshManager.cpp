@@ -12,6 +12,14 @@ CMeshManager::~CMeshManager()
 {
 	if (m_d3dDevice != nullptr)
 		FlushCommandQueue();
+
+	Export_Frame_Stats();
+	CProfiler::Write_Trace(PROFILER_TRACE_FILE);
+}
+
+void CMeshManager::Export_Frame_Stats()
+{
+	m_Timer.Export_Frame_Stats();
 }
 
 void CMeshManager::EnableDebugLayer_CreateFactory()
@@ -29,6 +37,8 @@ void CMeshManager::EnableDebugLayer_CreateFactory()
 
 void CMeshManager::Create_Device()
 {
+	PROFILE_FUNCTION();
+
 	HRESULT hardwareResult = D3D12CreateDevice(
 		nullptr,             // default adapter
 		D3D_FEATURE_LEVEL_11_0,
@@ -49,13 +59,16 @@ void CMeshManager::Create_Device()
 
 void CMeshManager::CreateFence_GetDescriptorsSize()
 {
-	ThrowIfFailed(m_d3dDevice->CreateFence(0, D3D12_FENCE_FLAG_NONE,
-		IID_PPV_ARGS(&m_Fence)));
+	m_Fence.Init(m_d3dDevice.Get());
 
 	m_RtvDescriptorSize = m_d3dDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
 	m_DsvDescriptorSize = m_d3dDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_DSV);
 	m_CbvSrvUavDescriptorSize = m_d3dDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
 
+	m_SrvHeap.Init(m_d3dDevice.Get(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV,
+		SRV_HEAP_PERSISTENT, 0, true);
+	m_RtvHeap.Init(m_d3dDevice.Get(), D3D12_DESCRIPTOR_HEAP_TYPE_RTV, RTV_HEAP_SIZE, 0, false);
+	m_DsvHeap.Init(m_d3dDevice.Get(), D3D12_DESCRIPTOR_HEAP_TYPE_DSV, DSV_HEAP_SIZE, 0, false);
 }
 
 void CMeshManager::Check_Multisample_Quality()
@@ -97,6 +110,8 @@ void CMeshManager::Create_CommandList_Allocator_Queue()
 
 void CMeshManager::Create_SwapChain()
 {
+	PROFILE_FUNCTION();
+
 	m_SwapChain.Reset();
 
 	DXGI_SWAP_CHAIN_DESC sd;
@@ -136,6 +151,7 @@ void CMeshManager::Resize_SwapChainBuffers()
 		m_SwapChainBuffer[i].Reset();
 
 	m_DepthStencilBuffer.Reset();
+	m_GpuMemory.Free(m_DepthStencilMemory);
 
 	ThrowIfFailed(m_SwapChain->ResizeBuffers(
 		m_SwapChainBufferCount,
@@ -146,30 +162,19 @@ void CMeshManager::Resize_SwapChainBuffers()
 
 void CMeshManager::FlushCommandQueue()
 {
-	m_CurrentFence++;
-
-	ThrowIfFailed(m_CommandQueue->Signal(m_Fence.Get(), m_CurrentFence));
-
-	if (m_Fence->GetCompletedValue() < m_CurrentFence)
-	{
-		HANDLE eventHandle = CreateEventEx(nullptr, false, false, EVENT_ALL_ACCESS);
+	PROFILE_FUNCTION();
 
-		ThrowIfFailed(m_Fence->SetEventOnCompletion(m_CurrentFence, eventHandle));
+	//both queues go idle, copies recorded but not submitted yet
+	//are submitted first, before m_Upload.Init Submit returns 0
+	CGpuFence* Fences[] = { &m_Fence, &m_Upload.Fence() };
+	UINT64 Values[] = { m_Fence.Signal(m_CommandQueue.Get()), m_Upload.Submit() };
 
-		WaitForSingleObject(eventHandle, INFINITE);
-		CloseHandle(eventHandle);
-	}
+	CGpuFence::Wait_All(Fences, Values, _countof(Fences));
 }
 
 void CMeshManager::Create_Dsv_DescriptorHeaps_And_View()
 {
-	D3D12_DESCRIPTOR_HEAP_DESC dsvHeapDesc;
-	dsvHeapDesc.NumDescriptors = 1;
-	dsvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_DSV;
-	dsvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
-	dsvHeapDesc.NodeMask = 0;
-	ThrowIfFailed(m_d3dDevice->CreateDescriptorHeap(
-		&dsvHeapDesc, IID_PPV_ARGS(m_DsvHeap.GetAddressOf())));
+	m_DepthStencilDsv = m_DsvHeap.Allocate();
 
 	D3D12_RESOURCE_DESC depthStencilDesc;
 	depthStencilDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
@@ -188,13 +193,8 @@ void CMeshManager::Create_Dsv_DescriptorHeaps_And_View()
 	optClear.Format = m_DepthStencilFormat;
 	optClear.DepthStencil.Depth = 1.0f;
 	optClear.DepthStencil.Stencil = 0;
-	ThrowIfFailed(m_d3dDevice->CreateCommittedResource(
-		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
-		D3D12_HEAP_FLAG_NONE,
-		&depthStencilDesc,
-		D3D12_RESOURCE_STATE_COMMON,
-		&optClear,
-		IID_PPV_ARGS(m_DepthStencilBuffer.GetAddressOf())));
+	m_DepthStencilMemory = m_GpuMemory.Create_Texture(depthStencilDesc, D3D12_RESOURCE_STATE_COMMON, &optClear);
+	m_DepthStencilBuffer = m_DepthStencilMemory.Resource;
 
 	D3D12_DEPTH_STENCIL_VIEW_DESC dsvDesc;
 	dsvDesc.Flags = D3D12_DSV_FLAG_NONE;
@@ -209,18 +209,68 @@ void CMeshManager::Create_Dsv_DescriptorHeaps_And_View()
 
 D3D12_CPU_DESCRIPTOR_HANDLE CMeshManager::DepthStencilView()
 {
-	return m_DsvHeap->GetCPUDescriptorHandleForHeapStart();
+	return m_DepthStencilDsv.CpuHandle;
 }
 
-void CMeshManager::Execute_Init_Commands()
+void CMeshManager::Submit_Init_Commands()
 {
+	PROFILE_FUNCTION();
+
 	ThrowIfFailed(m_CommandList->Close());
 	ID3D12CommandList* cmdsLists[] = { m_CommandList.Get() };
 	m_CommandQueue->ExecuteCommandLists(_countof(cmdsLists), cmdsLists);
+}
+
+void CMeshManager::Execute_Init_Commands()
+{
+	PROFILE_FUNCTION();
+
+	Submit_Init_Commands();
 
 	FlushCommandQueue();
 }
 
+void CMeshManager::Log_Startup_Phase(const char* Name)
+{
+	auto Now = std::chrono::steady_clock::now();
+
+	std::chrono::duration<double, std::milli> PhaseTime = Now - m_PhaseStart;
+	std::chrono::duration<double, std::milli> TotalTime = Now - m_InitStart;
+
+	char Msg[128];
+	sprintf_s(Msg, "Startup: %s %.2f ms, total %.2f ms\n", Name, PhaseTime.count(), TotalTime.count());
+	OutputDebugStringA(Msg);
+
+	m_PhaseStart = Now;
+}
+
+void CMeshManager::Start_Asset_Loads()
+{
+	m_TextureLoad = m_ThreadPool.Submit([this] { m_TextureLoaded = Read_Crate_Texture(); });
+	m_ShaderLoad = m_ThreadPool.Submit([this] { Compile_Shaders(); });
+}
+
+//blocks until Load is done, the time spent here is the part
+//of the load that device creation did not hide
+void CMeshManager::Wait_Asset_Load(std::future<void>& Load, const char* Name)
+{
+	PROFILE_FUNCTION();
+
+	if (!Load.valid())
+		return;
+
+	auto WaitStart = std::chrono::steady_clock::now();
+
+	//rethrows ThrowIfFailed of the worker
+	Load.get();
+
+	std::chrono::duration<double, std::milli> WaitTime = std::chrono::steady_clock::now() - WaitStart;
+
+	char Msg[128];
+	sprintf_s(Msg, "Startup: waited %.2f ms for %s\n", WaitTime.count(), Name);
+	OutputDebugStringA(Msg);
+}
+
 void CMeshManager::Update_ViewPort_And_Scissor()
 {
 	m_ScreenViewport.TopLeftX = 0;
@@ -235,15 +285,7 @@ void CMeshManager::Update_ViewPort_And_Scissor()
 
 void CMeshManager::Create_RenderTargetHeap_And_View_For_Pass1()
 {
-	D3D12_DESCRIPTOR_HEAP_DESC rtvHeapDesc1;
-	rtvHeapDesc1.NumDescriptors = 1;
-	rtvHeapDesc1.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
-	rtvHeapDesc1.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
-	rtvHeapDesc1.NodeMask = 0;
-	ThrowIfFailed(m_d3dDevice->CreateDescriptorHeap(
-		&rtvHeapDesc1, IID_PPV_ARGS(m_RtvHeapRTTex.GetAddressOf())));
-
-	m_RTVTexHandle = CD3DX12_CPU_DESCRIPTOR_HANDLE(m_RtvHeapRTTex->GetCPUDescriptorHandleForHeapStart());
+	m_RTVTexHandle = CD3DX12_CPU_DESCRIPTOR_HANDLE(m_RtvHeap.Allocate().CpuHandle);
 
 	D3D12_RESOURCE_DESC textureDesc = {};
 	textureDesc.MipLevels = 1;
@@ -258,134 +300,150 @@ void CMeshManager::Create_RenderTargetHeap_And_View_For_Pass1()
 
 	D3D12_CLEAR_VALUE clearValue = { DXGI_FORMAT_R8G8B8A8_UNORM, {0.0f, 0.125f, 0.3f, 1.0f  } };
 
-	ThrowIfFailed(m_d3dDevice->CreateCommittedResource(
-		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
-		D3D12_HEAP_FLAG_ALLOW_ALL_BUFFERS_AND_TEXTURES,
-		&textureDesc,
-		D3D12_RESOURCE_STATE_RENDER_TARGET,
-		&clearValue,
-		IID_PPV_ARGS(m_RenderTargetTex.GetAddressOf())));
+	//lives as long as the heaps, never freed on its own
+	m_RenderTargetTex = m_GpuMemory.Create_Texture(textureDesc, D3D12_RESOURCE_STATE_RENDER_TARGET, &clearValue).Resource;
 
 	m_d3dDevice->CreateRenderTargetView(m_RenderTargetTex.Get(), nullptr, m_RTVTexHandle);
 }
 
 void CMeshManager::LoadTextures()
 {
+	PROFILE_FUNCTION();
+
 	ThrowIfFailed(m_CommandList->Reset(m_DirectCmdListAlloc.Get(), nullptr));
 
+	Wait_Asset_Load(m_TextureLoad, "texture256.bmp");
+
+	if (!m_TextureLoaded)
+	{
+		MessageBox(NULL, L"Error Open File", L"INFO", MB_OK);
+		return;
+	}
+
 	auto CrateTex = std::make_unique<Texture>();
 	CrateTex->Name = "WoodCrateTex";
 	CrateTex->Filename = L"./texture256.bmp";
 
-	// BMP      
-	FILE* Fp = NULL;
-	fopen_s(&Fp, "texture256.bmp", "rb");
-	if (Fp == NULL)
-		MessageBox(NULL, L"Error Open File", L"INFO", MB_OK);
+	TextureWidth = m_CrateTexFile.Width();
+	TextureHeight = m_CrateTexFile.Height();
 
-	//   
-	BITMAPFILEHEADER Bfh;
-	fread(&Bfh, sizeof(BITMAPFILEHEADER), 1, Fp);
+	CrateTex->Resource = CreateTexture(m_d3dDevice.Get(), m_Upload, m_CrateTexFile);
 
-	//   
-	BITMAPINFOHEADER Bih;
-	fread(&Bih, sizeof(BITMAPINFOHEADER), 1, Fp);
+	//levels are in the staging ring now
+	m_CrateTexFile.Close();
 
-	//   BMP    
-	fseek(Fp, Bfh.bfOffBits, SEEK_SET);
+	m_Textures[CrateTex->Name] = std::move(CrateTex);
+}
+
+//runs on the pool, no D3D calls here
+bool CMeshManager::Read_Crate_Texture()
+{
+	PROFILE_FUNCTION();
 
-	//      BMP 
-	unsigned char* ResTemp;
-	ResTemp = new unsigned char[Bih.biHeight * Bih.biWidth * 3];
-	//   rgb  
-	fread(ResTemp, Bih.biHeight * Bih.biWidth * 3, 1, Fp);
+	auto LoadStart = std::chrono::steady_clock::now();
 
-	//   
-	fclose(Fp);
+	//cooked texture is keyed by the hash of texture256.bmp and the
+	//cook options, on a hit the compressed mip chain goes from
+	//the mapped file straight to the upload heap
+	TextureCookOptions CookOptions;
+	uint64_t SourceKey = 0;
+
+	{
+		CMappedFile Source;
+		if (!Source.Open("texture256.bmp"))
+			return false;
+
+		SourceKey = TextureCookKey(Source.Data(), Source.Size(), CookOptions);
+	}
 
-	TextureWidth = Bih.biWidth;
-	TextureHeight = Bih.biHeight;
+	std::string CacheName = AssetCachePath(ASSET_CACHE_DIR, "texture256", SourceKey, "dds");
 
-	unsigned char* Res = new unsigned char[TextureWidth * TextureHeight * 4];
+	CTextureFile& TexFile = m_CrateTexFile;
+	bool CacheHit = TexFile.Open(CacheName.c_str()) && TexFile.SourceKey() == SourceKey;
 
-	for (UINT i = 0; i < TextureWidth * TextureHeight; i++)
+	if (!CacheHit)
 	{
-		UINT Indx1 = i * 3;
-		UINT Indx2 = i * 4;
+		TexFile.Close();
 
-		Res[Indx2 + 0] = ResTemp[Indx1 + 2];
-		Res[Indx2 + 1] = ResTemp[Indx1 + 1];
-		Res[Indx2 + 2] = ResTemp[Indx1 + 0];
-		Res[Indx2 + 3] = 255;
+		TextureCookStats CookStats;
+
+		if (!CreateAssetCacheDir(ASSET_CACHE_DIR) ||
+			!CookTexture("texture256.bmp", CacheName.c_str(), SourceKey, CookOptions, m_ThreadPool, CookStats) ||
+			!TexFile.Open(CacheName.c_str()))
+			return false;
+
+		const double MegaPixels = CookStats.Width * (double)CookStats.Height / 1000000.0;
+
+		char Msg[256];
+		sprintf_s(Msg, "texture256.bmp: %ux%u, %u levels, decode %.2f ms, mips %.2f ms (%.2f ms/MP), encode %.2f ms (%.2f ms/MP)\n",
+			CookStats.Width, CookStats.Height, CookStats.LevelCount, CookStats.DecodeTime,
+			CookStats.MipTime, CookStats.MipTime / MegaPixels, CookStats.EncodeTime, CookStats.EncodeTime / MegaPixels);
+		OutputDebugStringA(Msg);
+
+		sprintf_s(Msg, "texture256.bmp: format %u, PSNR rgb %.2f dB alpha %.2f dB, %.1f KB -> %.1f KB\n",
+			(UINT)CookStats.Format, CookStats.Psnr.Rgb, CookStats.Psnr.Alpha,
+			CookStats.RawByteSize / 1024.0, CookStats.FileByteSize / 1024.0);
+		OutputDebugStringA(Msg);
 	}
 
-	CrateTex->Resource = CreateTexture(m_d3dDevice.Get(),
-		m_CommandList.Get(), Res, TextureWidth * TextureHeight * 4, CrateTex->UploadHeap);
-	
-	delete[] Res;
+	std::chrono::duration<double, std::milli> LoadTime = std::chrono::steady_clock::now() - LoadStart;
 
-	m_Textures[CrateTex->Name] = std::move(CrateTex);
+	char LoadMsg[256];
+	sprintf_s(LoadMsg, "%s: %s, %.2f ms\n", CacheName.c_str(), CacheHit ? "cache hit" : "cooked", LoadTime.count());
+	OutputDebugStringA(LoadMsg);
+
+	return true;
 }
 
 Microsoft::WRL::ComPtr<ID3D12Resource> CMeshManager::CreateTexture(
 	ID3D12Device* device,
-	ID3D12GraphicsCommandList* cmdList,
-	const void* initData,
-	UINT64 byteSize,
-	Microsoft::WRL::ComPtr<ID3D12Resource>& UploadBuffer)
+	CUploadManager& Upload,
+	const CTextureFile& TexFile)
 {
+	PROFILE_FUNCTION();
+
 	Microsoft::WRL::ComPtr<ID3D12Resource> m_Texture;
+
+	const UINT LevelCount = TexFile.LevelCount();
 	
 	D3D12_RESOURCE_DESC textureDesc = {};
-	textureDesc.MipLevels = 1;
-	textureDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-	textureDesc.Width = TextureWidth;
-	textureDesc.Height = TextureHeight;
+	textureDesc.MipLevels = (UINT16)LevelCount;
+	textureDesc.Format = (DXGI_FORMAT)TexFile.Format();
+	textureDesc.Width = TexFile.Width();
+	textureDesc.Height = TexFile.Height();
 	textureDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
 	textureDesc.DepthOrArraySize = 1;
 	textureDesc.SampleDesc.Count = 1;
 	textureDesc.SampleDesc.Quality = 0;
 	textureDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
 
-	ThrowIfFailed(device->CreateCommittedResource(
-		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
-		D3D12_HEAP_FLAG_NONE,
-		&textureDesc,
-		D3D12_RESOURCE_STATE_COPY_DEST,
-		nullptr,
-		IID_PPV_ARGS(m_Texture.GetAddressOf())));
-
-	const UINT64 UploadBufferSize = GetRequiredIntermediateSize(m_Texture.Get(), 0, 1);
+	//lives as long as the heaps, never freed on its own
+	m_Texture = m_GpuMemory.Create_Texture(textureDesc, D3D12_RESOURCE_STATE_COMMON, nullptr).Resource;
 
-	ThrowIfFailed(device->CreateCommittedResource(
-		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
-		D3D12_HEAP_FLAG_NONE,
-		&CD3DX12_RESOURCE_DESC::Buffer(UploadBufferSize),
-		D3D12_RESOURCE_STATE_GENERIC_READ,
-		nullptr,
-		IID_PPV_ARGS(&UploadBuffer)));
+	//pitches are per row of 4x4 blocks for BC formats
+	D3D12_SUBRESOURCE_DATA SubresourceData[TEXTURE_MAX_MIPS];
 
-	D3D12_SUBRESOURCE_DATA textureData = {};
-	textureData.pData = initData;
-	textureData.RowPitch = TextureWidth * 4;
-	textureData.SlicePitch = textureData.RowPitch * TextureHeight;
+	for (UINT i = 0; i < LevelCount; i++)
+	{
+		const TextureLevel& Level = TexFile.Level(i);
 
-	UpdateSubresources(cmdList, m_Texture.Get(), UploadBuffer.Get(), 0, 0, 1, &textureData);
+		SubresourceData[i].pData = Level.Data;
+		SubresourceData[i].RowPitch = (LONG_PTR)Level.RowPitch;
+		SubresourceData[i].SlicePitch = (LONG_PTR)Level.SlicePitch;
+	}
 
-	cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_Texture.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE));
+	//all levels go in one staging block, COMMON is promoted
+	//to PIXEL_SHADER_RESOURCE when the first draw samples it
+	Upload.UploadTexture(m_Texture.Get(), LevelCount, SubresourceData);
 
 	return m_Texture;
 }
 
 void CMeshManager::Create_ShaderResource_Heap_And_View_Pass1()
 {
-	D3D12_DESCRIPTOR_HEAP_DESC srvHeapDesc = {};
-	srvHeapDesc.NumDescriptors = 1;
-	srvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-	srvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-	ThrowIfFailed(m_d3dDevice->CreateDescriptorHeap(&srvHeapDesc, IID_PPV_ARGS(&m_SrvDescriptorHeap)));
+	m_SceneTexSrv = m_SrvHeap.Allocate();
 
-	CD3DX12_CPU_DESCRIPTOR_HANDLE hDescriptor(m_SrvDescriptorHeap->GetCPUDescriptorHandleForHeapStart());
+	CD3DX12_CPU_DESCRIPTOR_HANDLE hDescriptor(m_SceneTexSrv.CpuHandle);
 
 	auto WoodCrateTex = m_Textures["WoodCrateTex"]->Resource;
 
@@ -403,17 +461,11 @@ void CMeshManager::Create_ShaderResource_Heap_And_View_Pass1()
 
 void CMeshManager::Create_Main_RenderTargetHeap_And_View_Pass2()
 {
-	D3D12_DESCRIPTOR_HEAP_DESC rtvHeapDesc;
-	rtvHeapDesc.NumDescriptors = m_SwapChainBufferCount;
-	rtvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
-	rtvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
-	rtvHeapDesc.NodeMask = 0;
-	ThrowIfFailed(m_d3dDevice->CreateDescriptorHeap(
-		&rtvHeapDesc, IID_PPV_ARGS(m_RtvHeap.GetAddressOf())));
+	m_BackBufferRtv = m_RtvHeap.Allocate(m_SwapChainBufferCount);
 
 	m_CurrBackBuffer = 0;
 
-	CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHeapHandle(m_RtvHeap->GetCPUDescriptorHandleForHeapStart());
+	CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHeapHandle(m_BackBufferRtv.CpuHandle);
 
 	for (UINT i = 0; i < m_SwapChainBufferCount; i++)
 	{
@@ -425,13 +477,9 @@ void CMeshManager::Create_Main_RenderTargetHeap_And_View_Pass2()
 
 void CMeshManager::Create_ShaderRVHeap_And_View_Pass2()
 {
-	D3D12_DESCRIPTOR_HEAP_DESC srvHeapDesc = {};
-	srvHeapDesc.NumDescriptors = 1;
-	srvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-	srvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-	ThrowIfFailed(m_d3dDevice->CreateDescriptorHeap(&srvHeapDesc, IID_PPV_ARGS(&m_SrvDescriptorHeapSAQ)));
+	m_RenderTexSrv = m_SrvHeap.Allocate();
 
-	CD3DX12_CPU_DESCRIPTOR_HANDLE hDescriptor1(m_SrvDescriptorHeapSAQ->GetCPUDescriptorHandleForHeapStart());
+	CD3DX12_CPU_DESCRIPTOR_HANDLE hDescriptor1(m_RenderTexSrv.CpuHandle);
 
 	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
 	srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
@@ -444,11 +492,24 @@ void CMeshManager::Create_ShaderRVHeap_And_View_Pass2()
 	m_d3dDevice->CreateShaderResourceView(m_RenderTargetTex.Get(), &srvDesc, hDescriptor1);
 }
 
-void CMeshManager::Create_Cube_Shaders_And_InputLayout_Pass1()
+//runs on the pool, D3DCompile does not need the device
+void CMeshManager::Compile_Shaders()
 {
+	PROFILE_FUNCTION();
+
 	m_VsByteCode = d3dUtil::CompileShader(L"Shaders\\tex.hlsl", nullptr, "VS", "vs_5_0");
 	m_PsByteCode = d3dUtil::CompileShader(L"Shaders\\tex.hlsl", nullptr, "PS", "ps_5_0");
 
+	m_VsByteCodeSAQ = d3dUtil::CompileShader(L"Shaders\\saq.hlsl", nullptr, "VS", "vs_5_0");
+	m_PsByteCodeSAQ = d3dUtil::CompileShader(L"Shaders\\saq.hlsl", nullptr, "PS", "ps_5_0");
+}
+
+void CMeshManager::Create_Cube_Shaders_And_InputLayout_Pass1()
+{
+	PROFILE_FUNCTION();
+
+	Wait_Asset_Load(m_ShaderLoad, "shaders");
+
 	m_InputLayout =
 	{
 		{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
@@ -458,11 +519,14 @@ void CMeshManager::Create_Cube_Shaders_And_InputLayout_Pass1()
 
 void CMeshManager::Create_Constant_Buffer_Pass1()
 {
-	m_ObjectCB = std::make_unique<UploadBuffer<ObjectConstants>>(m_d3dDevice.Get(), 1, true);
+	for (int i = 0; i < FRAME_RESOURCE_COUNT; i++)
+		m_FrameResources.push_back(std::make_unique<FrameResource>(m_d3dDevice.Get()));
 }
 
 void CMeshManager::Create_Cube_Geometry_Pass1()
 {
+	PROFILE_FUNCTION();
+
 	std::array<Vertex, 24> Vertices =
 	{
 		Vertex({ DirectX::XMFLOAT3(-1.0f, 1.0f, -1.0f), DirectX::XMFLOAT2(0.0f, 0.0f) }),
@@ -523,11 +587,9 @@ void CMeshManager::Create_Cube_Geometry_Pass1()
 	m_Cube = std::make_unique<MeshGeometry>();
 	m_Cube->Name = "Cube";
 
-	m_Cube->VertexBufferGPU = d3dUtil::CreateDefaultBuffer(m_d3dDevice.Get(),
-		m_CommandList.Get(), Vertices.data(), VbByteSize, m_Cube->VertexBufferUploader);
+	m_Cube->VertexBufferGPU = m_Upload.CreateBuffer(Vertices.data(), VbByteSize);
 
-	m_Cube->IndexBufferGPU = d3dUtil::CreateDefaultBuffer(m_d3dDevice.Get(),
-		m_CommandList.Get(), Indices.data(), IbByteSize, m_Cube->IndexBufferUploader);
+	m_Cube->IndexBufferGPU = m_Upload.CreateBuffer(Indices.data(), IbByteSize);
 
 	m_Cube->VertexByteStride = sizeof(Vertex);
 	m_Cube->VertexBufferByteSize = VbByteSize;
@@ -544,6 +606,8 @@ void CMeshManager::Create_Cube_Geometry_Pass1()
 
 void CMeshManager::Create_RootSignature()
 {
+	PROFILE_FUNCTION();
+
 	CD3DX12_ROOT_PARAMETER slotRootParameter[2];
 
 	CD3DX12_DESCRIPTOR_RANGE cbvTable;
@@ -573,6 +637,9 @@ void CMeshManager::Create_RootSignature()
 		SerializedRootSig->GetBufferPointer(),
 		SerializedRootSig->GetBufferSize(),
 		IID_PPV_ARGS(&m_RootSignature)));
+
+	m_PipelineCache.Add_Root_Signature(m_RootSignature.Get(),
+		SerializedRootSig->GetBufferPointer(), SerializedRootSig->GetBufferSize());
 }
 
 std::array<const CD3DX12_STATIC_SAMPLER_DESC, 6> CMeshManager::GetStaticSamplers()
@@ -631,6 +698,8 @@ std::array<const CD3DX12_STATIC_SAMPLER_DESC, 6> CMeshManager::GetStaticSamplers
 
 void CMeshManager::Create_PipelineStateObject_Pass1()
 {
+	PROFILE_FUNCTION();
+
 	D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc;
 	ZeroMemory(&psoDesc, sizeof(D3D12_GRAPHICS_PIPELINE_STATE_DESC));
 	psoDesc.InputLayout = { m_InputLayout.data(), (UINT)m_InputLayout.size() };
@@ -655,13 +724,15 @@ void CMeshManager::Create_PipelineStateObject_Pass1()
 	psoDesc.SampleDesc.Count = m_4xMsaaState ? 4 : 1;
 	psoDesc.SampleDesc.Quality = m_4xMsaaState ? (m_4xMsaaQuality - 1) : 0;
 	psoDesc.DSVFormat = m_DepthStencilFormat;
-	ThrowIfFailed(m_d3dDevice->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&m_PSO)));
+	m_PSO = m_PipelineCache.Create_Graphics(psoDesc);
 }
 
 void CMeshManager::Create_ScreenAlignedQuad_Shaders_And_InputLayout_Pass2()
 {
-	m_VsByteCodeSAQ = d3dUtil::CompileShader(L"Shaders\\saq.hlsl", nullptr, "VS", "vs_5_0");
-	m_PsByteCodeSAQ = d3dUtil::CompileShader(L"Shaders\\saq.hlsl", nullptr, "PS", "ps_5_0");
+	PROFILE_FUNCTION();
+
+	//compiled with the pass 1 shaders in Compile_Shaders
+	Wait_Asset_Load(m_ShaderLoad, "shaders");
 
 	m_InputLayoutSAQ =
 	{
@@ -671,6 +742,8 @@ void CMeshManager::Create_ScreenAlignedQuad_Shaders_And_InputLayout_Pass2()
 
 void CMeshManager::Create_ScreenAlignedQuad_Geometry_Pass2()
 {
+	PROFILE_FUNCTION();
+
 	std::array<VertexSAQ, 4> VerticesSAQ =
 	{
 		VertexSAQ({ DirectX::XMFLOAT3(1.0f,   1.0f, 0.5f) }),
@@ -684,8 +757,7 @@ void CMeshManager::Create_ScreenAlignedQuad_Geometry_Pass2()
 	m_SQABuff = std::make_unique<MeshGeometry>();
 	m_SQABuff->Name = "SAQ";
 	
-	m_SQABuff->VertexBufferGPU = d3dUtil::CreateDefaultBuffer(m_d3dDevice.Get(),
-		m_CommandList.Get(), VerticesSAQ.data(), vbSAQByteSize, m_SQABuff->VertexBufferUploader);
+	m_SQABuff->VertexBufferGPU = m_Upload.CreateBuffer(VerticesSAQ.data(), vbSAQByteSize);
 
 	m_SQABuff->VertexByteStride = sizeof(VertexSAQ);
 	m_SQABuff->VertexBufferByteSize = vbSAQByteSize;
@@ -693,6 +765,8 @@ void CMeshManager::Create_ScreenAlignedQuad_Geometry_Pass2()
 
 void CMeshManager::Create_PipelineStateObject_Pass2()
 {
+	PROFILE_FUNCTION();
+
 	D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc_SAQ;
 	ZeroMemory(&psoDesc_SAQ, sizeof(D3D12_GRAPHICS_PIPELINE_STATE_DESC));
 	psoDesc_SAQ.InputLayout = { m_InputLayoutSAQ.data(), (UINT)m_InputLayoutSAQ.size() };
@@ -717,13 +791,13 @@ void CMeshManager::Create_PipelineStateObject_Pass2()
 	psoDesc_SAQ.SampleDesc.Count = m_4xMsaaState ? 4 : 1;
 	psoDesc_SAQ.SampleDesc.Quality = m_4xMsaaState ? (m_4xMsaaQuality - 1) : 0;
 	psoDesc_SAQ.DSVFormat = m_DepthStencilFormat;
-	ThrowIfFailed(m_d3dDevice->CreateGraphicsPipelineState(&psoDesc_SAQ, IID_PPV_ARGS(&m_PSOSAQ)));
+	m_PSOSAQ = m_PipelineCache.Create_Graphics(psoDesc_SAQ);
 }
 
 D3D12_CPU_DESCRIPTOR_HANDLE CMeshManager::CurrentBackBufferView()
 {
 	return CD3DX12_CPU_DESCRIPTOR_HANDLE(
-		m_RtvHeap->GetCPUDescriptorHandleForHeapStart(),
+		m_BackBufferRtv.CpuHandle,
 		m_CurrBackBuffer,
 		m_RtvDescriptorSize);
 }
@@ -735,12 +809,34 @@ ID3D12Resource* CMeshManager::CurrentBackBuffer()
 
 void CMeshManager::Init_MeshManager(HWND hWnd)
 {
+	PROFILE_THREAD_NAME("Main");
+	PROFILE_FUNCTION();
+
 	m_hWnd = hWnd;
 
+	m_InitStart = m_PhaseStart = std::chrono::steady_clock::now();
+
+	//texture is hashed, read or cooked and shaders compiled on
+	//the pool while the device, swap chain and heaps are made
+	Start_Asset_Loads();
+
 	EnableDebugLayer_CreateFactory();
 
 	Create_Device();
 
+	//the adapter of the device, for the pipeline cache id
+	//and the memory budget
+	Microsoft::WRL::ComPtr<IDXGIAdapter> Adapter;
+	m_dxgiFactory->EnumAdapterByLuid(m_d3dDevice->GetAdapterLuid(), IID_PPV_ARGS(&Adapter));
+
+	m_PipelineCache.Init(m_d3dDevice.Get(), Adapter.Get(), PIPELINE_CACHE_FILE);
+
+	m_GpuMemory.Init(m_d3dDevice.Get(), Adapter.Get());
+
+	m_Upload.Init(m_d3dDevice.Get(), &m_GpuMemory, UPLOAD_RING_SIZE);
+
+	Log_Startup_Phase("device");
+
 	CreateFence_GetDescriptorsSize();
 
 	Check_Multisample_Quality();
@@ -753,7 +849,10 @@ void CMeshManager::Init_MeshManager(HWND hWnd)
 
 	Create_Dsv_DescriptorHeaps_And_View();
 
-	Execute_Init_Commands();
+	//depth buffer barrier, the only fence wait is after the uploads
+	Submit_Init_Commands();
+
+	Log_Startup_Phase("swap chain and heaps");
 
 	Update_ViewPort_And_Scissor();
 
@@ -761,6 +860,8 @@ void CMeshManager::Init_MeshManager(HWND hWnd)
 
 	LoadTextures();
 
+	Log_Startup_Phase("textures");
+
 	Create_ShaderResource_Heap_And_View_Pass1();
 
 	Create_Main_RenderTargetHeap_And_View_Pass2();
@@ -783,8 +884,31 @@ void CMeshManager::Init_MeshManager(HWND hWnd)
 
 	Create_PipelineStateObject_Pass2();
 
+	//the next run loads what was compiled here
+	m_PipelineCache.Save();
+	m_PipelineCache.Log_Stats();
+
+	Log_Startup_Phase("shaders, geometry and pipeline states");
+
+	//copies run on the copy queue, the first frame waits for them
+	m_Upload.Submit();
+
 	Execute_Init_Commands();
 
+	Log_Startup_Phase("gpu init");
+
+	m_GpuMemory.Log_Stats();
+
+#ifdef GPU_MEMORY_BENCHMARK
+	TlsfBenchResult Bench = BenchmarkTlsf(256ull * 1024 * 1024, 1000000, 1);
+
+	char Msg[256];
+	sprintf_s(Msg, "TLSF %u calls: allocate %.1f ns, free %.1f ns, %u failed, peak %.1f MB, fragmentation %.2f\n",
+		Bench.Operations, Bench.AllocateTime, Bench.FreeTime, Bench.Failed,
+		Bench.PeakUsed / (1024.0 * 1024.0), Bench.Fragmentation);
+	OutputDebugStringA(Msg);
+#endif
+
 	DirectX::XMVECTOR Pos = DirectX::XMVectorSet(0, 0.0f, -8.0f, 1.0f);
 	DirectX::XMVECTOR Target = DirectX::XMVectorZero();
 	DirectX::XMVECTOR Up = DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
@@ -795,11 +919,20 @@ void CMeshManager::Init_MeshManager(HWND hWnd)
 	DirectX::XMMATRIX MatProj = DirectX::XMMatrixPerspectiveFovLH(0.25f * DirectX::XM_PI, 4.0f / 3.0f, 1.0f, 1000.0f);
 	XMStoreFloat4x4(&m_Proj, MatProj);
 	
+#ifdef FRAME_TIME_COMPARE
+	//the 30 fps cap would hide the difference
+	m_Timer.TimerStart(0);
+#else
 	m_Timer.TimerStart(30);
+#endif
 }
 
 void CMeshManager::Update_MeshManager()
 {
+	PROFILE_FUNCTION();
+
+	Next_Frame_Resource();
+
 	m_Timer.CalculateFPS();
 	float ElapsedTime = m_Timer.GetElaspedTime();
 
@@ -830,14 +963,17 @@ void CMeshManager::Update_MeshManager()
 
 	DirectX::XMStoreFloat4x4(&ObjConstants.WorldViewProj, DirectX::XMMatrixTranspose(WorldViewProj));
 	
-	m_ObjectCB->CopyData(0, ObjConstants);
+	m_ObjectCBAddress = m_CurrFrameResource->Constants.Push(ObjConstants);
 }
 
 void CMeshManager::Draw_MeshManager()
 {
-	ThrowIfFailed(m_DirectCmdListAlloc->Reset());
+	PROFILE_FUNCTION();
 
-	ThrowIfFailed(m_CommandList->Reset(m_DirectCmdListAlloc.Get(), m_PSO.Get()));
+	//the GPU is done with this allocator, Next_Frame_Resource waited for it
+	ThrowIfFailed(m_CurrFrameResource->CmdListAlloc->Reset());
+
+	ThrowIfFailed(m_CommandList->Reset(m_CurrFrameResource->CmdListAlloc.Get(), m_PSO.Get()));
 
 	m_CommandList->RSSetViewports(1, &m_ScreenViewport);
 	m_CommandList->RSSetScissorRects(1, &m_ScissorRect);
@@ -854,12 +990,13 @@ void CMeshManager::Draw_MeshManager()
 
 	m_CommandList->SetGraphicsRootSignature(m_RootSignature.Get());
 
-	ID3D12DescriptorHeap* descriptorHeaps[] = { m_SrvDescriptorHeap.Get() };
+	//the only heap switch of the frame, both passes use this heap
+	ID3D12DescriptorHeap* descriptorHeaps[] = { m_SrvHeap.Heap() };
 	m_CommandList->SetDescriptorHeaps(_countof(descriptorHeaps), descriptorHeaps);
 
-	m_CommandList->SetGraphicsRootDescriptorTable(0, m_SrvDescriptorHeap->GetGPUDescriptorHandleForHeapStart());
+	m_CommandList->SetGraphicsRootDescriptorTable(0, m_SceneTexSrv.GpuHandle);
 
-	D3D12_GPU_VIRTUAL_ADDRESS cbAddress = m_ObjectCB->Resource()->GetGPUVirtualAddress();
+	D3D12_GPU_VIRTUAL_ADDRESS cbAddress = m_ObjectCBAddress;
 	m_CommandList->SetGraphicsRootConstantBufferView(1, cbAddress);
 
 	m_CommandList->IASetVertexBuffers(0, 1, &m_Cube->VertexBufferView());
@@ -890,10 +1027,7 @@ void CMeshManager::Draw_MeshManager()
 
 	m_CommandList->SetGraphicsRootSignature(m_RootSignature.Get());
 
-	ID3D12DescriptorHeap* descriptorHeapsSAQ[] = { m_SrvDescriptorHeapSAQ.Get() };
-	m_CommandList->SetDescriptorHeaps(_countof(descriptorHeapsSAQ), descriptorHeapsSAQ);
-
-	m_CommandList->SetGraphicsRootDescriptorTable(0, m_SrvDescriptorHeapSAQ->GetGPUDescriptorHandleForHeapStart());
+	m_CommandList->SetGraphicsRootDescriptorTable(0, m_RenderTexSrv.GpuHandle);
 
 	m_CommandList->IASetVertexBuffers(0, 1, &m_SQABuff->VertexBufferView());
 	m_CommandList->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
@@ -909,6 +1043,9 @@ void CMeshManager::Draw_MeshManager()
 
 	ThrowIfFailed(m_CommandList->Close());
 
+	//no-op unless there were uploads since the last frame
+	m_Upload.Queue_Wait(m_CommandQueue.Get());
+
 	ID3D12CommandList* cmdsLists[] = { m_CommandList.Get() };
 	m_CommandQueue->ExecuteCommandLists(_countof(cmdsLists), cmdsLists);
 
@@ -916,7 +1053,60 @@ void CMeshManager::Draw_MeshManager()
 
 	m_CurrBackBuffer = (m_CurrBackBuffer + 1) % m_SwapChainBufferCount;
 
-	FlushCommandQueue();
+	//no wait here, the frame resource is reused once the GPU gets to this fence
+	m_CurrFrameResource->Fence = m_Fence.Signal(m_CommandQueue.Get());
+
+#ifdef FRAME_TIME_COMPARE
+	Compare_Frame_Time();
+#endif
+}
+
+void CMeshManager::Next_Frame_Resource()
+{
+	PROFILE_FUNCTION();
+
+	m_CurrFrameResourceIndex = (m_CurrFrameResourceIndex + 1) % FRAME_RESOURCE_COUNT;
+	m_CurrFrameResource = m_FrameResources[m_CurrFrameResourceIndex].get();
+
+	//blocks only if the CPU is FRAME_RESOURCE_COUNT frames ahead of the GPU
+	m_Fence.Wait(m_CurrFrameResource->Fence);
+
+	//the GPU has read every block of that frame
+	m_CurrFrameResource->Constants.Reset();
+}
+
+void CMeshManager::Compare_Frame_Time()
+{
+	//the old way, CPU waits for the GPU to go idle every frame
+	if (m_CompareFlush)
+		FlushCommandQueue();
+
+	auto Now = std::chrono::steady_clock::now();
+
+	if (m_CompareFrames++ > 0)
+	{
+		std::chrono::duration<double, std::milli> FrameTime = Now - m_CompareLast;
+		m_CompareFrameTime += FrameTime.count();
+	}
+
+	m_CompareLast = Now;
+
+	if (m_CompareFrames == FRAME_COMPARE_FRAMES)
+	{
+		char Msg[128];
+		if (m_CompareFlush)
+			sprintf_s(Msg, "Frames: flush per frame, %.3f ms per frame, %.3f ms waiting for the GPU\n",
+				m_CompareFrameTime / (FRAME_COMPARE_FRAMES - 1), m_Fence.Blocked_Time() / FRAME_COMPARE_FRAMES);
+		else
+			sprintf_s(Msg, "Frames: %d in flight, %.3f ms per frame, %.3f ms waiting for the GPU\n",
+				FRAME_RESOURCE_COUNT, m_CompareFrameTime / (FRAME_COMPARE_FRAMES - 1), m_Fence.Blocked_Time() / FRAME_COMPARE_FRAMES);
+		OutputDebugStringA(Msg);
+
+		m_CompareFlush = !m_CompareFlush;
+		m_CompareFrames = 0;
+		m_CompareFrameTime = 0.0;
+		m_Fence.Reset_Stats();
+	}
 }
 
 
@@ -22,67 +22,53 @@
 #include <array>
 #include <unordered_map>
 #include <DirectXCollision.h>
+#include <chrono>
 
 #include <directxmath.h>
 
 #include "d3dUtil.h"
+#include "ConstantAllocator.h"
+#include "GpuFence.h"
+#include "Profiler.h"
+#include "PipelineCache.h"
 
 #include "Timer.h"
 
-#pragma comment(lib,"d3dcompiler.lib")
-#pragma comment(lib, "D3D12.lib")
-#pragma comment(lib, "dxgi.lib")
+#include "MappedFile.h"
+#include "BmpDecoder.h"
+#include "TextureFile.h"
+#include "GpuMemory.h"
+#include "UploadManager.h"
+#include "DescriptorHeap.h"
 
-template<typename T>
-class UploadBuffer
-{
-public:
-	UploadBuffer(ID3D12Device* device, UINT elementCount, bool isConstantBuffer) :
-		mIsConstantBuffer(isConstantBuffer)
-	{
-		mElementByteSize = sizeof(T);
+//staging ring of the copy queue, bigger copies get their own buffer
+#define UPLOAD_RING_SIZE (8 * 1024 * 1024)
 
-		if (isConstantBuffer)
-			mElementByteSize = d3dUtil::CalcConstantBufferByteSize(sizeof(T));
+//times the TLSF allocator of the GPU heaps at startup
+//#define GPU_MEMORY_BENCHMARK
 
-		ThrowIfFailed(device->CreateCommittedResource(
-			&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
-			D3D12_HEAP_FLAG_NONE,
-			&CD3DX12_RESOURCE_DESC::Buffer(mElementByteSize * elementCount),
-			D3D12_RESOURCE_STATE_GENERIC_READ,
-			nullptr,
-			IID_PPV_ARGS(&mUploadBuffer)));
+//frames the CPU may record ahead of the GPU, 2 or 3
+#define FRAME_RESOURCE_COUNT 3
 
-		ThrowIfFailed(mUploadBuffer->Map(0, nullptr, reinterpret_cast<void**>(&mMappedData)));
-	}
-
-	UploadBuffer(const UploadBuffer& rhs) = delete;
-	UploadBuffer& operator=(const UploadBuffer& rhs) = delete;
-	~UploadBuffer()
-	{
-		if (mUploadBuffer != nullptr)
-			mUploadBuffer->Unmap(0, nullptr);
-
-		mMappedData = nullptr;
-	}
+//constant blocks one frame can allocate, in bytes
+#define FRAME_CONSTANT_SIZE (64 * 1024)
 
-	ID3D12Resource* Resource()const
-	{
-		return mUploadBuffer.Get();
-	}
+//descriptors of the one shader visible heap, both tables live
+//as long as their textures, so no transient part
+#define SRV_HEAP_PERSISTENT 256
 
-	void CopyData(int elementIndex, const T& data)
-	{
-		memcpy(&mMappedData[elementIndex * mElementByteSize], &data, sizeof(T));
-	}
+//CPU only heaps of the render target and depth views
+#define RTV_HEAP_SIZE 16
+#define DSV_HEAP_SIZE 4
 
-private:
-	Microsoft::WRL::ComPtr<ID3D12Resource> mUploadBuffer;
-	BYTE* mMappedData = nullptr;
+//switches between a flush per frame and frames in flight every
+//FRAME_COMPARE_FRAMES frames and logs the frame time of each
+//#define FRAME_TIME_COMPARE
+#define FRAME_COMPARE_FRAMES 256
 
-	UINT mElementByteSize = 0;
-	bool mIsConstantBuffer = false;
-};
+#pragma comment(lib,"d3dcompiler.lib")
+#pragma comment(lib, "D3D12.lib")
+#pragma comment(lib, "dxgi.lib")
 
 static DirectX::XMFLOAT4X4 Identity4x4()
 {
@@ -122,11 +108,8 @@ struct MeshGeometry
 {
 	std::string Name;
 
-	Microsoft::WRL::ComPtr<ID3D12Resource> VertexBufferGPU = nullptr;
-	Microsoft::WRL::ComPtr<ID3D12Resource> IndexBufferGPU = nullptr;
-
-	Microsoft::WRL::ComPtr<ID3D12Resource> VertexBufferUploader = nullptr;
-	Microsoft::WRL::ComPtr<ID3D12Resource> IndexBufferUploader = nullptr;
+	GpuAllocation VertexBufferGPU;
+	GpuAllocation IndexBufferGPU;
 
 	UINT VertexByteStride = 0;
 	UINT VertexBufferByteSize = 0;
@@ -138,7 +121,7 @@ struct MeshGeometry
 	D3D12_VERTEX_BUFFER_VIEW VertexBufferView()const
 	{
 		D3D12_VERTEX_BUFFER_VIEW vbv;
-		vbv.BufferLocation = VertexBufferGPU->GetGPUVirtualAddress();
+		vbv.BufferLocation = VertexBufferGPU.GpuAddress;
 		vbv.StrideInBytes = VertexByteStride;
 		vbv.SizeInBytes = VertexBufferByteSize;
 
@@ -148,18 +131,12 @@ struct MeshGeometry
 	D3D12_INDEX_BUFFER_VIEW IndexBufferView()const
 	{
 		D3D12_INDEX_BUFFER_VIEW ibv;
-		ibv.BufferLocation = IndexBufferGPU->GetGPUVirtualAddress();
+		ibv.BufferLocation = IndexBufferGPU.GpuAddress;
 		ibv.Format = IndexFormat;
 		ibv.SizeInBytes = IndexBufferByteSize;
 
 		return ibv;
 	}
-
-	void DisposeUploaders()
-	{
-		VertexBufferUploader = nullptr;
-		IndexBufferUploader = nullptr;
-	}
 };
 
 struct Texture
@@ -169,7 +146,28 @@ struct Texture
 	std::wstring Filename;
 
 	Microsoft::WRL::ComPtr<ID3D12Resource> Resource = nullptr;
-	Microsoft::WRL::ComPtr<ID3D12Resource> UploadHeap = nullptr;
+};
+
+//what one frame in flight owns, reused when
+//the GPU has passed Fence
+struct FrameResource
+{
+	FrameResource(ID3D12Device* device)
+	{
+		ThrowIfFailed(device->CreateCommandAllocator(
+			D3D12_COMMAND_LIST_TYPE_DIRECT,
+			IID_PPV_ARGS(CmdListAlloc.GetAddressOf())));
+
+		Constants.Init(device, FRAME_CONSTANT_SIZE);
+	}
+
+	FrameResource(const FrameResource& rhs) = delete;
+	FrameResource& operator=(const FrameResource& rhs) = delete;
+
+	Microsoft::WRL::ComPtr<ID3D12CommandAllocator> CmdListAlloc;
+	CConstantAllocator Constants;
+
+	UINT64 Fence = 0;
 };
 
 class CMeshManager
@@ -182,6 +180,9 @@ public:
 	void Update_MeshManager();
 	void Draw_MeshManager();
 
+	//frame time percentiles to the debug output and files
+	void Export_Frame_Stats();
+
 private:
 	void EnableDebugLayer_CreateFactory();
 	void Create_Device();
@@ -191,18 +192,24 @@ private:
 	void Create_SwapChain();
 	void Resize_SwapChainBuffers();
 	void FlushCommandQueue();
+	void Next_Frame_Resource();
+	void Compare_Frame_Time();
 	void Create_Dsv_DescriptorHeaps_And_View();
 	D3D12_CPU_DESCRIPTOR_HANDLE DepthStencilView();
+	void Submit_Init_Commands();
 	void Execute_Init_Commands();
+	void Log_Startup_Phase(const char* Name);
+	void Start_Asset_Loads();
+	void Wait_Asset_Load(std::future<void>& Load, const char* Name);
+	bool Read_Crate_Texture();
+	void Compile_Shaders();
 	void Update_ViewPort_And_Scissor();
 	void Create_RenderTargetHeap_And_View_For_Pass1();
 	void LoadTextures();
 	Microsoft::WRL::ComPtr<ID3D12Resource> CreateTexture(
 		ID3D12Device* device,
-		ID3D12GraphicsCommandList* cmdList,
-		const void* initData,
-		UINT64 byteSize,
-		Microsoft::WRL::ComPtr<ID3D12Resource>& UploadBuffer);
+		CUploadManager& Upload,
+		const CTextureFile& TexFile);
 	void Create_ShaderResource_Heap_And_View_Pass1();
 	void Create_Main_RenderTargetHeap_And_View_Pass2();
 	void Create_ShaderRVHeap_And_View_Pass2();
@@ -222,12 +229,24 @@ private:
 	
 	Microsoft::WRL::ComPtr<IDXGIFactory4> m_dxgiFactory;
 	Microsoft::WRL::ComPtr<ID3D12Device> m_d3dDevice;
-	Microsoft::WRL::ComPtr<ID3D12Fence> m_Fence;
+	CGpuFence m_Fence;
+
+	//pipeline states of the last run, goes before the states it makes
+	CPipelineCache m_PipelineCache;
+
+	//heaps of the placed resources, goes after everything placed in it
+	CGpuMemory m_GpuMemory;
 
 	UINT m_RtvDescriptorSize = 0;
 	UINT m_DsvDescriptorSize = 0;
 	UINT m_CbvSrvUavDescriptorSize = 0;
 
+	//every view of the sample, SetDescriptorHeaps is called
+	//once per command list
+	CDescriptorHeap m_SrvHeap;
+	CDescriptorHeap m_RtvHeap;
+	CDescriptorHeap m_DsvHeap;
+
 	DXGI_FORMAT m_BackBufferFormat = DXGI_FORMAT_R8G8B8A8_UNORM;
 
 	bool      m_4xMsaaState = false;
@@ -237,6 +256,9 @@ private:
 	Microsoft::WRL::ComPtr<ID3D12CommandAllocator> m_DirectCmdListAlloc;
 	Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> m_CommandList;
 
+	//vertex, index and texture data go through the copy queue
+	CUploadManager m_Upload;
+
 	Microsoft::WRL::ComPtr<IDXGISwapChain> m_SwapChain;
 
 	int m_ClientWidth = 800;
@@ -246,36 +268,46 @@ private:
 
 	Microsoft::WRL::ComPtr<ID3D12Resource> m_SwapChainBuffer[m_SwapChainBufferCount];
 	Microsoft::WRL::ComPtr<ID3D12Resource> m_DepthStencilBuffer;
+	GpuAllocation m_DepthStencilMemory;
 
 	HWND m_hWnd;
 
-	UINT64 m_CurrentFence = 0;
-
 	DXGI_FORMAT m_DepthStencilFormat = DXGI_FORMAT_D24_UNORM_S8_UINT;
 
-	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> m_DsvHeap;
+	DescriptorRange m_DepthStencilDsv;
 
 	D3D12_VIEWPORT m_ScreenViewport;
 	D3D12_RECT m_ScissorRect;
 
 	Microsoft::WRL::ComPtr<ID3D12Resource> m_RenderTargetTex;
 	CD3DX12_CPU_DESCRIPTOR_HANDLE m_RTVTexHandle;
-	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> m_RtvHeapRTTex;
 
 	std::unordered_map<std::string, std::unique_ptr<Texture>> m_Textures;
 
-	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> m_SrvDescriptorHeap = nullptr;
+	//table of pass 1, the crate texture
+	DescriptorRange m_SceneTexSrv;
 
 	int m_CurrBackBuffer = 0;
-	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> m_RtvHeap;
+	DescriptorRange m_BackBufferRtv;
 
-	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> m_SrvDescriptorHeapSAQ = nullptr;
+	//table of pass 2, the render target texture
+	DescriptorRange m_RenderTexSrv;
 
 	Microsoft::WRL::ComPtr<ID3DBlob> m_VsByteCode = nullptr;
 	Microsoft::WRL::ComPtr<ID3DBlob> m_PsByteCode = nullptr;
 	std::vector<D3D12_INPUT_ELEMENT_DESC> m_InputLayout;
 
-	std::unique_ptr<UploadBuffer<ObjectConstants>> m_ObjectCB = nullptr;
+	std::vector<std::unique_ptr<FrameResource>> m_FrameResources;
+	FrameResource* m_CurrFrameResource = nullptr;
+	int m_CurrFrameResourceIndex = 0;
+
+	//object constants of the current frame
+	D3D12_GPU_VIRTUAL_ADDRESS m_ObjectCBAddress = 0;
+
+	bool m_CompareFlush = false;
+	UINT m_CompareFrames = 0;
+	double m_CompareFrameTime = 0.0;
+	std::chrono::steady_clock::time_point m_CompareLast;
 
 	std::unique_ptr<MeshGeometry> m_Cube = nullptr;
 
@@ -297,6 +329,18 @@ private:
 
 	UINT TextureWidth = 0;
 	UINT TextureHeight = 0;
+
+	std::chrono::steady_clock::time_point m_InitStart;
+	std::chrono::steady_clock::time_point m_PhaseStart;
+
+	//files read on the pool, valid after the matching load is waited for
+	std::future<void> m_TextureLoad;
+	std::future<void> m_ShaderLoad;
+	bool m_TextureLoaded = false;
+	CTextureFile m_CrateTexFile;
+
+	//last member, workers finish before the members they use are gone
+	CThreadPool m_ThreadPool;
 };
 
 #endif
\ No newline at end of file
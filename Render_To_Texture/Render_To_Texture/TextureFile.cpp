@@ -0,0 +1,366 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Texture File DirectX12
+//======================================================================================
+
+#include "TextureFile.h"
+#include "BmpDecoder.h"
+#include "Profiler.h"
+
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <limits>
+#include <vector>
+
+#define DDS_MAGIC 0x20534444		//'DDS '
+#define DDS_FOURCC_DX10 0x30315844	//'DX10'
+
+#define DDSD_CAPS 0x1
+#define DDSD_HEIGHT 0x2
+#define DDSD_WIDTH 0x4
+#define DDSD_PITCH 0x8
+#define DDSD_PIXELFORMAT 0x1000
+#define DDSD_MIPMAPCOUNT 0x20000
+#define DDSD_LINEARSIZE 0x80000
+
+#define DDPF_FOURCC 0x4
+
+#define DDSCAPS_COMPLEX 0x8
+#define DDSCAPS_TEXTURE 0x1000
+#define DDSCAPS_MIPMAP 0x400000
+
+#define DDS_DIMENSION_TEXTURE2D 3
+
+//Reserved1[0] tag, the key goes to Reserved1[1] and Reserved1[2]
+#define DDS_CACHE_TAG 0x4B4F434B	//'KCOK'
+
+struct DdsPixelFormat
+{
+	uint32_t Size;
+	uint32_t Flags;
+	uint32_t FourCC;
+	uint32_t RGBBitCount;
+	uint32_t RBitMask;
+	uint32_t GBitMask;
+	uint32_t BBitMask;
+	uint32_t ABitMask;
+};
+
+struct DdsHeader
+{
+	uint32_t Size;
+	uint32_t Flags;
+	uint32_t Height;
+	uint32_t Width;
+	uint32_t PitchOrLinearSize;
+	uint32_t Depth;
+	uint32_t MipMapCount;
+	uint32_t Reserved1[11];
+	DdsPixelFormat PixelFormat;
+	uint32_t Caps;
+	uint32_t Caps2;
+	uint32_t Caps3;
+	uint32_t Caps4;
+	uint32_t Reserved2;
+};
+
+struct DdsHeaderDxt10
+{
+	uint32_t DxgiFormat;
+	uint32_t ResourceDimension;
+	uint32_t MiscFlag;
+	uint32_t ArraySize;
+	uint32_t MiscFlags2;
+};
+
+//magic, header and DX10 header
+#define DDS_DATA_OFFSET (sizeof(uint32_t) + sizeof(DdsHeader) + sizeof(DdsHeaderDxt10))
+
+static FILE* Open_File(const char* FileName, const char* Mode)
+{
+	FILE* Fp = NULL;
+#ifdef _WIN32
+	fopen_s(&Fp, FileName, Mode);
+#else
+	Fp = fopen(FileName, Mode);
+#endif
+	return Fp;
+}
+
+static bool Is_Block_Format(TextureFormat Format)
+{
+	return Format == TEXTURE_FORMAT_BC1 || Format == TEXTURE_FORMAT_BC3 || Format == TEXTURE_FORMAT_BC7;
+}
+
+static BlockFormat To_Block_Format(TextureFormat Format)
+{
+	if (Format == TEXTURE_FORMAT_BC1)
+		return BLOCK_BC1;
+	if (Format == TEXTURE_FORMAT_BC3)
+		return BLOCK_BC3;
+	return BLOCK_BC7;
+}
+
+uint64_t TextureRowPitch(TextureFormat Format, uint32_t Width)
+{
+	if (Is_Block_Format(Format))
+		return (uint64_t)((Width + 3) / 4) * BlockBytes(To_Block_Format(Format));
+
+	return (uint64_t)Width * 4;
+}
+
+uint32_t TextureRowCount(TextureFormat Format, uint32_t Height)
+{
+	return Is_Block_Format(Format) ? (Height + 3) / 4 : Height;
+}
+
+//fills level sizes and pitches, returns the size of all levels
+static uint64_t Texture_Layout(TextureFormat Format, uint32_t Width, uint32_t Height,
+	uint32_t LevelCount, TextureLevel* Levels)
+{
+	uint64_t Size = 0;
+
+	for (uint32_t i = 0; i < LevelCount; i++)
+	{
+		Levels[i].Width = Width;
+		Levels[i].Height = Height;
+		Levels[i].RowPitch = TextureRowPitch(Format, Width);
+		Levels[i].RowCount = TextureRowCount(Format, Height);
+		Levels[i].SlicePitch = Levels[i].RowPitch * Levels[i].RowCount;
+
+		Size += Levels[i].SlicePitch;
+
+		Width = Width > 1 ? Width / 2 : 1;
+		Height = Height > 1 ? Height / 2 : 1;
+	}
+
+	return Size;
+}
+
+bool CTextureFile::Open(const char* FileName)
+{
+	Close();
+
+	if (!m_File.Open(FileName))
+		return false;
+
+	const unsigned char* Data = m_File.Data();
+	const uint64_t Size = m_File.Size();
+
+	if (Size < DDS_DATA_OFFSET)
+	{
+		Close();
+		return false;
+	}
+
+	uint32_t Magic;
+	memcpy(&Magic, Data, sizeof(Magic));
+
+	DdsHeader Header;
+	memcpy(&Header, Data + sizeof(uint32_t), sizeof(Header));
+
+	DdsHeaderDxt10 Dxt10;
+	memcpy(&Dxt10, Data + sizeof(uint32_t) + sizeof(DdsHeader), sizeof(Dxt10));
+
+	TextureFormat Format = (TextureFormat)Dxt10.DxgiFormat;
+	uint32_t LevelCount = Header.MipMapCount ? Header.MipMapCount : 1;
+
+	if (Magic != DDS_MAGIC ||
+		Header.Size != sizeof(DdsHeader) ||
+		!(Header.PixelFormat.Flags & DDPF_FOURCC) ||
+		Header.PixelFormat.FourCC != DDS_FOURCC_DX10 ||
+		(Format != TEXTURE_FORMAT_RGBA8 && !Is_Block_Format(Format)) ||
+		Dxt10.ResourceDimension != DDS_DIMENSION_TEXTURE2D ||
+		Dxt10.ArraySize != 1 ||
+		Header.Width == 0 || Header.Height == 0 ||
+		LevelCount > TEXTURE_MAX_MIPS ||
+		LevelCount > MipLevelCount(Header.Width, Header.Height))
+	{
+		Close();
+		return false;
+	}
+
+	if (DDS_DATA_OFFSET + Texture_Layout(Format, Header.Width, Header.Height, LevelCount, m_Levels) > Size)
+	{
+		Close();
+		return false;
+	}
+
+	const unsigned char* Level = Data + DDS_DATA_OFFSET;
+
+	for (uint32_t i = 0; i < LevelCount; i++)
+	{
+		m_Levels[i].Data = Level;
+		Level += m_Levels[i].SlicePitch;
+	}
+
+	m_Format = Format;
+	m_Width = Header.Width;
+	m_Height = Header.Height;
+	m_LevelCount = LevelCount;
+
+	if (Header.Reserved1[0] == DDS_CACHE_TAG)
+		m_SourceKey = Header.Reserved1[1] | ((uint64_t)Header.Reserved1[2] << 32);
+
+	return true;
+}
+
+void CTextureFile::Close()
+{
+	m_File.Close();
+	m_Format = TEXTURE_FORMAT_UNKNOWN;
+	m_Width = 0;
+	m_Height = 0;
+	m_LevelCount = 0;
+	m_SourceKey = 0;
+}
+
+bool WriteTextureFile(const char* FileName, TextureFormat Format,
+	const TextureLevel* Levels, uint32_t LevelCount, uint64_t SourceKey)
+{
+	if (LevelCount == 0 || LevelCount > TEXTURE_MAX_MIPS)
+		return false;
+
+	DdsHeader Header = {};
+	Header.Size = sizeof(DdsHeader);
+	Header.Flags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT |
+		(Is_Block_Format(Format) ? DDSD_LINEARSIZE : DDSD_PITCH);
+	Header.Height = Levels[0].Height;
+	Header.Width = Levels[0].Width;
+	Header.PitchOrLinearSize = (uint32_t)(Is_Block_Format(Format) ? Levels[0].SlicePitch : Levels[0].RowPitch);
+	Header.MipMapCount = LevelCount;
+	Header.Reserved1[0] = DDS_CACHE_TAG;
+	Header.Reserved1[1] = (uint32_t)SourceKey;
+	Header.Reserved1[2] = (uint32_t)(SourceKey >> 32);
+	Header.PixelFormat.Size = sizeof(DdsPixelFormat);
+	Header.PixelFormat.Flags = DDPF_FOURCC;
+	Header.PixelFormat.FourCC = DDS_FOURCC_DX10;
+	Header.Caps = DDSCAPS_TEXTURE | (LevelCount > 1 ? DDSCAPS_COMPLEX | DDSCAPS_MIPMAP : 0);
+
+	DdsHeaderDxt10 Dxt10 = {};
+	Dxt10.DxgiFormat = Format;
+	Dxt10.ResourceDimension = DDS_DIMENSION_TEXTURE2D;
+	Dxt10.ArraySize = 1;
+
+	FILE* Fp = Open_File(FileName, "wb");
+	if (Fp == NULL)
+		return false;
+
+	const uint32_t Magic = DDS_MAGIC;
+
+	bool Result = fwrite(&Magic, sizeof(Magic), 1, Fp) == 1 &&
+		fwrite(&Header, sizeof(Header), 1, Fp) == 1 &&
+		fwrite(&Dxt10, sizeof(Dxt10), 1, Fp) == 1;
+
+	for (uint32_t i = 0; i < LevelCount && Result; i++)
+	{
+		const uint64_t RowBytes = TextureRowPitch(Format, Levels[i].Width);
+
+		for (uint32_t Row = 0; Row < Levels[i].RowCount && Result; Row++)
+			Result = fwrite(Levels[i].Data + Row * Levels[i].RowPitch, 1, (size_t)RowBytes, Fp) == RowBytes;
+	}
+
+	fclose(Fp);
+
+	if (!Result)
+		remove(FileName);
+
+	return Result;
+}
+
+static double Elapsed_Ms(std::chrono::steady_clock::time_point Start)
+{
+	std::chrono::duration<double, std::milli> Time = std::chrono::steady_clock::now() - Start;
+	return Time.count();
+}
+
+uint64_t TextureCookKey(const void* Source, size_t SourceSize, const TextureCookOptions& Options)
+{
+	const uint32_t Settings[] = { TEXTURE_COOK_VERSION, (uint32_t)Options.Format,
+		(uint32_t)Options.Quality, Options.Mips, Options.Srgb };
+
+	return AssetCacheKey(Source, SourceSize, Settings, sizeof(Settings));
+}
+
+bool CookTexture(const char* BmpFileName, const char* TexFileName, uint64_t SourceKey,
+	const TextureCookOptions& Options, CThreadPool& Pool, TextureCookStats& Stats)
+{
+	PROFILE_FUNCTION();
+
+	Stats = TextureCookStats();
+
+	auto Start = std::chrono::steady_clock::now();
+
+	CMappedFile BmpFile;
+	BmpInfo Info;
+
+	if (!BmpFile.Open(BmpFileName) || !ParseBmpHeader(BmpFile.Data(), BmpFile.Size(), Info))
+		return false;
+
+	//BC textures need the top level size to be a multiple of 4
+	TextureFormat Format = Options.Format;
+	if (Is_Block_Format(Format) && (Info.Width % 4 != 0 || Info.Height % 4 != 0))
+		Format = TEXTURE_FORMAT_RGBA8;
+
+	MipLevel Mips[TEXTURE_MAX_MIPS];
+	uint32_t LevelCount = Options.Mips ? MipLevelCount(Info.Width, Info.Height) : 1;
+	std::vector<unsigned char> Chain((size_t)MipChainLayout(Info.Width, Info.Height, LevelCount, Mips));
+
+	DecodeBmp(BmpFile.Data(), Info, Chain.data(), Mips[0].RowPitch, true);
+	BmpFile.Close();
+
+	Stats.DecodeTime = Elapsed_Ms(Start);
+	Start = std::chrono::steady_clock::now();
+
+	GenerateMips(Chain.data(), Mips, LevelCount, Options.Srgb, Pool);
+
+	Stats.MipTime = Elapsed_Ms(Start);
+	Start = std::chrono::steady_clock::now();
+
+	TextureLevel Levels[TEXTURE_MAX_MIPS];
+	uint64_t ByteSize = Texture_Layout(Format, Info.Width, Info.Height, LevelCount, Levels);
+
+	std::vector<unsigned char> Blocks;
+
+	if (Is_Block_Format(Format))
+	{
+		Blocks.resize((size_t)ByteSize);
+
+		unsigned char* Level = Blocks.data();
+
+		//levels one by one, block rows of each level run on Pool
+		for (uint32_t i = 0; i < LevelCount; i++)
+		{
+			CompressImage(To_Block_Format(Format), Options.Quality,
+				Chain.data() + Mips[i].Offset, Mips[i].Width, Mips[i].Height, Mips[i].RowPitch,
+				Level, Levels[i].RowPitch, Pool);
+
+			Levels[i].Data = Level;
+			Level += Levels[i].SlicePitch;
+		}
+
+		Stats.EncodeTime = Elapsed_Ms(Start);
+
+		Stats.Psnr = CompressedPsnr(To_Block_Format(Format), Chain.data(), Info.Width, Info.Height,
+			Mips[0].RowPitch, Levels[0].Data, Levels[0].RowPitch);
+	}
+	else
+	{
+		for (uint32_t i = 0; i < LevelCount; i++)
+			Levels[i].Data = Chain.data() + Mips[i].Offset;
+
+		Stats.Psnr.Rgb = Stats.Psnr.Alpha = std::numeric_limits<double>::infinity();
+	}
+
+	Stats.Width = Info.Width;
+	Stats.Height = Info.Height;
+	Stats.LevelCount = LevelCount;
+	Stats.Format = Format;
+	Stats.RawByteSize = Chain.size();
+	Stats.FileByteSize = DDS_DATA_OFFSET + ByteSize;
+
+	std::string TempFileName = std::string(TexFileName) + ".tmp";
+
+	return WriteTextureFile(TempFileName.c_str(), Format, Levels, LevelCount, SourceKey) &&
+		CommitCacheFile(TempFileName.c_str(), TexFileName);
+}
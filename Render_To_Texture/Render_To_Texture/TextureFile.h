@@ -0,0 +1,115 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Texture File DirectX12
+//======================================================================================
+
+#ifndef _TEXTUREFILE_
+#define _TEXTUREFILE_
+
+#include <cstdint>
+#include <cstddef>
+
+#include "MappedFile.h"
+#include "AssetCache.h"
+#include "BlockCompress.h"
+#include "TextureMips.h"
+
+//DDS file with DX10 header, 2D texture with mips,
+//levels go one after another with tight block rows,
+//cache key is kept in the reserved header fields
+
+//bump when the encoders or mip filter change
+#define TEXTURE_COOK_VERSION 3
+
+//DXGI_FORMAT values, the file code does not include d3d12.h
+enum TextureFormat
+{
+	TEXTURE_FORMAT_UNKNOWN = 0,
+	TEXTURE_FORMAT_RGBA8 = 28,
+	TEXTURE_FORMAT_BC1 = 71,
+	TEXTURE_FORMAT_BC3 = 77,
+	TEXTURE_FORMAT_BC7 = 98
+};
+
+//one mip level inside the file, RowPitch is for a row of
+//pixels or 4x4 blocks, RowCount - number of such rows
+struct TextureLevel
+{
+	uint32_t Width = 0;
+	uint32_t Height = 0;
+	const unsigned char* Data = nullptr;
+	uint64_t RowPitch = 0;
+	uint32_t RowCount = 0;
+	uint64_t SlicePitch = 0;
+};
+
+uint64_t TextureRowPitch(TextureFormat Format, uint32_t Width);
+uint32_t TextureRowCount(TextureFormat Format, uint32_t Height);
+
+class CTextureFile
+{
+public:
+	//maps the file and checks headers, returns false if the file
+	//is missing, truncated or has a format this code does not know
+	bool Open(const char* FileName);
+	void Close();
+
+	TextureFormat Format() const { return m_Format; }
+	uint32_t Width() const { return m_Width; }
+	uint32_t Height() const { return m_Height; }
+	uint32_t LevelCount() const { return m_LevelCount; }
+	uint64_t SourceKey() const { return m_SourceKey; }
+
+	const TextureLevel& Level(uint32_t Index) const { return m_Levels[Index]; }
+
+private:
+	CMappedFile m_File;
+	TextureFormat m_Format = TEXTURE_FORMAT_UNKNOWN;
+	uint32_t m_Width = 0;
+	uint32_t m_Height = 0;
+	uint32_t m_LevelCount = 0;
+	uint64_t m_SourceKey = 0;
+	TextureLevel m_Levels[TEXTURE_MAX_MIPS];
+};
+
+//Levels[i].Data with RowPitch from TextureRowPitch
+bool WriteTextureFile(const char* FileName, TextureFormat Format,
+	const TextureLevel* Levels, uint32_t LevelCount, uint64_t SourceKey = 0);
+
+struct TextureCookOptions
+{
+	TextureFormat Format = TEXTURE_FORMAT_BC7;
+	BlockQuality Quality = BLOCK_QUALITY_NORMAL;
+	bool Mips = true;
+	//source colors are sRGB, mips are filtered in linear space
+	bool Srgb = true;
+};
+
+//times in ms, Psnr of the top level in dB
+struct TextureCookStats
+{
+	uint32_t Width = 0;
+	uint32_t Height = 0;
+	uint32_t LevelCount = 0;
+	TextureFormat Format = TEXTURE_FORMAT_UNKNOWN;
+
+	double DecodeTime = 0.0;
+	double MipTime = 0.0;
+	double EncodeTime = 0.0;
+
+	BlockPsnr Psnr;
+
+	uint64_t RawByteSize = 0;
+	uint64_t FileByteSize = 0;
+};
+
+//cache key of a texture, changes with the source bytes,
+//the options and TEXTURE_COOK_VERSION
+uint64_t TextureCookKey(const void* Source, size_t SourceSize, const TextureCookOptions& Options);
+
+//BMP (see BmpDecoder.h) to texture file, rows go bottom up as the
+//samples uv expect, sizes that are not a multiple of 4 stay RGBA8,
+//the file is written next to TexFileName and renamed when complete
+bool CookTexture(const char* BmpFileName, const char* TexFileName, uint64_t SourceKey,
+	const TextureCookOptions& Options, CThreadPool& Pool, TextureCookStats& Stats);
+
+#endif
@@ -0,0 +1,306 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Texture Mips
+//======================================================================================
+
+#include "TextureMips.h"
+#include "Profiler.h"
+
+#include <cmath>
+
+//MIPS_NO_SIMD builds the plain C++ filters only
+#if !defined(MIPS_NO_SIMD) && (defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__))
+#define MIPS_SSE2
+#include <emmintrin.h>
+#endif
+
+//rows per tile, a tile is one ParallelFor item
+#define MIPS_TILE_ROWS 32
+
+//linear to sRGB table size, enough to hit the right byte for dark values too
+#define MIPS_LINEAR_TO_SRGB_SIZE 8192
+
+struct SrgbTables
+{
+	float ToLinear[256];
+	unsigned char ToSrgb[MIPS_LINEAR_TO_SRGB_SIZE + 1];
+
+	SrgbTables()
+	{
+		for (int i = 0; i < 256; i++)
+		{
+			float c = i / 255.0f;
+			ToLinear[i] = c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+		}
+
+		for (int i = 0; i <= MIPS_LINEAR_TO_SRGB_SIZE; i++)
+		{
+			float l = (float)i / MIPS_LINEAR_TO_SRGB_SIZE;
+			float c = l <= 0.0031308f ? l * 12.92f : 1.055f * powf(l, 1.0f / 2.4f) - 0.055f;
+			ToSrgb[i] = (unsigned char)(c * 255.0f + 0.5f);
+		}
+	}
+};
+
+static const SrgbTables& Srgb_Tables()
+{
+	static SrgbTables Tables;
+	return Tables;
+}
+
+uint32_t MipLevelCount(uint32_t Width, uint32_t Height)
+{
+	uint32_t Size = Width > Height ? Width : Height;
+	uint32_t Count = 1;
+
+	while (Size > 1 && Count < TEXTURE_MAX_MIPS)
+	{
+		Size >>= 1;
+		Count++;
+	}
+
+	return Count;
+}
+
+uint64_t MipChainLayout(uint32_t Width, uint32_t Height, uint32_t LevelCount, MipLevel* Levels)
+{
+	uint64_t Offset = 0;
+
+	for (uint32_t i = 0; i < LevelCount; i++)
+	{
+		Levels[i].Width = Width;
+		Levels[i].Height = Height;
+		Levels[i].Offset = Offset;
+		Levels[i].RowPitch = (uint64_t)Width * 4;
+
+		Offset += Levels[i].RowPitch * Height;
+
+		Width = Width > 1 ? Width / 2 : 1;
+		Height = Height > 1 ? Height / 2 : 1;
+	}
+
+	return Offset;
+}
+
+//source texels of one destination texel along one axis, a 2:1 box
+//for even sizes, for odd sizes 3 taps weighted by how much of each
+//texel the destination covers, so every source texel counts equally
+struct MipTaps
+{
+	uint32_t First = 0;
+	uint32_t Count = 0;
+	float Weight[3] = { 0.0f, 0.0f, 0.0f };
+};
+
+static MipTaps Mip_Taps(uint32_t Dst, uint32_t DstSize, uint32_t SrcSize)
+{
+	MipTaps Taps;
+
+	if (SrcSize == 1)
+	{
+		Taps.Count = 1;
+		Taps.Weight[0] = 1.0f;
+	}
+	else if (SrcSize % 2 == 0)
+	{
+		Taps.First = Dst * 2;
+		Taps.Count = 2;
+		Taps.Weight[0] = 0.5f;
+		Taps.Weight[1] = 0.5f;
+	}
+	else
+	{
+		//SrcSize = 2 * DstSize + 1
+		float InvSize = 1.0f / SrcSize;
+
+		Taps.First = Dst * 2;
+		Taps.Count = 3;
+		Taps.Weight[0] = (DstSize - Dst) * InvSize;
+		Taps.Weight[1] = DstSize * InvSize;
+		Taps.Weight[2] = (Dst + 1) * InvSize;
+	}
+
+	return Taps;
+}
+
+//one destination row from RowTaps.Count source Rows
+static void Filter_Row_Unorm(const unsigned char* const* Rows, const MipTaps& RowTaps,
+	uint32_t SrcWidth, unsigned char* Dst, uint32_t DstWidth)
+{
+	uint32_t x = 0;
+
+	//2x2 box, both sizes even
+	if (RowTaps.Count == 2 && SrcWidth == 2 * DstWidth)
+	{
+		const unsigned char* Src0 = Rows[0];
+		const unsigned char* Src1 = Rows[1];
+
+#ifdef MIPS_SSE2
+		//2 destination pixels per step from 4 source pixels of both rows
+		const __m128i Zero = _mm_setzero_si128();
+		const __m128i Round = _mm_set1_epi16(2);
+
+		for (; x + 2 <= DstWidth; x += 2)
+		{
+			__m128i a = _mm_loadu_si128((const __m128i*)(Src0 + x * 8));
+			__m128i b = _mm_loadu_si128((const __m128i*)(Src1 + x * 8));
+
+			//16 bit sums of the pixel pairs going down
+			__m128i Lo = _mm_add_epi16(_mm_unpacklo_epi8(a, Zero), _mm_unpacklo_epi8(b, Zero));
+			__m128i Hi = _mm_add_epi16(_mm_unpackhi_epi8(a, Zero), _mm_unpackhi_epi8(b, Zero));
+
+			//add left and right neighbours, each half holds one 2x2 block
+			Lo = _mm_add_epi16(Lo, _mm_srli_si128(Lo, 8));
+			Hi = _mm_add_epi16(Hi, _mm_srli_si128(Hi, 8));
+
+			__m128i Sum = _mm_unpacklo_epi64(Lo, Hi);
+			Sum = _mm_srli_epi16(_mm_add_epi16(Sum, Round), 2);
+
+			_mm_storel_epi64((__m128i*)(Dst + x * 4), _mm_packus_epi16(Sum, Sum));
+		}
+#endif
+
+		for (; x < DstWidth; x++)
+		{
+			for (int c = 0; c < 4; c++)
+			{
+				uint32_t Sum = Src0[x * 8 + c] + Src0[x * 8 + 4 + c] + Src1[x * 8 + c] + Src1[x * 8 + 4 + c];
+				Dst[x * 4 + c] = (unsigned char)((Sum + 2) >> 2);
+			}
+		}
+
+		return;
+	}
+
+	//odd width or height, up to 3x3 weighted taps
+	for (; x < DstWidth; x++)
+	{
+		MipTaps Cols = Mip_Taps(x, DstWidth, SrcWidth);
+
+		float Sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+		for (uint32_t r = 0; r < RowTaps.Count; r++)
+		{
+			for (uint32_t k = 0; k < Cols.Count; k++)
+			{
+				float w = RowTaps.Weight[r] * Cols.Weight[k];
+				const unsigned char* p = Rows[r] + (Cols.First + k) * 4;
+
+				for (int c = 0; c < 4; c++)
+					Sum[c] += w * p[c];
+			}
+		}
+
+		for (int c = 0; c < 4; c++)
+			Dst[x * 4 + c] = (unsigned char)(Sum[c] + 0.5f);
+	}
+}
+
+static void Filter_Row_Srgb(const unsigned char* const* Rows, const MipTaps& RowTaps,
+	uint32_t SrcWidth, unsigned char* Dst, uint32_t DstWidth)
+{
+	const SrgbTables& Tables = Srgb_Tables();
+
+	for (uint32_t x = 0; x < DstWidth; x++)
+	{
+		MipTaps Cols = Mip_Taps(x, DstWidth, SrcWidth);
+
+#ifdef MIPS_SSE2
+		//rgb through the table, alpha as is, all four channels in one register
+		__m128 Sum = _mm_setzero_ps();
+
+		for (uint32_t r = 0; r < RowTaps.Count; r++)
+		{
+			for (uint32_t k = 0; k < Cols.Count; k++)
+			{
+				const unsigned char* p = Rows[r] + (Cols.First + k) * 4;
+
+				__m128 Texel = _mm_setr_ps(Tables.ToLinear[p[0]], Tables.ToLinear[p[1]],
+					Tables.ToLinear[p[2]], p[3] * (1.0f / 255.0f));
+
+				Sum = _mm_add_ps(Sum, _mm_mul_ps(_mm_set1_ps(RowTaps.Weight[r] * Cols.Weight[k]), Texel));
+			}
+		}
+
+		const __m128 Scale = _mm_setr_ps((float)MIPS_LINEAR_TO_SRGB_SIZE, (float)MIPS_LINEAR_TO_SRGB_SIZE,
+			(float)MIPS_LINEAR_TO_SRGB_SIZE, 255.0f);
+
+		//weights add up to 1 only within rounding
+		Sum = _mm_min_ps(_mm_mul_ps(Sum, Scale), Scale);
+
+		__m128i Index = _mm_cvtps_epi32(Sum);
+
+		alignas(16) int32_t i32[4];
+		_mm_store_si128((__m128i*)i32, Index);
+
+		Dst[x * 4 + 0] = Tables.ToSrgb[i32[0]];
+		Dst[x * 4 + 1] = Tables.ToSrgb[i32[1]];
+		Dst[x * 4 + 2] = Tables.ToSrgb[i32[2]];
+		Dst[x * 4 + 3] = (unsigned char)i32[3];
+#else
+		float Sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+		for (uint32_t r = 0; r < RowTaps.Count; r++)
+		{
+			for (uint32_t k = 0; k < Cols.Count; k++)
+			{
+				float w = RowTaps.Weight[r] * Cols.Weight[k];
+				const unsigned char* p = Rows[r] + (Cols.First + k) * 4;
+
+				for (int c = 0; c < 3; c++)
+					Sum[c] += w * Tables.ToLinear[p[c]];
+
+				Sum[3] += w * p[3];
+			}
+		}
+
+		for (int c = 0; c < 3; c++)
+		{
+			int Index = (int)(Sum[c] * MIPS_LINEAR_TO_SRGB_SIZE + 0.5f);
+			Dst[x * 4 + c] = Tables.ToSrgb[Index < MIPS_LINEAR_TO_SRGB_SIZE ? Index : MIPS_LINEAR_TO_SRGB_SIZE];
+		}
+
+		Dst[x * 4 + 3] = (unsigned char)(Sum[3] < 255.0f ? Sum[3] + 0.5f : 255.0f);
+#endif
+	}
+}
+
+void GenerateMips(unsigned char* Chain, const MipLevel* Levels, uint32_t LevelCount,
+	bool Srgb, CThreadPool& Pool)
+{
+	PROFILE_FUNCTION();
+
+	if (Srgb)
+		Srgb_Tables();
+
+	//levels depend on the previous one, tiles of one level run in parallel
+	for (uint32_t i = 1; i < LevelCount; i++)
+	{
+		const MipLevel& Src = Levels[i - 1];
+		const MipLevel& Dst = Levels[i];
+
+		unsigned TileCount = (Dst.Height + MIPS_TILE_ROWS - 1) / MIPS_TILE_ROWS;
+
+		Pool.ParallelFor(TileCount, [&](unsigned Tile)
+		{
+			uint32_t RowEnd = (Tile + 1) * MIPS_TILE_ROWS;
+			if (RowEnd > Dst.Height)
+				RowEnd = Dst.Height;
+
+			for (uint32_t y = Tile * MIPS_TILE_ROWS; y < RowEnd; y++)
+			{
+				MipTaps RowTaps = Mip_Taps(y, Dst.Height, Src.Height);
+
+				const unsigned char* Rows[3];
+				for (uint32_t r = 0; r < RowTaps.Count; r++)
+					Rows[r] = Chain + Src.Offset + (RowTaps.First + r) * Src.RowPitch;
+
+				unsigned char* Row = Chain + Dst.Offset + y * Dst.RowPitch;
+
+				if (Srgb)
+					Filter_Row_Srgb(Rows, RowTaps, Src.Width, Row, Dst.Width);
+				else
+					Filter_Row_Unorm(Rows, RowTaps, Src.Width, Row, Dst.Width);
+			}
+		}, "Mip Tiles");
+	}
+}
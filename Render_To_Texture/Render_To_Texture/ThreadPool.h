@@ -0,0 +1,47 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Thread Pool
+//======================================================================================
+
+#ifndef _THREADPOOL_
+#define _THREADPOOL_
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <deque>
+#include <vector>
+
+class CThreadPool
+{
+public:
+	//ThreadCount 0 - one worker per hardware thread
+	explicit CThreadPool(unsigned ThreadCount = 0);
+	~CThreadPool();
+
+	CThreadPool(const CThreadPool& rhs) = delete;
+	CThreadPool& operator=(const CThreadPool& rhs) = delete;
+
+	unsigned ThreadCount() const { return (unsigned)m_Threads.size(); }
+
+	//queues Task on a worker thread
+	std::future<void> Submit(std::function<void()> Task);
+
+	//calls Func(0) ... Func(Count - 1) on the workers and the
+	//calling thread, returns when every call has finished, each
+	//thread that takes part records one Name profiler event
+	void ParallelFor(unsigned Count, const std::function<void(unsigned)>& Func,
+		const char* Name = "ParallelFor");
+
+private:
+	void Worker_Loop();
+
+	std::vector<std::thread> m_Threads;
+	std::deque<std::function<void()>> m_Tasks;
+	std::mutex m_Mutex;
+	std::condition_variable m_Cond;
+	bool m_Quit = false;
+};
+
+#endif
@@ -5,8 +5,26 @@
 #ifndef _TIMER_
 #define _TIMER_
 
-#include <Windows.h>
+#include <cstdint>
 
+#include "MonotonicClock.h"
+#include "FramePacer.h"
+#include "FrameHistogram.h"
+
+//pacing error of the frame limit is logged this often, seconds
+#define FRAME_PACER_LOG_SECONDS 10
+
+//frame budget when the frame rate is not limited, and how
+//much longer a frame may take before it counts as over budget
+#define FRAME_BUDGET_FPS 60.0f
+#define FRAME_BUDGET_SLACK_US 1000
+
+//written by Export_Frame_Stats, at shutdown and on F9
+#define FRAME_STATS_CSV "frame_stats.csv"
+#define FRAME_STATS_JSON "frame_stats.json"
+
+//counts in integer clock ticks, seconds are made only when
+//returned, so precision does not drop with uptime
 class CTimer
 {
 public:
@@ -14,29 +32,47 @@ public:
 	void TimerStart(float LimitFPS);
 	int CalculateFPS();
 	float GetElaspedTime();
-	float GetAppTime();
-	float GetAbsoluteTime();
+	double GetAppTime();
+	double GetAbsoluteTime();
+
+	//waits, error and sleep/spin split of the frame limit
+	void Log_Pacer_Stats();
+
+	//p50/p95/p99/max of the frame times and the files above
+	void Export_Frame_Stats();
+	const CFrameHistogram& Frame_Stats() const { return m_FrameStats; }
+
+	//set before TimerStart, the clock must outlive the timer
+	void Set_Clock(const CMonotonicClock* Clock) { m_Clock = Clock; }
 	
 
 private:
+	double To_Seconds(int64_t Ticks) const;
+	int64_t To_Microseconds(int64_t Ticks) const;
+
+	const CMonotonicClock* m_Clock = &CMonotonicClock::System();
+
 	unsigned long   m_FrameRate;
-	float           m_TimeScale;
-	float           m_TimeElapsed;
-    __int64         m_CurrentTime;
-    __int64         m_LastTime;
-	__int64         m_PerfFreq;
+	int64_t         m_CurrentTime;
+	int64_t         m_LastTime;
+	int64_t         m_PerfFreq;
 	
 	unsigned long   m_FPSFrameCount;
-	float           m_FPSTimeElapsed;
+	int64_t         m_FPSTicks;
 	
-	float m_AbsoluteTime;
+	double m_AbsoluteTime;
 	float m_ElapsedTime;
-	float m_AppTime;
+	double m_AppTime;
 
-	__int64 m_StartTime;
-	__int64 m_AppStartTime;
+	int64_t m_StartTime;
+	int64_t m_AppStartTime;
 
 	float m_LimitFPS;
+
+	CFramePacer m_Pacer;
+	int64_t m_PacerLogTicks;
+
+	CFrameHistogram m_FrameStats;
 };
 
 
@@ -0,0 +1,239 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Asset Cache Tests
+//======================================================================================
+
+//HashBytes is checked against the reference xxHash64, values below are
+//from the xxhash library for a generated buffer, the lengths walk every
+//tail path (8, 4 and 1 byte steps) with and without 32 byte stripes
+
+#include "TestCheck.h"
+
+#include "AssetCache.h"
+#include "TextureFile.h"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#define TEST_FILE_NAME "AssetCacheTest.bin"
+#define TEST_TEMP_NAME "AssetCacheTest.bin.tmp"
+#define TEST_DIR_NAME "AssetCacheTestDir"
+
+#define TEST_SEED 0x9E3779B97F4A7C15ull
+
+struct HashVector
+{
+	size_t Length;
+	uint64_t Hash;
+	uint64_t SeededHash;
+};
+
+static const HashVector g_Vectors[] =
+{
+	{    1, 0xa96c7f0ce858bbb7ull, 0x585882422a6165e7ull },
+	{    3, 0xbed43740ee6332bbull, 0x45fa1406538fa168ull },
+	{    4, 0xfa212ae44b3bb23dull, 0xa65107f22943365aull },
+	{    5, 0xd339dcc9ac8e6776ull, 0xf51eda3a20de9b88ull },
+	{    7, 0x2744460dd675d2c0ull, 0xc9b637e2c4599de2ull },
+	{    8, 0x994b676b71ce94ddull, 0xce592d5f53e192ecull },
+	{   11, 0x97f078da7a1a590cull, 0x2fa6f52e418933c2ull },
+	{   12, 0xb92f588ce720786eull, 0xbc37a5ae43141b1aull },
+	{   31, 0x6711d55e306b5d8full, 0x24c4e99ab0404b5eull },
+	{   32, 0x07f7b8e3bc5d6e25ull, 0x046e99bbda1a814bull },
+	{   33, 0x09f85eeb4e1cbe9full, 0xd7fe2bfee6e4cdedull },
+	{   36, 0xe7ac625222f2b655ull, 0x44a51e89fa88bfccull },
+	{   39, 0xb13c137a0fb701c3ull, 0x5fed1b08fdcb15f5ull },
+	{   40, 0xd25150177ba46490ull, 0x09eae257f2239c63ull },
+	{   63, 0xb7c9968c066cb6a5ull, 0xbd457f9ea47180c8ull },
+	{   64, 0x50d4159a0411632eull, 0xa768f350a8e4fcf6ull },
+	{   65, 0xd277176bff863efcull, 0xfe99ab21e40d4b0cull },
+	{  100, 0x9ddada11d3dc2d8full, 0x35546bd9a4779ae4ull },
+	{ 1000, 0x0bf0bdbcc82eb373ull, 0x3ecb5d7b5e7c64cfull },
+};
+
+static std::vector<unsigned char> Make_Buffer(size_t Size)
+{
+	std::vector<unsigned char> Buffer(Size);
+	for (size_t i = 0; i < Size; i++)
+		Buffer[i] = (unsigned char)(i * 131 + 7);
+	return Buffer;
+}
+
+static void Test_Hash_Reference()
+{
+	CHECK(HashBytes("", 0) == 0xef46db3751d8e999ull);
+
+	const char* Text = "Nobody inspects the spammish repetition";
+	CHECK(HashBytes(Text, strlen(Text)) == 0xfbcea83c8a378bf1ull);
+
+	std::vector<unsigned char> Buffer = Make_Buffer(1000);
+
+	for (const HashVector& Vector : g_Vectors)
+	{
+		CHECK(HashBytes(Buffer.data(), Vector.Length) == Vector.Hash);
+		CHECK(HashBytes(Buffer.data(), Vector.Length, TEST_SEED) == Vector.SeededHash);
+	}
+}
+
+static void Test_Hash_Unaligned()
+{
+	//the same bytes at any address hash the same
+	std::vector<unsigned char> Buffer = Make_Buffer(1000);
+	std::vector<unsigned char> Shifted(1000 + 8);
+
+	bool Same = true;
+
+	for (size_t Offset = 1; Offset < 8; Offset++)
+	{
+		memcpy(Shifted.data() + Offset, Buffer.data(), 1000);
+
+		for (const HashVector& Vector : g_Vectors)
+			Same = Same && HashBytes(Shifted.data() + Offset, Vector.Length) == Vector.Hash;
+	}
+
+	CHECK(Same);
+}
+
+static void Test_Cache_Key()
+{
+	std::vector<unsigned char> Source = Make_Buffer(300);
+	const uint32_t Options[] = { 3, 1, 64, 124, 16 };
+
+	const uint64_t Key = AssetCacheKey(Source.data(), Source.size(), Options, sizeof(Options));
+
+	//options hash seeds the source hash
+	CHECK(Key == HashBytes(Source.data(), Source.size(), HashBytes(Options, sizeof(Options))));
+
+	//any changed byte of the source or of the options is another key
+	bool SourceChanges = true;
+	for (size_t i = 0; i < Source.size(); i++)
+	{
+		std::vector<unsigned char> Changed = Source;
+		Changed[i] ^= 0x01;
+		SourceChanges = SourceChanges && AssetCacheKey(Changed.data(), Changed.size(), Options, sizeof(Options)) != Key;
+	}
+	CHECK(SourceChanges);
+
+	bool OptionChanges = true;
+	for (size_t i = 0; i < sizeof(Options); i++)
+	{
+		uint32_t Changed[5];
+		memcpy(Changed, Options, sizeof(Options));
+		((unsigned char*)Changed)[i] ^= 0x80;
+		OptionChanges = OptionChanges && AssetCacheKey(Source.data(), Source.size(), Changed, sizeof(Changed)) != Key;
+	}
+	CHECK(OptionChanges);
+
+	//a source one byte shorter, or options left out
+	CHECK(AssetCacheKey(Source.data(), Source.size() - 1, Options, sizeof(Options)) != Key);
+	CHECK(AssetCacheKey(Source.data(), Source.size(), Options, sizeof(Options) - 4) != Key);
+	CHECK(AssetCacheKey(Source.data(), Source.size(), NULL, 0) != Key);
+}
+
+static void Test_Texture_Cook_Key()
+{
+	//every cook setting is part of the key
+	std::vector<unsigned char> Source = Make_Buffer(500);
+
+	TextureCookOptions Options;
+	const uint64_t Key = TextureCookKey(Source.data(), Source.size(), Options);
+
+	TextureCookOptions Changed = Options;
+	Changed.Format = TEXTURE_FORMAT_BC1;
+	CHECK(TextureCookKey(Source.data(), Source.size(), Changed) != Key);
+
+	Changed = Options;
+	Changed.Quality = BLOCK_QUALITY_HIGH;
+	CHECK(TextureCookKey(Source.data(), Source.size(), Changed) != Key);
+
+	Changed = Options;
+	Changed.Mips = !Options.Mips;
+	CHECK(TextureCookKey(Source.data(), Source.size(), Changed) != Key);
+
+	Changed = Options;
+	Changed.Srgb = !Options.Srgb;
+	CHECK(TextureCookKey(Source.data(), Source.size(), Changed) != Key);
+
+	CHECK(TextureCookKey(Source.data(), Source.size(), Options) == Key);
+}
+
+static void Test_Cache_Path()
+{
+	CHECK(AssetCachePath("Cache", "room", 0x0123456789abcdefull, "mesh") == "Cache/room-0123456789abcdef.mesh");
+	CHECK(AssetCachePath("Cache", "Room", 0x1f, "dds") == "Cache/Room-000000000000001f.dds");
+}
+
+static void Write_File(const char* FileName, const char* Text)
+{
+	FILE* Fp = fopen(FileName, "wb");
+	fwrite(Text, 1, strlen(Text), Fp);
+	fclose(Fp);
+}
+
+static std::string Read_File(const char* FileName)
+{
+	std::string Text;
+
+	FILE* Fp = fopen(FileName, "rb");
+	if (Fp == NULL)
+		return "<missing>";
+
+	char Buffer[256];
+	size_t Read;
+	while ((Read = fread(Buffer, 1, sizeof(Buffer), Fp)) > 0)
+		Text.append(Buffer, Read);
+
+	fclose(Fp);
+
+	return Text;
+}
+
+static void Test_Commit()
+{
+	remove(TEST_FILE_NAME);
+
+	//first entry
+	Write_File(TEST_TEMP_NAME, "first");
+	CHECK(CommitCacheFile(TEST_TEMP_NAME, TEST_FILE_NAME));
+	CHECK(Read_File(TEST_FILE_NAME) == "first");
+	CHECK(Read_File(TEST_TEMP_NAME) == "<missing>");
+
+	//a cook of the same key over an entry already there
+	Write_File(TEST_TEMP_NAME, "second, longer");
+	CHECK(CommitCacheFile(TEST_TEMP_NAME, TEST_FILE_NAME));
+	CHECK(Read_File(TEST_FILE_NAME) == "second, longer");
+	CHECK(Read_File(TEST_TEMP_NAME) == "<missing>");
+
+	//nothing to move, the entry stays as it was
+	CHECK(!CommitCacheFile(TEST_TEMP_NAME, TEST_FILE_NAME));
+	CHECK(Read_File(TEST_FILE_NAME) == "second, longer");
+
+	remove(TEST_FILE_NAME);
+}
+
+static void Test_Create_Dir()
+{
+	CHECK(CreateAssetCacheDir(TEST_DIR_NAME));
+	//already there is fine
+	CHECK(CreateAssetCacheDir(TEST_DIR_NAME));
+
+	std::string Entry = AssetCachePath(TEST_DIR_NAME, "entry", 1, "bin");
+	Write_File(Entry.c_str(), "cooked");
+	CHECK(Read_File(Entry.c_str()) == "cooked");
+
+	remove(Entry.c_str());
+	remove(TEST_DIR_NAME);
+}
+
+int main()
+{
+	RUN_TEST(Test_Hash_Reference);
+	RUN_TEST(Test_Hash_Unaligned);
+	RUN_TEST(Test_Cache_Key);
+	RUN_TEST(Test_Texture_Cook_Key);
+	RUN_TEST(Test_Cache_Path);
+	RUN_TEST(Test_Commit);
+	RUN_TEST(Test_Create_Dir);
+
+	return TEST_RESULT();
+}
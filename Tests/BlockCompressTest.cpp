@@ -0,0 +1,579 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Block Compress Tests
+//======================================================================================
+
+//hand made blocks check the decoders bit for bit, images are
+//encoded and decoded back to check PSNR of each format and quality,
+//a cooked BMP is read back through CTextureFile
+
+#include "TestCheck.h"
+
+#include "TextureFile.h"
+#include "BmpDecoder.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+static const BlockFormat g_Formats[] = { BLOCK_BC1, BLOCK_BC3, BLOCK_BC7 };
+static const BlockQuality g_Qualities[] = { BLOCK_QUALITY_FAST, BLOCK_QUALITY_NORMAL, BLOCK_QUALITY_HIGH };
+
+struct TestImage
+{
+	uint32_t Width = 0;
+	uint32_t Height = 0;
+	std::vector<unsigned char> Rgba;
+};
+
+//smooth color ramps with a ramp in alpha, what block formats are made for
+static TestImage Make_Gradient(uint32_t Width, uint32_t Height)
+{
+	TestImage Image;
+	Image.Width = Width;
+	Image.Height = Height;
+	Image.Rgba.resize((size_t)Width * Height * 4);
+
+	for (uint32_t y = 0; y < Height; y++)
+	{
+		for (uint32_t x = 0; x < Width; x++)
+		{
+			unsigned char* p = &Image.Rgba[((size_t)y * Width + x) * 4];
+			p[0] = (unsigned char)(x * 255 / (Width - 1));
+			p[1] = (unsigned char)(y * 255 / (Height - 1));
+			p[2] = (unsigned char)(255 - (x + y) * 255 / (Width + Height - 2));
+			p[3] = (unsigned char)((x * 3 + y) * 255 / (Width * 3 + Height - 4));
+		}
+	}
+
+	return Image;
+}
+
+//independent noise in every channel, the worst case for 4x4 endpoints
+static TestImage Make_Noise(uint32_t Width, uint32_t Height, uint32_t Seed)
+{
+	TestImage Image;
+	Image.Width = Width;
+	Image.Height = Height;
+	Image.Rgba.resize((size_t)Width * Height * 4);
+
+	std::mt19937 Rng(Seed);
+	for (unsigned char& c : Image.Rgba)
+		c = (unsigned char)(Rng() & 0xFF);
+
+	return Image;
+}
+
+//one pool for all the tests
+static CThreadPool& Test_Pool()
+{
+	static CThreadPool Pool;
+	return Pool;
+}
+
+static std::vector<unsigned char> Read_File(const char* FileName)
+{
+	std::vector<unsigned char> Data;
+
+	FILE* File = fopen(FileName, "rb");
+	if (!File)
+		return Data;
+
+	fseek(File, 0, SEEK_END);
+	Data.resize((size_t)ftell(File));
+	fseek(File, 0, SEEK_SET);
+
+	if (fread(Data.data(), 1, Data.size(), File) != Data.size())
+		Data.clear();
+
+	fclose(File);
+	return Data;
+}
+
+static bool Load_Room(TestImage& Image)
+{
+	std::vector<unsigned char> Data = Read_File(SAMPLE_DIR "/Room.bmp");
+
+	BmpInfo Info;
+	if (!ParseBmpHeader(Data.data(), Data.size(), Info))
+		return false;
+
+	Image.Width = Info.Width;
+	Image.Height = Info.Height;
+	Image.Rgba.resize((size_t)Info.Width * Info.Height * 4);
+	DecodeBmp(Data.data(), Info, Image.Rgba.data(), (uint64_t)Info.Width * 4, true);
+
+	return true;
+}
+
+//24 bit bottom up BMP, alpha is dropped
+static bool Write_Bmp(const char* FileName, const TestImage& Image)
+{
+	const uint32_t RowSize = (Image.Width * 3 + 3) & ~3u;
+	const uint32_t DataSize = RowSize * Image.Height;
+
+	unsigned char Header[54] = {};
+	auto Put32 = [&](int Offset, uint32_t v) { memcpy(Header + Offset, &v, 4); };
+	auto Put16 = [&](int Offset, uint16_t v) { memcpy(Header + Offset, &v, 2); };
+
+	Header[0] = 'B';
+	Header[1] = 'M';
+	Put32(2, 54 + DataSize);
+	Put32(10, 54);
+	Put32(14, 40);
+	Put32(18, Image.Width);
+	Put32(22, Image.Height);
+	Put16(26, 1);
+	Put16(28, 24);
+	Put32(34, DataSize);
+
+	std::vector<unsigned char> Data(DataSize, 0);
+	for (uint32_t y = 0; y < Image.Height; y++)
+	{
+		//file row y is image row y, both go from the bottom up
+		for (uint32_t x = 0; x < Image.Width; x++)
+		{
+			const unsigned char* s = &Image.Rgba[((size_t)y * Image.Width + x) * 4];
+			unsigned char* d = &Data[(size_t)y * RowSize + x * 3];
+			d[0] = s[2];
+			d[1] = s[1];
+			d[2] = s[0];
+		}
+	}
+
+	FILE* File = fopen(FileName, "wb");
+	if (!File)
+		return false;
+
+	bool Ok = fwrite(Header, 1, sizeof(Header), File) == sizeof(Header) &&
+		fwrite(Data.data(), 1, Data.size(), File) == Data.size();
+
+	return fclose(File) == 0 && Ok;
+}
+
+static std::vector<unsigned char> Compress(BlockFormat Format, BlockQuality Quality,
+	const TestImage& Image, uint64_t& BlockRowPitch, CThreadPool& Pool)
+{
+	BlockRowPitch = (uint64_t)(Image.Width + 3) / 4 * BlockBytes(Format);
+
+	std::vector<unsigned char> Blocks((size_t)(BlockRowPitch * ((Image.Height + 3) / 4)));
+	CompressImage(Format, Quality, Image.Rgba.data(), Image.Width, Image.Height, (uint64_t)Image.Width * 4,
+		Blocks.data(), BlockRowPitch, Pool);
+
+	return Blocks;
+}
+
+//PSNR of the rgb channels from a full decoded image, the
+//reference for CompressedPsnr
+static double Decoded_Psnr(BlockFormat Format, const TestImage& Image,
+	const std::vector<unsigned char>& Blocks, uint64_t BlockRowPitch, int FirstChannel, int ChannelCount)
+{
+	std::vector<unsigned char> Decoded(Image.Rgba.size());
+
+	for (uint32_t by = 0; by < (Image.Height + 3) / 4; by++)
+	{
+		for (uint32_t bx = 0; bx < (Image.Width + 3) / 4; bx++)
+		{
+			unsigned char Texels[64];
+			DecodeBlock(Format, &Blocks[(size_t)(by * BlockRowPitch + bx * BlockBytes(Format))], Texels);
+
+			for (uint32_t y = 0; y < 4 && by * 4 + y < Image.Height; y++)
+				for (uint32_t x = 0; x < 4 && bx * 4 + x < Image.Width; x++)
+					memcpy(&Decoded[((size_t)(by * 4 + y) * Image.Width + bx * 4 + x) * 4], &Texels[(y * 4 + x) * 4], 4);
+		}
+	}
+
+	double Error = 0.0;
+	for (size_t i = 0; i < Decoded.size(); i += 4)
+	{
+		for (int c = FirstChannel; c < FirstChannel + ChannelCount; c++)
+		{
+			double d = (double)Image.Rgba[i + c] - Decoded[i + c];
+			Error += d * d;
+		}
+	}
+
+	if (Error == 0.0)
+		return std::numeric_limits<double>::infinity();
+
+	double Mse = Error / ((double)Image.Width * Image.Height * ChannelCount);
+	return 10.0 * log10(255.0 * 255.0 / Mse);
+}
+
+//both lossless or the same dB
+static bool Same_Psnr(double A, double B)
+{
+	if (std::isinf(A) || std::isinf(B))
+		return A == B;
+
+	return fabs(A - B) <= 1e-9;
+}
+
+//
+//hand made blocks
+//
+
+static void Test_BC1_Four_Colors()
+{
+	//c0 = red > c1 = blue, indices 0 1 2 3 over each row
+	unsigned char Block[8] = { 0x00, 0xF8, 0x1F, 0x00, 0xE4, 0xE4, 0xE4, 0xE4 };
+
+	unsigned char Rgba[64];
+	DecodeBlock(BLOCK_BC1, Block, Rgba);
+
+	const int Expected[4][4] = {
+		{ 255, 0, 0, 255 },
+		{ 0, 0, 255, 255 },
+		{ 170, 0, 85, 255 },
+		{ 85, 0, 170, 255 } };
+
+	for (int i = 0; i < 16; i++)
+		for (int c = 0; c < 4; c++)
+			CHECK(Rgba[i * 4 + c] == Expected[i & 3][c]);
+}
+
+static void Test_BC1_Three_Colors()
+{
+	//c0 = blue <= c1 = red picks three colors and transparent black
+	unsigned char Block[8] = { 0x1F, 0x00, 0x00, 0xF8, 0xE4, 0xE4, 0xE4, 0xE4 };
+
+	unsigned char Rgba[64];
+	DecodeBlock(BLOCK_BC1, Block, Rgba);
+
+	const int Expected[4][4] = {
+		{ 0, 0, 255, 255 },
+		{ 255, 0, 0, 255 },
+		{ 128, 0, 128, 255 },
+		{ 0, 0, 0, 0 } };
+
+	for (int i = 0; i < 16; i++)
+		for (int c = 0; c < 4; c++)
+			CHECK(Rgba[i * 4 + c] == Expected[i & 3][c]);
+
+	//the color half of BC3 always has four colors
+	unsigned char Block3[16] = { 255, 255, 0, 0, 0, 0, 0, 0 };
+	memcpy(Block3 + 8, Block, 8);
+	DecodeBlock(BLOCK_BC3, Block3, Rgba);
+
+	for (int i = 0; i < 16; i++)
+		CHECK(Rgba[i * 4 + 3] == 255);
+
+	CHECK(Rgba[3 * 4 + 0] == 170);
+	CHECK(Rgba[3 * 4 + 2] == 85);
+}
+
+static void Test_BC3_Alpha_Block()
+{
+	//a0 = 210 > a1 = 0, eight values, index i goes to pixel i % 8
+	unsigned char Block[16] = { 210, 0 };
+	uint64_t Indices = 0;
+	for (int i = 0; i < 16; i++)
+		Indices |= (uint64_t)(i % 8) << (i * 3);
+	for (int i = 0; i < 6; i++)
+		Block[2 + i] = (unsigned char)(Indices >> (i * 8));
+
+	unsigned char Rgba[64];
+	DecodeBlock(BLOCK_BC3, Block, Rgba);
+
+	const int Eight[8] = { 210, 0, 180, 150, 120, 90, 60, 30 };
+	for (int i = 0; i < 16; i++)
+		CHECK(Rgba[i * 4 + 3] == Eight[i % 8]);
+
+	//a0 <= a1, six values plus 0 and 255
+	Block[0] = 0;
+	Block[1] = 200;
+	DecodeBlock(BLOCK_BC3, Block, Rgba);
+
+	const int Six[8] = { 0, 200, 40, 80, 120, 160, 0, 255 };
+	for (int i = 0; i < 16; i++)
+		CHECK(Rgba[i * 4 + 3] == Six[i % 8]);
+}
+
+//alpha ends stay exact, in between is within half a palette step
+static void Test_BC3_Alpha_Encode()
+{
+	for (BlockQuality Quality : g_Qualities)
+	{
+		unsigned char Rgba[64];
+		for (int i = 0; i < 16; i++)
+		{
+			Rgba[i * 4 + 0] = Rgba[i * 4 + 1] = Rgba[i * 4 + 2] = 128;
+			Rgba[i * 4 + 3] = (unsigned char)(i * 17);
+		}
+
+		unsigned char Block[16];
+		EncodeBlock(BLOCK_BC3, Quality, Rgba, Block);
+
+		unsigned char Decoded[64];
+		DecodeBlock(BLOCK_BC3, Block, Decoded);
+
+		CHECK(Decoded[3] == 0);
+		CHECK(Decoded[15 * 4 + 3] == 255);
+
+		for (int i = 0; i < 16; i++)
+			CHECK(abs(Decoded[i * 4 + 3] - Rgba[i * 4 + 3]) <= 19);
+	}
+}
+
+//one color block comes back within the precision of the endpoints
+static void Test_Solid_Blocks()
+{
+	std::mt19937 Rng(7);
+
+	for (int Run = 0; Run < 200; Run++)
+	{
+		unsigned char Color[4] = { (unsigned char)Rng(), (unsigned char)Rng(), (unsigned char)Rng(), (unsigned char)Rng() };
+
+		unsigned char Rgba[64];
+		for (int i = 0; i < 16; i++)
+			memcpy(Rgba + i * 4, Color, 4);
+
+		for (BlockFormat Format : g_Formats)
+		{
+			for (BlockQuality Quality : g_Qualities)
+			{
+				unsigned char Block[16];
+				EncodeBlock(Format, Quality, Rgba, Block);
+
+				unsigned char Decoded[64];
+				DecodeBlock(Format, Block, Decoded);
+
+				//565 endpoints round to 8 and 4 steps, BC7 is
+				//off by the shared p-bit at most
+				const int Tolerance[3] = {
+					Format == BLOCK_BC7 ? 1 : 4,
+					Format == BLOCK_BC7 ? 1 : 2,
+					Format == BLOCK_BC7 ? 1 : 4 };
+
+				for (int i = 0; i < 16; i++)
+				{
+					for (int c = 0; c < 3; c++)
+						CHECK(abs(Decoded[i * 4 + c] - Color[c]) <= Tolerance[c]);
+
+					if (Format == BLOCK_BC1)
+						CHECK(Decoded[i * 4 + 3] == 255);
+					else if (Format == BLOCK_BC3)
+						CHECK(Decoded[i * 4 + 3] == Color[3]);
+					else
+						CHECK(abs(Decoded[i * 4 + 3] - Color[3]) <= 1);
+				}
+			}
+		}
+	}
+}
+
+//
+//images
+//
+
+//lowest PSNR per format and quality, about 1 dB under what the
+//encoders reach now, alpha per format, BC1 alpha is not checked
+struct PsnrLimit
+{
+	double Rgb[3][3];
+	double Alpha[3];
+};
+
+static void Check_Image(const char* Name, const TestImage& Image, const PsnrLimit& Limit, CThreadPool& Pool)
+{
+	for (int f = 0; f < 3; f++)
+	{
+		double Previous = 0.0;
+
+		for (int q = 0; q < 3; q++)
+		{
+			uint64_t BlockRowPitch;
+			std::vector<unsigned char> Blocks = Compress(g_Formats[f], g_Qualities[q], Image, BlockRowPitch, Pool);
+
+			BlockPsnr Psnr = CompressedPsnr(g_Formats[f], Image.Rgba.data(), Image.Width, Image.Height,
+				(uint64_t)Image.Width * 4, Blocks.data(), BlockRowPitch);
+
+			printf("%s BC%d quality %d: rgb %.2f dB, alpha %.2f dB\n", Name, f == 0 ? 1 : f == 1 ? 3 : 7, q, Psnr.Rgb, Psnr.Alpha);
+
+			CHECK(Psnr.Rgb >= Limit.Rgb[f][q]);
+			CHECK(g_Formats[f] == BLOCK_BC1 || Psnr.Alpha >= Limit.Alpha[f]);
+			CHECK_NEAR(Psnr.Rgb, Decoded_Psnr(g_Formats[f], Image, Blocks, BlockRowPitch, 0, 3), 1e-9);
+
+			if (g_Formats[f] != BLOCK_BC1)
+				CHECK(Same_Psnr(Psnr.Alpha, Decoded_Psnr(g_Formats[f], Image, Blocks, BlockRowPitch, 3, 1)));
+
+			//better quality is never worse
+			CHECK(Psnr.Rgb >= Previous - 0.05);
+			Previous = Psnr.Rgb;
+		}
+	}
+}
+
+static void Test_Gradient_Psnr()
+{
+	CThreadPool& Pool = Test_Pool();
+
+	const PsnrLimit Limit = {
+		{ { 42.3, 42.7, 43.0 }, { 42.3, 42.7, 43.0 }, { 44.5, 48.9, 49.0 } },
+		{ 0.0, 60.0, 47.9 } };
+	Check_Image("gradient", Make_Gradient(256, 128), Limit, Pool);
+}
+
+static void Test_Noise_Psnr()
+{
+	CThreadPool& Pool = Test_Pool();
+
+	const PsnrLimit Limit = {
+		{ { 11.1, 12.6, 12.7 }, { 11.1, 12.6, 12.7 }, { 11.0, 12.3, 12.3 } },
+		{ 0.0, 28.3, 11.1 } };
+	Check_Image("noise", Make_Noise(64, 64, 3), Limit, Pool);
+}
+
+static void Test_Room_Psnr()
+{
+	CThreadPool& Pool = Test_Pool();
+
+	TestImage Room;
+	CHECK(Load_Room(Room));
+	if (Room.Rgba.empty())
+		return;
+
+	const PsnrLimit Limit = {
+		{ { 33.1, 33.7, 34.1 }, { 33.1, 33.7, 34.1 }, { 37.6, 39.1, 39.2 } },
+		{ 0.0, 60.0, 51.6 } };
+	Check_Image("Room.bmp", Room, Limit, Pool);
+}
+
+//odd image sizes, the blocks over the edge repeat the last pixel
+static void Test_Partial_Blocks()
+{
+	CThreadPool& Pool = Test_Pool();
+
+	TestImage Image = Make_Gradient(37, 13);
+
+	for (BlockFormat Format : g_Formats)
+	{
+		uint64_t BlockRowPitch;
+		std::vector<unsigned char> Blocks = Compress(Format, BLOCK_QUALITY_NORMAL, Image, BlockRowPitch, Pool);
+
+		BlockPsnr Psnr = CompressedPsnr(Format, Image.Rgba.data(), Image.Width, Image.Height,
+			(uint64_t)Image.Width * 4, Blocks.data(), BlockRowPitch);
+
+		CHECK(Psnr.Rgb > 30.0);
+		CHECK_NEAR(Psnr.Rgb, Decoded_Psnr(Format, Image, Blocks, BlockRowPitch, 0, 3), 1e-9);
+	}
+}
+
+//
+//cooked files
+//
+
+static void Test_Cook_Round_Trip()
+{
+	CThreadPool& Pool = Test_Pool();
+
+	TestImage Image = Make_Gradient(64, 32);
+	for (size_t i = 3; i < Image.Rgba.size(); i += 4)
+		Image.Rgba[i] = 255;
+
+	CHECK(Write_Bmp("BlockCompressTest.bmp", Image));
+
+	const TextureFormat Formats[3] = { TEXTURE_FORMAT_BC1, TEXTURE_FORMAT_BC3, TEXTURE_FORMAT_BC7 };
+
+	for (int f = 0; f < 3; f++)
+	{
+		TextureCookOptions Options;
+		Options.Format = Formats[f];
+		Options.Srgb = false;
+
+		TextureCookStats Stats;
+		CHECK(CookTexture("BlockCompressTest.bmp", "BlockCompressTest.dds", 0x1234 + f, Options, Pool, Stats));
+		CHECK(Stats.Format == Formats[f]);
+		CHECK(Stats.LevelCount == 7);
+
+		CTextureFile File;
+		CHECK(File.Open("BlockCompressTest.dds"));
+		CHECK(File.Format() == Formats[f]);
+		CHECK(File.Width() == 64 && File.Height() == 32);
+		CHECK(File.LevelCount() == 7);
+		CHECK(File.SourceKey() == 0x1234u + f);
+
+		uint64_t FileBytes = 0;
+		for (uint32_t i = 0; i < File.LevelCount() && i < 7; i++)
+		{
+			const TextureLevel& Level = File.Level(i);
+			uint32_t Width = 64 >> i ? 64 >> i : 1;
+			uint32_t Height = 32 >> i ? 32 >> i : 1;
+
+			CHECK(Level.Width == Width && Level.Height == Height);
+			CHECK(Level.RowPitch == (uint64_t)(Width + 3) / 4 * BlockBytes(g_Formats[f]));
+			CHECK(Level.RowPitch == TextureRowPitch(Formats[f], Width));
+			CHECK(Level.RowCount == (Height + 3) / 4);
+			CHECK(Level.SlicePitch == Level.RowPitch * Level.RowCount);
+			FileBytes += Level.SlicePitch;
+		}
+
+		CHECK(FileBytes + 148 == Stats.FileByteSize);
+
+		//top level decodes to the PSNR the cook printed
+		const TextureLevel& Top = File.Level(0);
+		std::vector<unsigned char> Blocks(Top.Data, Top.Data + Top.SlicePitch);
+		CHECK_NEAR(Stats.Psnr.Rgb, Decoded_Psnr(g_Formats[f], Image, Blocks, Top.RowPitch, 0, 3), 1e-9);
+		CHECK(Stats.Psnr.Rgb > 35.0);
+	}
+
+	remove("BlockCompressTest.dds");
+	remove("BlockCompressTest.bmp");
+}
+
+//sizes that are not a multiple of 4 are stored as is
+static void Test_Cook_Rgba8_Fallback()
+{
+	CThreadPool& Pool = Test_Pool();
+
+	TestImage Image = Make_Noise(30, 18, 11);
+	for (size_t i = 3; i < Image.Rgba.size(); i += 4)
+		Image.Rgba[i] = 255;
+
+	CHECK(Write_Bmp("BlockCompressOdd.bmp", Image));
+
+	TextureCookOptions Options;
+	Options.Format = TEXTURE_FORMAT_BC7;
+
+	TextureCookStats Stats;
+	CHECK(CookTexture("BlockCompressOdd.bmp", "BlockCompressOdd.dds", 1, Options, Pool, Stats));
+	CHECK(Stats.Format == TEXTURE_FORMAT_RGBA8);
+	CHECK(std::isinf(Stats.Psnr.Rgb));
+
+	CTextureFile File;
+	CHECK(File.Open("BlockCompressOdd.dds"));
+	CHECK(File.Format() == TEXTURE_FORMAT_RGBA8);
+	CHECK(File.LevelCount() == 5);
+
+	const TextureLevel& Top = File.Level(0);
+	CHECK(Top.RowPitch == 30 * 4);
+	CHECK(Top.RowCount == 18);
+
+	bool Same = true;
+	for (uint32_t y = 0; y < 18; y++)
+		Same = Same && memcmp(Top.Data + y * Top.RowPitch, &Image.Rgba[(size_t)y * 30 * 4], 30 * 4) == 0;
+	CHECK(Same);
+
+	File.Close();
+	remove("BlockCompressOdd.dds");
+	remove("BlockCompressOdd.bmp");
+}
+
+int main()
+{
+	RUN_TEST(Test_BC1_Four_Colors);
+	RUN_TEST(Test_BC1_Three_Colors);
+	RUN_TEST(Test_BC3_Alpha_Block);
+	RUN_TEST(Test_BC3_Alpha_Encode);
+	RUN_TEST(Test_Solid_Blocks);
+	RUN_TEST(Test_Gradient_Psnr);
+	RUN_TEST(Test_Noise_Psnr);
+	RUN_TEST(Test_Room_Psnr);
+	RUN_TEST(Test_Partial_Blocks);
+	RUN_TEST(Test_Cook_Round_Trip);
+	RUN_TEST(Test_Cook_Rgba8_Fallback);
+
+	return TEST_RESULT();
+}
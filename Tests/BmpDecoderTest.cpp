@@ -0,0 +1,307 @@
+//======================================================================================
+//	Ed Kurlyak 2023 BMP Decoder Tests
+//======================================================================================
+
+//files are made here byte by byte, every SIMD kernel the CPU runs
+//must write the same rows as BMP_SIMD_NONE for any width, so the
+//tails the kernels hand to Row_Scalar are all covered, and the
+//scalar rows are checked against the file pixels themselves
+
+#include "TestCheck.h"
+
+#include "BmpDecoder.h"
+
+#include <initializer_list>
+#include <vector>
+
+#define FILE_HEADER_SIZE 14
+#define BI_RGB 0
+#define BI_RLE8 1
+#define BI_BITFIELDS 3
+
+static void Put_U16(std::vector<unsigned char>& File, size_t Offset, uint32_t Value)
+{
+	File[Offset + 0] = (unsigned char)Value;
+	File[Offset + 1] = (unsigned char)(Value >> 8);
+}
+
+static void Put_U32(std::vector<unsigned char>& File, size_t Offset, uint32_t Value)
+{
+	for (int i = 0; i < 4; i++)
+		File[Offset + i] = (unsigned char)(Value >> (i * 8));
+}
+
+//HeaderSize 40 with BI_BITFIELDS puts the 3 masks after the header,
+//56 (V3) holds them and the alpha mask in the header
+static std::vector<unsigned char> Make_Bmp(uint32_t Width, uint32_t Height, uint32_t BitCount,
+	uint32_t Compression, uint32_t HeaderSize, bool BottomUp, uint32_t AlphaMask = 0xFF000000)
+{
+	uint32_t DataOffset = FILE_HEADER_SIZE + HeaderSize;
+	if (Compression == BI_BITFIELDS && HeaderSize == 40)
+		DataOffset += 12;
+
+	const uint32_t RowPitch = ((Width * BitCount / 8) + 3) & ~3u;
+
+	std::vector<unsigned char> File(DataOffset + (size_t)RowPitch * Height, 0);
+
+	File[0] = 'B';
+	File[1] = 'M';
+	Put_U32(File, 2, (uint32_t)File.size());
+	Put_U32(File, 10, DataOffset);
+
+	const size_t Bih = FILE_HEADER_SIZE;
+	Put_U32(File, Bih + 0, HeaderSize);
+	Put_U32(File, Bih + 4, Width);
+	Put_U32(File, Bih + 8, BottomUp ? Height : (uint32_t)-(int32_t)Height);
+	Put_U16(File, Bih + 12, 1);
+	Put_U16(File, Bih + 14, BitCount);
+	Put_U32(File, Bih + 16, Compression);
+
+	if (Compression == BI_BITFIELDS)
+	{
+		Put_U32(File, Bih + 40, 0x00FF0000);
+		Put_U32(File, Bih + 44, 0x0000FF00);
+		Put_U32(File, Bih + 48, 0x000000FF);
+
+		if (HeaderSize >= 56)
+			Put_U32(File, Bih + 52, AlphaMask);
+	}
+
+	//row padding holds junk too, no kernel may copy it
+	for (size_t i = DataOffset; i < File.size(); i++)
+		File[i] = (unsigned char)(i * 131 + (i >> 7));
+
+	return File;
+}
+
+//decodes with Simd into rows Pitch apart, bytes past Width * 4
+//in each row keep the fill so writes past the row show up
+static std::vector<unsigned char> Decode(const std::vector<unsigned char>& File, const BmpInfo& Info,
+	uint64_t Pitch, bool BottomUpRows, BmpSimd Simd)
+{
+	std::vector<unsigned char> Dst((size_t)(Pitch * Info.Height), 0xCD);
+	DecodeBmp(File.data(), Info, Dst.data(), Pitch, BottomUpRows, Simd);
+	return Dst;
+}
+
+//the scalar rows against the file, RGBA from BGR(A) in the row
+//the file stores for each output row
+static bool Check_Scalar(const std::vector<unsigned char>& File, const BmpInfo& Info,
+	const std::vector<unsigned char>& Dst, uint64_t Pitch, bool BottomUpRows)
+{
+	const uint32_t Bpp = Info.BitCount / 8;
+
+	for (uint32_t y = 0; y < Info.Height; y++)
+	{
+		uint32_t FileRow = Info.BottomUp == BottomUpRows ? y : Info.Height - 1 - y;
+		const unsigned char* Src = File.data() + Info.DataOffset + (uint64_t)FileRow * Info.RowPitch;
+		const unsigned char* Row = Dst.data() + y * Pitch;
+
+		for (uint32_t x = 0; x < Info.Width; x++)
+		{
+			const unsigned char* s = Src + x * Bpp;
+			const unsigned char* d = Row + x * 4;
+
+			if (d[0] != s[2] || d[1] != s[1] || d[2] != s[0] ||
+				d[3] != (Info.HasAlpha ? s[3] : 255))
+				return false;
+		}
+
+		for (uint64_t x = Info.Width * 4; x < Pitch; x++)
+			if (Row[x] != 0xCD)
+				return false;
+	}
+
+	return true;
+}
+
+struct Format
+{
+	const char* Name;
+	uint32_t BitCount;
+	uint32_t Compression;
+	uint32_t HeaderSize;
+	bool HasAlpha;
+};
+
+static const Format Formats[] =
+{
+	{ "24 bit", 24, BI_RGB, 40, false },
+	{ "32 bit BI_RGB", 32, BI_RGB, 40, false },
+	{ "32 bit BI_BITFIELDS", 32, BI_BITFIELDS, 40, false },
+	{ "32 bit BI_BITFIELDS alpha", 32, BI_BITFIELDS, 56, true },
+};
+
+static void Test_Kernels()
+{
+	const BmpSimd Best = BmpSimdSupport();
+	printf("    kernels up to %s\n", Best == BMP_SIMD_AVX2 ? "AVX2" : Best == BMP_SIMD_SSSE3 ? "SSSE3" : "scalar");
+
+	const uint32_t Height = 3;
+
+	for (const Format& Fmt : Formats)
+	{
+		bool Parsed = true;
+		bool Scalar = true;
+		bool Same = true;
+
+		for (uint32_t Width = 1; Width <= 40; Width++)
+		{
+			for (bool BottomUp : { true, false })
+			{
+				std::vector<unsigned char> File = Make_Bmp(Width, Height, Fmt.BitCount,
+					Fmt.Compression, Fmt.HeaderSize, BottomUp);
+
+				BmpInfo Info;
+				if (!ParseBmpHeader(File.data(), File.size(), Info) ||
+					Info.Width != Width || Info.Height != Height || Info.BitCount != Fmt.BitCount ||
+					Info.BottomUp != BottomUp || Info.HasAlpha != Fmt.HasAlpha)
+				{
+					Parsed = false;
+					continue;
+				}
+
+				//tight rows and the 256 byte upload footprint pitch
+				const uint64_t Pitches[] = { (uint64_t)Width * 4, ((uint64_t)Width * 4 + 255) & ~(uint64_t)255 };
+
+				for (uint64_t Pitch : Pitches)
+				{
+					for (bool BottomUpRows : { true, false })
+					{
+						std::vector<unsigned char> Expected = Decode(File, Info, Pitch, BottomUpRows, BMP_SIMD_NONE);
+						Scalar = Scalar && Check_Scalar(File, Info, Expected, Pitch, BottomUpRows);
+
+						for (int Simd = BMP_SIMD_SSSE3; Simd <= (int)Best; Simd++)
+							Same = Same && Decode(File, Info, Pitch, BottomUpRows, (BmpSimd)Simd) == Expected;
+					}
+				}
+			}
+		}
+
+		printf("    %s\n", Fmt.Name);
+		CHECK(Parsed);
+		CHECK(Scalar);
+		CHECK(Same);
+	}
+}
+
+static void Test_Alpha_Mask()
+{
+	//V3 header without the 0xFF000000 alpha mask, alpha is 255
+	std::vector<unsigned char> File = Make_Bmp(8, 2, 32, BI_BITFIELDS, 56, true, 0);
+
+	BmpInfo Info;
+	CHECK(ParseBmpHeader(File.data(), File.size(), Info));
+	CHECK(!Info.HasAlpha);
+
+	std::vector<unsigned char> Dst = Decode(File, Info, 32, true, BmpSimdSupport());
+	CHECK(Check_Scalar(File, Info, Dst, 32, true));
+}
+
+static bool Parses(const std::vector<unsigned char>& File)
+{
+	BmpInfo Info;
+	return ParseBmpHeader(File.data(), File.size(), Info);
+}
+
+static void Test_Malformed()
+{
+	const std::vector<unsigned char> Good = Make_Bmp(5, 4, 24, BI_RGB, 40, true);
+	CHECK(Parses(Good));
+
+	std::vector<unsigned char> File;
+
+	//shorter than the two headers
+	File.assign(Good.begin(), Good.begin() + 53);
+	CHECK(!Parses(File));
+
+	File = Good;
+	File[1] = 'A';
+	CHECK(!Parses(File));
+
+	//BITMAPCOREHEADER is not supported
+	File = Good;
+	Put_U32(File, 14, 12);
+	CHECK(!Parses(File));
+
+	File = Good;
+	Put_U16(File, 26, 2);
+	CHECK(!Parses(File));
+
+	File = Good;
+	Put_U32(File, 18, 0);
+	CHECK(!Parses(File));
+
+	File = Good;
+	Put_U32(File, 18, (uint32_t)-5);
+	CHECK(!Parses(File));
+
+	File = Good;
+	Put_U32(File, 22, 0);
+	CHECK(!Parses(File));
+
+	File = Good;
+	Put_U32(File, 22, 0x80000000);
+	CHECK(!Parses(File));
+
+	File = Good;
+	Put_U16(File, 28, 16);
+	CHECK(!Parses(File));
+
+	File = Good;
+	Put_U16(File, 28, 8);
+	CHECK(!Parses(File));
+
+	File = Good;
+	Put_U32(File, 30, BI_RLE8);
+	CHECK(!Parses(File));
+
+	//masks only for 32 bit
+	File = Good;
+	Put_U32(File, 30, BI_BITFIELDS);
+	CHECK(!Parses(File));
+
+	//565 or any mask but 8 bits per channel in place
+	File = Make_Bmp(5, 4, 32, BI_BITFIELDS, 40, true);
+	CHECK(Parses(File));
+	Put_U32(File, 14 + 40, 0x0000F800);
+	CHECK(!Parses(File));
+
+	File = Make_Bmp(5, 4, 32, BI_BITFIELDS, 40, true);
+	Put_U32(File, 14 + 48, 0xFF000000);
+	CHECK(!Parses(File));
+
+	//masks cut off by the end of the file
+	File = Make_Bmp(1, 1, 32, BI_BITFIELDS, 40, true);
+	File.resize(14 + 40 + 8);
+	CHECK(!Parses(File));
+
+	//pixel data one byte short, or starting past the end
+	File = Good;
+	File.pop_back();
+	CHECK(!Parses(File));
+
+	File = Good;
+	Put_U32(File, 10, 0xFFFFFFF0);
+	CHECK(!Parses(File));
+
+	//rows of a huge width overflow 32 bits
+	File = Good;
+	Put_U32(File, 18, 0x7FFFFFFF);
+	CHECK(!Parses(File));
+
+	//a failed parse leaves nothing of the header behind
+	BmpInfo Info;
+	Info.Width = 7;
+	CHECK(!ParseBmpHeader(File.data(), File.size(), Info));
+	CHECK(Info.Width == 0 && Info.Height == 0 && Info.RowPitch == 0);
+}
+
+int main()
+{
+	RUN_TEST(Test_Kernels);
+	RUN_TEST(Test_Alpha_Mask);
+	RUN_TEST(Test_Malformed);
+
+	return TEST_RESULT();
+}
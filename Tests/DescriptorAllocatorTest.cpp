@@ -0,0 +1,301 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Descriptor Allocator Tests
+//======================================================================================
+
+//CDescriptorAllocator is driven the way CDescriptorHeap and the
+//samples drive it, a counter stands in for the frame fence and
+//the GPU finishes frames in order a few frames behind the CPU
+
+#include "TestCheck.h"
+
+#include "DescriptorAllocator.h"
+
+#include <deque>
+#include <random>
+#include <vector>
+
+static void Test_Handle()
+{
+	CHECK(CDescriptorAllocator::Handle(1000, 0, 32) == 1000);
+	CHECK(CDescriptorAllocator::Handle(1000, 3, 32) == 1096);
+
+	//GPU handles are 64 bit, the product must not wrap at 32 bits
+	CHECK(CDescriptorAllocator::Handle(0x100000000ull, 0x10000, 0x10000) == 0x200000000ull);
+}
+
+static void Test_Persistent()
+{
+	CDescriptorAllocator Allocator;
+	Allocator.Init(16, 0);
+
+	uint32_t A = ~0u, B = ~0u, C = ~0u, Index = ~0u;
+	CHECK(Allocator.Allocate(4, A));
+	CHECK(Allocator.Allocate(4, B));
+	CHECK(Allocator.Allocate(8, C));
+	CHECK(A == 0 && B == 4 && C == 8);
+	CHECK(Allocator.Persistent_Used() == 16);
+
+	CHECK(!Allocator.Allocate(1, Index));
+	CHECK(!Allocator.Allocate(0, Index));
+
+	//4 free in the middle, 5 do not fit
+	Allocator.Free(B, 4);
+	CHECK(!Allocator.Allocate(5, Index));
+
+	CHECK(Allocator.Allocate(2, Index));
+	CHECK(Index == 4);
+
+	//first fit, the range at the start is taken before [6, 8)
+	Allocator.Free(A, 4);
+	CHECK(Allocator.Allocate(2, Index));
+	CHECK(Index == 0);
+
+	//everything back in any order merges into one range
+	Allocator.Free(0, 2);
+	Allocator.Free(C, 8);
+	Allocator.Free(4, 2);
+	CHECK(Allocator.Persistent_Used() == 0);
+
+	CHECK(Allocator.Allocate(16, Index));
+	CHECK(Index == 0);
+
+	//freeing nothing changes nothing
+	Allocator.Free(0, 0);
+	CHECK(Allocator.Persistent_Used() == 16);
+}
+
+static void Test_Transient_Ring()
+{
+	CDescriptorAllocator Allocator;
+	Allocator.Init(8, 16);
+
+	CHECK(Allocator.Persistent_Count() == 8);
+	CHECK(Allocator.Transient_Count() == 16);
+
+	//transient indices come after the persistent ones
+	uint32_t Index = ~0u;
+	CHECK(Allocator.Allocate_Transient(10, Index));
+	CHECK(Index == 8);
+	Allocator.Close_Frame(1);
+
+	CHECK(Allocator.Allocate_Transient(4, Index));
+	CHECK(Index == 18);
+	Allocator.Close_Frame(2);
+
+	//the ring is not persistent space
+	uint32_t Persistent = ~0u;
+	CHECK(Allocator.Allocate(8, Persistent));
+	CHECK(Persistent == 0);
+
+	CHECK(!Allocator.Allocate_Transient(6, Index));
+
+	//frame 1 is done, its 10 are free again
+	Allocator.Release(0);
+	CHECK(Allocator.Transient_Used() == 14);
+	Allocator.Release(1);
+	CHECK(Allocator.Transient_Used() == 4);
+
+	//2 left before the end, a table never wraps, so it starts
+	//at the front and the 2 at the end are skipped
+	CHECK(Allocator.Allocate_Transient(4, Index));
+	CHECK(Index == 8);
+
+	//up to the tail of frame 2 and not one more
+	CHECK(!Allocator.Allocate_Transient(7, Index));
+	CHECK(Allocator.Allocate_Transient(6, Index));
+	CHECK(Index == 12);
+	CHECK(Allocator.Transient_Used() == 16);
+	Allocator.Close_Frame(3);
+
+	Allocator.Release(3);
+	CHECK(Allocator.Transient_Used() == 0);
+	CHECK(Allocator.Persistent_Used() == 8);
+}
+
+//start of the first free run of Count in the model, what first
+//fit over coalesced free ranges has to return
+static bool First_Fit(const std::vector<bool>& Used, uint32_t Count, uint32_t& Index)
+{
+	uint32_t Run = 0;
+
+	for (uint32_t i = 0; i < (uint32_t)Used.size(); i++)
+	{
+		Run = Used[i] ? 0 : Run + 1;
+
+		if (Run == Count)
+		{
+			Index = i + 1 - Count;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+struct Table
+{
+	uint32_t Index;
+	uint32_t Count;
+};
+
+struct Frame
+{
+	uint64_t Fence;
+	std::vector<Table> Tables;
+};
+
+//frames of persistent views made and freed and transient tables,
+//persistent results are compared with a first fit model, that only
+//holds if every Free merged with its free neighbours
+static void Test_Random()
+{
+	const uint32_t PersistentCount = 256;
+	const uint32_t TransientCount = 64;
+
+	CDescriptorAllocator Allocator;
+	Allocator.Init(PersistentCount, TransientCount);
+
+	std::mt19937 Rng(3);
+
+	std::vector<bool> Used(PersistentCount, false);
+	uint32_t UsedCount = 0;
+	std::vector<Table> Views;
+
+	//transient descriptors of frames the GPU has not finished
+	std::vector<int> Live(TransientCount, 0);
+	std::deque<Frame> InFlight;
+
+	uint64_t Fence = 0;
+	uint64_t Completed = 0;
+
+	uint32_t PersistentFailed = 0;
+	uint32_t TransientFailed = 0;
+	bool Valid = true;
+
+	for (uint32_t Step = 0; Step < 100000; Step++)
+	{
+		Frame Current;
+
+		//views that live as long as their resource
+		for (uint32_t i = Rng() % 4; i > 0; i--)
+		{
+			if (!Views.empty() && Rng() % 2 == 0)
+			{
+				size_t Pick = Rng() % Views.size();
+				Table View = Views[Pick];
+				Views[Pick] = Views.back();
+				Views.pop_back();
+
+				Allocator.Free(View.Index, View.Count);
+
+				for (uint32_t j = 0; j < View.Count; j++)
+					Used[View.Index + j] = false;
+				UsedCount -= View.Count;
+
+				continue;
+			}
+
+			uint32_t Count = 1 + Rng() % 16;
+			uint32_t Expected = 0;
+			bool Fits = First_Fit(Used, Count, Expected);
+
+			uint32_t Index = ~0u;
+			bool Allocated = Allocator.Allocate(Count, Index);
+
+			Valid = Valid && Allocated == Fits;
+
+			if (!Allocated)
+			{
+				PersistentFailed++;
+				continue;
+			}
+
+			Valid = Valid && Index == Expected;
+
+			for (uint32_t j = 0; j < Count; j++)
+				Used[Index + j] = true;
+			UsedCount += Count;
+
+			Views.push_back({ Index, Count });
+		}
+
+		//tables made again every frame
+		for (uint32_t i = Rng() % 6; i > 0; i--)
+		{
+			uint32_t Count = 1 + Rng() % 12;
+			uint32_t Index = ~0u;
+
+			if (!Allocator.Allocate_Transient(Count, Index))
+			{
+				TransientFailed++;
+				continue;
+			}
+
+			//after the persistent part and all in one piece
+			Valid = Valid && Index >= PersistentCount;
+			Valid = Valid && Index + Count <= PersistentCount + TransientCount;
+
+			for (uint32_t j = 0; j < Count && Valid; j++)
+			{
+				int& Slot = Live[Index - PersistentCount + j];
+				Valid = Valid && Slot == 0;
+				Slot = 1;
+			}
+
+			Current.Tables.push_back({ Index, Count });
+		}
+
+		Valid = Valid && Allocator.Persistent_Used() == UsedCount;
+
+		//Draw_MeshManager signals, Next_Frame_Resource releases
+		//what the GPU finished, up to 3 frames in flight
+		Current.Fence = ++Fence;
+		Allocator.Close_Frame(Current.Fence);
+		InFlight.push_back(Current);
+
+		uint64_t Lag = Rng() % 3;
+		if (Fence - Lag > Completed)
+			Completed = Fence - Lag;
+
+		Allocator.Release(Completed);
+
+		while (!InFlight.empty() && InFlight.front().Fence <= Completed)
+		{
+			for (const Table& Done : InFlight.front().Tables)
+				for (uint32_t j = 0; j < Done.Count; j++)
+					Live[Done.Index - PersistentCount + j] = 0;
+
+			InFlight.pop_front();
+		}
+	}
+
+	CHECK(Valid);
+
+	//the mix runs out of both now and then
+	CHECK(PersistentFailed > 100);
+	CHECK(TransientFailed > 100);
+	printf("    %u persistent and %u transient allocations failed\n", PersistentFailed, TransientFailed);
+
+	//the GPU catches up and every view is freed
+	Allocator.Release(Fence);
+	CHECK(Allocator.Transient_Used() == 0);
+
+	for (const Table& View : Views)
+		Allocator.Free(View.Index, View.Count);
+
+	CHECK(Allocator.Persistent_Used() == 0);
+
+	uint32_t Index = ~0u;
+	CHECK(Allocator.Allocate(PersistentCount, Index));
+	CHECK(Index == 0);
+}
+
+int main()
+{
+	RUN_TEST(Test_Handle);
+	RUN_TEST(Test_Persistent);
+	RUN_TEST(Test_Transient_Ring);
+	RUN_TEST(Test_Random);
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,376 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Frame Histogram Tests
+//======================================================================================
+
+//bucket edges are checked at every power of two, percentiles against
+//an exact sort of the same frames, and both exports are parsed back,
+//the JSON one by a strict reader
+
+#include "TestCheck.h"
+#include "TestJson.h"
+
+#include "FrameHistogram.h"
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#define TEST_JSON_NAME "FrameHistogramTest.json"
+#define TEST_CSV_NAME "FrameHistogramTest.csv"
+
+//longest time the histogram keeps apart
+#define RANGE_END ((int64_t)1 << 28)
+
+//first time a bucket holds
+static int64_t Bucket_Lower(int Index)
+{
+	return Index == 0 ? 0 : CFrameHistogram::Bucket_Upper(Index - 1) + 1;
+}
+
+static void Test_Bucket_Edges()
+{
+	//one bucket per microsecond below SUB_COUNT
+	for (int64_t t = 0; t < FRAME_HISTOGRAM_SUB_COUNT; t++)
+	{
+		CHECK(CFrameHistogram::Bucket_Index(t) == (int)t);
+		CHECK(CFrameHistogram::Bucket_Upper((int)t) == t);
+	}
+
+	//a power of two starts a bucket, the time before it ends one
+	for (int Bit = FRAME_HISTOGRAM_SUB_BITS; Bit < 28; Bit++)
+	{
+		int64_t p = (int64_t)1 << Bit;
+
+		int Index = CFrameHistogram::Bucket_Index(p);
+		CHECK(CFrameHistogram::Bucket_Index(p - 1) == Index - 1);
+		CHECK(CFrameHistogram::Bucket_Upper(Index - 1) == p - 1);
+		CHECK(Index % FRAME_HISTOGRAM_SUB_COUNT == 0);
+
+		//width of the buckets of this magnitude
+		int64_t Width = p >> FRAME_HISTOGRAM_SUB_BITS;
+		CHECK(CFrameHistogram::Bucket_Upper(Index) == p + Width - 1);
+		CHECK(CFrameHistogram::Bucket_Index(p + Width - 1) == Index);
+		CHECK(CFrameHistogram::Bucket_Index(p + Width) == Index + 1);
+	}
+
+	CHECK(CFrameHistogram::Bucket_Upper(FRAME_HISTOGRAM_BUCKETS - 1) == RANGE_END - 1);
+
+	//buckets follow each other with no gap, each no wider
+	//than 1/32 of the times it holds
+	bool Contiguous = true;
+	bool Narrow = true;
+
+	for (int i = 0; i < FRAME_HISTOGRAM_BUCKETS; i++)
+	{
+		int64_t Lower = Bucket_Lower(i);
+		int64_t Upper = CFrameHistogram::Bucket_Upper(i);
+
+		Contiguous = Contiguous && Upper >= Lower &&
+			CFrameHistogram::Bucket_Index(Lower) == i && CFrameHistogram::Bucket_Index(Upper) == i;
+
+		Narrow = Narrow && (Upper - Lower) * FRAME_HISTOGRAM_SUB_COUNT <= Lower;
+	}
+
+	CHECK(Contiguous);
+	CHECK(Narrow);
+}
+
+static void Test_Overflow_Clamp()
+{
+	CHECK(CFrameHistogram::Bucket_Index(RANGE_END - 1) == FRAME_HISTOGRAM_BUCKETS - 1);
+	CHECK(CFrameHistogram::Bucket_Index(RANGE_END) == FRAME_HISTOGRAM_BUCKETS - 1);
+	CHECK(CFrameHistogram::Bucket_Index(INT64_MAX) == FRAME_HISTOGRAM_BUCKETS - 1);
+	CHECK(CFrameHistogram::Bucket_Index(-5) == 0);
+
+	std::unique_ptr<CFrameHistogram> Histogram(new CFrameHistogram());
+
+	for (int i = 0; i < 99; i++)
+		Histogram->Record(16000);
+
+	//a hang of 18 minutes, past the last magnitude
+	const int64_t Hang = (int64_t)1100 * 1000000;
+	Histogram->Record(Hang);
+
+	CHECK(Histogram->Max() == Hang);
+	CHECK(Histogram->Percentile(99.0) >= 16000 && Histogram->Percentile(99.0) <= 16000 + 16000 / 32);
+	//the last bucket has no edge, the longest frame is the answer
+	CHECK(Histogram->Percentile(100.0) == Hang);
+
+	//negative times from a clock that went back count as 0
+	Histogram->Reset();
+	Histogram->Record(-100);
+	CHECK(Histogram->Count() == 1);
+	CHECK(Histogram->Max() == 0);
+	CHECK(Histogram->Percentile(50.0) == 0);
+}
+
+//rank rule of Percentile, P / 100 * N rounded up, at least 1
+static int64_t Exact_Percentile(const std::vector<int64_t>& Sorted, double P)
+{
+	double Rank = P / 100.0 * (double)Sorted.size();
+	uint64_t Target = (uint64_t)Rank;
+	if ((double)Target < Rank || Target == 0)
+		Target++;
+	if (Target > Sorted.size())
+		Target = Sorted.size();
+
+	return Sorted[(size_t)Target - 1];
+}
+
+static void Check_Percentiles(CFrameHistogram& Histogram, std::vector<int64_t>& Frames, bool& Valid)
+{
+	std::sort(Frames.begin(), Frames.end());
+
+	static const double Ps[] = { 0.0, 1.0, 10.0, 50.0, 90.0, 95.0, 99.0, 99.9, 100.0 };
+
+	for (double P : Ps)
+	{
+		int64_t Exact = Exact_Percentile(Frames, P);
+		int64_t Result = Histogram.Percentile(P);
+
+		//the bucket edge is never below the frame and at most 1/32 above it
+		Valid = Valid && Result >= Exact && Result <= Exact + Exact / FRAME_HISTOGRAM_SUB_COUNT;
+	}
+}
+
+static void Test_Percentiles()
+{
+	std::unique_ptr<CFrameHistogram> Histogram(new CFrameHistogram());
+	CHECK(Histogram->Percentile(50.0) == 0);
+
+	std::mt19937_64 Rng(19);
+	bool Valid = true;
+
+	for (int Round = 0; Round < 200; Round++)
+	{
+		Histogram->Reset();
+
+		std::vector<int64_t> Frames;
+		int Count = 1 + (int)(Rng() % 3000);
+
+		for (int i = 0; i < Count; i++)
+		{
+			int64_t Time;
+
+			//every magnitude, or frames around 60 Hz with a few hitches
+			if (Round % 2 == 0)
+				Time = (int64_t)(Rng() % (uint64_t)RANGE_END) >> (Rng() % 28);
+			else
+				Time = 16000 + (int64_t)(Rng() % 1400) + (Rng() % 50 == 0 ? (int64_t)(Rng() % 100000) : 0);
+
+			Histogram->Record(Time);
+			Frames.push_back(Time);
+		}
+
+		Check_Percentiles(*Histogram, Frames, Valid);
+	}
+
+	CHECK(Valid);
+}
+
+static void Test_Over_Budget()
+{
+	std::unique_ptr<CFrameHistogram> Histogram(new CFrameHistogram());
+
+	//off by default
+	Histogram->Record(1000000);
+	CHECK(Histogram->Over_Budget() == 0);
+
+	Histogram->Set_Budget(16666);
+	Histogram->Record(16665);
+	Histogram->Record(16666);
+	Histogram->Record(16667);
+	Histogram->Record(40000);
+	CHECK(Histogram->Over_Budget() == 2);
+
+	//only later frames see a new budget
+	Histogram->Set_Budget(33333);
+	Histogram->Record(40000);
+	Histogram->Record(20000);
+	CHECK(Histogram->Over_Budget() == 3);
+
+	Histogram->Set_Budget(0);
+	Histogram->Record(1000000);
+	CHECK(Histogram->Over_Budget() == 3);
+
+	//the budget outlives Reset
+	Histogram->Set_Budget(100);
+	Histogram->Reset();
+	CHECK(Histogram->Over_Budget() == 0);
+	Histogram->Record(101);
+	CHECK(Histogram->Over_Budget() == 1);
+}
+
+static std::vector<std::string> Split(const std::string& Line, char Sep)
+{
+	std::vector<std::string> Fields;
+	size_t Start = 0;
+
+	for (;;)
+	{
+		size_t End = Line.find(Sep, Start);
+		Fields.push_back(Line.substr(Start, End == std::string::npos ? std::string::npos : End - Start));
+		if (End == std::string::npos)
+			return Fields;
+		Start = End + 1;
+	}
+}
+
+static bool Is_Number(const std::string& Field)
+{
+	if (Field.empty())
+		return false;
+
+	char* End = NULL;
+	strtod(Field.c_str(), &End);
+	return *End == '\0';
+}
+
+//sections of key,value rows split by blank lines, the first row of
+//each is its header, every other row is a name or number and a number
+static bool Read_CSV(const char* FileName, std::vector<std::vector<std::vector<std::string>>>& Sections)
+{
+	Sections.clear();
+
+	FILE* Fp = fopen(FileName, "r");
+	if (Fp == NULL)
+		return false;
+
+	std::string Text;
+	char Buffer[4096];
+	size_t Read;
+	while ((Read = fread(Buffer, 1, sizeof(Buffer), Fp)) > 0)
+		Text.append(Buffer, Read);
+
+	fclose(Fp);
+
+	if (Text.empty() || Text.back() != '\n')
+		return false;
+
+	Text.pop_back();
+
+	bool NewSection = true;
+
+	for (const std::string& Line : Split(Text, '\n'))
+	{
+		if (Line.empty())
+		{
+			if (NewSection)
+				return false;
+			NewSection = true;
+			continue;
+		}
+
+		std::vector<std::string> Fields = Split(Line, ',');
+		if (Fields.size() != 2)
+			return false;
+
+		if (NewSection)
+		{
+			Sections.emplace_back();
+			NewSection = false;
+		}
+		else if (!Is_Number(Fields[1]))
+		{
+			return false;
+		}
+
+		Sections.back().push_back(Fields);
+	}
+
+	return !NewSection;
+}
+
+static void Test_History_And_Exports()
+{
+	std::unique_ptr<CFrameHistogram> Histogram(new CFrameHistogram());
+	Histogram->Set_Budget(1500);
+
+	//more frames than the history holds, each one a different time
+	const int Frames = FRAME_HISTORY_SIZE * 2 + 300;
+	for (int i = 1; i <= Frames; i++)
+		Histogram->Record(i);
+
+	CHECK(Histogram->Count() == (uint64_t)Frames);
+	CHECK(Histogram->Over_Budget() == (uint64_t)(Frames - 1500));
+	CHECK_NEAR(Histogram->Average(), (Frames + 1) * 0.5, 1.0e-9);
+
+	CHECK(Histogram->Write_JSON(TEST_JSON_NAME));
+
+	JsonValue Root;
+	CHECK(Read_Json_File(TEST_JSON_NAME, Root));
+	CHECK(Root.Type == JsonValue::OBJECT);
+
+	const JsonValue* Count = Root.Find("frames");
+	const JsonValue* Max = Root.Find("max_us");
+	const JsonValue* Over = Root.Find("over_budget");
+	const JsonValue* Percentiles = Root.Find("percentiles_us");
+	const JsonValue* Buckets = Root.Find("histogram");
+	const JsonValue* Recent = Root.Find("recent_us");
+
+	CHECK(Count && Count->Number == Frames);
+	CHECK(Max && Max->Number == Frames);
+	CHECK(Over && Over->Number == Frames - 1500);
+	CHECK(Percentiles && Percentiles->Find("p50") && Percentiles->Find("p99.9"));
+
+	//every frame is in some bucket
+	double InBuckets = 0.0;
+	if (Buckets)
+		for (const JsonValue& Bucket : Buckets->Items)
+			InBuckets += Bucket.Find("frames") ? Bucket.Find("frames")->Number : 0.0;
+	CHECK(InBuckets == Frames);
+
+	//the newest FRAME_HISTORY_SIZE frames, oldest first
+	bool InOrder = Recent && Recent->Items.size() == FRAME_HISTORY_SIZE;
+	for (size_t i = 0; InOrder && i < Recent->Items.size(); i++)
+		InOrder = Recent->Items[i].Number == Frames - FRAME_HISTORY_SIZE + 1 + (double)i;
+	CHECK(InOrder);
+
+	CHECK(Histogram->Write_CSV(TEST_CSV_NAME));
+
+	std::vector<std::vector<std::vector<std::string>>> Sections;
+	CHECK(Read_CSV(TEST_CSV_NAME, Sections));
+	CHECK(Sections.size() == 3);
+
+	if (Sections.size() == 3)
+	{
+		CHECK(Sections[0][0][0] == "key" && Sections[1][0][0] == "bucket_upper_us" && Sections[2][0][0] == "recent_frame");
+		CHECK(Sections[0][1][0] == "frames" && Sections[0][1][1] == std::to_string(Frames));
+
+		double Csv = 0.0;
+		for (size_t i = 1; i < Sections[1].size(); i++)
+			Csv += strtod(Sections[1][i][1].c_str(), NULL);
+		CHECK(Csv == Frames);
+
+		InOrder = Sections[2].size() == FRAME_HISTORY_SIZE + 1;
+		for (size_t i = 1; InOrder && i < Sections[2].size(); i++)
+			InOrder = Sections[2][i][0] == std::to_string(i - 1) &&
+				Sections[2][i][1] == std::to_string(Frames - FRAME_HISTORY_SIZE + i);
+		CHECK(InOrder);
+	}
+
+	//nothing recorded still exports valid files
+	Histogram->Reset();
+	CHECK(Histogram->Write_JSON(TEST_JSON_NAME));
+	CHECK(Read_Json_File(TEST_JSON_NAME, Root));
+	CHECK(Root.Find("recent_us") && Root.Find("recent_us")->Items.empty());
+
+	CHECK(Histogram->Write_CSV(TEST_CSV_NAME));
+	CHECK(Read_CSV(TEST_CSV_NAME, Sections));
+}
+
+int main()
+{
+	RUN_TEST(Test_Bucket_Edges);
+	RUN_TEST(Test_Overflow_Clamp);
+	RUN_TEST(Test_Percentiles);
+	RUN_TEST(Test_Over_Budget);
+	RUN_TEST(Test_History_And_Exports);
+
+	remove(TEST_JSON_NAME);
+	remove(TEST_CSV_NAME);
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,153 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Linear Allocator Tests
+//======================================================================================
+
+#include "TestCheck.h"
+
+#include "LinearAllocator.h"
+
+#include <cstdint>
+#include <random>
+
+static void Test_Alignment()
+{
+	CLinearAllocator Allocator;
+	Allocator.Init(4096, 256);
+
+	uint64_t Offset = ~0ull;
+	CHECK(Allocator.Allocate(1, Offset));
+	CHECK(Offset == 0);
+	CHECK(Allocator.Used() == 1);
+
+	CHECK(Allocator.Allocate(256, Offset));
+	CHECK(Offset == 256);
+	CHECK(Allocator.Used() == 512);
+
+	//an aligned end needs no padding
+	CHECK(Allocator.Allocate(100, Offset));
+	CHECK(Offset == 512);
+	CHECK(Allocator.Allocate(100, Offset));
+	CHECK(Offset == 768);
+	CHECK(Allocator.Used() == 868);
+
+	//any power of two
+	for (uint64_t Align = 1; Align <= 4096; Align <<= 1)
+	{
+		CLinearAllocator a;
+		a.Init(1 << 20, Align);
+
+		std::mt19937 Rng((uint32_t)Align);
+		uint64_t End = 0;
+
+		for (int i = 0; i < 100; i++)
+		{
+			uint64_t Size = 1 + Rng() % 300;
+			CHECK(a.Allocate(Size, Offset));
+			CHECK(Offset % Align == 0);
+			CHECK(Offset >= End && Offset - End < Align);
+			End = Offset + Size;
+			CHECK(a.Used() == End);
+		}
+	}
+}
+
+static void Test_Exhaustion()
+{
+	CLinearAllocator Allocator;
+	Allocator.Init(1024, 256);
+
+	uint64_t Offset = ~0ull;
+	CHECK(!Allocator.Allocate(0, Offset));
+	CHECK(!Allocator.Allocate(1025, Offset));
+	CHECK(!Allocator.Allocate(UINT64_MAX, Offset));
+	CHECK(Allocator.Used() == 0);
+
+	CHECK(Allocator.Allocate(768, Offset));
+
+	//257 does not fit, failed calls leave the allocator as it was
+	CHECK(!Allocator.Allocate(257, Offset));
+	CHECK(Offset == 0);
+	CHECK(Allocator.Used() == 768);
+
+	//exact fit
+	CHECK(Allocator.Allocate(256, Offset));
+	CHECK(Offset == 768);
+	CHECK(Allocator.Used() == 1024);
+	CHECK(!Allocator.Allocate(1, Offset));
+
+	//capacity that is not a multiple of the alignment, the
+	//aligned start goes past the end
+	CLinearAllocator Odd;
+	Odd.Init(1000, 256);
+	CHECK(Odd.Allocate(900, Offset));
+	CHECK(!Odd.Allocate(1, Offset));
+	CHECK(!Odd.Allocate(UINT64_MAX - 512, Offset));
+	CHECK(Odd.Used() == 900);
+}
+
+static void Test_Reset()
+{
+	CLinearAllocator Allocator;
+	Allocator.Init(1024, 256);
+
+	uint64_t Offset;
+	CHECK(Allocator.Allocate(1024, Offset));
+	CHECK(!Allocator.Allocate(1, Offset));
+
+	Allocator.Reset();
+	CHECK(Allocator.Used() == 0);
+	CHECK(Allocator.Capacity() == 1024);
+
+	CHECK(Allocator.Allocate(10, Offset));
+	CHECK(Offset == 0);
+
+	//Init starts over, the peak too
+	Allocator.Init(2048, 16);
+	CHECK(Allocator.Used() == 0);
+	CHECK(Allocator.Peak() == 0);
+	CHECK(Allocator.Capacity() == 2048);
+}
+
+//frames of random constant blocks, Peak is the largest
+//frame since Init and survives Reset
+static void Test_Peak()
+{
+	CLinearAllocator Allocator;
+	Allocator.Init(64 * 1024, 256);
+
+	std::mt19937 Rng(5);
+	uint64_t Peak = 0;
+
+	for (int Frame = 0; Frame < 1000; Frame++)
+	{
+		int Blocks = 1 + Rng() % 64;
+
+		for (int i = 0; i < Blocks; i++)
+		{
+			uint64_t Offset;
+			if (!Allocator.Allocate(1 + Rng() % 1024, Offset))
+				break;
+		}
+
+		uint64_t Used = Allocator.Used();
+		Peak = Used > Peak ? Used : Peak;
+
+		CHECK(Allocator.Peak() == Peak);
+		CHECK(Allocator.Used() <= Allocator.Peak());
+
+		Allocator.Reset();
+		CHECK(Allocator.Peak() == Peak);
+	}
+
+	CHECK(Peak > 0 && Peak <= 64 * 1024);
+}
+
+int main()
+{
+	RUN_TEST(Test_Alignment);
+	RUN_TEST(Test_Exhaustion);
+	RUN_TEST(Test_Reset);
+	RUN_TEST(Test_Peak);
+
+	return TEST_RESULT();
+}
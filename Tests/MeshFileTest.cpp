@@ -0,0 +1,231 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Mesh File Tests
+//======================================================================================
+
+#include "TestCheck.h"
+
+#include "MeshFile.h"
+#include "SyntheticMesh.h"
+
+#include <cstring>
+
+#define TEST_FILE_NAME "MeshFileTest.mesh"
+
+struct TestMesh
+{
+	std::vector<float> Vertices;
+	std::vector<uint32_t> Indices;
+	std::vector<MeshCluster> Clusters;
+};
+
+static TestMesh Make_Test_Mesh()
+{
+	TestMesh Mesh;
+	MakeGridMesh(20, 20, Mesh.Vertices, Mesh.Indices);
+
+	BuildMeshClusters(Mesh.Indices.data(), Mesh.Indices.size(), Mesh.Vertices.data(),
+		5 * sizeof(float), (uint32_t)(Mesh.Vertices.size() / 5), Mesh.Clusters);
+
+	return Mesh;
+}
+
+static bool Write_Test_Mesh(const TestMesh& Mesh)
+{
+	MeshFileDesc Desc;
+	Desc.VertexCount = (uint32_t)(Mesh.Vertices.size() / 5);
+	Desc.StreamCount = 1;
+	Desc.StreamData[0] = Mesh.Vertices.data();
+	Desc.StreamStride[0] = 5 * sizeof(float);
+	Desc.IndexCount = (uint32_t)Mesh.Indices.size();
+	Desc.IndexStride = 4;
+	Desc.IndexData = Mesh.Indices.data();
+	Desc.ClusterCount = (uint32_t)Mesh.Clusters.size();
+	Desc.Clusters = Mesh.Clusters.data();
+	Desc.SourceKey = 0x1234;
+
+	return WriteMeshFile(TEST_FILE_NAME, Desc);
+}
+
+static std::vector<unsigned char> Read_File(const char* FileName)
+{
+	std::vector<unsigned char> Data;
+
+	FILE* Fp = fopen(FileName, "rb");
+	if (Fp == NULL)
+		return Data;
+
+	unsigned char Buffer[4096];
+	size_t Read;
+	while ((Read = fread(Buffer, 1, sizeof(Buffer), Fp)) > 0)
+		Data.insert(Data.end(), Buffer, Buffer + Read);
+
+	fclose(Fp);
+
+	return Data;
+}
+
+static void Write_File(const char* FileName, const std::vector<unsigned char>& Data)
+{
+	FILE* Fp = fopen(FileName, "wb");
+	fwrite(Data.data(), 1, Data.size(), Fp);
+	fclose(Fp);
+}
+
+//writes the test mesh, lets Patch change the bytes and opens the result
+template <typename Func>
+static bool Open_Patched(Func Patch)
+{
+	TestMesh Mesh = Make_Test_Mesh();
+	Write_Test_Mesh(Mesh);
+
+	std::vector<unsigned char> Data = Read_File(TEST_FILE_NAME);
+	Patch(Data);
+	Write_File(TEST_FILE_NAME, Data);
+
+	CMeshFile MeshFile;
+	return MeshFile.Open(TEST_FILE_NAME);
+}
+
+static MeshFileHeader& Header_Of(std::vector<unsigned char>& Data)
+{
+	return *(MeshFileHeader*)Data.data();
+}
+
+static MeshCluster* Clusters_Of(std::vector<unsigned char>& Data)
+{
+	return (MeshCluster*)(Data.data() + Header_Of(Data).ClusterOffset);
+}
+
+static void Test_Round_Trip()
+{
+	TestMesh Mesh = Make_Test_Mesh();
+	CHECK(Write_Test_Mesh(Mesh));
+
+	CMeshFile MeshFile;
+	CHECK(MeshFile.Open(TEST_FILE_NAME));
+
+	const MeshFileHeader& Header = MeshFile.Header();
+	CHECK(Header.VertexCount == Mesh.Vertices.size() / 5);
+	CHECK(Header.IndexCount == Mesh.Indices.size());
+	CHECK(Header.ClusterCount == Mesh.Clusters.size());
+	CHECK(Header.SourceKey == 0x1234);
+
+	CHECK(memcmp(MeshFile.StreamData(0), Mesh.Vertices.data(), Mesh.Vertices.size() * sizeof(float)) == 0);
+	CHECK(memcmp(MeshFile.IndexData(), Mesh.Indices.data(), Mesh.Indices.size() * sizeof(uint32_t)) == 0);
+	CHECK(memcmp(MeshFile.Clusters(), Mesh.Clusters.data(), Mesh.Clusters.size() * sizeof(MeshCluster)) == 0);
+}
+
+static void Test_Unchanged_File_Opens()
+{
+	CHECK(Open_Patched([](std::vector<unsigned char>&) {}));
+}
+
+static void Test_Truncated_File()
+{
+	CHECK(!Open_Patched([](std::vector<unsigned char>& Data) { Data.resize(Data.size() - 16); }));
+	CHECK(!Open_Patched([](std::vector<unsigned char>& Data) { Data.resize(sizeof(MeshFileHeader) - 1); }));
+}
+
+static void Test_Bad_Header()
+{
+	CHECK(!Open_Patched([](std::vector<unsigned char>& Data) { Header_Of(Data).Magic = 0; }));
+	CHECK(!Open_Patched([](std::vector<unsigned char>& Data) { Header_Of(Data).Version++; }));
+	CHECK(!Open_Patched([](std::vector<unsigned char>& Data) { Header_Of(Data).StreamCount = 0; }));
+	CHECK(!Open_Patched([](std::vector<unsigned char>& Data) { Header_Of(Data).IndexStride = 3; }));
+	CHECK(!Open_Patched([](std::vector<unsigned char>& Data) { Header_Of(Data).VertexCount++; }));
+}
+
+static void Test_Offsets_Do_Not_Wrap()
+{
+	CHECK(!Open_Patched([](std::vector<unsigned char>& Data) { Header_Of(Data).IndexOffset = ~(uint64_t)15; }));
+	CHECK(!Open_Patched([](std::vector<unsigned char>& Data) { Header_Of(Data).ClusterOffset = ~(uint64_t)15; }));
+	CHECK(!Open_Patched([](std::vector<unsigned char>& Data) { Header_Of(Data).IndexCount = 0xFFFFFFFF; }));
+	CHECK(!Open_Patched([](std::vector<unsigned char>& Data) { Header_Of(Data).IndexOffset += 4; }));
+}
+
+static void Test_Index_Out_Of_Range()
+{
+	CHECK(!Open_Patched([](std::vector<unsigned char>& Data)
+	{
+		MeshFileHeader& Header = Header_Of(Data);
+		uint32_t* Indices = (uint32_t*)(Data.data() + Header.IndexOffset);
+		Indices[Header.IndexCount - 1] = Header.VertexCount;
+	}));
+
+	CHECK(!Open_Patched([](std::vector<unsigned char>& Data)
+	{
+		MeshFileHeader& Header = Header_Of(Data);
+		uint32_t* Indices = (uint32_t*)(Data.data() + Header.IndexOffset);
+		Indices[0] = 0xFFFFFFFF;
+	}));
+
+	//the last vertex is a valid index
+	CHECK(Open_Patched([](std::vector<unsigned char>& Data)
+	{
+		MeshFileHeader& Header = Header_Of(Data);
+		uint32_t* Indices = (uint32_t*)(Data.data() + Header.IndexOffset);
+		Indices[0] = Header.VertexCount - 1;
+	}));
+}
+
+static void Test_Cluster_Out_Of_Range()
+{
+	CHECK(!Open_Patched([](std::vector<unsigned char>& Data)
+	{
+		MeshFileHeader& Header = Header_Of(Data);
+		MeshCluster& Last = Clusters_Of(Data)[Header.ClusterCount - 1];
+		Last.IndexOffset = Header.IndexCount - 3;
+		Last.TriangleCount = 2;
+	}));
+
+	CHECK(!Open_Patched([](std::vector<unsigned char>& Data)
+	{
+		Clusters_Of(Data)[0].IndexOffset = 0xFFFFFFFD;
+	}));
+
+	CHECK(!Open_Patched([](std::vector<unsigned char>& Data) { Clusters_Of(Data)[0].IndexOffset = 1; }));
+	CHECK(!Open_Patched([](std::vector<unsigned char>& Data) { Clusters_Of(Data)[0].TriangleCount = 0; }));
+	CHECK(!Open_Patched([](std::vector<unsigned char>& Data)
+	{
+		Clusters_Of(Data)[0].TriangleCount = MESHCLUSTER_MAX_TRIANGLES + 1;
+	}));
+	CHECK(!Open_Patched([](std::vector<unsigned char>& Data)
+	{
+		Clusters_Of(Data)[0].VertexCount = MESHCLUSTER_MAX_VERTICES + 1;
+	}));
+}
+
+static void Test_Convert_Room()
+{
+	CThreadPool Pool(2);
+	TextMeshResult Parsed;
+	MeshCookStats Stats;
+
+	CHECK(ConvertTextMeshToBinary(SAMPLE_DIR "/room.txt", TEST_FILE_NAME, 42, Pool, Parsed, Stats));
+	CHECK(Parsed.ErrorCount == 0);
+	CHECK(Parsed.VertexCount == 2076 * 3);
+
+	CMeshFile MeshFile;
+	CHECK(MeshFile.Open(TEST_FILE_NAME));
+	CHECK(MeshFile.Header().VertexCount == 3879);
+	CHECK(MeshFile.Header().IndexCount == 2076 * 3);
+	CHECK(MeshFile.Header().IndexStride == 2);
+	CHECK(MeshFile.Header().SourceKey == 42);
+	CHECK(Stats.Optimize.After.ACMR <= Stats.Optimize.Before.ACMR);
+}
+
+int main()
+{
+	RUN_TEST(Test_Round_Trip);
+	RUN_TEST(Test_Unchanged_File_Opens);
+	RUN_TEST(Test_Truncated_File);
+	RUN_TEST(Test_Bad_Header);
+	RUN_TEST(Test_Offsets_Do_Not_Wrap);
+	RUN_TEST(Test_Index_Out_Of_Range);
+	RUN_TEST(Test_Cluster_Out_Of_Range);
+	RUN_TEST(Test_Convert_Room);
+
+	remove(TEST_FILE_NAME);
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,325 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Mesh Optimizer Tests
+//======================================================================================
+
+#include "TestCheck.h"
+
+#include "MeshOptimizer.h"
+#include "SyntheticMesh.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#define VERTEX_STRIDE (5 * sizeof(float))
+
+typedef std::array<uint32_t, 3> Triangle;
+
+//triangles rotated to start at the smallest index, the winding stays
+static std::vector<Triangle> Sorted_Triangles(const uint32_t* Indices, size_t IndexCount)
+{
+	std::vector<Triangle> Tris(IndexCount / 3);
+
+	for (size_t t = 0; t < Tris.size(); t++)
+	{
+		Triangle Tri = { Indices[t * 3], Indices[t * 3 + 1], Indices[t * 3 + 2] };
+		std::rotate(Tri.begin(), std::min_element(Tri.begin(), Tri.end()), Tri.end());
+		Tris[t] = Tri;
+	}
+
+	std::sort(Tris.begin(), Tris.end());
+
+	return Tris;
+}
+
+static bool Same_Triangles(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b)
+{
+	return a.size() == b.size() &&
+		Sorted_Triangles(a.data(), a.size()) == Sorted_Triangles(b.data(), b.size());
+}
+
+static void Make_Shuffled_Grid(uint32_t Quads, std::vector<float>& Vertices, std::vector<uint32_t>& Indices)
+{
+	MakeGridMesh(Quads, Quads, Vertices, Indices);
+	ShuffleTriangles(Indices, 7);
+}
+
+//axis aligned box of half size Size, triangles facing outwards
+static void Add_Box(float Size, std::vector<float>& Vertices, std::vector<uint32_t>& Indices)
+{
+	const uint32_t Base = (uint32_t)(Vertices.size() / 5);
+
+	for (int i = 0; i < 8; i++)
+	{
+		Vertices.push_back(i & 1 ? Size : -Size);
+		Vertices.push_back(i & 2 ? Size : -Size);
+		Vertices.push_back(i & 4 ? Size : -Size);
+		Vertices.push_back(0.0f);
+		Vertices.push_back(0.0f);
+	}
+
+	const uint32_t Faces[12][3] = {
+		{ 0, 2, 1 }, { 1, 2, 3 }, { 4, 5, 6 }, { 5, 7, 6 },
+		{ 0, 1, 4 }, { 1, 5, 4 }, { 2, 6, 3 }, { 3, 6, 7 },
+		{ 0, 4, 2 }, { 2, 4, 6 }, { 1, 3, 5 }, { 3, 7, 5 } };
+
+	for (const auto& Face : Faces)
+		for (uint32_t Index : Face)
+			Indices.push_back(Base + Index);
+}
+
+static void Test_Analyze_Single_Triangle()
+{
+	const uint32_t Indices[] = { 0, 1, 2 };
+
+	VertexCacheStats Stats = AnalyzeVertexCache(Indices, 3, 3);
+	CHECK(Stats.Misses == 3);
+	CHECK_NEAR(Stats.ACMR, 3.0, 1e-6);
+	CHECK_NEAR(Stats.ATVR, 1.0, 1e-6);
+}
+
+static void Test_Analyze_Shared_Edge()
+{
+	const uint32_t Indices[] = { 0, 1, 2, 2, 1, 3 };
+
+	VertexCacheStats Stats = AnalyzeVertexCache(Indices, 6, 4);
+	CHECK(Stats.Misses == 4);
+	CHECK_NEAR(Stats.ACMR, 2.0, 1e-6);
+	CHECK_NEAR(Stats.ATVR, 1.0, 1e-6);
+}
+
+static void Test_Analyze_Is_Fifo()
+{
+	//a hit does not move vertex 0 to the front, so it is evicted
+	//by 3 and missed again, an LRU cache would miss 7 times
+	const uint32_t Indices[] = { 0, 1, 2, 0, 3, 4, 0, 5, 6 };
+
+	VertexCacheStats Stats = AnalyzeVertexCache(Indices, 9, 7, 3);
+	CHECK(Stats.Misses == 8);
+	CHECK_NEAR(Stats.ATVR, 8.0 / 7.0, 1e-6);
+}
+
+static void Test_Analyze_Unused_Vertices()
+{
+	//ATVR is per used vertex, unused ones do not count
+	const uint32_t Indices[] = { 0, 2, 4 };
+
+	VertexCacheStats Stats = AnalyzeVertexCache(Indices, 3, 100);
+	CHECK(Stats.Misses == 3);
+	CHECK_NEAR(Stats.ATVR, 1.0, 1e-6);
+}
+
+static void Test_Analyze_Empty()
+{
+	VertexCacheStats Stats = AnalyzeVertexCache(nullptr, 0, 0);
+	CHECK(Stats.Misses == 0);
+	CHECK(Stats.ACMR == 0.0f);
+}
+
+static void Test_Vertex_Cache_Keeps_Triangles()
+{
+	std::vector<float> Vertices;
+	std::vector<uint32_t> Indices;
+	Make_Shuffled_Grid(40, Vertices, Indices);
+
+	const uint32_t VertexCount = (uint32_t)(Vertices.size() / 5);
+
+	std::vector<uint32_t> Optimized(Indices.size());
+	OptimizeVertexCache(Optimized.data(), Indices.data(), Indices.size(), VertexCount);
+
+	CHECK(Same_Triangles(Indices, Optimized));
+}
+
+static void Test_Vertex_Cache_Improves_Grid()
+{
+	std::vector<float> Vertices;
+	std::vector<uint32_t> Indices;
+	Make_Shuffled_Grid(100, Vertices, Indices);
+
+	const uint32_t VertexCount = (uint32_t)(Vertices.size() / 5);
+
+	std::vector<uint32_t> Optimized(Indices.size());
+	OptimizeVertexCache(Optimized.data(), Indices.data(), Indices.size(), VertexCount);
+
+	VertexCacheStats Before = AnalyzeVertexCache(Indices.data(), Indices.size(), VertexCount);
+	VertexCacheStats After = AnalyzeVertexCache(Optimized.data(), Optimized.size(), VertexCount);
+
+	//a shuffled grid misses almost every vertex, the best
+	//order of a grid is about 0.5 misses per triangle
+	CHECK(Before.ACMR > 2.5f);
+	CHECK(After.ACMR < 0.8f);
+	CHECK(After.ATVR < 1.5f);
+}
+
+static void Test_Vertex_Cache_High_Valence()
+{
+	//fan of 200 triangles around vertex 0, more than the valence table covers
+	std::vector<uint32_t> Indices;
+	for (uint32_t i = 1; i <= 200; i++)
+		Indices.insert(Indices.end(), { 0, i, i % 200 + 1 });
+
+	std::vector<uint32_t> Optimized(Indices.size());
+	OptimizeVertexCache(Optimized.data(), Indices.data(), Indices.size(), 201);
+
+	CHECK(Same_Triangles(Indices, Optimized));
+	CHECK(AnalyzeVertexCache(Optimized.data(), Optimized.size(), 201).ACMR < 1.2f);
+}
+
+static void Test_Vertex_Cache_Degenerate_Sizes()
+{
+	const uint32_t One[] = { 0, 1, 2 };
+	uint32_t Out[3] = {};
+
+	OptimizeVertexCache(Out, One, 3, 3);
+	CHECK(Out[0] == 0 && Out[1] == 1 && Out[2] == 2);
+
+	OptimizeVertexCache(Out, One, 0, 0);
+}
+
+static void Test_Overdraw_Keeps_Triangles_And_Cache()
+{
+	std::vector<float> Vertices;
+	std::vector<uint32_t> Indices;
+	Make_Shuffled_Grid(100, Vertices, Indices);
+
+	const uint32_t VertexCount = (uint32_t)(Vertices.size() / 5);
+	const float Threshold = 1.05f;
+
+	std::vector<uint32_t> CacheOptimized(Indices.size());
+	OptimizeVertexCache(CacheOptimized.data(), Indices.data(), Indices.size(), VertexCount);
+
+	std::vector<uint32_t> Optimized(Indices.size());
+	OptimizeOverdraw(Optimized.data(), CacheOptimized.data(), CacheOptimized.size(),
+		Vertices.data(), VERTEX_STRIDE, VertexCount, Threshold);
+
+	CHECK(Same_Triangles(Indices, Optimized));
+
+	float CacheAcmr = AnalyzeVertexCache(CacheOptimized.data(), CacheOptimized.size(), VertexCount).ACMR;
+	float OverdrawAcmr = AnalyzeVertexCache(Optimized.data(), Optimized.size(), VertexCount).ACMR;
+
+	//cluster splits cost a little vertex cache, bounded by the threshold
+	CHECK(OverdrawAcmr <= CacheAcmr * Threshold + 0.01f);
+}
+
+static void Test_Overdraw_Outer_Shell_First()
+{
+	//inner box first in the input, the outer box hides it
+	//so its triangles must be drawn first
+	std::vector<float> Vertices;
+	std::vector<uint32_t> Indices;
+	Add_Box(1.0f, Vertices, Indices);
+	Add_Box(10.0f, Vertices, Indices);
+
+	const uint32_t VertexCount = (uint32_t)(Vertices.size() / 5);
+
+	std::vector<uint32_t> Optimized(Indices.size());
+	OptimizeOverdraw(Optimized.data(), Indices.data(), Indices.size(),
+		Vertices.data(), VERTEX_STRIDE, VertexCount);
+
+	CHECK(Same_Triangles(Indices, Optimized));
+
+	//outer box vertices are 8 ... 15
+	for (size_t i = 0; i < 36; i++)
+		CHECK(Optimized[i] >= 8);
+}
+
+static void Test_Vertex_Fetch_First_Use_Order()
+{
+	std::vector<float> Vertices;
+	std::vector<uint32_t> Indices;
+	Make_Shuffled_Grid(30, Vertices, Indices);
+
+	//vertices no triangle uses are dropped
+	Vertices.insert(Vertices.end(), 10 * 5, 1.0f);
+
+	std::vector<unsigned char> Bytes((unsigned char*)Vertices.data(),
+		(unsigned char*)(Vertices.data() + Vertices.size()));
+	std::vector<unsigned char> SourceBytes = Bytes;
+	std::vector<uint32_t> SourceIndices = Indices;
+
+	uint32_t NewCount = OptimizeVertexFetch(Bytes, Indices, VERTEX_STRIDE);
+
+	CHECK(Bytes.size() == (size_t)NewCount * VERTEX_STRIDE);
+	CHECK(NewCount < Vertices.size() / 5);
+	CHECK(Indices.size() == SourceIndices.size());
+
+	//indices appear in order 0, 1, 2 ... and point to the same vertex data
+	uint32_t Next = 0;
+
+	for (size_t i = 0; i < Indices.size(); i++)
+	{
+		CHECK(Indices[i] <= Next);
+		if (Indices[i] == Next)
+			Next++;
+
+		CHECK(memcmp(&Bytes[(size_t)Indices[i] * VERTEX_STRIDE],
+			&SourceBytes[(size_t)SourceIndices[i] * VERTEX_STRIDE], VERTEX_STRIDE) == 0);
+	}
+
+	CHECK(Next == NewCount);
+}
+
+static void Test_Optimize_Mesh()
+{
+	std::vector<float> Vertices;
+	std::vector<uint32_t> Indices;
+	Make_Shuffled_Grid(80, Vertices, Indices);
+
+	std::vector<unsigned char> Bytes((unsigned char*)Vertices.data(),
+		(unsigned char*)(Vertices.data() + Vertices.size()));
+	std::vector<unsigned char> SourceBytes = Bytes;
+	std::vector<uint32_t> SourceIndices = Indices;
+
+	MeshOptimizeStats Stats = OptimizeMesh(Bytes, Indices, VERTEX_STRIDE);
+
+	CHECK(Stats.After.ACMR < Stats.Before.ACMR);
+	CHECK(Stats.After.ACMR < 0.85f);
+	CHECK(Stats.After.ATVR < 1.6f);
+
+	//same triangles by position, indices have been renumbered
+	auto Triangle_Positions = [](const std::vector<unsigned char>& Bytes, const std::vector<uint32_t>& Indices)
+	{
+		std::vector<std::array<float, 9>> Tris(Indices.size() / 3);
+
+		for (size_t t = 0; t < Tris.size(); t++)
+		{
+			for (int k = 0; k < 3; k++)
+				memcpy(&Tris[t][k * 3], &Bytes[(size_t)Indices[t * 3 + k] * VERTEX_STRIDE], 3 * sizeof(float));
+
+			//rotate to the smallest first vertex, winding stays
+			std::array<float, 9> Best = Tris[t];
+			for (int r = 1; r < 3; r++)
+			{
+				std::array<float, 9> Rotated;
+				for (int k = 0; k < 3; k++)
+					memcpy(&Rotated[k * 3], &Tris[t][((k + r) % 3) * 3], 3 * sizeof(float));
+				Best = std::min(Best, Rotated);
+			}
+			Tris[t] = Best;
+		}
+
+		std::sort(Tris.begin(), Tris.end());
+		return Tris;
+	};
+
+	CHECK(Triangle_Positions(Bytes, Indices) == Triangle_Positions(SourceBytes, SourceIndices));
+}
+
+int main()
+{
+	RUN_TEST(Test_Analyze_Single_Triangle);
+	RUN_TEST(Test_Analyze_Shared_Edge);
+	RUN_TEST(Test_Analyze_Is_Fifo);
+	RUN_TEST(Test_Analyze_Unused_Vertices);
+	RUN_TEST(Test_Analyze_Empty);
+	RUN_TEST(Test_Vertex_Cache_Keeps_Triangles);
+	RUN_TEST(Test_Vertex_Cache_Improves_Grid);
+	RUN_TEST(Test_Vertex_Cache_High_Valence);
+	RUN_TEST(Test_Vertex_Cache_Degenerate_Sizes);
+	RUN_TEST(Test_Overdraw_Keeps_Triangles_And_Cache);
+	RUN_TEST(Test_Overdraw_Outer_Shell_First);
+	RUN_TEST(Test_Vertex_Fetch_First_Use_Order);
+	RUN_TEST(Test_Optimize_Mesh);
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,292 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Mesh Processing Tests
+//======================================================================================
+
+//welded output is checked against the source vertex by vertex, unique
+//vertices must come in first use order and every index must point back
+//at the bytes it replaced
+
+#include "TestCheck.h"
+
+#include "MappedFile.h"
+#include "MeshProcessing.h"
+#include "TextMeshParser.h"
+#include "ThreadPool.h"
+
+#include <cstring>
+#include <set>
+#include <string>
+#include <vector>
+
+#define VERTEX_STRIDE (TEXTMESH_FLOATS_PER_VERTEX * sizeof(float))
+
+//index i of the welded mesh has the same bytes as source vertex i,
+//and a new unique vertex is always the next one
+static bool Weld_Matches(const std::vector<unsigned char>& Source, uint32_t Stride,
+	const std::vector<unsigned char>& Vertices, const std::vector<uint32_t>& Indices)
+{
+	const size_t VertexCount = Source.size() / Stride;
+	const size_t UniqueCount = Vertices.size() / Stride;
+
+	if (Indices.size() != VertexCount || Vertices.size() % Stride != 0)
+		return false;
+
+	uint32_t NextUnique = 0;
+
+	for (size_t i = 0; i < VertexCount; i++)
+	{
+		if (Indices[i] > NextUnique || Indices[i] >= UniqueCount)
+			return false;
+
+		if (Indices[i] == NextUnique)
+			NextUnique++;
+
+		if (memcmp(&Vertices[(size_t)Indices[i] * Stride], &Source[i * Stride], Stride) != 0)
+			return false;
+	}
+
+	return NextUnique == UniqueCount;
+}
+
+static size_t Count_Distinct(const std::vector<unsigned char>& Source, uint32_t Stride)
+{
+	std::set<std::string> Distinct;
+
+	for (size_t i = 0; i < Source.size(); i += Stride)
+		Distinct.insert(std::string((const char*)&Source[i], Stride));
+
+	return Distinct.size();
+}
+
+static void Append_Vertex(std::vector<unsigned char>& Source, float X, float Y, float Z, float U, float V)
+{
+	const float Vertex[TEXTMESH_FLOATS_PER_VERTEX] = { X, Y, Z, U, V };
+	Source.insert(Source.end(), (const unsigned char*)Vertex, (const unsigned char*)Vertex + VERTEX_STRIDE);
+}
+
+static void Test_First_Use_Order()
+{
+	//A B A C B D
+	std::vector<unsigned char> Source;
+	Append_Vertex(Source, 1.0f, 2.0f, 3.0f, 0.0f, 0.0f);
+	Append_Vertex(Source, 4.0f, 5.0f, 6.0f, 1.0f, 0.0f);
+	Append_Vertex(Source, 1.0f, 2.0f, 3.0f, 0.0f, 0.0f);
+	Append_Vertex(Source, 7.0f, 8.0f, 9.0f, 1.0f, 1.0f);
+	Append_Vertex(Source, 4.0f, 5.0f, 6.0f, 1.0f, 0.0f);
+	Append_Vertex(Source, 1.0f, 2.0f, 3.0f, 0.0f, 1.0f);
+
+	std::vector<unsigned char> Vertices;
+	std::vector<uint32_t> Indices;
+	WeldVertices(Source.data(), 6, VERTEX_STRIDE, Vertices, Indices);
+
+	CHECK(Vertices.size() == 4 * VERTEX_STRIDE);
+	CHECK(Indices == std::vector<uint32_t>({ 0, 1, 0, 2, 1, 3 }));
+	CHECK(Weld_Matches(Source, VERTEX_STRIDE, Vertices, Indices));
+
+	//A, B, C, D as they came
+	CHECK(memcmp(&Vertices[0 * VERTEX_STRIDE], &Source[0 * VERTEX_STRIDE], VERTEX_STRIDE) == 0);
+	CHECK(memcmp(&Vertices[1 * VERTEX_STRIDE], &Source[1 * VERTEX_STRIDE], VERTEX_STRIDE) == 0);
+	CHECK(memcmp(&Vertices[2 * VERTEX_STRIDE], &Source[3 * VERTEX_STRIDE], VERTEX_STRIDE) == 0);
+	CHECK(memcmp(&Vertices[3 * VERTEX_STRIDE], &Source[5 * VERTEX_STRIDE], VERTEX_STRIDE) == 0);
+}
+
+static void Test_Bitwise()
+{
+	//-0 and +0 compare equal as floats but are other bytes
+	std::vector<unsigned char> Source;
+	Append_Vertex(Source, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+	Append_Vertex(Source, -0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+	Append_Vertex(Source, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+
+	std::vector<unsigned char> Vertices;
+	std::vector<uint32_t> Indices;
+	WeldVertices(Source.data(), 3, VERTEX_STRIDE, Vertices, Indices);
+
+	CHECK(Indices == std::vector<uint32_t>({ 0, 1, 0 }));
+	CHECK(Weld_Matches(Source, VERTEX_STRIDE, Vertices, Indices));
+}
+
+static void Test_All_Unique()
+{
+	std::vector<unsigned char> Source;
+	for (int i = 0; i < 1000; i++)
+		Append_Vertex(Source, (float)i, (float)(i * 3), -(float)i, (float)(i % 7), 0.5f);
+
+	std::vector<unsigned char> Vertices;
+	std::vector<uint32_t> Indices;
+	WeldVertices(Source.data(), 1000, VERTEX_STRIDE, Vertices, Indices);
+
+	CHECK(Vertices == Source);
+
+	bool Identity = Indices.size() == 1000;
+	for (uint32_t i = 0; i < Indices.size(); i++)
+		Identity = Identity && Indices[i] == i;
+
+	CHECK(Identity);
+}
+
+static void Test_Many_Duplicates()
+{
+	//a small pool picked from over and over, odd stride so
+	//vertices are not float aligned
+	const uint32_t Stride = 7;
+	const uint32_t VertexCount = 20000;
+
+	std::vector<unsigned char> Source((size_t)VertexCount * Stride);
+	uint32_t Seed = 12345;
+
+	for (uint32_t i = 0; i < VertexCount; i++)
+	{
+		Seed = Seed * 1664525u + 1013904223u;
+		const uint32_t Pick = (Seed >> 16) % 300;
+
+		for (uint32_t b = 0; b < Stride; b++)
+			Source[(size_t)i * Stride + b] = (unsigned char)(Pick * (b + 1) + (Pick >> 8) * 31);
+	}
+
+	std::vector<unsigned char> Vertices;
+	std::vector<uint32_t> Indices;
+	WeldVertices(Source.data(), VertexCount, Stride, Vertices, Indices);
+
+	CHECK(Vertices.size() / Stride == Count_Distinct(Source, Stride));
+	CHECK(Weld_Matches(Source, Stride, Vertices, Indices));
+}
+
+static void Test_Zero_Vertices()
+{
+	//outputs holding something from an earlier weld
+	std::vector<unsigned char> Vertices(40, 1);
+	std::vector<uint32_t> Indices(3, 5);
+
+	WeldVertices(NULL, 0, VERTEX_STRIDE, Vertices, Indices);
+
+	CHECK(Vertices.empty());
+	CHECK(Indices.empty());
+}
+
+static void Test_Zero_Stride()
+{
+	//no bytes to compare, every vertex is the first one
+	std::vector<unsigned char> Source(1);
+	std::vector<unsigned char> Vertices(40, 1);
+	std::vector<uint32_t> Indices;
+
+	WeldVertices(Source.data(), 5, 0, Vertices, Indices);
+
+	CHECK(Vertices.empty());
+	CHECK(Indices == std::vector<uint32_t>(5, 0));
+}
+
+static void Test_Index_Stride()
+{
+	CHECK(IndexStrideFor(0) == 2);
+	CHECK(IndexStrideFor(1) == 2);
+	CHECK(IndexStrideFor(65535) == 2);
+	CHECK(IndexStrideFor(65536) == 2);
+	CHECK(IndexStrideFor(65537) == 4);
+	CHECK(IndexStrideFor(0xFFFFFFFF) == 4);
+}
+
+static void Test_Pack_Indices()
+{
+	//largest index 16 bit can hold
+	const std::vector<uint32_t> Short = { 0, 1, 65535, 300, 65534 };
+	std::vector<unsigned char> Packed(3, 7);
+
+	PackIndices(Short, 65536, Packed);
+	CHECK(Packed.size() == Short.size() * 2);
+
+	if (Packed.size() == Short.size() * 2)
+	{
+		uint16_t Read[5];
+		memcpy(Read, Packed.data(), sizeof(Read));
+
+		bool Same = true;
+		for (size_t i = 0; i < Short.size(); i++)
+			Same = Same && Read[i] == Short[i];
+
+		CHECK(Same);
+	}
+
+	//one vertex more and indices past 16 bit
+	const std::vector<uint32_t> Long = { 0, 65536, 65535, 1, 65536 };
+
+	PackIndices(Long, 65537, Packed);
+	CHECK(Packed.size() == Long.size() * 4);
+
+	if (Packed.size() == Long.size() * 4)
+		CHECK(memcmp(Packed.data(), Long.data(), Packed.size()) == 0);
+
+	PackIndices(std::vector<uint32_t>(), 3, Packed);
+	CHECK(Packed.empty());
+}
+
+static void Test_Weld_Stats()
+{
+	//room sized mesh, 16 bit indices
+	MeshWeldStats Stats = CalcWeldStats(6228, 3879, 6228, VERTEX_STRIDE);
+
+	CHECK(Stats.SourceVertexCount == 6228);
+	CHECK(Stats.VertexCount == 3879);
+	CHECK(Stats.IndexStride == 2);
+	CHECK(Stats.SourceByteSize == 6228ull * 20);
+	CHECK(Stats.ByteSize == 3879ull * 20 + 6228ull * 2);
+	CHECK(Stats.BytesSaved() == 124560 - 90036);
+	CHECK_NEAR(Stats.ReductionRatio(), 6228.0f / 3879.0f, 1e-6f);
+
+	//32 bit indices once past 65536 vertices, the weld costs bytes
+	Stats = CalcWeldStats(70000, 70000, 70000, VERTEX_STRIDE);
+
+	CHECK(Stats.IndexStride == 4);
+	CHECK(Stats.SourceByteSize == 70000ull * 20);
+	CHECK(Stats.ByteSize == 70000ull * 20 + 70000ull * 4);
+	CHECK(Stats.BytesSaved() == -70000ll * 4);
+	CHECK(Stats.ReductionRatio() == 1.0f);
+
+	//byte sizes do not wrap at 32 bit
+	Stats = CalcWeldStats(0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 64);
+	CHECK(Stats.SourceByteSize == 0xFFFFFFFFull * 64);
+	CHECK(Stats.ByteSize == 0xFFFFFFFFull * 68);
+
+	Stats = CalcWeldStats(0, 0, 0, VERTEX_STRIDE);
+	CHECK(Stats.SourceByteSize == 0 && Stats.ByteSize == 0);
+	CHECK(Stats.BytesSaved() == 0);
+	CHECK(Stats.ReductionRatio() == 0.0f);
+}
+
+static void Test_Weld_Room()
+{
+	CMappedFile TextFile;
+	CHECK(TextFile.Open(SAMPLE_DIR "/room.txt"));
+
+	CThreadPool Pool(2);
+	TextMeshResult Parsed;
+	CHECK(ParseTextMesh((const char*)TextFile.Data(), TextFile.Size(), Pool, Parsed));
+	CHECK(Parsed.VertexCount == 2076 * 3);
+
+	std::vector<unsigned char> Source((const unsigned char*)Parsed.Vertices.data(),
+		(const unsigned char*)Parsed.Vertices.data() + (size_t)Parsed.VertexCount * VERTEX_STRIDE);
+
+	std::vector<unsigned char> Vertices;
+	std::vector<uint32_t> Indices;
+	WeldVertices(Source.data(), Parsed.VertexCount, VERTEX_STRIDE, Vertices, Indices);
+
+	CHECK(Vertices.size() / VERTEX_STRIDE == 3879);
+	CHECK(Weld_Matches(Source, VERTEX_STRIDE, Vertices, Indices));
+}
+
+int main()
+{
+	RUN_TEST(Test_First_Use_Order);
+	RUN_TEST(Test_Bitwise);
+	RUN_TEST(Test_All_Unique);
+	RUN_TEST(Test_Many_Duplicates);
+	RUN_TEST(Test_Zero_Vertices);
+	RUN_TEST(Test_Zero_Stride);
+	RUN_TEST(Test_Index_Stride);
+	RUN_TEST(Test_Pack_Indices);
+	RUN_TEST(Test_Weld_Stats);
+	RUN_TEST(Test_Weld_Room);
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,298 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Pipeline Cache File Tests
+//======================================================================================
+
+//a cache is written, its bytes are patched or cut and read back,
+//every read that fails must leave Library and Entries empty so the
+//samples start over with an empty pipeline library
+
+#include "TestCheck.h"
+
+#include "PipelineCacheFile.h"
+
+#include <cstddef>
+#include <cstring>
+
+#define TEST_FILE_NAME "PipelineCacheFileTest.bin"
+
+static PipelineCacheId Make_Id()
+{
+	PipelineCacheId Id;
+	Id.VendorId = 0x10DE;
+	Id.DeviceId = 0x2484;
+	Id.SubSysId = 0x146710DE;
+	Id.Revision = 0xA1;
+	Id.DriverVersion = 0x001F000F00105F82ull;
+	return Id;
+}
+
+static std::vector<uint8_t> Make_Library()
+{
+	std::vector<uint8_t> Library(1000);
+	for (size_t i = 0; i < Library.size(); i++)
+		Library[i] = (uint8_t)(i * 7 + 3);
+	return Library;
+}
+
+//a pipeline with its own blob, one the library holds
+//and one more blob so records follow blobs in the file
+static PipelineCacheEntries Make_Entries()
+{
+	PipelineCacheEntries Entries;
+
+	Entries[0x1111222233334444ull].CompileTime = 12.5;
+	Entries[0x1111222233334444ull].Blob.assign(37, 0xAB);
+
+	Entries[0x5555666677778888ull].CompileTime = 3.25;
+
+	Entries[42].CompileTime = 0.75;
+	for (int i = 0; i < 300; i++)
+		Entries[42].Blob.push_back((uint8_t)i);
+
+	return Entries;
+}
+
+static bool Write_Test_Cache()
+{
+	std::vector<uint8_t> Library = Make_Library();
+	return WritePipelineCache(TEST_FILE_NAME, Make_Id(), Library.data(), Library.size(), Make_Entries());
+}
+
+static std::vector<uint8_t> Read_File(const char* FileName)
+{
+	std::vector<uint8_t> Data;
+
+	FILE* Fp = fopen(FileName, "rb");
+	if (Fp == NULL)
+		return Data;
+
+	uint8_t Buffer[4096];
+	size_t Read;
+	while ((Read = fread(Buffer, 1, sizeof(Buffer), Fp)) > 0)
+		Data.insert(Data.end(), Buffer, Buffer + Read);
+
+	fclose(Fp);
+
+	return Data;
+}
+
+static void Write_File(const char* FileName, const std::vector<uint8_t>& Data)
+{
+	FILE* Fp = fopen(FileName, "wb");
+	fwrite(Data.data(), 1, Data.size(), Fp);
+	fclose(Fp);
+}
+
+//reads with the outputs already holding something, false
+//also when the read failed but left any of it behind
+static bool Read_Test_Cache(const PipelineCacheId& Id)
+{
+	std::vector<uint8_t> Library(5, 1);
+	PipelineCacheEntries Entries;
+	Entries[7].Blob.assign(3, 2);
+
+	bool Result = ReadPipelineCache(TEST_FILE_NAME, Id, Library, Entries);
+
+	CHECK(Result || (Library.empty() && Entries.empty()));
+
+	return Result;
+}
+
+//writes the test cache, lets Patch change the bytes and reads it
+template <typename Func>
+static bool Read_Patched(Func Patch)
+{
+	Write_Test_Cache();
+
+	std::vector<uint8_t> Data = Read_File(TEST_FILE_NAME);
+	Patch(Data);
+	Write_File(TEST_FILE_NAME, Data);
+
+	return Read_Test_Cache(Make_Id());
+}
+
+template <typename T>
+static void Put(std::vector<uint8_t>& Data, size_t Offset, T Value)
+{
+	memcpy(Data.data() + Offset, &Value, sizeof(Value));
+}
+
+static void Test_Round_Trip()
+{
+	CHECK(Write_Test_Cache());
+
+	std::vector<uint8_t> Library;
+	PipelineCacheEntries Entries;
+	CHECK(ReadPipelineCache(TEST_FILE_NAME, Make_Id(), Library, Entries));
+
+	CHECK(Library == Make_Library());
+
+	PipelineCacheEntries Expected = Make_Entries();
+	CHECK(Entries.size() == Expected.size());
+
+	for (const auto& It : Expected)
+	{
+		auto Found = Entries.find(It.first);
+		CHECK(Found != Entries.end());
+
+		if (Found != Entries.end())
+		{
+			CHECK(Found->second.CompileTime == It.second.CompileTime);
+			CHECK(Found->second.Blob == It.second.Blob);
+		}
+	}
+
+	//nothing left of the temp file
+	CHECK(Read_File(TEST_FILE_NAME ".tmp").empty());
+}
+
+static void Test_Empty_Cache()
+{
+	CHECK(WritePipelineCache(TEST_FILE_NAME, Make_Id(), NULL, 0, PipelineCacheEntries()));
+	CHECK(Read_File(TEST_FILE_NAME).size() == sizeof(PipelineCacheHeader));
+
+	std::vector<uint8_t> Library;
+	PipelineCacheEntries Entries;
+	CHECK(ReadPipelineCache(TEST_FILE_NAME, Make_Id(), Library, Entries));
+	CHECK(Library.empty() && Entries.empty());
+}
+
+static void Test_Rewrite_Replaces()
+{
+	CHECK(Write_Test_Cache());
+
+	PipelineCacheEntries One;
+	One[9].Blob.assign(4, 9);
+	CHECK(WritePipelineCache(TEST_FILE_NAME, Make_Id(), NULL, 0, One));
+
+	std::vector<uint8_t> Library;
+	PipelineCacheEntries Entries;
+	CHECK(ReadPipelineCache(TEST_FILE_NAME, Make_Id(), Library, Entries));
+	CHECK(Library.empty());
+	CHECK(Entries.size() == 1 && Entries[9].Blob == One[9].Blob);
+}
+
+static void Test_Other_Id()
+{
+	CHECK(Write_Test_Cache());
+	CHECK(Read_Test_Cache(Make_Id()));
+
+	PipelineCacheId Id = Make_Id();
+	Id.VendorId++;
+	CHECK(!Read_Test_Cache(Id));
+
+	Id = Make_Id();
+	Id.DeviceId++;
+	CHECK(!Read_Test_Cache(Id));
+
+	Id = Make_Id();
+	Id.SubSysId++;
+	CHECK(!Read_Test_Cache(Id));
+
+	Id = Make_Id();
+	Id.Revision++;
+	CHECK(!Read_Test_Cache(Id));
+
+	//a driver update, only the high half changes
+	Id = Make_Id();
+	Id.DriverVersion += 1ull << 32;
+	CHECK(!Read_Test_Cache(Id));
+}
+
+static void Test_Missing_File()
+{
+	remove(TEST_FILE_NAME);
+	CHECK(!Read_Test_Cache(Make_Id()));
+}
+
+static void Test_Header()
+{
+	CHECK(Read_Patched([](std::vector<uint8_t>&) {}));
+
+	CHECK(!Read_Patched([](std::vector<uint8_t>& Data)
+	{
+		Put<uint32_t>(Data, offsetof(PipelineCacheHeader, Magic), 0x44484D4D);
+	}));
+
+	CHECK(!Read_Patched([](std::vector<uint8_t>& Data)
+	{
+		Put<uint32_t>(Data, offsetof(PipelineCacheHeader, Version), PIPELINECACHE_VERSION + 1);
+	}));
+}
+
+static void Test_Truncated()
+{
+	CHECK(Write_Test_Cache());
+	const std::vector<uint8_t> Data = Read_File(TEST_FILE_NAME);
+
+	//every cut, in the header, the library, a record or a blob
+	bool Valid = true;
+
+	for (size_t Size = 0; Size < Data.size(); Size++)
+	{
+		Write_File(TEST_FILE_NAME, std::vector<uint8_t>(Data.begin(), Data.begin() + Size));
+		Valid = Valid && !Read_Test_Cache(Make_Id());
+	}
+
+	CHECK(Valid);
+}
+
+//sizes past the end of the file fail before any allocation
+static void Test_Sizes_Past_End()
+{
+	CHECK(!Read_Patched([](std::vector<uint8_t>& Data)
+	{
+		Put<uint64_t>(Data, offsetof(PipelineCacheHeader, LibrarySize), Data.size() + 1);
+	}));
+
+	CHECK(!Read_Patched([](std::vector<uint8_t>& Data)
+	{
+		Put<uint64_t>(Data, offsetof(PipelineCacheHeader, LibrarySize), ~0ull);
+	}));
+
+	CHECK(!Read_Patched([](std::vector<uint8_t>& Data)
+	{
+		Put<uint32_t>(Data, offsetof(PipelineCacheHeader, EntryCount), 4);
+	}));
+
+	CHECK(!Read_Patched([](std::vector<uint8_t>& Data)
+	{
+		Put<uint32_t>(Data, offsetof(PipelineCacheHeader, EntryCount), ~0u);
+	}));
+
+	//the first record follows the library
+	const size_t BlobSizeOffset = sizeof(PipelineCacheHeader) + Make_Library().size() +
+		offsetof(PipelineCacheRecord, BlobSize);
+
+	CHECK(!Read_Patched([&](std::vector<uint8_t>& Data)
+	{
+		Put<uint64_t>(Data, BlobSizeOffset, Data.size() + 1);
+	}));
+
+	CHECK(!Read_Patched([&](std::vector<uint8_t>& Data)
+	{
+		Put<uint64_t>(Data, BlobSizeOffset, ~0ull);
+	}));
+
+	//a blob that fits the file but runs past its end
+	CHECK(!Read_Patched([&](std::vector<uint8_t>& Data)
+	{
+		Put<uint64_t>(Data, BlobSizeOffset, Data.size() - BlobSizeOffset);
+	}));
+}
+
+int main()
+{
+	RUN_TEST(Test_Round_Trip);
+	RUN_TEST(Test_Empty_Cache);
+	RUN_TEST(Test_Rewrite_Replaces);
+	RUN_TEST(Test_Other_Id);
+	RUN_TEST(Test_Missing_File);
+	RUN_TEST(Test_Header);
+	RUN_TEST(Test_Truncated);
+	RUN_TEST(Test_Sizes_Past_End);
+
+	remove(TEST_FILE_NAME);
+
+	return TEST_RESULT();
+}
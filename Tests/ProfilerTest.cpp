@@ -0,0 +1,294 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Profiler Tests
+//======================================================================================
+
+//every case records on a thread of its own, so it has a fresh ring,
+//then the trace of all threads is written, parsed by a strict JSON
+//reader and the events of that thread are picked out by its name
+
+#include "TestCheck.h"
+#include "TestJson.h"
+
+#include "Profiler.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#define TEST_FILE_NAME "ProfilerTest.json"
+
+struct TraceEvent
+{
+	std::string Name;
+	double Ts;
+	double Dur;
+};
+
+//writes the trace, checks it is JSON of the Chrome trace shape
+//and returns the complete events of the thread named ThreadName
+static bool Read_Thread_Events(const char* ThreadName, std::vector<TraceEvent>& Events)
+{
+	Events.clear();
+
+	if (!CProfiler::Write_Trace(TEST_FILE_NAME))
+		return false;
+
+	JsonValue Root;
+	if (!Read_Json_File(TEST_FILE_NAME, Root) || Root.Type != JsonValue::OBJECT)
+		return false;
+
+	const JsonValue* List = Root.Find("traceEvents");
+	if (List == nullptr || List->Type != JsonValue::ARRAY)
+		return false;
+
+	//thread ids are looked up by name, one thread per name
+	double Tid = -1.0;
+	int Named = 0;
+
+	for (const JsonValue& Event : List->Items)
+	{
+		const JsonValue* Ph = Event.Find("ph");
+		const JsonValue* EventTid = Event.Find("tid");
+		const JsonValue* Args = Event.Find("args");
+
+		if (Ph == nullptr || Ph->String != "M" || EventTid == nullptr || Args == nullptr)
+			continue;
+
+		const JsonValue* Name = Args->Find("name");
+		if (Name != nullptr && Name->String == ThreadName)
+		{
+			Tid = EventTid->Number;
+			Named++;
+		}
+	}
+
+	if (Named != 1)
+		return false;
+
+	for (const JsonValue& Event : List->Items)
+	{
+		const JsonValue* Ph = Event.Find("ph");
+		const JsonValue* EventTid = Event.Find("tid");
+
+		if (Ph == nullptr || Ph->String != "X" || EventTid == nullptr || EventTid->Number != Tid)
+			continue;
+
+		const JsonValue* Name = Event.Find("name");
+		const JsonValue* Ts = Event.Find("ts");
+		const JsonValue* Dur = Event.Find("dur");
+
+		if (Name == nullptr || Ts == nullptr || Dur == nullptr ||
+			Name->Type != JsonValue::STRING || Ts->Type != JsonValue::NUMBER || Dur->Type != JsonValue::NUMBER ||
+			Ts->Number < 0.0 || Dur->Number < 0.0)
+			return false;
+
+		Events.push_back({ Name->String, Ts->Number, Dur->Number });
+	}
+
+	return true;
+}
+
+template <typename Func>
+static void Run_On_Thread(Func Body)
+{
+	std::thread Thread(Body);
+	Thread.join();
+}
+
+//ts and dur are printed with 3 digits
+#define TIME_EPS 0.002
+
+static bool Inside(const TraceEvent& Inner, const TraceEvent& Outer)
+{
+	return Inner.Ts >= Outer.Ts - TIME_EPS &&
+		Inner.Ts + Inner.Dur <= Outer.Ts + Outer.Dur + TIME_EPS;
+}
+
+static void Test_Nothing_Recorded()
+{
+	//must run before any marker in the process
+	CHECK(!CProfiler::Write_Trace(TEST_FILE_NAME));
+
+	//End with nothing open is ignored
+	CProfiler::End();
+}
+
+static void Test_Nesting()
+{
+	Run_On_Thread([]
+	{
+		PROFILE_THREAD_NAME("Nesting");
+
+		PROFILE_SCOPE("Outer");
+		{
+			PROFILE_SCOPE("First");
+			{
+				PROFILE_SCOPE("Leaf");
+			}
+		}
+		{
+			PROFILE_SCOPE("Second");
+		}
+	});
+
+	std::vector<TraceEvent> Events;
+	CHECK(Read_Thread_Events("Nesting", Events));
+	CHECK(Events.size() == 4);
+
+	//recorded as they end
+	if (Events.size() == 4)
+	{
+		CHECK(Events[0].Name == "Leaf");
+		CHECK(Events[1].Name == "First");
+		CHECK(Events[2].Name == "Second");
+		CHECK(Events[3].Name == "Outer");
+
+		CHECK(Inside(Events[0], Events[1]));
+		CHECK(Inside(Events[1], Events[3]));
+		CHECK(Inside(Events[2], Events[3]));
+		CHECK(Events[1].Ts + Events[1].Dur <= Events[2].Ts + TIME_EPS);
+	}
+}
+
+static void Test_Max_Depth()
+{
+	const int Extra = 5;
+
+	Run_On_Thread([]
+	{
+		PROFILE_THREAD_NAME("Deep");
+
+		for (int i = 0; i < PROFILER_MAX_DEPTH + Extra; i++)
+			CProfiler::Begin(i < PROFILER_MAX_DEPTH ? "Recorded" : "Too Deep");
+
+		for (int i = 0; i < PROFILER_MAX_DEPTH + Extra; i++)
+			CProfiler::End();
+
+		//one End too many must not break the next scope
+		CProfiler::End();
+
+		PROFILE_SCOPE("After");
+	});
+
+	std::vector<TraceEvent> Events;
+	CHECK(Read_Thread_Events("Deep", Events));
+	CHECK(Events.size() == PROFILER_MAX_DEPTH + 1);
+
+	bool Nested = true;
+	for (size_t i = 0; i + 1 < Events.size() && i + 1 < PROFILER_MAX_DEPTH; i++)
+		Nested = Nested && Events[i].Name == "Recorded" && Inside(Events[i], Events[i + 1]);
+
+	CHECK(Nested);
+
+	if (!Events.empty())
+		CHECK(Events.back().Name == "After");
+}
+
+#define WRAP_EXTRA 1000
+
+static char g_RingNames[PROFILER_RING_SIZE + WRAP_EXTRA][8];
+
+static void Test_Ring_Wrap()
+{
+	const int Count = PROFILER_RING_SIZE + WRAP_EXTRA;
+
+	for (int i = 0; i < Count; i++)
+		snprintf(g_RingNames[i], sizeof(g_RingNames[i]), "%d", i);
+
+	Run_On_Thread([]
+	{
+		PROFILE_THREAD_NAME("Ring");
+
+		for (int i = 0; i < Count; i++)
+		{
+			PROFILE_SCOPE(g_RingNames[i]);
+		}
+	});
+
+	std::vector<TraceEvent> Events;
+	CHECK(Read_Thread_Events("Ring", Events));
+	CHECK(Events.size() == PROFILER_RING_SIZE);
+
+	//the oldest are gone, the newest are there in order
+	bool Newest = true;
+	for (size_t i = 0; i < Events.size(); i++)
+		Newest = Newest && Events[i].Name == g_RingNames[WRAP_EXTRA + i];
+
+	CHECK(Newest);
+}
+
+#define THREAD_COUNT 4
+
+static const char* g_ThreadNames[THREAD_COUNT] = { "Loader 0", "Loader 1", "Loader 2", "Loader 3" };
+static const char* g_EventNames[THREAD_COUNT] = { "Load 0", "Load 1", "Load 2", "Load 3" };
+
+static void Test_Threads()
+{
+	std::vector<std::thread> Threads;
+
+	for (int t = 0; t < THREAD_COUNT; t++)
+	{
+		Threads.emplace_back([t]
+		{
+			//named before the first marker or after it
+			if (t % 2 == 0)
+				PROFILE_THREAD_NAME(g_ThreadNames[t]);
+
+			for (int i = 0; i <= t; i++)
+			{
+				PROFILE_SCOPE(g_EventNames[t]);
+			}
+
+			if (t % 2 == 1)
+				PROFILE_THREAD_NAME(g_ThreadNames[t]);
+		});
+	}
+
+	for (std::thread& Thread : Threads)
+		Thread.join();
+
+	for (int t = 0; t < THREAD_COUNT; t++)
+	{
+		std::vector<TraceEvent> Events;
+		CHECK(Read_Thread_Events(g_ThreadNames[t], Events));
+		CHECK(Events.size() == (size_t)t + 1);
+
+		bool Own = true;
+		for (const TraceEvent& Event : Events)
+			Own = Own && Event.Name == g_EventNames[t];
+
+		CHECK(Own);
+	}
+}
+
+static void Test_Escaped_Names()
+{
+	Run_On_Thread([]
+	{
+		PROFILE_THREAD_NAME("Thread \"quoted\" C:\\path");
+
+		PROFILE_SCOPE("say \"hi\"\\ \x01tab\there\nnext \xC3\xA9");
+	});
+
+	//quotes and backslashes escaped, control characters dropped
+	std::vector<TraceEvent> Events;
+	CHECK(Read_Thread_Events("Thread \"quoted\" C:\\path", Events));
+	CHECK(Events.size() == 1);
+
+	if (Events.size() == 1)
+		CHECK(Events[0].Name == "say \"hi\"\\ tabherenext \xC3\xA9");
+}
+
+int main()
+{
+	RUN_TEST(Test_Nothing_Recorded);
+	RUN_TEST(Test_Nesting);
+	RUN_TEST(Test_Max_Depth);
+	RUN_TEST(Test_Ring_Wrap);
+	RUN_TEST(Test_Threads);
+	RUN_TEST(Test_Escaped_Names);
+
+	remove(TEST_FILE_NAME);
+
+	return TEST_RESULT();
+}
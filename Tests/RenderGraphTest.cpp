@@ -0,0 +1,621 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Render Graph Tests
+//======================================================================================
+
+//Execute goes to a recorder that keeps the barrier batches and
+//the passes in the order they run, a replay of the barriers
+//checks every pass finds its resources in the states it asked
+//for and every frame ends where the next one starts
+
+#include "TestCheck.h"
+
+#include "RenderGraph.h"
+
+#include <random>
+#include <vector>
+
+#define KB64 (64 * 1024)
+
+struct TestAccess
+{
+	uint32_t Resource;
+	RGState State;
+};
+
+//what the test declared, the graph does not give it back
+struct GraphSpec
+{
+	std::vector<std::vector<TestAccess>> Passes;
+	std::vector<uint64_t> Sizes;
+	std::vector<uint64_t> Alignments;
+	std::vector<RGState> Finals;
+	std::vector<bool> Imported;
+};
+
+//one event per barrier batch or pass run
+struct FrameEvent
+{
+	bool IsPass;
+	uint32_t Pass;
+	std::vector<RGBarrier> Barriers;
+};
+
+static std::vector<FrameEvent> g_Events;
+
+static uint32_t Add_Texture(CRenderGraph& Graph, GraphSpec& Spec, uint64_t Size, uint64_t Alignment)
+{
+	Spec.Sizes.push_back(Size);
+	Spec.Alignments.push_back(Alignment);
+	Spec.Finals.push_back(RG_STATE_COMMON);
+	Spec.Imported.push_back(false);
+
+	return Graph.Create_Texture("Texture", Size, Alignment);
+}
+
+static uint32_t Add_Import(CRenderGraph& Graph, GraphSpec& Spec, RGState Final)
+{
+	Spec.Sizes.push_back(0);
+	Spec.Alignments.push_back(1);
+	Spec.Finals.push_back(Final);
+	Spec.Imported.push_back(true);
+
+	return Graph.Import("Import", Final);
+}
+
+static uint32_t Add_Pass(CRenderGraph& Graph, GraphSpec& Spec)
+{
+	uint32_t Pass = Graph.Add_Pass("Pass", [Index = (uint32_t)Spec.Passes.size()]()
+	{
+		FrameEvent Event = { true, Index, {} };
+		g_Events.push_back(Event);
+	});
+
+	Spec.Passes.emplace_back();
+
+	return Pass;
+}
+
+static void Access(CRenderGraph& Graph, GraphSpec& Spec, uint32_t Pass, uint32_t Resource, RGState State, bool Write)
+{
+	if (Write)
+		Graph.Write(Pass, Resource, State);
+	else
+		Graph.Read(Pass, Resource, State);
+
+	TestAccess NewAccess = { Resource, State };
+	Spec.Passes[Pass].push_back(NewAccess);
+}
+
+static std::vector<FrameEvent> Run_Frame(const CRenderGraph& Graph)
+{
+	g_Events.clear();
+
+	Graph.Execute([](const RGBarrier* Barriers, uint32_t Count)
+	{
+		FrameEvent Event = { false, RG_INVALID, std::vector<RGBarrier>(Barriers, Barriers + Count) };
+		g_Events.push_back(Event);
+	});
+
+	return g_Events;
+}
+
+static bool Same_Barrier(const RGBarrier& a, const RGBarrier& b)
+{
+	if (a.Resource != b.Resource || a.Aliasing != b.Aliasing)
+		return false;
+
+	return a.Aliasing || (a.Before == b.Before && a.After == b.After);
+}
+
+static bool Same_Frame(const std::vector<FrameEvent>& a, const std::vector<FrameEvent>& b)
+{
+	if (a.size() != b.size())
+		return false;
+
+	for (size_t i = 0; i < a.size(); i++)
+	{
+		if (a[i].IsPass != b[i].IsPass || a[i].Pass != b[i].Pass || a[i].Barriers.size() != b[i].Barriers.size())
+			return false;
+
+		for (size_t j = 0; j < a[i].Barriers.size(); j++)
+		{
+			if (!Same_Barrier(a[i].Barriers[j], b[i].Barriers[j]))
+				return false;
+		}
+	}
+
+	return true;
+}
+
+//States holds the state of every resource before the frame, the
+//owner state for imports, and after it on return, the aliasing
+//barriers of each resource are counted into Aliasing
+static void Replay_Frame(const CRenderGraph& Graph, const GraphSpec& Spec,
+	const std::vector<FrameEvent>& Events, std::vector<RGState>& States, std::vector<int>& Aliasing)
+{
+	std::vector<bool> Moved(States.size(), false);
+	Aliasing.assign(States.size(), 0);
+
+	uint32_t LastPass = 0;
+	bool AnyPass = false;
+
+	for (const FrameEvent& Event : Events)
+	{
+		if (Event.IsPass)
+		{
+			CHECK(!Graph.Is_Culled(Event.Pass));
+			CHECK(!AnyPass || Event.Pass > LastPass);
+
+			for (const TestAccess& A : Spec.Passes[Event.Pass])
+				CHECK(States[A.Resource] == A.State);
+
+			LastPass = Event.Pass;
+			AnyPass = true;
+			continue;
+		}
+
+		CHECK(!Event.Barriers.empty());
+
+		for (const RGBarrier& B : Event.Barriers)
+		{
+			if (B.Aliasing)
+			{
+				//makes the resource the owner before it moves
+				CHECK(!Graph.Is_Imported(B.Resource));
+				CHECK(!Moved[B.Resource]);
+				Aliasing[B.Resource]++;
+				continue;
+			}
+
+			CHECK(B.Before != B.After);
+			CHECK(B.After != RG_STATE_UNKNOWN);
+
+			//only the first move of an import leaves the state
+			//to its owner, the graph knows every other one
+			if (Spec.Imported[B.Resource] && !Moved[B.Resource])
+				CHECK(B.Before == RG_STATE_UNKNOWN);
+			else
+				CHECK(B.Before == States[B.Resource]);
+
+			States[B.Resource] = B.After;
+			Moved[B.Resource] = true;
+		}
+	}
+
+	for (uint32_t r = 0; r < (uint32_t)States.size(); r++)
+	{
+		if (Spec.Imported[r])
+			CHECK(States[r] == Spec.Finals[r]);
+		else if (Graph.Is_Allocated(r))
+			CHECK(States[r] == Graph.Create_State(r));
+	}
+}
+
+static std::vector<RGState> Start_States(const CRenderGraph& Graph, const GraphSpec& Spec, RGState ImportState)
+{
+	std::vector<RGState> States(Spec.Sizes.size());
+
+	for (uint32_t r = 0; r < (uint32_t)States.size(); r++)
+		States[r] = Spec.Imported[r] ? ImportState : Graph.Create_State(r);
+
+	return States;
+}
+
+static bool Memory_Overlap(const CRenderGraph& Graph, const GraphSpec& Spec, uint32_t a, uint32_t b)
+{
+	return Graph.Offset(a) < Graph.Offset(b) + Spec.Sizes[b] &&
+		Graph.Offset(b) < Graph.Offset(a) + Spec.Sizes[a];
+}
+
+//first and last pass left after culling that use the resource
+static void Lifetime(const CRenderGraph& Graph, const GraphSpec& Spec, uint32_t Resource,
+	uint32_t& First, uint32_t& Last)
+{
+	First = RG_INVALID;
+	Last = RG_INVALID;
+
+	for (uint32_t p = 0; p < (uint32_t)Spec.Passes.size(); p++)
+	{
+		if (Graph.Is_Culled(p))
+			continue;
+
+		for (const TestAccess& A : Spec.Passes[p])
+		{
+			if (A.Resource != Resource)
+				continue;
+
+			if (First == RG_INVALID)
+				First = p;
+
+			Last = p;
+		}
+	}
+}
+
+//no two transients alive in one pass share memory, everything
+//is aligned and inside the heap
+static void Check_Placement(const CRenderGraph& Graph, const GraphSpec& Spec)
+{
+	uint32_t Count = (uint32_t)Spec.Sizes.size();
+
+	for (uint32_t a = 0; a < Count; a++)
+	{
+		if (!Graph.Is_Allocated(a))
+			continue;
+
+		CHECK(Graph.Offset(a) % Spec.Alignments[a] == 0);
+		CHECK(Graph.Offset(a) + Spec.Sizes[a] <= Graph.Heap_Size());
+		CHECK(Graph.Heap_Alignment() % Spec.Alignments[a] == 0);
+
+		uint32_t FirstA, LastA;
+		Lifetime(Graph, Spec, a, FirstA, LastA);
+
+		for (uint32_t b = a + 1; b < Count; b++)
+		{
+			if (!Graph.Is_Allocated(b))
+				continue;
+
+			uint32_t FirstB, LastB;
+			Lifetime(Graph, Spec, b, FirstB, LastB);
+
+			bool Alive = FirstA <= LastB && FirstB <= LastA;
+			CHECK(!(Alive && Memory_Overlap(Graph, Spec, a, b)));
+		}
+	}
+
+	CHECK(Graph.Heap_Size() <= Graph.Unaliased_Size());
+}
+
+//a transient sharing memory with any other gets one aliasing
+//barrier every frame in its first pass, the others get none
+static void Check_Aliasing(const CRenderGraph& Graph, const GraphSpec& Spec,
+	const std::vector<FrameEvent>& Events, const std::vector<int>& Aliasing)
+{
+	uint32_t Count = (uint32_t)Spec.Sizes.size();
+
+	for (uint32_t r = 0; r < Count; r++)
+	{
+		bool Shared = false;
+		for (uint32_t o = 0; o < Count && Graph.Is_Allocated(r); o++)
+		{
+			if (o != r && Graph.Is_Allocated(o) && Memory_Overlap(Graph, Spec, r, o))
+				Shared = true;
+		}
+
+		CHECK(Aliasing[r] == (Shared ? 1 : 0));
+	}
+
+	//the barrier batch of a pass comes right before it runs
+	for (size_t i = 0; i < Events.size(); i++)
+	{
+		if (Events[i].IsPass)
+			continue;
+
+		for (const RGBarrier& B : Events[i].Barriers)
+		{
+			if (!B.Aliasing)
+				continue;
+
+			CHECK(i + 1 < Events.size() && Events[i + 1].IsPass);
+			if (i + 1 >= Events.size())
+				continue;
+
+			uint32_t First, Last;
+			Lifetime(Graph, Spec, B.Resource, First, Last);
+			CHECK(Events[i + 1].Pass == First);
+		}
+	}
+}
+
+static void Test_Culling()
+{
+	CRenderGraph Graph;
+	GraphSpec Spec;
+
+	uint32_t Unread = Add_Texture(Graph, Spec, KB64, KB64);
+	uint32_t Chain1 = Add_Texture(Graph, Spec, KB64, KB64);
+	uint32_t Chain2 = Add_Texture(Graph, Spec, KB64, KB64);
+	uint32_t Used = Add_Texture(Graph, Spec, KB64, KB64);
+	uint32_t BackBuffer = Add_Import(Graph, Spec, RG_STATE_PRESENT);
+	uint32_t History = Add_Import(Graph, Spec, RG_STATE_SHADER_READ);
+
+	//nothing reads it
+	uint32_t Lonely = Add_Pass(Graph, Spec);
+	Access(Graph, Spec, Lonely, Unread, RG_STATE_RENDER_TARGET, true);
+
+	//a chain that ends in a pass nothing needs goes whole
+	uint32_t ChainA = Add_Pass(Graph, Spec);
+	Access(Graph, Spec, ChainA, Chain1, RG_STATE_RENDER_TARGET, true);
+	uint32_t ChainB = Add_Pass(Graph, Spec);
+	Access(Graph, Spec, ChainB, Chain1, RG_STATE_SHADER_READ, false);
+	Access(Graph, Spec, ChainB, Chain2, RG_STATE_RENDER_TARGET, true);
+
+	uint32_t Produce = Add_Pass(Graph, Spec);
+	Access(Graph, Spec, Produce, Used, RG_STATE_RENDER_TARGET, true);
+
+	//writes an import with nothing after it, stays
+	uint32_t Copy = Add_Pass(Graph, Spec);
+	Access(Graph, Spec, Copy, History, RG_STATE_COPY_DEST, true);
+
+	uint32_t Final = Add_Pass(Graph, Spec);
+	Access(Graph, Spec, Final, Used, RG_STATE_SHADER_READ, false);
+	Access(Graph, Spec, Final, BackBuffer, RG_STATE_RENDER_TARGET, true);
+
+	CHECK(Graph.Compile());
+
+	CHECK(Graph.Is_Culled(Lonely));
+	CHECK(Graph.Is_Culled(ChainA));
+	CHECK(Graph.Is_Culled(ChainB));
+	CHECK(!Graph.Is_Culled(Produce));
+	CHECK(!Graph.Is_Culled(Copy));
+	CHECK(!Graph.Is_Culled(Final));
+	CHECK(Graph.Culled_Count() == 3);
+
+	CHECK(!Graph.Is_Allocated(Unread));
+	CHECK(!Graph.Is_Allocated(Chain1));
+	CHECK(!Graph.Is_Allocated(Chain2));
+	CHECK(Graph.Is_Allocated(Used));
+	CHECK(!Graph.Is_Allocated(BackBuffer));
+
+	CHECK(Graph.Pass_Barriers(Lonely).empty());
+	CHECK(Graph.Heap_Size() == KB64);
+	CHECK(Graph.Unaliased_Size() == KB64);
+
+	std::vector<FrameEvent> Events = Run_Frame(Graph);
+
+	std::vector<uint32_t> Ran;
+	for (const FrameEvent& Event : Events)
+	{
+		if (Event.IsPass)
+			Ran.push_back(Event.Pass);
+	}
+
+	CHECK(Ran.size() == 3);
+	CHECK(Ran.size() == 3 && Ran[0] == Produce && Ran[1] == Copy && Ran[2] == Final);
+
+	//one pass asks for a resource in two states
+	CRenderGraph Bad;
+	uint32_t Tex = Bad.Create_Texture("Texture", KB64, KB64);
+	uint32_t Out = Bad.Import("Import", RG_STATE_PRESENT);
+	uint32_t Pass = Bad.Add_Pass("Pass", nullptr);
+	Bad.Read(Pass, Tex, RG_STATE_SHADER_READ);
+	Bad.Write(Pass, Tex, RG_STATE_RENDER_TARGET);
+	Bad.Write(Pass, Out, RG_STATE_RENDER_TARGET);
+	CHECK(!Bad.Compile());
+}
+
+static void Test_Barriers_Across_Frames()
+{
+	CRenderGraph Graph;
+	GraphSpec Spec;
+
+	uint32_t Color = Add_Texture(Graph, Spec, 4 * KB64, KB64);
+	uint32_t Depth = Add_Texture(Graph, Spec, 2 * KB64, KB64);
+	uint32_t BackBuffer = Add_Import(Graph, Spec, RG_STATE_PRESENT);
+	uint32_t DepthStencil = Add_Import(Graph, Spec, RG_STATE_DEPTH_WRITE);
+
+	uint32_t Scene = Add_Pass(Graph, Spec);
+	Access(Graph, Spec, Scene, Color, RG_STATE_RENDER_TARGET, true);
+	Access(Graph, Spec, Scene, Depth, RG_STATE_DEPTH_WRITE, true);
+	Access(Graph, Spec, Scene, DepthStencil, RG_STATE_DEPTH_WRITE, true);
+
+	uint32_t Post = Add_Pass(Graph, Spec);
+	Access(Graph, Spec, Post, Color, RG_STATE_SHADER_READ, false);
+	Access(Graph, Spec, Post, Depth, RG_STATE_SHADER_READ, false);
+	Access(Graph, Spec, Post, BackBuffer, RG_STATE_RENDER_TARGET, true);
+	Access(Graph, Spec, Post, DepthStencil, RG_STATE_DEPTH_WRITE, true);
+
+	CHECK(Graph.Compile());
+
+	//transients are made in their last state, the first pass
+	//moves them from there
+	CHECK(Graph.Create_State(Color) == RG_STATE_SHADER_READ);
+	CHECK(Graph.Create_State(Depth) == RG_STATE_SHADER_READ);
+
+	const std::vector<RGBarrier>& SceneBarriers = Graph.Pass_Barriers(Scene);
+	CHECK(SceneBarriers.size() == 3);
+	if (SceneBarriers.size() == 3)
+	{
+		RGBarrier Expect0 = { Color, false, RG_STATE_SHADER_READ, RG_STATE_RENDER_TARGET };
+		RGBarrier Expect1 = { Depth, false, RG_STATE_SHADER_READ, RG_STATE_DEPTH_WRITE };
+		RGBarrier Expect2 = { DepthStencil, false, RG_STATE_UNKNOWN, RG_STATE_DEPTH_WRITE };
+		CHECK(Same_Barrier(SceneBarriers[0], Expect0));
+		CHECK(Same_Barrier(SceneBarriers[1], Expect1));
+		CHECK(Same_Barrier(SceneBarriers[2], Expect2));
+	}
+
+	//the depth stencil stays in DEPTH_WRITE, no second barrier
+	const std::vector<RGBarrier>& PostBarriers = Graph.Pass_Barriers(Post);
+	CHECK(PostBarriers.size() == 3);
+	if (PostBarriers.size() == 3)
+	{
+		RGBarrier Expect0 = { Color, false, RG_STATE_RENDER_TARGET, RG_STATE_SHADER_READ };
+		RGBarrier Expect1 = { Depth, false, RG_STATE_DEPTH_WRITE, RG_STATE_SHADER_READ };
+		RGBarrier Expect2 = { BackBuffer, false, RG_STATE_UNKNOWN, RG_STATE_RENDER_TARGET };
+		CHECK(Same_Barrier(PostBarriers[0], Expect0));
+		CHECK(Same_Barrier(PostBarriers[1], Expect1));
+		CHECK(Same_Barrier(PostBarriers[2], Expect2));
+	}
+
+	const std::vector<RGBarrier>& FinalBarriers = Graph.Final_Barriers();
+	CHECK(FinalBarriers.size() == 1);
+	if (FinalBarriers.size() == 1)
+	{
+		RGBarrier Expect = { BackBuffer, false, RG_STATE_RENDER_TARGET, RG_STATE_PRESENT };
+		CHECK(Same_Barrier(FinalBarriers[0], Expect));
+	}
+
+	//the owner has the back buffer in PRESENT, every frame is
+	//the same and ends where the next one starts
+	std::vector<RGState> States = Start_States(Graph, Spec, RG_STATE_PRESENT);
+	States[DepthStencil] = RG_STATE_DEPTH_WRITE;
+	std::vector<int> Aliasing;
+
+	std::vector<FrameEvent> First = Run_Frame(Graph);
+	Replay_Frame(Graph, Spec, First, States, Aliasing);
+
+	for (int Frame = 0; Frame < 3; Frame++)
+	{
+		std::vector<FrameEvent> Next = Run_Frame(Graph);
+		CHECK(Same_Frame(First, Next));
+		Replay_Frame(Graph, Spec, Next, States, Aliasing);
+	}
+
+	//both alive in both passes, no aliasing
+	CHECK(Aliasing[Color] == 0 && Aliasing[Depth] == 0);
+	CHECK(Graph.Heap_Size() == 6 * KB64);
+}
+
+static void Test_Aliasing_Chain()
+{
+	CRenderGraph Graph;
+	GraphSpec Spec;
+
+	//A feeds B feeds C, A and C are never alive together
+	uint32_t A = Add_Texture(Graph, Spec, 4 * KB64, KB64);
+	uint32_t B = Add_Texture(Graph, Spec, 4 * KB64, KB64);
+	uint32_t C = Add_Texture(Graph, Spec, 4 * KB64, KB64);
+	uint32_t Small = Add_Texture(Graph, Spec, KB64, KB64);
+	uint32_t BackBuffer = Add_Import(Graph, Spec, RG_STATE_PRESENT);
+
+	uint32_t Pass0 = Add_Pass(Graph, Spec);
+	Access(Graph, Spec, Pass0, A, RG_STATE_RENDER_TARGET, true);
+
+	uint32_t Pass1 = Add_Pass(Graph, Spec);
+	Access(Graph, Spec, Pass1, A, RG_STATE_SHADER_READ, false);
+	Access(Graph, Spec, Pass1, B, RG_STATE_RENDER_TARGET, true);
+
+	uint32_t Pass2 = Add_Pass(Graph, Spec);
+	Access(Graph, Spec, Pass2, B, RG_STATE_SHADER_READ, false);
+	Access(Graph, Spec, Pass2, C, RG_STATE_RENDER_TARGET, true);
+
+	uint32_t Pass3 = Add_Pass(Graph, Spec);
+	Access(Graph, Spec, Pass3, C, RG_STATE_SHADER_READ, false);
+	Access(Graph, Spec, Pass3, Small, RG_STATE_RENDER_TARGET, true);
+
+	uint32_t Pass4 = Add_Pass(Graph, Spec);
+	Access(Graph, Spec, Pass4, Small, RG_STATE_SHADER_READ, false);
+	Access(Graph, Spec, Pass4, BackBuffer, RG_STATE_RENDER_TARGET, true);
+
+	CHECK(Graph.Compile());
+	Check_Placement(Graph, Spec);
+
+	//A and C share, B sits next to them, Small goes into the
+	//memory of A and B that is free by then
+	CHECK(Graph.Offset(A) == Graph.Offset(C));
+	CHECK(Graph.Offset(B) != Graph.Offset(A));
+	CHECK(Graph.Heap_Size() == 8 * KB64);
+	CHECK(Graph.Unaliased_Size() == 13 * KB64);
+
+	std::vector<RGState> States = Start_States(Graph, Spec, RG_STATE_PRESENT);
+	std::vector<int> Aliasing;
+
+	for (int Frame = 0; Frame < 2; Frame++)
+	{
+		std::vector<FrameEvent> Events = Run_Frame(Graph);
+		Replay_Frame(Graph, Spec, Events, States, Aliasing);
+		Check_Aliasing(Graph, Spec, Events, Aliasing);
+	}
+
+	//the aliasing barrier comes before the transition of the
+	//same resource in the batch
+	const std::vector<RGBarrier>& Barriers = Graph.Pass_Barriers(Pass2);
+	CHECK(Barriers.size() >= 2);
+	bool SeenAliasing = false;
+	for (const RGBarrier& Barrier : Barriers)
+	{
+		if (Barrier.Resource != C)
+			continue;
+
+		if (Barrier.Aliasing)
+			SeenAliasing = true;
+		else
+			CHECK(SeenAliasing);
+	}
+	CHECK(SeenAliasing);
+}
+
+static void Test_Random_Graphs()
+{
+	std::mt19937 Rng(1234);
+
+	static const RGState WriteStates[] = { RG_STATE_RENDER_TARGET, RG_STATE_DEPTH_WRITE, RG_STATE_COPY_DEST };
+	static const RGState ReadStates[] = { RG_STATE_SHADER_READ, RG_STATE_COPY_SOURCE, RG_STATE_DEPTH_READ };
+
+	int AliasedGraphs = 0;
+
+	for (int Iteration = 0; Iteration < 2000; Iteration++)
+	{
+		CRenderGraph Graph;
+		GraphSpec Spec;
+
+		uint32_t TextureCount = 2 + Rng() % 10;
+		for (uint32_t t = 0; t < TextureCount; t++)
+		{
+			//now and then an MSAA sized alignment
+			uint64_t Alignment = Rng() % 8 == 0 ? 64 * KB64 : KB64;
+			uint64_t Size = (1 + Rng() % 16) * KB64;
+			Add_Texture(Graph, Spec, Size, Alignment);
+		}
+
+		uint32_t BackBuffer = Add_Import(Graph, Spec, RG_STATE_PRESENT);
+
+		uint32_t PassCount = 2 + Rng() % 12;
+		for (uint32_t p = 0; p < PassCount; p++)
+		{
+			uint32_t Pass = Add_Pass(Graph, Spec);
+
+			std::vector<bool> Used(TextureCount, false);
+			uint32_t AccessCount = 1 + Rng() % 3;
+
+			for (uint32_t a = 0; a < AccessCount; a++)
+			{
+				uint32_t Tex = Rng() % TextureCount;
+				if (Used[Tex])
+					continue;
+
+				Used[Tex] = true;
+
+				bool Write = Rng() % 2 == 0;
+				RGState State = Write ? WriteStates[Rng() % 3] : ReadStates[Rng() % 3];
+				Access(Graph, Spec, Pass, Tex, State, Write);
+			}
+
+			if (p == PassCount - 1)
+				Access(Graph, Spec, Pass, BackBuffer, RG_STATE_RENDER_TARGET, true);
+		}
+
+		CHECK(Graph.Compile());
+		CHECK(!Graph.Is_Culled(PassCount - 1));
+
+		Check_Placement(Graph, Spec);
+
+		std::vector<RGState> States = Start_States(Graph, Spec, RG_STATE_PRESENT);
+		std::vector<int> Aliasing;
+
+		std::vector<FrameEvent> First = Run_Frame(Graph);
+		Replay_Frame(Graph, Spec, First, States, Aliasing);
+		Check_Aliasing(Graph, Spec, First, Aliasing);
+
+		std::vector<FrameEvent> Second = Run_Frame(Graph);
+		CHECK(Same_Frame(First, Second));
+		Replay_Frame(Graph, Spec, Second, States, Aliasing);
+
+		if (Graph.Heap_Size() < Graph.Unaliased_Size())
+			AliasedGraphs++;
+	}
+
+	//the random graphs do reach the aliasing code
+	CHECK(AliasedGraphs > 100);
+	printf("    %d of 2000 graphs aliased memory\n", AliasedGraphs);
+}
+
+int main()
+{
+	RUN_TEST(Test_Culling);
+	RUN_TEST(Test_Barriers_Across_Frames);
+	RUN_TEST(Test_Aliasing_Chain);
+	RUN_TEST(Test_Random_Graphs);
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,407 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Resource State Tracker Tests
+//======================================================================================
+
+//Flush goes to a mock command list that keeps every ResourceBarrier
+//call, a replay of the barriers checks each StateBefore the way the
+//debug layer does and that the states end where the tracker says
+
+#include "TestCheck.h"
+
+#include "ResourceStateTracker.h"
+
+#include <map>
+#include <random>
+#include <utility>
+#include <vector>
+
+struct MockCommandList
+{
+	std::vector<std::vector<D3D12_RESOURCE_BARRIER>> Calls;
+
+	void ResourceBarrier(UINT NumBarriers, const D3D12_RESOURCE_BARRIER* Barriers)
+	{
+		Calls.emplace_back(Barriers, Barriers + NumBarriers);
+	}
+};
+
+//made up resources, only the addresses are used
+static ID3D12Resource* Resource(int Index)
+{
+	static char Dummies[16];
+	return (ID3D12Resource*)&Dummies[Index];
+}
+
+static const D3D12_RESOURCE_STATES RT = D3D12_RESOURCE_STATE_RENDER_TARGET;
+static const D3D12_RESOURCE_STATES PSR = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
+static const D3D12_RESOURCE_STATES NPSR = D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
+static const D3D12_RESOURCE_STATES CopySrc = D3D12_RESOURCE_STATE_COPY_SOURCE;
+static const D3D12_RESOURCE_STATES CopyDst = D3D12_RESOURCE_STATE_COPY_DEST;
+static const D3D12_RESOURCE_STATES DepthWrite = D3D12_RESOURCE_STATE_DEPTH_WRITE;
+
+static bool Is_Barrier(const D3D12_RESOURCE_BARRIER& b, ID3D12Resource* Res, UINT Subresource,
+	D3D12_RESOURCE_STATES Before, D3D12_RESOURCE_STATES After)
+{
+	return b.Type == D3D12_RESOURCE_BARRIER_TYPE_TRANSITION &&
+		b.Transition.pResource == Res && b.Transition.Subresource == Subresource &&
+		b.Transition.StateBefore == Before && b.Transition.StateAfter == After;
+}
+
+static bool Has_Barrier(const std::vector<D3D12_RESOURCE_BARRIER>& Barriers, ID3D12Resource* Res, UINT Subresource,
+	D3D12_RESOURCE_STATES Before, D3D12_RESOURCE_STATES After)
+{
+	for (const D3D12_RESOURCE_BARRIER& b : Barriers)
+		if (Is_Barrier(b, Res, Subresource, Before, After))
+			return true;
+
+	return false;
+}
+
+static void Test_Batching()
+{
+	CResourceStateTracker States;
+	MockCommandList List;
+
+	States.Register(Resource(0), RT);
+	States.Register(Resource(1), DepthWrite);
+	States.Register(Resource(2), PSR);
+
+	States.Transition(Resource(0), PSR);
+	States.Transition(Resource(1), D3D12_RESOURCE_STATE_DEPTH_READ);
+	States.Transition(Resource(2), RT);
+	CHECK(States.Pending_Count() == 3);
+
+	//state follows recording, not flushing
+	CHECK(States.State(Resource(0)) == PSR);
+
+	States.Flush(&List);
+	CHECK(List.Calls.size() == 1);
+	CHECK(List.Calls[0].size() == 3);
+	CHECK(Is_Barrier(List.Calls[0][0], Resource(0), D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, RT, PSR));
+	CHECK(Is_Barrier(List.Calls[0][1], Resource(1), D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, DepthWrite, D3D12_RESOURCE_STATE_DEPTH_READ));
+	CHECK(Is_Barrier(List.Calls[0][2], Resource(2), D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, PSR, RT));
+	CHECK(States.Pending_Count() == 0);
+
+	//nothing pending, no call
+	States.Flush(&List);
+	CHECK(List.Calls.size() == 1);
+
+	CHECK(States.Barrier_Count() == 3);
+	CHECK(States.Batch_Count() == 1);
+
+	States.Reset_Stats();
+	CHECK(States.Barrier_Count() == 0 && States.Batch_Count() == 0 && States.Dropped_Count() == 0);
+}
+
+static void Test_Redundant()
+{
+	CResourceStateTracker States;
+	MockCommandList List;
+
+	States.Register(Resource(0), RT);
+	States.Register(Resource(1), PSR | NPSR);
+
+	States.Transition(Resource(0), RT);
+	CHECK(States.Dropped_Count() == 1);
+
+	//a read state inside a combined read state
+	States.Transition(Resource(1), PSR);
+	States.Transition(Resource(1), NPSR);
+	CHECK(States.Dropped_Count() == 3);
+	CHECK(States.State(Resource(1)) == (PSR | NPSR));
+
+	//more read bits than the resource is in, or a write, need barriers
+	States.Register(Resource(2), PSR);
+	States.Transition(Resource(2), PSR | CopySrc);
+	States.Register(Resource(3), PSR);
+	States.Transition(Resource(3), CopyDst);
+	CHECK(States.Pending_Count() == 2);
+
+	States.Flush(&List);
+	CHECK(List.Calls.size() == 1 && List.Calls[0].size() == 2);
+	CHECK(Is_Barrier(List.Calls[0][0], Resource(2), D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, PSR, PSR | CopySrc));
+	CHECK(Is_Barrier(List.Calls[0][1], Resource(3), D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, PSR, CopyDst));
+}
+
+static void Test_Fold_And_Cancel()
+{
+	CResourceStateTracker States;
+	MockCommandList List;
+
+	//two moves before a flush fold into one barrier
+	States.Register(Resource(0), RT);
+	States.Transition(Resource(0), PSR);
+	States.Transition(Resource(0), CopySrc);
+	CHECK(States.Pending_Count() == 1);
+	CHECK(States.Dropped_Count() == 1);
+
+	//a move and its way back cancel
+	States.Register(Resource(1), RT);
+	States.Transition(Resource(1), PSR);
+	States.Transition(Resource(1), RT);
+	CHECK(States.Dropped_Count() == 3);
+	CHECK(States.State(Resource(1)) == RT);
+
+	States.Flush(&List);
+	CHECK(List.Calls.size() == 1 && List.Calls[0].size() == 1);
+	CHECK(Is_Barrier(List.Calls[0][0], Resource(0), D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, RT, CopySrc));
+
+	//after a flush the next move is a barrier of its own
+	States.Transition(Resource(0), RT);
+	States.Flush(&List);
+	CHECK(List.Calls.size() == 2);
+	CHECK(Is_Barrier(List.Calls[1][0], Resource(0), D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, CopySrc, RT));
+
+	//only cancelled moves, no call at all
+	States.Transition(Resource(0), PSR);
+	States.Transition(Resource(0), RT);
+	States.Flush(&List);
+	CHECK(List.Calls.size() == 2);
+}
+
+static void Test_Subresources()
+{
+	CResourceStateTracker States;
+	MockCommandList List;
+
+	//a texture with 4 mips, mip 1 is rendered to
+	States.Register(Resource(0), PSR, 4);
+	States.Transition(Resource(0), RT, 1);
+	CHECK(States.State(Resource(0), 0) == PSR);
+	CHECK(States.State(Resource(0), 1) == RT);
+	States.Flush(&List);
+	CHECK(Is_Barrier(List.Calls[0][0], Resource(0), 1, PSR, RT));
+
+	//the whole texture back, only the mip that went apart moves
+	States.Transition(Resource(0), PSR);
+	States.Flush(&List);
+	CHECK(List.Calls[1].size() == 1);
+	CHECK(Is_Barrier(List.Calls[1][0], Resource(0), 1, RT, PSR));
+
+	//merged again, the next whole move is one barrier
+	States.Transition(Resource(0), CopySrc);
+	States.Flush(&List);
+	CHECK(List.Calls[2].size() == 1);
+	CHECK(Is_Barrier(List.Calls[2][0], Resource(0), D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, PSR, CopySrc));
+
+	//every mip on its own to the same state merges too
+	for (UINT i = 0; i < 4; i++)
+		States.Transition(Resource(0), RT, i);
+	States.Flush(&List);
+	CHECK(List.Calls[3].size() == 4);
+	for (UINT i = 0; i < 4; i++)
+		CHECK(Is_Barrier(List.Calls[3][i], Resource(0), i, CopySrc, RT));
+
+	States.Transition(Resource(0), PSR);
+	States.Flush(&List);
+	CHECK(List.Calls[4].size() == 1);
+	CHECK(Is_Barrier(List.Calls[4][0], Resource(0), D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, RT, PSR));
+
+	//a pending mip move folds into the whole move that follows
+	States.Transition(Resource(0), RT, 2);
+	States.Transition(Resource(0), CopyDst);
+	States.Flush(&List);
+	CHECK(List.Calls[5].size() == 4);
+	for (UINT i = 0; i < 4; i++)
+		CHECK(Has_Barrier(List.Calls[5], Resource(0), i, PSR, CopyDst));
+	for (UINT i = 0; i < 4; i++)
+		CHECK(States.State(Resource(0), i) == CopyDst);
+}
+
+//whole resource barriers and subresource ones of the same
+//resource in one batch, each move starts where the last left
+static void Test_Mixed_Barriers()
+{
+	CResourceStateTracker States;
+	MockCommandList List;
+
+	States.Register(Resource(0), PSR, 3);
+	States.Transition(Resource(0), RT);
+	for (UINT i = 0; i < 3; i++)
+		States.Transition(Resource(0), CopySrc, i);
+	States.Transition(Resource(0), CopyDst);
+	States.Flush(&List);
+
+	const std::vector<D3D12_RESOURCE_BARRIER>& Batch = List.Calls[0];
+	CHECK(Batch.size() == 5);
+	CHECK(Is_Barrier(Batch[0], Resource(0), D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, PSR, RT));
+	for (UINT i = 0; i < 3; i++)
+		CHECK(Is_Barrier(Batch[1 + i], Resource(0), i, RT, CopySrc));
+	CHECK(Is_Barrier(Batch[4], Resource(0), D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, CopySrc, CopyDst));
+
+	//a one subresource resource only has whole resource barriers
+	States.Register(Resource(1), PSR);
+	States.Transition(Resource(1), RT);
+	States.Transition(Resource(1), CopySrc, 0);
+	States.Transition(Resource(1), PSR);
+	States.Transition(Resource(1), DepthWrite, 0);
+	States.Flush(&List);
+
+	CHECK(List.Calls[1].size() == 1);
+	CHECK(Is_Barrier(List.Calls[1][0], Resource(1), D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, PSR, DepthWrite));
+}
+
+static void Test_Unregister()
+{
+	CResourceStateTracker States;
+	MockCommandList List;
+
+	States.Register(Resource(0), RT);
+	States.Register(Resource(1), RT);
+	States.Transition(Resource(0), PSR);
+	States.Transition(Resource(1), PSR);
+
+	//a released resource never reaches the list
+	States.Unregister(Resource(0));
+	States.Flush(&List);
+	CHECK(List.Calls.size() == 1 && List.Calls[0].size() == 1);
+	CHECK(List.Calls[0][0].Transition.pResource == Resource(1));
+}
+
+static void Test_Aliasing()
+{
+	CResourceStateTracker States;
+	MockCommandList List;
+
+	//two placed resources on the same memory, the graph moves
+	//the new owner right after its aliasing barrier
+	States.Register(Resource(0), PSR);
+	States.Register(Resource(1), PSR);
+
+	States.Transition(Resource(0), RT);
+	States.Aliasing(Resource(1));
+	States.Transition(Resource(1), RT);
+	CHECK(States.Pending_Count() == 3);
+
+	States.Flush(&List);
+	CHECK(List.Calls.size() == 1 && List.Calls[0].size() == 3);
+	if (List.Calls.size() == 1 && List.Calls[0].size() == 3)
+	{
+		CHECK(Is_Barrier(List.Calls[0][0], Resource(0), D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, PSR, RT));
+		CHECK(List.Calls[0][1].Type == D3D12_RESOURCE_BARRIER_TYPE_ALIASING);
+		CHECK(List.Calls[0][1].Aliasing.pResourceBefore == nullptr);
+		CHECK(List.Calls[0][1].Aliasing.pResourceAfter == Resource(1));
+		CHECK(Is_Barrier(List.Calls[0][2], Resource(1), D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, PSR, RT));
+	}
+
+	//a move before the aliasing barrier does not fold with one
+	//after it, nor cancel
+	States.Transition(Resource(0), PSR);
+	States.Aliasing(Resource(0));
+	States.Transition(Resource(0), RT);
+	CHECK(States.Pending_Count() == 3);
+	CHECK(States.State(Resource(0)) == RT);
+
+	//a released resource takes its aliasing barrier with it
+	States.Unregister(Resource(0));
+	CHECK(States.Pending_Count() == 0);
+
+	States.Aliasing(Resource(1));
+	States.Flush(&List);
+	CHECK(List.Calls.size() == 2 && List.Calls[1].size() == 1);
+	CHECK(States.Barrier_Count() == 4);
+}
+
+//state of every subresource as the barriers leave it
+struct Replay
+{
+	std::map<std::pair<ID3D12Resource*, UINT>, D3D12_RESOURCE_STATES> State;
+	std::map<ID3D12Resource*, UINT> Subresources;
+
+	void Register(ID3D12Resource* Res, D3D12_RESOURCE_STATES s, UINT Count)
+	{
+		Subresources[Res] = Count;
+		for (UINT i = 0; i < Count; i++)
+			State[{ Res, i }] = s;
+	}
+
+	//false when a barrier does not start from the current state
+	bool Apply(const std::vector<D3D12_RESOURCE_BARRIER>& Barriers)
+	{
+		bool Valid = true;
+
+		for (const D3D12_RESOURCE_BARRIER& b : Barriers)
+		{
+			const D3D12_RESOURCE_TRANSITION_BARRIER& t = b.Transition;
+
+			UINT First = t.Subresource == D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES ? 0 : t.Subresource;
+			UINT End = t.Subresource == D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES ? Subresources[t.pResource] : t.Subresource + 1;
+
+			Valid = Valid && t.StateBefore != t.StateAfter;
+
+			for (UINT i = First; i < End; i++)
+			{
+				Valid = Valid && State[{ t.pResource, i }] == t.StateBefore;
+				State[{ t.pResource, i }] = t.StateAfter;
+			}
+		}
+
+		return Valid;
+	}
+};
+
+//random moves of whole resources and single mips, flushed now and
+//then, the barriers must be valid and as few as the moves allow
+static void Test_Random_Replay()
+{
+	const D3D12_RESOURCE_STATES Choices[] = { RT, PSR, NPSR, PSR | NPSR, CopySrc, CopyDst, DepthWrite };
+
+	std::mt19937 Rng(21);
+
+	for (int Run = 0; Run < 200; Run++)
+	{
+		CResourceStateTracker States;
+		MockCommandList List;
+		Replay Model;
+
+		const UINT Counts[4] = { 1, 1, 3, 6 };
+		for (int r = 0; r < 4; r++)
+		{
+			States.Register(Resource(r), PSR, Counts[r]);
+			Model.Register(Resource(r), PSR, Counts[r]);
+		}
+
+		for (int Step = 0; Step < 100; Step++)
+		{
+			int r = Rng() % 4;
+			D3D12_RESOURCE_STATES s = Choices[Rng() % 7];
+			UINT Sub = Rng() % 3 == 0 ? Rng() % Counts[r] : D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+
+			States.Transition(Resource(r), s, Sub);
+
+			if (Rng() % 5 == 0)
+			{
+				size_t Calls = List.Calls.size();
+				States.Flush(&List);
+
+				if (List.Calls.size() != Calls)
+					CHECK(Model.Apply(List.Calls.back()));
+			}
+		}
+
+		size_t Calls = List.Calls.size();
+		States.Flush(&List);
+		if (List.Calls.size() != Calls)
+			CHECK(Model.Apply(List.Calls.back()));
+
+		CHECK(States.Pending_Count() == 0);
+
+		for (int r = 0; r < 4; r++)
+			for (UINT i = 0; i < Counts[r]; i++)
+				CHECK(Model.State[std::make_pair(Resource(r), i)] == States.State(Resource(r), i));
+	}
+}
+
+int main()
+{
+	RUN_TEST(Test_Batching);
+	RUN_TEST(Test_Redundant);
+	RUN_TEST(Test_Fold_And_Cancel);
+	RUN_TEST(Test_Subresources);
+	RUN_TEST(Test_Mixed_Barriers);
+	RUN_TEST(Test_Unregister);
+	RUN_TEST(Test_Aliasing);
+	RUN_TEST(Test_Random_Replay);
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,44 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Unit Test Checks
+//======================================================================================
+
+#ifndef _TESTCHECK_
+#define _TESTCHECK_
+
+#include <cstdio>
+#include <cmath>
+
+//a failed check prints where it is and the test goes on,
+//main returns TEST_RESULT() so ctest sees any failure
+
+inline int g_CheckFailures = 0;
+
+#define CHECK(Expr) \
+	do { \
+		if (!(Expr)) \
+		{ \
+			g_CheckFailures++; \
+			printf("%s(%d): CHECK(%s) failed\n", __FILE__, __LINE__, #Expr); \
+		} \
+	} while (0)
+
+#define CHECK_NEAR(A, B, Eps) \
+	do { \
+		double CheckA = (double)(A), CheckB = (double)(B); \
+		if (!(fabs(CheckA - CheckB) <= (double)(Eps))) \
+		{ \
+			g_CheckFailures++; \
+			printf("%s(%d): CHECK_NEAR(%s, %s) failed, %g and %g\n", \
+				__FILE__, __LINE__, #A, #B, CheckA, CheckB); \
+		} \
+	} while (0)
+
+#define RUN_TEST(Test) \
+	do { \
+		printf("%s\n", #Test); \
+		Test(); \
+	} while (0)
+
+#define TEST_RESULT() (g_CheckFailures == 0 ? 0 : 1)
+
+#endif
@@ -0,0 +1,249 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Unit Test JSON Reader
+//======================================================================================
+
+#ifndef _TESTJSON_
+#define _TESTJSON_
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+//strict reader for the JSON the exports write, a file
+//that does not parse here does not load in the tools
+
+struct JsonValue
+{
+	enum Kind { NUL, BOOL, NUMBER, STRING, ARRAY, OBJECT };
+
+	Kind Type = NUL;
+	double Number = 0.0;
+	std::string String;
+	std::vector<JsonValue> Items;
+	std::vector<std::pair<std::string, JsonValue>> Members;
+
+	const JsonValue* Find(const char* Key) const
+	{
+		for (const auto& Member : Members)
+			if (Member.first == Key)
+				return &Member.second;
+		return nullptr;
+	}
+};
+
+//RFC 8259 without the \u escapes, the exports never write them
+class CJsonReader
+{
+public:
+	explicit CJsonReader(const std::string& Text) : m_p(Text.c_str()), m_End(Text.c_str() + Text.size()) {}
+
+	bool Parse(JsonValue& Value)
+	{
+		return Parse_Value(Value) && (Skip_Space(), m_p == m_End);
+	}
+
+private:
+	void Skip_Space()
+	{
+		while (m_p < m_End && (*m_p == ' ' || *m_p == '\t' || *m_p == '\n' || *m_p == '\r'))
+			m_p++;
+	}
+
+	bool Parse_Literal(const char* Word)
+	{
+		size_t Length = strlen(Word);
+		if ((size_t)(m_End - m_p) < Length || strncmp(m_p, Word, Length) != 0)
+			return false;
+		m_p += Length;
+		return true;
+	}
+
+	bool Parse_String(std::string& Str)
+	{
+		if (m_p == m_End || *m_p != '"')
+			return false;
+
+		for (m_p++; m_p < m_End; m_p++)
+		{
+			unsigned char c = (unsigned char)*m_p;
+
+			if (c == '"')
+			{
+				m_p++;
+				return true;
+			}
+
+			if (c < 0x20)
+				return false;
+
+			if (c == '\\')
+			{
+				if (++m_p == m_End)
+					return false;
+
+				switch (*m_p)
+				{
+				case '"': Str += '"'; break;
+				case '\\': Str += '\\'; break;
+				case '/': Str += '/'; break;
+				case 'b': Str += '\b'; break;
+				case 'f': Str += '\f'; break;
+				case 'n': Str += '\n'; break;
+				case 'r': Str += '\r'; break;
+				case 't': Str += '\t'; break;
+				default: return false;
+				}
+			}
+			else
+			{
+				Str += (char)c;
+			}
+		}
+
+		return false;
+	}
+
+	bool Parse_Number(double& Number)
+	{
+		const char* Start = m_p;
+
+		if (m_p < m_End && *m_p == '-')
+			m_p++;
+
+		//no leading zeros, no bare dot, no hex or inf
+		if (m_p == m_End || !isdigit((unsigned char)*m_p))
+			return false;
+		if (*m_p == '0' && m_p + 1 < m_End && isdigit((unsigned char)m_p[1]))
+			return false;
+		while (m_p < m_End && isdigit((unsigned char)*m_p))
+			m_p++;
+
+		if (m_p < m_End && *m_p == '.')
+		{
+			if (++m_p == m_End || !isdigit((unsigned char)*m_p))
+				return false;
+			while (m_p < m_End && isdigit((unsigned char)*m_p))
+				m_p++;
+		}
+
+		if (m_p < m_End && (*m_p == 'e' || *m_p == 'E'))
+		{
+			m_p++;
+			if (m_p < m_End && (*m_p == '+' || *m_p == '-'))
+				m_p++;
+			if (m_p == m_End || !isdigit((unsigned char)*m_p))
+				return false;
+			while (m_p < m_End && isdigit((unsigned char)*m_p))
+				m_p++;
+		}
+
+		Number = strtod(std::string(Start, m_p).c_str(), NULL);
+		return true;
+	}
+
+	bool Parse_Value(JsonValue& Value)
+	{
+		Skip_Space();
+
+		if (m_p == m_End)
+			return false;
+
+		switch (*m_p)
+		{
+		case '{':
+			Value.Type = JsonValue::OBJECT;
+			m_p++;
+			Skip_Space();
+			if (m_p < m_End && *m_p == '}')
+				return m_p++, true;
+			for (;;)
+			{
+				std::pair<std::string, JsonValue> Member;
+				Skip_Space();
+				if (!Parse_String(Member.first))
+					return false;
+				Skip_Space();
+				if (m_p == m_End || *m_p++ != ':')
+					return false;
+				if (!Parse_Value(Member.second))
+					return false;
+				Value.Members.push_back(std::move(Member));
+				Skip_Space();
+				if (m_p == m_End)
+					return false;
+				if (*m_p == '}')
+					return m_p++, true;
+				if (*m_p++ != ',')
+					return false;
+			}
+
+		case '[':
+			Value.Type = JsonValue::ARRAY;
+			m_p++;
+			Skip_Space();
+			if (m_p < m_End && *m_p == ']')
+				return m_p++, true;
+			for (;;)
+			{
+				Value.Items.emplace_back();
+				if (!Parse_Value(Value.Items.back()))
+					return false;
+				Skip_Space();
+				if (m_p == m_End)
+					return false;
+				if (*m_p == ']')
+					return m_p++, true;
+				if (*m_p++ != ',')
+					return false;
+			}
+
+		case '"':
+			Value.Type = JsonValue::STRING;
+			return Parse_String(Value.String);
+
+		case 't':
+			Value.Type = JsonValue::BOOL;
+			return Parse_Literal("true");
+
+		case 'f':
+			Value.Type = JsonValue::BOOL;
+			return Parse_Literal("false");
+
+		case 'n':
+			return Parse_Literal("null");
+
+		default:
+			Value.Type = JsonValue::NUMBER;
+			return Parse_Number(Value.Number);
+		}
+	}
+
+	const char* m_p;
+	const char* m_End;
+};
+
+//false when the file is missing or is not one JSON value
+inline bool Read_Json_File(const char* FileName, JsonValue& Root)
+{
+	std::string Text;
+
+	FILE* Fp = fopen(FileName, "rb");
+	if (Fp == NULL)
+		return false;
+
+	char Buffer[4096];
+	size_t Read;
+	while ((Read = fread(Buffer, 1, sizeof(Buffer), Fp)) > 0)
+		Text.append(Buffer, Read);
+
+	fclose(Fp);
+
+	Root = JsonValue();
+	return CJsonReader(Text).Parse(Root);
+}
+
+#endif
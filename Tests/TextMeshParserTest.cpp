@@ -0,0 +1,305 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Text Mesh Parser Tests
+//======================================================================================
+
+#include "TestCheck.h"
+
+#include "TextMeshParser.h"
+#include "MappedFile.h"
+#include "SyntheticMesh.h"
+
+#include <cstring>
+#include <string>
+
+//vertex lines start at line 2, line 1 is the triangles count
+#define FIRST_VERTEX_LINE 2
+
+//values are multiples of 1/64, "%f" prints them exactly
+static float Test_Value(size_t Vertex, int Component)
+{
+	return (float)((int)((Vertex * 7 + Component * 13) % 4096) - 2048) / 64.0f;
+}
+
+struct TextOptions
+{
+	const char* Eol = "\n";
+	const char* Separator = " ";
+	bool FinalEol = true;
+	//a blank line after every BlankEvery vertex lines
+	size_t BlankEvery = 0;
+};
+
+static std::string Make_Text(uint64_t TriCount, size_t VertexCount, const TextOptions& Options = TextOptions())
+{
+	std::string Text = std::to_string(TriCount) + Options.Eol;
+
+	char Line[256];
+
+	for (size_t i = 0; i < VertexCount; i++)
+	{
+		snprintf(Line, sizeof(Line), "%f%s%f%s%f%s%f%s%f",
+			Test_Value(i, 0), Options.Separator, Test_Value(i, 1), Options.Separator,
+			Test_Value(i, 2), Options.Separator, Test_Value(i, 3), Options.Separator, Test_Value(i, 4));
+
+		Text += Line;
+
+		if (i + 1 < VertexCount || Options.FinalEol)
+			Text += Options.Eol;
+
+		if (Options.BlankEvery && (i + 1) % Options.BlankEvery == 0 && i + 1 < VertexCount)
+			Text += Options.Eol;
+	}
+
+	return Text;
+}
+
+static bool Parse(const std::string& Text, unsigned ThreadCount, TextMeshResult& Result)
+{
+	CThreadPool Pool(ThreadCount);
+	return ParseTextMesh(Text.data(), Text.size(), Pool, Result);
+}
+
+static bool Values_Match(const TextMeshResult& Result, size_t VertexCount)
+{
+	if (Result.VertexCount != VertexCount || Result.Vertices.size() != VertexCount * 5)
+		return false;
+
+	for (size_t i = 0; i < VertexCount; i++)
+	{
+		for (int j = 0; j < 5; j++)
+		{
+			if (Result.Vertices[i * 5 + j] != Test_Value(i, j))
+				return false;
+		}
+	}
+
+	return true;
+}
+
+//replaces vertex line Line (1 based file line) of a text made by Make_Text
+static void Replace_Line(std::string& Text, uint64_t Line, const char* NewLine)
+{
+	size_t Begin = 0;
+	for (uint64_t i = 1; i < Line; i++)
+		Begin = Text.find('\n', Begin) + 1;
+
+	size_t End = Text.find('\n', Begin);
+	Text.replace(Begin, End - Begin, NewLine);
+}
+
+static void Test_Room_Matches_Legacy_Loop()
+{
+	std::vector<float> Legacy;
+	CHECK(LoadTextMeshLegacy(SAMPLE_DIR "/room.txt", Legacy));
+
+	CMappedFile File;
+	CHECK(File.Open(SAMPLE_DIR "/room.txt"));
+
+	for (unsigned ThreadCount : { 1, 3, 8 })
+	{
+		CThreadPool Pool(ThreadCount);
+		TextMeshResult Result;
+
+		CHECK(ParseTextMesh((const char*)File.Data(), File.Size(), Pool, Result));
+		CHECK(Result.VertexCount == 2076 * 3);
+		CHECK(Result.Vertices == Legacy);
+		CHECK(Result.ErrorCount == 0);
+	}
+}
+
+static void Test_Chunk_Boundaries()
+{
+	//several MB, many 64 KB chunks, the chunk size changes
+	//with the thread count so the boundaries move too
+	const uint64_t TriCount = 40000;
+	std::string Text = Make_Text(TriCount, TriCount * 3);
+
+	for (unsigned ThreadCount = 1; ThreadCount <= 9; ThreadCount++)
+	{
+		TextMeshResult Result;
+		CHECK(Parse(Text, ThreadCount, Result));
+		CHECK(Values_Match(Result, TriCount * 3));
+	}
+}
+
+static void Test_Line_Endings_And_Blank_Lines()
+{
+	const uint64_t TriCount = 20000;
+
+	TextOptions Crlf;
+	Crlf.Eol = "\r\n";
+	Crlf.Separator = "\t ";
+	Crlf.BlankEvery = 997;
+
+	TextOptions NoFinalEol;
+	NoFinalEol.FinalEol = false;
+	NoFinalEol.BlankEvery = 5000;
+
+	for (const TextOptions& Options : { Crlf, NoFinalEol })
+	{
+		std::string Text = Make_Text(TriCount, TriCount * 3, Options);
+
+		for (unsigned ThreadCount : { 1, 4 })
+		{
+			TextMeshResult Result;
+			CHECK(Parse(Text, ThreadCount, Result));
+			CHECK(Values_Match(Result, TriCount * 3));
+		}
+	}
+}
+
+static void Test_Triangle_Counts()
+{
+	for (uint64_t TriCount : { 1, 2, 7, 2076, 2077, 65536, 100003 })
+	{
+		TextMeshResult Result;
+		CHECK(Parse(Make_Text(TriCount, TriCount * 3), 4, Result));
+		CHECK(Values_Match(Result, TriCount * 3));
+	}
+}
+
+static void Test_Bounds()
+{
+	const size_t VertexCount = 3000;
+
+	TextMeshResult Result;
+	CHECK(Parse(Make_Text(VertexCount / 3, VertexCount), 2, Result));
+
+	for (int j = 0; j < 3; j++)
+	{
+		float Min = Test_Value(0, j), Max = Test_Value(0, j);
+
+		for (size_t i = 1; i < VertexCount; i++)
+		{
+			Min = std::min(Min, Test_Value(i, j));
+			Max = std::max(Max, Test_Value(i, j));
+		}
+
+		CHECK(Result.BoundsMin[j] == Min);
+		CHECK(Result.BoundsMax[j] == Max);
+	}
+}
+
+static void Test_Malformed_Line_Numbers()
+{
+	const uint64_t TriCount = 30000;
+	std::string Text = Make_Text(TriCount, TriCount * 3);
+
+	const uint64_t LastLine = TriCount * 3 + 1;
+
+	Replace_Line(Text, FIRST_VERTEX_LINE, "1 2 3 4");
+	Replace_Line(Text, 1000, "1 2 x 4 5");
+	Replace_Line(Text, 45001, "1 2 3 4 5 6");
+	Replace_Line(Text, 60000, "1.5.5 2 3 4 5");
+	Replace_Line(Text, LastLine, "1 2 3 4 5x");
+
+	for (unsigned ThreadCount : { 1, 2, 8 })
+	{
+		TextMeshResult Result;
+		CHECK(!Parse(Text, ThreadCount, Result));
+		CHECK(Result.ErrorCount == 5);
+		CHECK(Result.Errors.size() == 5);
+
+		if (Result.Errors.size() == 5)
+		{
+			CHECK(Result.Errors[0].Line == FIRST_VERTEX_LINE);
+			CHECK(strcmp(Result.Errors[0].Message, "expected 5 numbers per line") == 0);
+			CHECK(Result.Errors[1].Line == 1000);
+			CHECK(strcmp(Result.Errors[1].Message, "bad number") == 0);
+			CHECK(Result.Errors[2].Line == 45001);
+			CHECK(strcmp(Result.Errors[2].Message, "extra data after 5 numbers") == 0);
+			CHECK(Result.Errors[3].Line == 60000);
+			CHECK(Result.Errors[4].Line == LastLine);
+		}
+	}
+}
+
+static void Test_Line_Numbers_Count_Blank_Lines()
+{
+	TextOptions Options;
+	Options.BlankEvery = 10;
+
+	std::string Text = Make_Text(1000, 3000, Options);
+
+	//vertex 25 is on line 2 + 25 + 2 blank lines
+	Replace_Line(Text, FIRST_VERTEX_LINE + 27, "oops");
+
+	TextMeshResult Result;
+	CHECK(!Parse(Text, 2, Result));
+	CHECK(Result.ErrorCount == 1);
+	CHECK(Result.Errors.size() == 1 && Result.Errors[0].Line == FIRST_VERTEX_LINE + 27);
+}
+
+static void Test_Vertex_Count_Mismatch()
+{
+	//one vertex short, the error is on the line after the last one
+	TextMeshResult Short;
+	CHECK(!Parse(Make_Text(1000, 2999), 2, Short));
+	CHECK(Short.ErrorCount == 1);
+	CHECK(Short.Errors.size() == 1 && Short.Errors[0].Line == 2999 + FIRST_VERTEX_LINE);
+
+	//two extra vertices, reported once at the first extra line
+	TextMeshResult Long;
+	CHECK(!Parse(Make_Text(1000, 3002), 2, Long));
+	CHECK(Long.ErrorCount == 1);
+	CHECK(Long.Errors.size() == 1 && Long.Errors[0].Line == 3000 + FIRST_VERTEX_LINE);
+}
+
+static void Test_Bad_Triangle_Count()
+{
+	const char* Texts[] = { "", "\n1 2 3 4 5\n", "abc\n", "0\n", "-3\n", "2 3\n", "99999999999\n" };
+
+	for (const char* Text : Texts)
+	{
+		TextMeshResult Result;
+		CHECK(!Parse(Text, 1, Result));
+		CHECK(Result.Errors.size() == 1 && Result.Errors[0].Line == 1);
+	}
+}
+
+static void Test_Errors_Are_First_In_File_Order()
+{
+	//every line of the first chunks is bad, more than a chunk keeps
+	const uint64_t TriCount = 20000;
+	const uint64_t BadLines = 9000;
+
+	std::string Text = Make_Text(TriCount, TriCount * 3);
+
+	std::string Bad;
+	for (uint64_t i = 0; i < BadLines; i++)
+		Bad += "bad\n";
+
+	size_t Begin = Text.find('\n') + 1;
+	size_t End = Begin;
+	for (uint64_t i = 0; i < BadLines; i++)
+		End = Text.find('\n', End) + 1;
+
+	Text.replace(Begin, End - Begin, Bad);
+
+	for (unsigned ThreadCount : { 1, 8 })
+	{
+		TextMeshResult Result;
+		CHECK(!Parse(Text, ThreadCount, Result));
+		CHECK(Result.ErrorCount == BadLines);
+		CHECK(!Result.Errors.empty());
+
+		for (size_t i = 0; i < Result.Errors.size(); i++)
+			CHECK(Result.Errors[i].Line == FIRST_VERTEX_LINE + i);
+	}
+}
+
+int main()
+{
+	RUN_TEST(Test_Room_Matches_Legacy_Loop);
+	RUN_TEST(Test_Chunk_Boundaries);
+	RUN_TEST(Test_Line_Endings_And_Blank_Lines);
+	RUN_TEST(Test_Triangle_Counts);
+	RUN_TEST(Test_Bounds);
+	RUN_TEST(Test_Malformed_Line_Numbers);
+	RUN_TEST(Test_Line_Numbers_Count_Blank_Lines);
+	RUN_TEST(Test_Vertex_Count_Mismatch);
+	RUN_TEST(Test_Bad_Triangle_Count);
+	RUN_TEST(Test_Errors_Are_First_In_File_Order);
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,307 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Texture Mips Tests
+//======================================================================================
+
+//built twice, with the SSE2 filters and with MIPS_NO_SIMD, the
+//levels are checked against a double precision box filter
+
+#include "TestCheck.h"
+
+#include "TextureMips.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+struct TestImage
+{
+	std::vector<unsigned char> Chain;
+	MipLevel Levels[TEXTURE_MAX_MIPS];
+	uint32_t LevelCount = 0;
+};
+
+static TestImage Make_Image(uint32_t Width, uint32_t Height, uint32_t Seed)
+{
+	TestImage Image;
+	Image.LevelCount = MipLevelCount(Width, Height);
+	Image.Chain.resize((size_t)MipChainLayout(Width, Height, Image.LevelCount, Image.Levels));
+
+	std::mt19937 Rng(Seed);
+	for (size_t i = 0; i < (size_t)Width * Height * 4; i++)
+		Image.Chain[i] = (unsigned char)(Rng() & 0xFF);
+
+	return Image;
+}
+
+static unsigned char* Texel(TestImage& Image, uint32_t Level, uint32_t x, uint32_t y)
+{
+	const MipLevel& L = Image.Levels[Level];
+	return &Image.Chain[(size_t)(L.Offset + y * L.RowPitch + x * 4)];
+}
+
+static double To_Linear(double c)
+{
+	c /= 255.0;
+	return c <= 0.04045 ? c / 12.92 : pow((c + 0.055) / 1.055, 2.4);
+}
+
+static double To_Srgb(double l)
+{
+	double c = l <= 0.0031308 ? l * 12.92 : 1.055 * pow(l, 1.0 / 2.4) - 0.055;
+	return c * 255.0;
+}
+
+//source texels under destination texel Dst with the part of
+//the destination each one covers, an exact box filter
+static std::vector<std::pair<uint32_t, double>> Box_Weights(uint32_t Dst, uint32_t DstSize, uint32_t SrcSize)
+{
+	std::vector<std::pair<uint32_t, double>> Weights;
+
+	double Begin = (double)Dst * SrcSize / DstSize;
+	double End = (double)(Dst + 1) * SrcSize / DstSize;
+
+	for (uint32_t i = (uint32_t)Begin; i < SrcSize && i < End; i++)
+	{
+		double Overlap = std::min(End, i + 1.0) - std::max(Begin, (double)i);
+		if (Overlap > 0.0)
+			Weights.push_back({ i, Overlap / (End - Begin) });
+	}
+
+	return Weights;
+}
+
+//largest difference of level Level from the reference filter of Level - 1
+static int Max_Error(TestImage& Image, uint32_t Level, bool Srgb)
+{
+	const MipLevel& Src = Image.Levels[Level - 1];
+	const MipLevel& Dst = Image.Levels[Level];
+
+	int MaxError = 0;
+
+	for (uint32_t y = 0; y < Dst.Height; y++)
+	{
+		auto Rows = Box_Weights(y, Dst.Height, Src.Height);
+
+		for (uint32_t x = 0; x < Dst.Width; x++)
+		{
+			auto Cols = Box_Weights(x, Dst.Width, Src.Width);
+
+			double Sum[4] = { 0.0, 0.0, 0.0, 0.0 };
+
+			for (auto& Row : Rows)
+			{
+				for (auto& Col : Cols)
+				{
+					const unsigned char* p = Texel(Image, Level - 1, Col.first, Row.first);
+					double w = Row.second * Col.second;
+
+					for (int c = 0; c < 4; c++)
+						Sum[c] += w * (Srgb && c < 3 ? To_Linear(p[c]) : p[c]);
+				}
+			}
+
+			const unsigned char* Result = Texel(Image, Level, x, y);
+
+			for (int c = 0; c < 4; c++)
+			{
+				int Expected = (int)floor((Srgb && c < 3 ? To_Srgb(Sum[c]) : Sum[c]) + 0.5);
+				MaxError = std::max(MaxError, abs(Expected - (int)Result[c]));
+			}
+		}
+	}
+
+	return MaxError;
+}
+
+static void Test_Level_Count_And_Layout()
+{
+	CHECK(MipLevelCount(1, 1) == 1);
+	CHECK(MipLevelCount(2, 1) == 2);
+	CHECK(MipLevelCount(37, 5) == 6);
+	CHECK(MipLevelCount(64, 9472) == 14);
+	CHECK(MipLevelCount(256, 256) == 9);
+
+	MipLevel Levels[TEXTURE_MAX_MIPS];
+	uint64_t Size = MipChainLayout(37, 5, 6, Levels);
+
+	const uint32_t Widths[] = { 37, 18, 9, 4, 2, 1 };
+	const uint32_t Heights[] = { 5, 2, 1, 1, 1, 1 };
+
+	uint64_t Offset = 0;
+	for (int i = 0; i < 6; i++)
+	{
+		CHECK(Levels[i].Width == Widths[i]);
+		CHECK(Levels[i].Height == Heights[i]);
+		CHECK(Levels[i].Offset == Offset);
+		CHECK(Levels[i].RowPitch == Widths[i] * 4);
+		Offset += (uint64_t)Widths[i] * Heights[i] * 4;
+	}
+
+	CHECK(Size == Offset);
+}
+
+static void Test_Matches_Reference()
+{
+	const uint32_t Sizes[][2] = {
+		{ 1, 1 }, { 2, 2 }, { 3, 3 }, { 4, 4 }, { 5, 2 }, { 2, 5 }, { 1, 7 }, { 7, 1 },
+		{ 37, 5 }, { 37, 37 }, { 64, 64 }, { 100, 3 }, { 255, 1 }, { 256, 256 }, { 65, 130 } };
+
+	for (unsigned ThreadCount : { 1, 4 })
+	{
+		CThreadPool Pool(ThreadCount);
+
+		for (bool Srgb : { false, true })
+		{
+			uint32_t Seed = 1;
+
+			for (const auto& Size : Sizes)
+			{
+				TestImage Image = Make_Image(Size[0], Size[1], Seed++);
+				GenerateMips(Image.Chain.data(), Image.Levels, Image.LevelCount, Srgb, Pool);
+
+				for (uint32_t i = 1; i < Image.LevelCount; i++)
+				{
+					const MipLevel& Src = Image.Levels[i - 1];
+
+					//the 2x2 box is exact, weighted taps may round the other way
+					bool Box = Src.Width % 2 == 0 && Src.Height % 2 == 0;
+					int Error = Max_Error(Image, i, Srgb);
+
+					if (Box && !Srgb)
+						CHECK(Error == 0);
+					else
+						CHECK(Error <= 1);
+
+					if (Error > (Box && !Srgb ? 0 : 1))
+						printf("  %ux%u level %u srgb %d: error %d\n", Size[0], Size[1], i, Srgb, Error);
+				}
+			}
+		}
+	}
+}
+
+static void Test_Room_Texture_Chain()
+{
+	//Room.bmp size, the heights go odd at 37 on the way down
+	CThreadPool Pool(4);
+
+	for (bool Srgb : { false, true })
+	{
+		TestImage Image = Make_Image(64, 9472, 99);
+		GenerateMips(Image.Chain.data(), Image.Levels, Image.LevelCount, Srgb, Pool);
+
+		for (uint32_t i = 1; i < Image.LevelCount; i++)
+			CHECK(Max_Error(Image, i, Srgb) <= 1);
+	}
+}
+
+static void Test_Last_Column_And_Row_Count()
+{
+	CThreadPool Pool(1);
+
+	//one white texel at the end of a black 37 texel row or column
+	for (int Vertical = 0; Vertical < 2; Vertical++)
+	{
+		uint32_t Width = Vertical ? 1 : 37;
+		uint32_t Height = Vertical ? 37 : 1;
+
+		TestImage Image = Make_Image(Width, Height, 0);
+		std::fill(Image.Chain.begin(), Image.Chain.end(), 0);
+		std::fill(Texel(Image, 0, Width - 1, Height - 1), Texel(Image, 0, Width - 1, Height - 1) + 4, 255);
+
+		GenerateMips(Image.Chain.data(), Image.Levels, Image.LevelCount, false, Pool);
+
+		//18 / 37 of the last destination texel
+		const unsigned char* Last = Texel(Image, 1, Image.Levels[1].Width - 1, Image.Levels[1].Height - 1);
+		CHECK(Last[0] == 124);
+
+		//and it survives down to 1x1
+		const unsigned char* Top = Texel(Image, Image.LevelCount - 1, 0, 0);
+		CHECK(Top[0] == 7);
+	}
+}
+
+static void Test_Odd_Sizes_Keep_Mean()
+{
+	CThreadPool Pool(2);
+
+	//a ramp, dropping a row or column moves the mean
+	TestImage Image = Make_Image(37, 75, 0);
+
+	for (uint32_t y = 0; y < 75; y++)
+	{
+		for (uint32_t x = 0; x < 37; x++)
+		{
+			unsigned char* p = Texel(Image, 0, x, y);
+			p[0] = (unsigned char)(x * 7);
+			p[1] = (unsigned char)(y * 3);
+			p[2] = (unsigned char)((x + y) * 2);
+			p[3] = 255;
+		}
+	}
+
+	GenerateMips(Image.Chain.data(), Image.Levels, Image.LevelCount, false, Pool);
+
+	auto Mean = [&](uint32_t Level, int c)
+	{
+		const MipLevel& L = Image.Levels[Level];
+		double Sum = 0.0;
+		for (uint32_t y = 0; y < L.Height; y++)
+			for (uint32_t x = 0; x < L.Width; x++)
+				Sum += Texel(Image, Level, x, y)[c];
+		return Sum / (L.Width * L.Height);
+	};
+
+	for (int c = 0; c < 4; c++)
+	{
+		double Base = Mean(0, c);
+
+		for (uint32_t i = 1; i < Image.LevelCount; i++)
+			CHECK_NEAR(Mean(i, c), Base, 0.5 * i);
+	}
+}
+
+static void Test_Constant_Stays_Constant()
+{
+	CThreadPool Pool(2);
+
+	const unsigned char Color[4] = { 200, 13, 128, 77 };
+
+	for (bool Srgb : { false, true })
+	{
+		TestImage Image = Make_Image(75, 37, 0);
+
+		for (size_t i = 0; i < (size_t)75 * 37; i++)
+			std::copy(Color, Color + 4, &Image.Chain[i * 4]);
+
+		GenerateMips(Image.Chain.data(), Image.Levels, Image.LevelCount, Srgb, Pool);
+
+		for (uint32_t i = 1; i < Image.LevelCount; i++)
+		{
+			const MipLevel& L = Image.Levels[i];
+
+			for (uint32_t y = 0; y < L.Height; y++)
+			{
+				for (uint32_t x = 0; x < L.Width; x++)
+				{
+					const unsigned char* p = Texel(Image, i, x, y);
+
+					for (int c = 0; c < 4; c++)
+						CHECK(abs(p[c] - Color[c]) <= (Srgb && c < 3 ? 1 : 0));
+				}
+			}
+		}
+	}
+}
+
+int main()
+{
+	RUN_TEST(Test_Level_Count_And_Layout);
+	RUN_TEST(Test_Matches_Reference);
+	RUN_TEST(Test_Room_Texture_Chain);
+	RUN_TEST(Test_Last_Column_And_Row_Count);
+	RUN_TEST(Test_Odd_Sizes_Keep_Mean);
+	RUN_TEST(Test_Constant_Stays_Constant);
+
+	return TEST_RESULT();
+}
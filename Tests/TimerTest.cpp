@@ -0,0 +1,152 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Timer Tests
+//======================================================================================
+
+//CTimer runs on a fake clock that starts weeks after boot, as
+//QueryPerformanceCounter does, and is moved through days of
+//uptime at the counter frequencies seen on real machines
+
+#include "TestCheck.h"
+
+#include "Timer.h"
+
+#include <cstdint>
+#include <initializer_list>
+
+class CFakeClock : public CMonotonicClock
+{
+public:
+	CFakeClock(int64_t Frequency, int64_t StartTicks) : m_Frequency(Frequency), m_Ticks(StartTicks) {}
+
+	int64_t Ticks() const override { return m_Ticks; }
+	int64_t Frequency() const override { return m_Frequency; }
+
+	void Advance(int64_t Ticks) { m_Ticks += Ticks; }
+
+private:
+	int64_t m_Frequency;
+	int64_t m_Ticks;
+};
+
+//10 MHz of Windows 10 and later, the 3.58 MHz ACPI timer,
+//a 3 GHz TSC and the nanoseconds of CLOCK_MONOTONIC_RAW
+static const int64_t g_Frequencies[] = { 10000000, 3579545, 3000000000LL, 1000000000 };
+
+static const int64_t DAY_SECONDS = 24 * 60 * 60;
+
+static void Test_To_Seconds()
+{
+	for (int64_t Freq : g_Frequencies)
+	{
+		//one tick and one tick short of a second after 100 days
+		for (int64_t Rest : { (int64_t)1, Freq / 3, Freq - 1 })
+		{
+			int64_t Ticks = 100 * DAY_SECONDS * Freq + Rest;
+			double Seconds = CMonotonicClock::To_Seconds(Ticks, Freq);
+
+			//a double near 8.6e6 s is good to about 2 ns
+			CHECK_NEAR(Seconds - 100.0 * DAY_SECONDS, (double)Rest / Freq, 4e-9);
+		}
+
+		CHECK(CMonotonicClock::To_Seconds(0, Freq) == 0.0);
+		CHECK(CMonotonicClock::To_Seconds(Freq, Freq) == 1.0);
+	}
+}
+
+static void Test_To_Microseconds()
+{
+	for (int64_t Freq : g_Frequencies)
+	{
+		for (int64_t Days : { 0, 1, 49, 365 })
+		{
+			for (int64_t Rest : { (int64_t)0, (int64_t)1, Freq / 60, Freq / 7, Freq - 1 })
+			{
+				int64_t Ticks = Days * DAY_SECONDS * Freq + Rest;
+
+				//Rest * 1000000 fits, the whole seconds are exact
+				int64_t Expected = Days * DAY_SECONDS * 1000000 + Rest * 1000000 / Freq;
+
+				CHECK(CMonotonicClock::To_Microseconds(Ticks, Freq) == Expected);
+			}
+		}
+
+		//a year at 3 GHz is 9.5e16 ticks, times 1000000 does not fit
+		int64_t Year = 365 * DAY_SECONDS * Freq;
+		CHECK(CMonotonicClock::To_Microseconds(Year, Freq) == 365 * DAY_SECONDS * 1000000);
+	}
+
+	//rounds down, 1 tick of 3.58 MHz is 0.28 us
+	CHECK(CMonotonicClock::To_Microseconds(1, 3579545) == 0);
+	CHECK(CMonotonicClock::To_Microseconds(4, 3579545) == 1);
+}
+
+//a week of frames at 60 fps, the frames of each day are run and
+//the rest of the day is skipped, app time and frame times stay
+//exact to the tick however long the app is up
+static void Test_Days_Of_Uptime()
+{
+	for (int64_t Freq : g_Frequencies)
+	{
+		//the machine was booted 30 days before the app
+		CFakeClock Clock(Freq, 30 * DAY_SECONDS * Freq);
+
+		CTimer Timer;
+		Timer.Set_Clock(&Clock);
+		Timer.TimerStart(0.0f);
+
+		const int64_t FrameTicks = Freq / 60;
+		const int FramesPerDay = 600;
+
+		int64_t AppTicks = 0;
+
+		for (int Day = 0; Day < 7; Day++)
+		{
+			for (int Frame = 0; Frame < FramesPerDay; Frame++)
+			{
+				Clock.Advance(FrameTicks);
+				AppTicks += FrameTicks;
+
+				Timer.CalculateFPS();
+
+				float Elapsed = Timer.GetElaspedTime();
+				CHECK_NEAR(Elapsed, (double)FrameTicks / Freq, 1e-7);
+			}
+
+			int64_t AppSeconds = AppTicks / Freq;
+			CHECK_NEAR(Timer.GetAppTime() - AppSeconds, (double)(AppTicks % Freq) / Freq, 4e-9);
+
+			//the rest of the day passes without frames
+			int64_t Skip = DAY_SECONDS * Freq - FramesPerDay * FrameTicks;
+			Clock.Advance(Skip);
+			AppTicks += Skip;
+
+			CHECK_NEAR(Timer.GetAppTime(), (double)(Day + 1) * DAY_SECONDS, 4e-9);
+
+			//the skip is one frame, so the next frame time is the
+			//frame after it
+			Timer.CalculateFPS();
+			Timer.GetElaspedTime();
+		}
+
+		//every frame was recorded to the microsecond, the skipped
+		//parts of the days are the longest frames
+		const CFrameHistogram& Stats = Timer.Frame_Stats();
+		CHECK(Stats.Count() == 7 * (FramesPerDay + 1));
+
+		int64_t Skip = DAY_SECONDS * Freq - FramesPerDay * FrameTicks;
+		CHECK(Stats.Max() == CMonotonicClock::To_Microseconds(Skip, Freq));
+
+		//absolute time counts from boot
+		double Boot = 30.0 * DAY_SECONDS;
+		CHECK_NEAR(Timer.GetAbsoluteTime() - Boot - 7.0 * DAY_SECONDS, 0.0, 4e-9);
+	}
+}
+
+int main()
+{
+	RUN_TEST(Test_To_Seconds);
+	RUN_TEST(Test_To_Microseconds);
+	RUN_TEST(Test_Days_Of_Uptime);
+
+	return TEST_RESULT();
+}
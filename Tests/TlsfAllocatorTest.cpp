@@ -0,0 +1,274 @@
+//======================================================================================
+//	Ed Kurlyak 2023 TLSF Allocator Tests
+//======================================================================================
+
+//the random test keeps every live range in a map and checks each
+//allocation against it, now and then it compares the free blocks
+//with the gaps between live ranges, they are the same when every
+//freed block merged with its free neighbours
+
+#include "TestCheck.h"
+
+#include "TlsfAllocator.h"
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <vector>
+
+#define KB (1024ull)
+#define MB (1024ull * 1024)
+
+//live ranges by offset, the value is the size the allocator took
+typedef std::map<uint64_t, uint64_t> LiveMap;
+
+static bool Overlaps(const LiveMap& Live, uint64_t Offset, uint64_t Size)
+{
+	auto Next = Live.lower_bound(Offset);
+	if (Next != Live.end() && Next->first < Offset + Size)
+		return true;
+
+	if (Next != Live.begin())
+	{
+		auto Prev = std::prev(Next);
+		if (Prev->first + Prev->second > Offset)
+			return true;
+	}
+
+	return false;
+}
+
+//free space between live ranges, each gap is one free block
+static void Gaps(const LiveMap& Live, uint64_t Capacity, uint32_t& Count, uint64_t& Largest)
+{
+	Count = 0;
+	Largest = 0;
+
+	uint64_t End = 0;
+	for (const auto& Range : Live)
+	{
+		if (Range.first > End)
+		{
+			Count++;
+			Largest = std::max(Largest, Range.first - End);
+		}
+
+		End = Range.first + Range.second;
+	}
+
+	if (Capacity > End)
+	{
+		Count++;
+		Largest = std::max(Largest, Capacity - End);
+	}
+}
+
+static void Check_Coalesced(const CTlsfAllocator& Allocator, const LiveMap& Live)
+{
+	uint32_t Count;
+	uint64_t Largest;
+	Gaps(Live, Allocator.Capacity(), Count, Largest);
+
+	CHECK(Allocator.Free_Block_Count() == Count);
+	CHECK(Allocator.Largest_Free() == Largest);
+	CHECK(Allocator.Allocation_Count() == Live.size());
+}
+
+static void Test_Alignment()
+{
+	CTlsfAllocator Allocator;
+	Allocator.Init(16 * MB, 256);
+
+	uint64_t Offset = 0;
+
+	//sizes round up to the granularity
+	CHECK(Allocator.Allocate(1, 1, Offset));
+	CHECK(Offset == 0);
+	CHECK(Allocator.Used() == 256);
+
+	//the gap in front of an aligned block stays free
+	uint64_t Aligned = 0;
+	CHECK(Allocator.Allocate(1000, 64 * KB, Aligned));
+	CHECK(Aligned == 64 * KB);
+	CHECK(Allocator.Used() == 256 + 1024);
+	CHECK(Allocator.Free_Block_Count() == 2);
+
+	uint64_t Small = 0;
+	CHECK(Allocator.Allocate(512, 256, Small));
+	CHECK(Small == 256);
+
+	//4 MB alignment like MSAA textures
+	uint64_t Big = 0;
+	CHECK(Allocator.Allocate(3 * MB, 4 * MB, Big));
+	CHECK(Big % (4 * MB) == 0);
+
+	//capacity is cut to the granularity
+	CTlsfAllocator Odd;
+	Odd.Init(1000, 256);
+	CHECK(Odd.Capacity() == 768);
+}
+
+static void Test_Bad_Requests()
+{
+	CTlsfAllocator Allocator;
+	Allocator.Init(1 * MB, 256);
+
+	uint64_t Offset = 0;
+	CHECK(!Allocator.Allocate(0, 256, Offset));
+	CHECK(!Allocator.Allocate(2 * MB, 256, Offset));
+
+	//fills it exactly, then nothing fits
+	CHECK(Allocator.Allocate(1 * MB, 256, Offset));
+	CHECK(Offset == 0);
+	CHECK(Allocator.Free_Size() == 0);
+	CHECK(Allocator.Free_Block_Count() == 0);
+	CHECK(Allocator.Largest_Free() == 0);
+	CHECK(Allocator.Fragmentation() == 0.0);
+
+	uint64_t Other = 0;
+	CHECK(!Allocator.Allocate(256, 256, Other));
+
+	//an unknown offset changes nothing
+	Allocator.Free(12345);
+	CHECK(Allocator.Used() == 1 * MB);
+
+	Allocator.Free(Offset);
+	CHECK(Allocator.Used() == 0);
+	CHECK(Allocator.Free_Block_Count() == 1);
+
+	//a free twice is ignored
+	Allocator.Free(Offset);
+	CHECK(Allocator.Free_Block_Count() == 1);
+	CHECK(Allocator.Largest_Free() == 1 * MB);
+}
+
+static void Test_Merge()
+{
+	CTlsfAllocator Allocator;
+	Allocator.Init(1 * MB, 256);
+
+	uint64_t Offsets[4];
+	for (int i = 0; i < 4; i++)
+		CHECK(Allocator.Allocate(256 * KB, 256, Offsets[i]));
+
+	CHECK(Allocator.Free_Block_Count() == 0);
+
+	//not neighbours, two blocks
+	Allocator.Free(Offsets[0]);
+	Allocator.Free(Offsets[2]);
+	CHECK(Allocator.Free_Block_Count() == 2);
+	CHECK(Allocator.Largest_Free() == 256 * KB);
+	CHECK_NEAR(Allocator.Fragmentation(), 0.5, 1e-9);
+
+	//merges with the block before and after it
+	Allocator.Free(Offsets[1]);
+	CHECK(Allocator.Free_Block_Count() == 1);
+	CHECK(Allocator.Largest_Free() == 768 * KB);
+
+	uint64_t Big = 0;
+	CHECK(Allocator.Allocate(768 * KB, 256, Big));
+	CHECK(Big == 0);
+
+	Allocator.Free(Big);
+	Allocator.Free(Offsets[3]);
+	CHECK(Allocator.Free_Block_Count() == 1);
+	CHECK(Allocator.Largest_Free() == 1 * MB);
+	CHECK(Allocator.Fragmentation() == 0.0);
+}
+
+//400k random allocations and frees, mostly small sizes with some
+//texture sized ones and alignments up to 4 MB
+static void Test_Random()
+{
+	static const uint64_t Granularities[] = { 256, 64 * KB };
+
+	for (uint64_t Granularity : Granularities)
+	{
+		CTlsfAllocator Allocator;
+		//small enough for the big sizes to fill it now and then
+		Allocator.Init(32 * MB, Granularity);
+
+		std::mt19937 Rng(7);
+		LiveMap Live;
+		std::vector<uint64_t> Offsets;
+
+		uint64_t Used = 0;
+		uint32_t Failed = 0;
+		bool Valid = true;
+
+		for (uint32_t Step = 0; Step < 400000; Step++)
+		{
+			bool DoFree = !Offsets.empty() &&
+				Rng() % 1000 < 300 + 700 * Used / Allocator.Capacity();
+
+			if (DoFree)
+			{
+				size_t Pick = Rng() % Offsets.size();
+				uint64_t Offset = Offsets[Pick];
+				Offsets[Pick] = Offsets.back();
+				Offsets.pop_back();
+
+				Allocator.Free(Offset);
+
+				Used -= Live[Offset];
+				Live.erase(Offset);
+			}
+			else
+			{
+				uint64_t Size = Rng() % 8 != 0 ? 1 + Rng() % (64 * KB) : 64 * KB + Rng() % (4 * MB);
+				uint64_t Align = 1ull << (Rng() % 23);
+
+				uint64_t Offset = 0;
+				if (!Allocator.Allocate(Size, Align, Offset))
+				{
+					//a failed call leaves everything as it was
+					Valid = Valid && Allocator.Used() == Used;
+					Failed++;
+					continue;
+				}
+
+				uint64_t Taken = (Size + Granularity - 1) / Granularity * Granularity;
+
+				Valid = Valid && Offset % std::max(Align, Granularity) == 0;
+				Valid = Valid && Offset + Taken <= Allocator.Capacity();
+				Valid = Valid && !Overlaps(Live, Offset, Taken);
+
+				Live[Offset] = Taken;
+				Offsets.push_back(Offset);
+				Used += Taken;
+			}
+
+			Valid = Valid && Allocator.Used() == Used;
+
+			if (Step % 1000 == 0)
+				Check_Coalesced(Allocator, Live);
+		}
+
+		CHECK(Valid);
+		Check_Coalesced(Allocator, Live);
+
+		//the random mix fills the range now and then
+		CHECK(Failed > 100);
+		printf("    granularity %llu, %u failed, %u live, fragmentation %.3f\n",
+			(unsigned long long)Granularity, Failed, Allocator.Allocation_Count(), Allocator.Fragmentation());
+
+		//everything back, one block again
+		for (uint64_t Offset : Offsets)
+			Allocator.Free(Offset);
+
+		CHECK(Allocator.Used() == 0);
+		CHECK(Allocator.Allocation_Count() == 0);
+		CHECK(Allocator.Free_Block_Count() == 1);
+		CHECK(Allocator.Largest_Free() == Allocator.Capacity());
+	}
+}
+
+int main()
+{
+	RUN_TEST(Test_Alignment);
+	RUN_TEST(Test_Bad_Requests);
+	RUN_TEST(Test_Merge);
+	RUN_TEST(Test_Random);
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,242 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Upload Ring Tests
+//======================================================================================
+
+//CUploadRing is driven the way CUploadManager drives it, a counter
+//stands in for the copy queue fence and completes batches in order
+
+#include "TestCheck.h"
+
+#include "UploadRing.h"
+
+#include <random>
+#include <vector>
+
+//copy fence of a queue that finishes submits in order
+struct MockFence
+{
+	uint64_t Submitted = 0;
+	uint64_t Completed = 0;
+
+	uint64_t Signal() { return ++Submitted; }
+};
+
+static void Test_Align_And_Release()
+{
+	CUploadRing Ring;
+	Ring.Init(1024);
+
+	uint64_t Offset = ~0ull;
+	CHECK(Ring.Allocate(100, 16, Offset));
+	CHECK(Offset == 0);
+
+	CHECK(Ring.Allocate(100, 256, Offset));
+	CHECK(Offset == 256);
+	CHECK(Ring.Used() == 356);
+	CHECK(Ring.Has_Open_Allocations());
+	CHECK(Ring.Oldest_Fence() == 0);
+
+	Ring.Close_Batch(1);
+	CHECK(!Ring.Has_Open_Allocations());
+	CHECK(Ring.Oldest_Fence() == 1);
+
+	//closing with nothing open makes no batch
+	Ring.Close_Batch(2);
+	CHECK(Ring.Oldest_Fence() == 1);
+
+	Ring.Release(0);
+	CHECK(Ring.Used() == 356);
+
+	Ring.Release(1);
+	CHECK(Ring.Used() == 0);
+	CHECK(Ring.Oldest_Fence() == 0);
+}
+
+static void Test_Bad_Sizes()
+{
+	CUploadRing Ring;
+	Ring.Init(1024);
+
+	uint64_t Offset;
+	CHECK(!Ring.Allocate(0, 1, Offset));
+	CHECK(!Ring.Allocate(1025, 1, Offset));
+	CHECK(Ring.Allocate(1024, 1, Offset));
+	CHECK(Offset == 0);
+
+	//full ring has head == tail
+	CHECK(!Ring.Allocate(1, 1, Offset));
+	CHECK(Ring.Used() == 1024);
+}
+
+static void Test_Wrap()
+{
+	CUploadRing Ring;
+	Ring.Init(1000);
+
+	uint64_t Offset;
+	CHECK(Ring.Allocate(600, 1, Offset));
+	Ring.Close_Batch(1);
+	CHECK(Ring.Allocate(300, 1, Offset));
+	CHECK(Offset == 600);
+	Ring.Close_Batch(2);
+
+	//500 does not fit [900, 1000) or [0, 0)
+	CHECK(!Ring.Allocate(500, 1, Offset));
+
+	Ring.Release(1);
+
+	//the tail [900, 1000) is skipped and counted with the batch
+	CHECK(Ring.Allocate(500, 1, Offset));
+	CHECK(Offset == 0);
+	CHECK(Ring.Used() == 300 + 100 + 500);
+
+	//wrapped, free space is [500, 600)
+	CHECK(Ring.Allocate(100, 1, Offset));
+	CHECK(Offset == 500);
+	CHECK(!Ring.Allocate(1, 1, Offset));
+	Ring.Close_Batch(3);
+
+	Ring.Release(2);
+	CHECK(Ring.Used() == 700);
+
+	CHECK(Ring.Allocate(200, 64, Offset));
+	CHECK(Offset == 640);
+	Ring.Close_Batch(4);
+
+	Ring.Release(4);
+	CHECK(Ring.Used() == 0);
+
+	//empty ring starts over, a whole ring block fits
+	CHECK(Ring.Allocate(1000, 1, Offset));
+	CHECK(Offset == 0);
+}
+
+//live allocations of a batch in the model of the ring
+struct LiveBlock
+{
+	uint64_t Fence;
+	uint64_t Offset;
+	uint64_t Size;
+};
+
+static bool Overlaps(const std::vector<LiveBlock>& Live, uint64_t Offset, uint64_t Size)
+{
+	for (const LiveBlock& b : Live)
+		if (Offset < b.Offset + b.Size && b.Offset < Offset + Size)
+			return true;
+
+	return false;
+}
+
+//the model drops what the fence has passed, returns the live bytes
+static uint64_t Drop_Completed(std::vector<LiveBlock>& Live, uint64_t Completed)
+{
+	size_t Kept = 0;
+	uint64_t LiveBytes = 0;
+
+	for (const LiveBlock& b : Live)
+	{
+		if (b.Fence > Completed)
+		{
+			Live[Kept++] = b;
+			LiveBytes += b.Size;
+		}
+	}
+
+	Live.resize(Kept);
+	return LiveBytes;
+}
+
+//random copies of random sizes and alignments, batches submitted
+//now and then and a fence that runs behind, as the copy queue does
+static void Test_Random_Fence()
+{
+	const uint64_t Capacity = 64 * 1024;
+
+	CUploadRing Ring;
+	Ring.Init(Capacity);
+
+	MockFence Fence;
+	std::vector<LiveBlock> Live;
+	std::mt19937 Rng(1234);
+
+	int Stalls = 0;
+	int Wraps = 0;
+	uint64_t LastOffset = 0;
+
+	for (int Step = 0; Step < 100000; Step++)
+	{
+		uint64_t Size = 1 + Rng() % (Rng() % 8 == 0 ? 16384 : 1024);
+		uint64_t Align = 1ull << (Rng() % 10);
+
+		uint64_t Offset;
+		while (!Ring.Allocate(Size, Align, Offset))
+		{
+			//what CUploadManager does, submit what is open and
+			//wait for the oldest batch
+			if (Ring.Has_Open_Allocations())
+				Ring.Close_Batch(Fence.Signal());
+
+			CHECK(Ring.Oldest_Fence() != 0);
+			if (Ring.Oldest_Fence() == 0)
+				return;
+
+			Fence.Completed = Ring.Oldest_Fence();
+			Ring.Release(Fence.Completed);
+			Stalls++;
+		}
+
+		Drop_Completed(Live, Fence.Completed);
+
+		CHECK(Offset % Align == 0);
+		CHECK(Offset + Size <= Capacity);
+		CHECK(!Overlaps(Live, Offset, Size));
+
+		if (Offset < LastOffset)
+			Wraps++;
+		LastOffset = Offset;
+
+		//blocks of the open batch get the next fence value
+		Live.push_back({ Fence.Submitted + 1, Offset, Size });
+
+		if (Rng() % 4 == 0)
+			Ring.Close_Batch(Fence.Signal());
+
+		//the GPU runs behind, slow enough that the ring fills
+		if (Fence.Completed < Fence.Submitted && Rng() % 8 == 0)
+		{
+			Fence.Completed += 1 + Rng() % 2;
+			if (Fence.Completed > Fence.Submitted)
+				Fence.Completed = Fence.Submitted;
+
+			Ring.Release(Fence.Completed);
+		}
+
+		uint64_t LiveBytes = Drop_Completed(Live, Fence.Completed);
+		CHECK(Ring.Used() >= LiveBytes);
+		CHECK(Ring.Used() <= Capacity);
+		CHECK(Ring.Oldest_Fence() == 0 || Ring.Oldest_Fence() > Fence.Completed);
+	}
+
+	//drain, the ring ends empty with nothing lost to padding
+	Ring.Close_Batch(Fence.Signal());
+	Ring.Release(Fence.Submitted);
+
+	CHECK(Ring.Used() == 0);
+	CHECK(Ring.Oldest_Fence() == 0);
+	CHECK(!Ring.Has_Open_Allocations());
+
+	//the run did fill and wrap the ring
+	CHECK(Stalls > 0);
+	CHECK(Wraps > 0);
+}
+
+int main()
+{
+	RUN_TEST(Test_Align_And_Release);
+	RUN_TEST(Test_Bad_Sizes);
+	RUN_TEST(Test_Wrap);
+	RUN_TEST(Test_Random_Fence);
+
+	return TEST_RESULT();
+}
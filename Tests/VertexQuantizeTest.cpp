@@ -0,0 +1,429 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Vertex Quantization Tests
+//======================================================================================
+
+//normals go over a dense sphere and the points where the octahedron
+//folds, halves are checked against every half value and the midpoints
+//between them, QuantizePosTex error is measured here the way the shader
+//decodes and compared with what it reports
+
+#include "TestCheck.h"
+
+#include "VertexQuantize.h"
+
+#include <cfloat>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+#define PI 3.14159265358979323846
+
+static float Bits_To_Float(uint32_t Bits)
+{
+	float f;
+	memcpy(&f, &Bits, sizeof(f));
+	return f;
+}
+
+//exact value of a finite half
+static double Half_To_Double(uint16_t h)
+{
+	int Exp = (h >> 10) & 0x1F;
+	int Mantissa = h & 0x3FF;
+
+	double Value = Exp == 0 ? ldexp(Mantissa, -24) : ldexp(Mantissa | 0x400, Exp - 25);
+
+	return (h & 0x8000) ? -Value : Value;
+}
+
+static bool Is_Half_NaN(uint16_t h)
+{
+	return (h & 0x7C00) == 0x7C00 && (h & 0x3FF) != 0;
+}
+
+static void Test_Snorm_Unorm()
+{
+	CHECK(QuantizeSnorm16(1.0f) == 32767);
+	CHECK(QuantizeSnorm16(-1.0f) == -32767);
+	CHECK(QuantizeSnorm16(0.0f) == 0);
+	CHECK(QuantizeSnorm16(3.0f) == 32767);
+	CHECK(QuantizeSnorm16(-3.0f) == -32767);
+
+	CHECK(QuantizeUnorm16(0.0f) == 0);
+	CHECK(QuantizeUnorm16(1.0f) == 65535);
+	CHECK(QuantizeUnorm16(-0.5f) == 0);
+	CHECK(QuantizeUnorm16(2.0f) == 65535);
+	CHECK(QuantizeUnorm16(0.5f) == 32768);
+}
+
+static void Test_Half_Exact()
+{
+	//every half comes back as it was
+	bool Exact = true;
+	bool NaN = true;
+
+	for (uint32_t h = 0; h < 0x10000; h++)
+	{
+		if (Is_Half_NaN((uint16_t)h))
+		{
+			NaN = NaN && Is_Half_NaN(QuantizeHalf(std::numeric_limits<float>::quiet_NaN()));
+			continue;
+		}
+
+		float f = (h & 0x7C00) == 0x7C00 ?
+			((h & 0x8000) ? -INFINITY : INFINITY) : (float)Half_To_Double((uint16_t)h);
+
+		Exact = Exact && QuantizeHalf(f) == h;
+	}
+
+	CHECK(Exact);
+	CHECK(NaN);
+
+	//signalling NaN and NaN with only low mantissa bits stay NaN
+	CHECK(Is_Half_NaN(QuantizeHalf(Bits_To_Float(0x7F800001))));
+	CHECK(Is_Half_NaN(QuantizeHalf(Bits_To_Float(0xFFC00000))));
+	CHECK((QuantizeHalf(Bits_To_Float(0xFFC00000)) & 0x8000) != 0);
+
+	CHECK(QuantizeHalf(-0.0f) == 0x8000);
+}
+
+//halfway between two halves goes to the even one, the float
+//just below and just above go to the nearer one
+static void Test_Half_Rounding()
+{
+	bool Even = true;
+	bool Nearest = true;
+
+	//up to the midpoint between 65504 and where 65536 would be
+	for (uint32_t h = 0; h < 0x7BFF + 1; h++)
+	{
+		for (uint32_t Sign : { 0u, 0x8000u })
+		{
+			uint16_t Lo = (uint16_t)(h | Sign);
+			uint16_t Hi = (uint16_t)((h + 1) | Sign);
+
+			//past 65504 the next step would be 65536
+			double LoValue = Half_To_Double((uint16_t)h);
+			double HiValue = h + 1 == 0x7C00 ? 65536.0 : Half_To_Double((uint16_t)(h + 1));
+
+			//exact in a float, halves have 11 bit significands
+			double Mid = (LoValue + HiValue) * 0.5;
+			float f = (float)(Sign ? -Mid : Mid);
+
+			uint16_t Expected = (h & 1) ? Hi : Lo;
+			Even = Even && QuantizeHalf(f) == Expected;
+
+			float Below = nextafterf(f, 0.0f);
+			float Above = nextafterf(f, Sign ? -INFINITY : INFINITY);
+
+			Nearest = Nearest && QuantizeHalf(Below) == Lo && QuantizeHalf(Above) == Hi;
+		}
+	}
+
+	CHECK(Even);
+	CHECK(Nearest);
+}
+
+static void Test_Half_Range()
+{
+	//denormals
+	CHECK(QuantizeHalf((float)ldexp(1.0, -24)) == 0x0001);
+	CHECK(QuantizeHalf((float)ldexp(1023.0, -24)) == 0x03FF);
+	CHECK(QuantizeHalf((float)ldexp(3.0, -25)) == 0x0002);
+	CHECK(QuantizeHalf((float)ldexp(1.0, -25)) == 0x0000);
+	CHECK(QuantizeHalf((float)ldexp(1.0, -26)) == 0x0000);
+	CHECK(QuantizeHalf(-(float)ldexp(1.0, -26)) == 0x8000);
+	CHECK(QuantizeHalf(FLT_MIN) == 0x0000);
+	CHECK(QuantizeHalf(Bits_To_Float(1)) == 0x0000);
+
+	//largest denormal rounds up into the smallest normal
+	CHECK(QuantizeHalf((float)ldexp(1023.75, -24)) == 0x0400);
+
+	//overflow
+	CHECK(QuantizeHalf(65504.0f) == 0x7BFF);
+	CHECK(QuantizeHalf(65519.0f) == 0x7BFF);
+	CHECK(QuantizeHalf(65520.0f) == 0x7C00);
+	CHECK(QuantizeHalf(-65520.0f) == 0xFC00);
+	CHECK(QuantizeHalf(1.0e10f) == 0x7C00);
+	CHECK(QuantizeHalf(FLT_MAX) == 0x7C00);
+	CHECK(QuantizeHalf(-FLT_MAX) == 0xFC00);
+	CHECK(QuantizeHalf(INFINITY) == 0x7C00);
+	CHECK(QuantizeHalf(-INFINITY) == 0xFC00);
+
+	CHECK(QuantizeHalf(1.0f) == 0x3C00);
+	CHECK(QuantizeHalf(-2.0f) == 0xC000);
+}
+
+//angle in degrees between Normal and its decoded octahedral code
+static double Oct_Error(const float* Normal)
+{
+	int16_t Oct[2];
+	EncodeOctahedral(Normal, Oct);
+
+	float Decoded[3];
+	DecodeOctahedral(Oct, Decoded);
+
+	double Len = sqrt((double)Decoded[0] * Decoded[0] + (double)Decoded[1] * Decoded[1] + (double)Decoded[2] * Decoded[2]);
+	if (fabs(Len - 1.0) > 1.0e-5)
+		return 180.0;
+
+	double Dot = (Normal[0] * (double)Decoded[0] + Normal[1] * (double)Decoded[1] + Normal[2] * (double)Decoded[2]) / Len;
+	Dot = Dot > 1.0 ? 1.0 : (Dot < -1.0 ? -1.0 : Dot);
+
+	return acos(Dot) * 180.0 / PI;
+}
+
+//16 bit per component rounded to nearest, the worst case is where
+//a cell is stretched most, about 0.02 degrees at (+-s, +-s, 0)
+#define OCT_MAX_DEGREES 0.025
+
+static void Test_Octahedral_Sphere()
+{
+	//Fibonacci sphere, even cover of both halves
+	const int Count = 200000;
+	const double Golden = PI * (3.0 - sqrt(5.0));
+
+	double MaxError = 0.0;
+	double MaxLower = 0.0;
+
+	for (int i = 0; i < Count; i++)
+	{
+		double z = 1.0 - 2.0 * (i + 0.5) / Count;
+		double r = sqrt(1.0 - z * z);
+		double a = Golden * i;
+
+		float Normal[3] = { (float)(r * cos(a)), (float)(r * sin(a)), (float)z };
+
+		double Error = Oct_Error(Normal);
+
+		if (Error > MaxError)
+			MaxError = Error;
+		if (z < 0.0 && Error > MaxLower)
+			MaxLower = Error;
+	}
+
+	printf("    max error %.5f degrees, %.5f in the folded half\n", MaxError, MaxLower);
+
+	CHECK(MaxError < OCT_MAX_DEGREES);
+	CHECK(MaxLower > 0.0);
+}
+
+static void Test_Octahedral_Edges()
+{
+	const float s = 0.70710678f;
+
+	//axes, where x or y is 0 and the fold picks a sign,
+	//and the edges of the folded half
+	const float Normals[][3] =
+	{
+		{ 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 },
+		{ 0, 0, 1 }, { 0, 0, -1 },
+		{ s, 0, -s }, { -s, 0, -s }, { 0, s, -s }, { 0, -s, -s },
+		{ s, s, 0 }, { -s, s, 0 }, { s, -s, 0 }, { -s, -s, 0 },
+		{ 0.001f, 0, -0.9999995f }, { -0.001f, 0, -0.9999995f },
+		{ 0, 0.001f, -0.9999995f }, { 0, -0.001f, -0.9999995f },
+	};
+
+	for (const float* Normal : Normals)
+		CHECK(Oct_Error(Normal) < OCT_MAX_DEGREES);
+
+	//axes decode exactly
+	for (int i = 0; i < 6; i++)
+	{
+		int16_t Oct[2];
+		EncodeOctahedral(Normals[i], Oct);
+
+		float Decoded[3];
+		DecodeOctahedral(Oct, Decoded);
+
+		CHECK(Decoded[0] == Normals[i][0] && Decoded[1] == Normals[i][1] && Decoded[2] == Normals[i][2]);
+	}
+
+	//the fold of -z lands on the corners of the square
+	int16_t Oct[2];
+	EncodeOctahedral(Normals[5], Oct);
+	CHECK((Oct[0] == 32767 || Oct[0] == -32767) && (Oct[1] == 32767 || Oct[1] == -32767));
+}
+
+//what the shader gets back, max(v / 32767, -1) * Scale + Offset
+static float Decode_Pos(const QuantizedVertex& Q, const VertexDequantize& Decode, int j)
+{
+	float f = Q.Pos[j] / 32767.0f;
+	f = f < -1.0f ? -1.0f : f;
+	return f * Decode.PosScale[j] + Decode.PosOffset[j];
+}
+
+static float Decode_Tex(const QuantizedVertex& Q, const VertexDequantize& Decode, int j)
+{
+	return Q.Tex[j] / 65535.0f * Decode.TexScale[j] + Decode.TexOffset[j];
+}
+
+struct MeasuredError
+{
+	double Pos = 0.0;
+	double Tex = 0.0;
+};
+
+static MeasuredError Measure(const std::vector<float>& Vertices, const std::vector<QuantizedVertex>& Dst,
+	const VertexDequantize& Decode)
+{
+	MeasuredError Max;
+
+	for (size_t i = 0; i < Dst.size(); i++)
+	{
+		double Pos = 0.0, Tex = 0.0;
+
+		for (int j = 0; j < 3; j++)
+		{
+			double d = (double)Decode_Pos(Dst[i], Decode, j) - Vertices[i * 5 + j];
+			Pos += d * d;
+		}
+
+		for (int j = 0; j < 2; j++)
+		{
+			double d = (double)Decode_Tex(Dst[i], Decode, j) - Vertices[i * 5 + 3 + j];
+			Tex += d * d;
+		}
+
+		if (sqrt(Pos) > Max.Pos) Max.Pos = sqrt(Pos);
+		if (sqrt(Tex) > Max.Tex) Max.Tex = sqrt(Tex);
+	}
+
+	return Max;
+}
+
+static void Bounds_Of(const std::vector<float>& Vertices, float* Min, float* Max)
+{
+	for (int j = 0; j < 3; j++)
+	{
+		Min[j] = FLT_MAX;
+		Max[j] = -FLT_MAX;
+	}
+
+	for (size_t i = 0; i < Vertices.size(); i += 5)
+	{
+		for (int j = 0; j < 3; j++)
+		{
+			if (Vertices[i + j] < Min[j]) Min[j] = Vertices[i + j];
+			if (Vertices[i + j] > Max[j]) Max[j] = Vertices[i + j];
+		}
+	}
+}
+
+static void Test_Pos_Tex_Error()
+{
+	std::mt19937 Rng(6);
+	std::uniform_real_distribution<float> PosX(-300.0f, 500.0f);
+	std::uniform_real_distribution<float> PosY(0.0f, 40.0f);
+	std::uniform_real_distribution<float> PosZ(-2.0f, -1.0f);
+	std::uniform_real_distribution<float> Uv(-3.0f, 7.0f);
+
+	const uint32_t Count = 50000;
+	std::vector<float> Vertices;
+
+	for (uint32_t i = 0; i < Count; i++)
+	{
+		float v[5] = { PosX(Rng), PosY(Rng), PosZ(Rng), Uv(Rng), Uv(Rng) };
+		Vertices.insert(Vertices.end(), v, v + 5);
+	}
+
+	float Min[3], Max[3];
+	Bounds_Of(Vertices, Min, Max);
+
+	std::vector<QuantizedVertex> Dst(Count);
+	VertexDequantize Decode;
+	VertexQuantizeError Error;
+	QuantizePosTex(Vertices.data(), Count, Min, Max, Dst.data(), Decode, Error);
+
+	MeasuredError Measured = Measure(Vertices, Dst, Decode);
+
+	//what is reported is what the shader sees
+	CHECK_NEAR(Error.MaxPosError, Measured.Pos, Measured.Pos * 1.0e-3);
+	CHECK_NEAR(Error.MaxTexError, Measured.Tex, Measured.Tex * 1.0e-3);
+
+	//half a step on each axis, plus float rounding of the decode
+	double PosBound = 0.0, TexBound = 0.0;
+	for (int j = 0; j < 3; j++)
+	{
+		double Step = Decode.PosScale[j] / 32767.0 * 0.5 + fabs(Max[j]) * FLT_EPSILON * 2.0;
+		PosBound += Step * Step;
+	}
+	for (int j = 0; j < 2; j++)
+	{
+		double Step = Decode.TexScale[j] / 65535.0 * 0.5 + 7.0 * FLT_EPSILON * 2.0;
+		TexBound += Step * Step;
+	}
+
+	printf("    max pos error %.6f of %.6f, max uv error %.7f of %.7f\n",
+		Error.MaxPosError, sqrt(PosBound), Error.MaxTexError, sqrt(TexBound));
+
+	CHECK(Error.MaxPosError > 0.0f && Error.MaxPosError <= sqrt(PosBound));
+	CHECK(Error.MaxTexError > 0.0f && Error.MaxTexError <= sqrt(TexBound));
+
+	//w is padding
+	bool ZeroW = true;
+	for (const QuantizedVertex& Q : Dst)
+		ZeroW = ZeroW && Q.Pos[3] == 0;
+	CHECK(ZeroW);
+}
+
+static void Test_Zero_Extent()
+{
+	//a floor, flat in y, with one uv for every vertex
+	std::vector<float> Vertices;
+	for (int i = 0; i < 100; i++)
+	{
+		float v[5] = { i * 0.37f - 10.0f, 2.5f, (i % 7) * 1.5f, 0.25f, 0.75f };
+		Vertices.insert(Vertices.end(), v, v + 5);
+	}
+
+	float Min[3], Max[3];
+	Bounds_Of(Vertices, Min, Max);
+
+	const uint32_t Count = (uint32_t)(Vertices.size() / 5);
+	std::vector<QuantizedVertex> Dst(Count);
+	VertexDequantize Decode;
+	VertexQuantizeError Error;
+	QuantizePosTex(Vertices.data(), Count, Min, Max, Dst.data(), Decode, Error);
+
+	CHECK(Decode.PosScale[1] == 1.0f);
+	CHECK(Decode.PosOffset[1] == 2.5f);
+	CHECK(Decode.TexScale[0] == 1.0f && Decode.TexScale[1] == 1.0f);
+
+	//flat axis and uv come back exact
+	bool Exact = true;
+	for (uint32_t i = 0; i < Count; i++)
+	{
+		Exact = Exact && Dst[i].Pos[1] == 0 && Decode_Pos(Dst[i], Decode, 1) == 2.5f;
+		Exact = Exact && Decode_Tex(Dst[i], Decode, 0) == 0.25f && Decode_Tex(Dst[i], Decode, 1) == 0.75f;
+	}
+
+	CHECK(Exact);
+	CHECK(Error.MaxTexError == 0.0f);
+
+	MeasuredError Measured = Measure(Vertices, Dst, Decode);
+	CHECK_NEAR(Error.MaxPosError, Measured.Pos, Measured.Pos * 1.0e-3);
+
+	//a single vertex, every extent is zero
+	float One[5] = { 1.0f, -2.0f, 3.0f, 0.5f, 0.5f };
+	QuantizedVertex Q;
+	QuantizePosTex(One, 1, One, One, &Q, Decode, Error);
+
+	CHECK(Error.MaxPosError == 0.0f && Error.MaxTexError == 0.0f);
+	CHECK(Decode_Pos(Q, Decode, 0) == 1.0f && Decode_Pos(Q, Decode, 1) == -2.0f && Decode_Pos(Q, Decode, 2) == 3.0f);
+}
+
+int main()
+{
+	RUN_TEST(Test_Snorm_Unorm);
+	RUN_TEST(Test_Half_Exact);
+	RUN_TEST(Test_Half_Rounding);
+	RUN_TEST(Test_Half_Range);
+	RUN_TEST(Test_Octahedral_Sphere);
+	RUN_TEST(Test_Octahedral_Edges);
+	RUN_TEST(Test_Pos_Tex_Error);
+	RUN_TEST(Test_Zero_Extent);
+
+	return TEST_RESULT();
+}
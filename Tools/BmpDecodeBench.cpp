@@ -0,0 +1,52 @@
+//======================================================================================
+//	Ed Kurlyak 2023 BMP Decode Benchmark
+//======================================================================================
+
+//runs BenchmarkBmpDecode, a generated square BMP of the given size
+//decoded into rows of the upload footprint pitch, with every kernel
+//this CPU runs, 24 bit like Room.bmp and 32 bit, ms per decode and MB/s
+//
+//	BmpDecodeBench [<image size>]
+
+#include "BmpDecoder.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <initializer_list>
+
+#define RUNS 4
+
+int main(int argc, char* argv[])
+{
+	const uint32_t Size = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : 4096;
+
+	if (Size == 0 || Size > 16384)
+	{
+		fprintf(stderr, "usage: BmpDecodeBench [<image size, 1 - 16384>]\n");
+		return 2;
+	}
+
+	static const char* SimdNames[] = { "scalar", "SSSE3", "AVX2" };
+
+	for (uint32_t BitCount : { 24u, 32u })
+	{
+		BmpBenchResult Bench = BenchmarkBmpDecode(Size, Size, BitCount, RUNS);
+
+		const double FileMB = (double)Size * Size * BitCount / 8 / (1024.0 * 1024.0);
+
+		printf("%ux%u %u bit, %.1f MB of pixels\n", Size, Size, BitCount, FileMB);
+
+		for (int i = BMP_SIMD_NONE; i <= (int)BmpSimdSupport(); i++)
+		{
+			printf("  %-6s %8.2f ms, %6.0f MB/s", SimdNames[i], Bench.Time[i],
+				Bench.Time[i] > 0.0 ? FileMB / (Bench.Time[i] / 1000.0) : 0.0);
+
+			if (i > BMP_SIMD_NONE && Bench.Time[i] > 0.0)
+				printf(", %.2fx scalar", Bench.Time[BMP_SIMD_NONE] / Bench.Time[i]);
+
+			printf("\n");
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,23 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Cache Path of a Source Asset
+//======================================================================================
+
+#include "CachePath.h"
+#include "AssetCache.h"
+
+std::string SourceCachePath(const char* SourceName, uint64_t Key, const char* Ext, std::string& Dir)
+{
+	const std::string Source = SourceName;
+
+	size_t Slash = Source.find_last_of("/\\");
+	Dir = Slash == std::string::npos ? std::string(".") : Source.substr(0, Slash);
+
+	std::string Name = Slash == std::string::npos ? Source : Source.substr(Slash + 1);
+	size_t Dot = Name.find_last_of('.');
+	if (Dot != std::string::npos)
+		Name.resize(Dot);
+
+	Dir += "/" ASSET_CACHE_DIR;
+
+	return AssetCachePath(Dir.c_str(), Name.c_str(), Key, Ext);
+}
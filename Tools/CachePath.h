@@ -0,0 +1,15 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Cache Path of a Source Asset
+//======================================================================================
+
+#ifndef _CACHEPATH_
+#define _CACHEPATH_
+
+#include <cstdint>
+#include <string>
+
+//<dir of SourceName>/Cache/<name without extension>-<Key>.<Ext>, the
+//file the samples look up for SourceName, Dir gets the cache directory
+std::string SourceCachePath(const char* SourceName, uint64_t Key, const char* Ext, std::string& Dir);
+
+#endif
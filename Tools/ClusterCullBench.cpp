@@ -0,0 +1,203 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Cluster Cull Benchmark
+//======================================================================================
+
+//culls a large synthetic cluster set from a ring of cameras flying
+//over it and one camera under it, where the normal cones reject most
+//clusters, and reports how many clusters CullMeshClusters rejects
+//per millisecond
+//
+//	ClusterCullBench [<cluster count>]
+//
+//clusters are built by BuildMeshClusters from a height field grid,
+//the tile is repeated side by side to reach the cluster count
+
+#include "MeshCluster.h"
+#include "SyntheticMesh.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#define TILE_QUADS 256
+#define VIEW_COUNT 16
+#define CULL_RUNS 20
+
+#define PI 3.14159265f
+
+struct Float3
+{
+	float x, y, z;
+};
+
+static Float3 Sub(Float3 a, Float3 b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+static float Dot(Float3 a, Float3 b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+static Float3 Cross(Float3 a, Float3 b)
+{
+	return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+}
+
+static Float3 Normalize(Float3 a)
+{
+	float Len = sqrtf(Dot(a, a));
+	return { a.x / Len, a.y / Len, a.z / Len };
+}
+
+//row major for row vectors, same as XMMatrixLookAtLH
+//and XMMatrixPerspectiveFovLH, times each other
+static void View_Proj(Float3 Eye, Float3 At, float Fov, float Aspect, float Near, float Far, float* m)
+{
+	Float3 z = Normalize(Sub(At, Eye));
+	Float3 x = Normalize(Cross({ 0.0f, 1.0f, 0.0f }, z));
+	Float3 y = Cross(z, x);
+
+	const float View[16] = {
+		x.x, y.x, z.x, 0.0f,
+		x.y, y.y, z.y, 0.0f,
+		x.z, y.z, z.z, 0.0f,
+		-Dot(x, Eye), -Dot(y, Eye), -Dot(z, Eye), 1.0f };
+
+	float h = 1.0f / tanf(Fov * 0.5f);
+	float w = h / Aspect;
+	float q = Far / (Far - Near);
+
+	const float Proj[16] = {
+		w, 0.0f, 0.0f, 0.0f,
+		0.0f, h, 0.0f, 0.0f,
+		0.0f, 0.0f, q, 1.0f,
+		0.0f, 0.0f, -q * Near, 0.0f };
+
+	for (int r = 0; r < 4; r++)
+	{
+		for (int c = 0; c < 4; c++)
+		{
+			m[r * 4 + c] = 0.0f;
+			for (int k = 0; k < 4; k++)
+				m[r * 4 + c] += View[r * 4 + k] * Proj[k * 4 + c];
+		}
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const uint32_t ClusterTarget = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : 1000000;
+
+	if (ClusterTarget == 0)
+	{
+		fprintf(stderr, "usage: ClusterCullBench [<cluster count>]\n");
+		return 2;
+	}
+
+	std::vector<float> Vertices;
+	std::vector<uint32_t> Indices;
+	MakeGridMesh(TILE_QUADS, TILE_QUADS, Vertices, Indices);
+
+	std::vector<MeshCluster> Tile;
+	BuildMeshClusters(Indices.data(), Indices.size(), Vertices.data(), 5 * sizeof(float),
+		(uint32_t)(Vertices.size() / 5), Tile);
+
+	const float TileSize = TILE_QUADS * 16.0f;
+	const uint32_t TilesPerRow = (uint32_t)ceil(sqrt((double)ClusterTarget / Tile.size()));
+
+	std::vector<MeshCluster> Clusters;
+	Clusters.reserve(ClusterTarget);
+
+	for (uint32_t t = 0; Clusters.size() < ClusterTarget; t++)
+	{
+		for (const MeshCluster& Source : Tile)
+		{
+			if (Clusters.size() == ClusterTarget)
+				break;
+
+			MeshCluster Cluster = Source;
+			Cluster.Center[0] += (t % TilesPerRow) * TileSize;
+			Cluster.Center[2] += (t / TilesPerRow) * TileSize;
+			Clusters.push_back(Cluster);
+		}
+	}
+
+	const float Extent = TilesPerRow * TileSize;
+	const Float3 Middle = { Extent * 0.5f, 0.0f, Extent * 0.5f };
+
+	struct CullView
+	{
+		ClusterCullView View;
+		const char* Name;
+	};
+
+	std::vector<CullView> Views;
+
+	//ring of cameras over the middle, looking down at the far side
+	for (int i = 0; i < VIEW_COUNT; i++)
+	{
+		float Angle = 2.0f * PI * i / VIEW_COUNT;
+		Float3 Eye = { Middle.x + cosf(Angle) * Extent * 0.25f, 1500.0f, Middle.z + sinf(Angle) * Extent * 0.25f };
+		Float3 At = { Middle.x - cosf(Angle) * Extent * 0.25f, 0.0f, Middle.z - sinf(Angle) * Extent * 0.25f };
+
+		float WorldViewProj[16];
+		View_Proj(Eye, At, 0.25f * PI, 4.0f / 3.0f, 1.0f, Extent, WorldViewProj);
+
+		CullView View;
+		View.Name = "over";
+		SetClusterCullView(View.View, WorldViewProj, &Eye.x);
+		Views.push_back(View);
+	}
+
+	//under the height field looking up, most clusters face away
+	{
+		Float3 Eye = { Middle.x, -5000.0f, Middle.z };
+		Float3 At = { Middle.x + 1.0f, 0.0f, Middle.z };
+
+		float WorldViewProj[16];
+		View_Proj(Eye, At, 0.5f * PI, 4.0f / 3.0f, 1.0f, Extent * 2.0f, WorldViewProj);
+
+		CullView View;
+		View.Name = "under";
+		SetClusterCullView(View.View, WorldViewProj, &Eye.x);
+		Views.push_back(View);
+	}
+
+	const uint32_t ClusterCount = (uint32_t)Clusters.size();
+	std::vector<uint8_t> Visible(ClusterCount);
+
+	uint64_t Rejected = 0;
+	uint32_t UnderVisible = 0;
+	double Seconds = 0.0;
+
+	for (const CullView& View : Views)
+	{
+		for (int r = 0; r < CULL_RUNS; r++)
+		{
+			auto Start = std::chrono::steady_clock::now();
+
+			uint32_t VisibleCount = CullMeshClusters(Clusters.data(), ClusterCount, View.View, Visible.data());
+
+			Seconds += SecondsSince(Start);
+			Rejected += ClusterCount - VisibleCount;
+
+			if (r == 0 && View.Name[0] == 'u')
+				UnderVisible = VisibleCount;
+		}
+	}
+
+	//the under view again without the cone test, clusters it
+	//finds visible and the full test does not were back facing
+	std::vector<MeshCluster> NoCones = Clusters;
+	for (MeshCluster& Cluster : NoCones)
+		Cluster.ConeCutoff = 1.0f;
+
+	uint32_t UnderInFrustum = CullMeshClusters(NoCones.data(), ClusterCount, Views.back().View, Visible.data());
+
+	const double Culls = (double)Views.size() * CULL_RUNS;
+
+	printf("%u clusters (%zu per tile), %zu views x %d runs\n",
+		ClusterCount, Tile.size(), Views.size(), CULL_RUNS);
+	printf("  %.3f ms per cull, %.1f%% rejected, %.0f clusters rejected per ms, %.0f tested per ms\n",
+		Seconds * 1000.0 / Culls, 100.0 * Rejected / (Culls * ClusterCount),
+		Rejected / (Seconds * 1000.0), Culls * ClusterCount / (Seconds * 1000.0));
+	printf("  camera under the mesh: %u clusters in the frustum, %u rejected by the normal cones\n",
+		UnderInFrustum, UnderInFrustum - UnderVisible);
+
+	return 0;
+}
@@ -0,0 +1,143 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Mesh Converter
+//======================================================================================
+
+//converts a text mesh (room.txt format) to the binary mesh file the
+//samples load, the same cook Read_Scene_Mesh does on a cache miss
+//
+//	MeshConvert [-trace <trace.json>] <source.txt> [<output.mesh>]
+//
+//	-trace <trace.json>		writes the profiler markers of the cook
+//
+//without an output name the file goes to Cache/<name>-<key>.mesh next to
+//the source, where the samples look it up, so a build machine can cook
+//the meshes before they ship
+
+#include "MeshFile.h"
+#include "CachePath.h"
+#include "Profiler.h"
+#include "SyntheticMesh.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+static void Print_Usage()
+{
+	fprintf(stderr, "usage: MeshConvert [-trace <trace.json>] <source.txt> [<output.mesh>]\n");
+}
+
+int main(int argc, char* argv[])
+{
+	const char* TraceName = nullptr;
+
+	const char* Files[2] = { nullptr, nullptr };
+	int FileCount = 0;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const char* Arg = argv[i];
+
+		if (strcmp(Arg, "-trace") == 0 && i + 1 < argc)
+		{
+			TraceName = argv[++i];
+		}
+		else if (Arg[0] != '-' && FileCount < 2)
+		{
+			Files[FileCount++] = Arg;
+		}
+		else
+		{
+			Print_Usage();
+			return 2;
+		}
+	}
+
+	if (FileCount == 0)
+	{
+		Print_Usage();
+		return 2;
+	}
+
+	const char* SourceName = Files[0];
+
+	uint64_t SourceKey = 0;
+
+	{
+		CMappedFile Source;
+		if (!Source.Open(SourceName))
+		{
+			fprintf(stderr, "%s: can not open\n", SourceName);
+			return 1;
+		}
+
+		SourceKey = MeshCookKey(Source.Data(), Source.Size());
+	}
+
+	std::string OutputName;
+
+	if (FileCount == 2)
+	{
+		OutputName = Files[1];
+	}
+	else
+	{
+		std::string Dir;
+		OutputName = SourceCachePath(SourceName, SourceKey, "mesh", Dir);
+
+		if (!CreateAssetCacheDir(Dir.c_str()))
+		{
+			fprintf(stderr, "%s: can not create\n", Dir.c_str());
+			return 1;
+		}
+	}
+
+	CThreadPool Pool;
+
+	auto Start = std::chrono::steady_clock::now();
+
+	TextMeshResult Parsed;
+	MeshCookStats Stats;
+	bool Converted = ConvertTextMeshToBinary(SourceName, OutputName.c_str(), SourceKey, Pool, Parsed, Stats);
+
+	double Seconds = SecondsSince(Start);
+
+	if (TraceName != nullptr && !CProfiler::Write_Trace(TraceName))
+		fprintf(stderr, "%s: can not write the trace\n", TraceName);
+
+	for (const TextMeshError& Error : Parsed.Errors)
+		fprintf(stderr, "%s(%llu): %s\n", SourceName, (unsigned long long)Error.Line, Error.Message);
+
+	if (Parsed.ErrorCount > Parsed.Errors.size())
+		fprintf(stderr, "%s: %llu more errors\n", SourceName,
+			(unsigned long long)(Parsed.ErrorCount - Parsed.Errors.size()));
+
+	if (!Converted)
+	{
+		fprintf(stderr, "%s: conversion failed\n", SourceName);
+		return 1;
+	}
+
+	CMeshFile MeshFile;
+	if (!MeshFile.Open(OutputName.c_str()))
+	{
+		fprintf(stderr, "%s: written file does not open\n", OutputName.c_str());
+		return 1;
+	}
+
+	const MeshFileHeader& Header = MeshFile.Header();
+
+	printf("%s -> %s\n", SourceName, OutputName.c_str());
+	printf("  %u triangles, %u -> %u vertices, %u bit indices, %u clusters\n",
+		Header.IndexCount / 3, Parsed.VertexCount, Header.VertexCount,
+		Header.IndexStride * 8, Header.ClusterCount);
+	printf("  ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n",
+		Stats.Optimize.Before.ACMR, Stats.Optimize.After.ACMR,
+		Stats.Optimize.Before.ATVR, Stats.Optimize.After.ATVR);
+	printf("  max position error %.4f, max uv error %.6f\n",
+		Stats.Quantize.MaxPosError, Stats.Quantize.MaxTexError);
+	printf("  %.1f MB -> %.1f MB in %.2f s\n",
+		Parsed.ByteSize / 1048576.0, Header.FileSize / 1048576.0, Seconds);
+
+	return 0;
+}
@@ -0,0 +1,134 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Mesh Load Benchmark
+//======================================================================================
+
+//loads the same synthetic mesh from the text format with the original
+//fgets + sscanf loop and from the binary mesh file, the binary load maps
+//the file, checks it and copies vertices and indices out as the samples
+//do into the upload buffer
+//
+//	MeshLoadBench [<triangle count>]
+//
+//the files are written to the working directory and removed at the end,
+//both loads read from the OS file cache, cold loads favour binary more
+
+#include "MeshFile.h"
+#include "SyntheticMesh.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#define TEXT_FILE_NAME "MeshLoadBench.txt"
+#define BIN_FILE_NAME "MeshLoadBench.mesh"
+
+#define BINARY_LOAD_RUNS 5
+
+static bool Load_Binary(std::vector<unsigned char>& Upload)
+{
+	CMeshFile MeshFile;
+	if (!MeshFile.Open(BIN_FILE_NAME))
+		return false;
+
+	const uint64_t VbByteSize = MeshFile.StreamByteSize(0);
+	const uint64_t IbByteSize = MeshFile.IndexByteSize();
+
+	Upload.resize((size_t)(VbByteSize + IbByteSize));
+	memcpy(Upload.data(), MeshFile.StreamData(0), (size_t)VbByteSize);
+	memcpy(Upload.data() + VbByteSize, MeshFile.IndexData(), (size_t)IbByteSize);
+
+	return true;
+}
+
+int main(int argc, char* argv[])
+{
+	const uint32_t TriangleCount = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : 2000000;
+
+	if (TriangleCount == 0)
+	{
+		fprintf(stderr, "usage: MeshLoadBench [<triangle count>]\n");
+		return 2;
+	}
+
+	std::vector<float> GridVertices;
+	std::vector<uint32_t> GridIndices;
+	MakeGridMeshTriangles(TriangleCount, GridVertices, GridIndices);
+	GridIndices.resize((size_t)TriangleCount * 3);
+	ShuffleTriangles(GridIndices, 1);
+
+	std::vector<float> Vertices;
+	UnindexMesh(GridVertices, GridIndices, Vertices);
+
+	if (!WriteTextMesh(TEXT_FILE_NAME, Vertices))
+	{
+		fprintf(stderr, "%s: can not write\n", TEXT_FILE_NAME);
+		return 1;
+	}
+
+	CThreadPool Pool;
+
+	uint64_t SourceKey = 0;
+	uint64_t TextSize = 0;
+
+	{
+		CMappedFile Source;
+		Source.Open(TEXT_FILE_NAME);
+		SourceKey = MeshCookKey(Source.Data(), Source.Size());
+		TextSize = Source.Size();
+	}
+
+	//text
+	auto Start = std::chrono::steady_clock::now();
+
+	std::vector<float> TextVertices;
+	bool TextLoaded = LoadTextMeshLegacy(TEXT_FILE_NAME, TextVertices);
+
+	double TextTime = SecondsSince(Start);
+
+	//one time cook
+	Start = std::chrono::steady_clock::now();
+
+	TextMeshResult Parsed;
+	MeshCookStats Stats;
+	bool Converted = ConvertTextMeshToBinary(TEXT_FILE_NAME, BIN_FILE_NAME, SourceKey, Pool, Parsed, Stats);
+
+	double ConvertTime = SecondsSince(Start);
+
+	//binary, best of a few runs
+	double BinaryTime = 0.0;
+	bool BinaryLoaded = Converted;
+	std::vector<unsigned char> Upload;
+
+	for (int i = 0; i < BINARY_LOAD_RUNS && BinaryLoaded; i++)
+	{
+		Start = std::chrono::steady_clock::now();
+
+		BinaryLoaded = Load_Binary(Upload);
+
+		double Time = SecondsSince(Start);
+		if (i == 0 || Time < BinaryTime)
+			BinaryTime = Time;
+	}
+
+	uint64_t BinarySize = Upload.size();
+
+	remove(TEXT_FILE_NAME);
+	remove(BIN_FILE_NAME);
+
+	if (!TextLoaded || TextVertices.size() != Vertices.size() || !Converted || !BinaryLoaded)
+	{
+		fprintf(stderr, "load failed: text %d, convert %d, binary %d\n", TextLoaded, Converted, BinaryLoaded);
+		return 1;
+	}
+
+	printf("%u triangles, text %.1f MB, binary %.1f MB\n",
+		TriangleCount, TextSize / 1048576.0, BinarySize / 1048576.0);
+	printf("  text (fgets + sscanf)  %9.2f ms  %7.1f MB/s\n",
+		TextTime * 1000.0, TextSize / 1048576.0 / TextTime);
+	printf("  convert to binary      %9.2f ms  (once per source change)\n",
+		ConvertTime * 1000.0);
+	printf("  binary (mapped file)   %9.2f ms  %7.1fx faster than text\n",
+		BinaryTime * 1000.0, TextTime / BinaryTime);
+
+	return 0;
+}
@@ -0,0 +1,81 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Mesh Optimizer Benchmark
+//======================================================================================
+
+//runs the OptimizeMesh passes one by one on a shuffled synthetic
+//grid and reports their speed and the vertex cache stats after each
+//
+//	MeshOptimizerBench [<triangle count>]
+
+#include "MeshOptimizer.h"
+#include "SyntheticMesh.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+#define VERTEX_STRIDE (5 * sizeof(float))
+
+static void Print_Pass(const char* Name, double Seconds, size_t TriCount,
+	const uint32_t* Indices, size_t IndexCount, uint32_t VertexCount)
+{
+	VertexCacheStats Stats = AnalyzeVertexCache(Indices, IndexCount, VertexCount);
+
+	if (Seconds > 0.0)
+		printf("  %-14s %9.2f ms  %7.2f Mtri/s  ACMR %.3f  ATVR %.3f\n", Name, Seconds * 1000.0,
+			TriCount / Seconds / 1e6, Stats.ACMR, Stats.ATVR);
+	else
+		printf("  %-14s %9s     %7s         ACMR %.3f  ATVR %.3f\n", Name, "", "", Stats.ACMR, Stats.ATVR);
+}
+
+int main(int argc, char* argv[])
+{
+	const uint32_t TriangleCount = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : 4000000;
+
+	if (TriangleCount == 0)
+	{
+		fprintf(stderr, "usage: MeshOptimizerBench [<triangle count>]\n");
+		return 2;
+	}
+
+	std::vector<float> Vertices;
+	std::vector<uint32_t> Indices;
+	MakeGridMeshTriangles(TriangleCount, Vertices, Indices);
+	Indices.resize((size_t)TriangleCount * 3);
+	ShuffleTriangles(Indices, 1);
+
+	const uint32_t VertexCount = (uint32_t)(Vertices.size() / 5);
+	const size_t TriCount = Indices.size() / 3;
+
+	printf("%zu triangles, %u vertices, cache size %d\n", TriCount, VertexCount, VERTEX_CACHE_SIZE);
+
+	Print_Pass("shuffled", 0.0, TriCount, Indices.data(), Indices.size(), VertexCount);
+
+	std::vector<uint32_t> CacheOptimized(Indices.size());
+
+	auto Start = std::chrono::steady_clock::now();
+	OptimizeVertexCache(CacheOptimized.data(), Indices.data(), Indices.size(), VertexCount);
+	double CacheTime = SecondsSince(Start);
+
+	Print_Pass("vertex cache", CacheTime, TriCount, CacheOptimized.data(), CacheOptimized.size(), VertexCount);
+
+	Start = std::chrono::steady_clock::now();
+	OptimizeOverdraw(Indices.data(), CacheOptimized.data(), CacheOptimized.size(),
+		Vertices.data(), VERTEX_STRIDE, VertexCount);
+	double OverdrawTime = SecondsSince(Start);
+
+	Print_Pass("overdraw", OverdrawTime, TriCount, Indices.data(), Indices.size(), VertexCount);
+
+	std::vector<unsigned char> Bytes((unsigned char*)Vertices.data(),
+		(unsigned char*)(Vertices.data() + Vertices.size()));
+
+	Start = std::chrono::steady_clock::now();
+	uint32_t FetchCount = OptimizeVertexFetch(Bytes, Indices, VERTEX_STRIDE);
+	double FetchTime = SecondsSince(Start);
+
+	Print_Pass("vertex fetch", FetchTime, TriCount, Indices.data(), Indices.size(), FetchCount);
+
+	double Total = CacheTime + OverdrawTime + FetchTime;
+	printf("  %-14s %9.2f ms  %7.2f Mtri/s\n", "total", Total * 1000.0, TriCount / Total / 1e6);
+
+	return 0;
+}
@@ -0,0 +1,145 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Synthetic Meshes for Tests and Benchmarks
+//======================================================================================
+
+#include "SyntheticMesh.h"
+
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+void MakeGridMesh(uint32_t QuadsX, uint32_t QuadsY,
+	std::vector<float>& Vertices, std::vector<uint32_t>& Indices)
+{
+	const uint32_t RowSize = QuadsX + 1;
+
+	Vertices.clear();
+	Vertices.reserve((size_t)RowSize * (QuadsY + 1) * 5);
+
+	for (uint32_t y = 0; y <= QuadsY; y++)
+	{
+		for (uint32_t x = 0; x <= QuadsX; x++)
+		{
+			Vertices.push_back(x * 16.0f);
+			Vertices.push_back(sinf(x * 0.05f) * cosf(y * 0.07f) * 200.0f);
+			Vertices.push_back(y * 16.0f);
+			Vertices.push_back((float)x / QuadsX);
+			Vertices.push_back((float)y / QuadsY);
+		}
+	}
+
+	Indices.clear();
+	Indices.reserve((size_t)QuadsX * QuadsY * 6);
+
+	for (uint32_t y = 0; y < QuadsY; y++)
+	{
+		for (uint32_t x = 0; x < QuadsX; x++)
+		{
+			uint32_t i0 = y * RowSize + x;
+			uint32_t i1 = i0 + 1;
+			uint32_t i2 = i0 + RowSize;
+			uint32_t i3 = i2 + 1;
+
+			Indices.insert(Indices.end(), { i0, i2, i1, i1, i2, i3 });
+		}
+	}
+}
+
+void MakeGridMeshTriangles(uint32_t TriangleCount,
+	std::vector<float>& Vertices, std::vector<uint32_t>& Indices)
+{
+	uint32_t QuadCount = TriangleCount / 2 + TriangleCount % 2;
+	if (QuadCount == 0)
+		QuadCount = 1;
+
+	uint32_t QuadsX = (uint32_t)ceil(sqrt((double)QuadCount));
+	uint32_t QuadsY = (QuadCount + QuadsX - 1) / QuadsX;
+
+	MakeGridMesh(QuadsX, QuadsY, Vertices, Indices);
+}
+
+void ShuffleTriangles(std::vector<uint32_t>& Indices, uint32_t Seed)
+{
+	std::mt19937 Rng(Seed);
+
+	const size_t TriCount = Indices.size() / 3;
+
+	for (size_t i = TriCount; i > 1; i--)
+	{
+		size_t j = std::uniform_int_distribution<size_t>(0, i - 1)(Rng);
+
+		for (int k = 0; k < 3; k++)
+			std::swap(Indices[(i - 1) * 3 + k], Indices[j * 3 + k]);
+	}
+}
+
+void UnindexMesh(const std::vector<float>& Vertices, const std::vector<uint32_t>& Indices,
+	std::vector<float>& OutVertices)
+{
+	OutVertices.resize(Indices.size() * 5);
+
+	for (size_t i = 0; i < Indices.size(); i++)
+	{
+		for (int k = 0; k < 5; k++)
+			OutVertices[i * 5 + k] = Vertices[(size_t)Indices[i] * 5 + k];
+	}
+}
+
+bool WriteTextMesh(const char* FileName, const std::vector<float>& Vertices)
+{
+	FILE* Fp = fopen(FileName, "wt");
+	if (Fp == NULL)
+		return false;
+
+	const size_t VertexCount = Vertices.size() / 5;
+
+	fprintf(Fp, "%zu\n", VertexCount / 3);
+
+	for (size_t i = 0; i < VertexCount; i++)
+	{
+		const float* v = &Vertices[i * 5];
+		fprintf(Fp, "%f %f %f %f %f\n", v[0], v[1], v[2], v[3], v[4]);
+	}
+
+	bool Result = ferror(Fp) == 0;
+	fclose(Fp);
+
+	return Result;
+}
+
+bool LoadTextMeshLegacy(const char* FileName, std::vector<float>& Vertices)
+{
+	FILE* f = fopen(FileName, "rt");
+	if (f == NULL)
+		return false;
+
+	char Buffer[1024];
+
+	int Size = 0;
+	if (fgets(Buffer, 1024, f) == NULL || sscanf(Buffer, "%d", &Size) != 1 || Size < 0)
+	{
+		fclose(f);
+		return false;
+	}
+
+	Vertices.resize((size_t)Size * 3 * 5);
+
+	bool Result = true;
+
+	for (size_t i = 0; i < (size_t)Size * 3 && Result; i++)
+	{
+		float* v = &Vertices[i * 5];
+
+		Result = fgets(Buffer, 1024, f) != NULL &&
+			sscanf(Buffer, "%f %f %f %f %f", &v[0], &v[1], &v[2], &v[3], &v[4]) == 5;
+	}
+
+	fclose(f);
+
+	return Result;
+}
+
+double SecondsSince(std::chrono::steady_clock::time_point Start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+}
@@ -0,0 +1,37 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Synthetic Meshes for Tests and Benchmarks
+//======================================================================================
+
+#ifndef _SYNTHETICMESH_
+#define _SYNTHETICMESH_
+
+#include <cstdint>
+#include <chrono>
+#include <vector>
+
+//indexed height field of QuadsX * QuadsY quads, two triangles
+//each, x y z u v per vertex as in the text mesh format
+void MakeGridMesh(uint32_t QuadsX, uint32_t QuadsY,
+	std::vector<float>& Vertices, std::vector<uint32_t>& Indices);
+
+//square grid with at least TriangleCount triangles
+void MakeGridMeshTriangles(uint32_t TriangleCount,
+	std::vector<float>& Vertices, std::vector<uint32_t>& Indices);
+
+//random triangle order, as from an exporter that does not care
+void ShuffleTriangles(std::vector<uint32_t>& Indices, uint32_t Seed);
+
+//one vertex per index, the layout of the text mesh format
+void UnindexMesh(const std::vector<float>& Vertices, const std::vector<uint32_t>& Indices,
+	std::vector<float>& OutVertices);
+
+//writes unindexed Vertices in the room.txt format
+bool WriteTextMesh(const char* FileName, const std::vector<float>& Vertices);
+
+//the room.txt loop of the original Create_Cube_Geometry_Pass1, fgets and
+//sscanf per line, without the fixed triangle count, benchmark baseline
+bool LoadTextMeshLegacy(const char* FileName, std::vector<float>& Vertices);
+
+double SecondsSince(std::chrono::steady_clock::time_point Start);
+
+#endif
@@ -0,0 +1,117 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Text Mesh Parser Benchmark
+//======================================================================================
+
+//parse throughput of the original fgets + sscanf loop and of ParseTextMesh
+//with one worker and with a worker per hardware thread, on the same
+//synthetic text mesh
+//
+//	TextMeshParserBench [<triangle count>]
+
+#include "TextMeshParser.h"
+#include "MappedFile.h"
+#include "SyntheticMesh.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+#define TEXT_FILE_NAME "TextMeshParserBench.txt"
+
+#define PARSE_RUNS 3
+
+//best of PARSE_RUNS, in seconds
+template <typename Func>
+static double Best_Time(Func Parse, bool& Result)
+{
+	double Best = 0.0;
+
+	for (int i = 0; i < PARSE_RUNS; i++)
+	{
+		auto Start = std::chrono::steady_clock::now();
+
+		Result = Parse();
+
+		double Time = SecondsSince(Start);
+		if (i == 0 || Time < Best)
+			Best = Time;
+	}
+
+	return Best;
+}
+
+int main(int argc, char* argv[])
+{
+	const uint32_t TriangleCount = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : 2000000;
+
+	if (TriangleCount == 0)
+	{
+		fprintf(stderr, "usage: TextMeshParserBench [<triangle count>]\n");
+		return 2;
+	}
+
+	std::vector<float> GridVertices;
+	std::vector<uint32_t> GridIndices;
+	MakeGridMeshTriangles(TriangleCount, GridVertices, GridIndices);
+	GridIndices.resize((size_t)TriangleCount * 3);
+
+	std::vector<float> Vertices;
+	UnindexMesh(GridVertices, GridIndices, Vertices);
+
+	if (!WriteTextMesh(TEXT_FILE_NAME, Vertices))
+	{
+		fprintf(stderr, "%s: can not write\n", TEXT_FILE_NAME);
+		return 1;
+	}
+
+	CMappedFile File;
+	if (!File.Open(TEXT_FILE_NAME))
+	{
+		fprintf(stderr, "%s: can not open\n", TEXT_FILE_NAME);
+		return 1;
+	}
+
+	const double MegaBytes = File.Size() / 1048576.0;
+
+	bool LegacyResult = false;
+	std::vector<float> LegacyVertices;
+
+	double LegacyTime = Best_Time([&]
+	{
+		return LoadTextMeshLegacy(TEXT_FILE_NAME, LegacyVertices);
+	}, LegacyResult);
+
+	CThreadPool OneWorker(1);
+	CThreadPool AllWorkers;
+
+	bool OneResult = false, AllResult = false;
+	TextMeshResult Parsed;
+
+	double OneTime = Best_Time([&]
+	{
+		return ParseTextMesh((const char*)File.Data(), File.Size(), OneWorker, Parsed);
+	}, OneResult);
+
+	double AllTime = Best_Time([&]
+	{
+		return ParseTextMesh((const char*)File.Data(), File.Size(), AllWorkers, Parsed);
+	}, AllResult);
+
+	File.Close();
+	remove(TEXT_FILE_NAME);
+
+	if (!LegacyResult || !OneResult || !AllResult || Parsed.Vertices != LegacyVertices)
+	{
+		fprintf(stderr, "parse failed or results differ\n");
+		return 1;
+	}
+
+	printf("%u triangles, %.1f MB\n", TriangleCount, MegaBytes);
+	printf("  fgets + sscanf             %9.2f ms  %8.1f MB/s\n",
+		LegacyTime * 1000.0, MegaBytes / LegacyTime);
+	printf("  from_chars, 1 worker       %9.2f ms  %8.1f MB/s  %5.1fx\n",
+		OneTime * 1000.0, MegaBytes / OneTime, LegacyTime / OneTime);
+	printf("  from_chars, %2u workers     %9.2f ms  %8.1f MB/s  %5.1fx\n",
+		AllWorkers.ThreadCount(), AllTime * 1000.0, MegaBytes / AllTime, LegacyTime / AllTime);
+
+	return 0;
+}
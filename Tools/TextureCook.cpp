@@ -0,0 +1,227 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Texture Cooker
+//======================================================================================
+
+//cooks a BMP into the DDS texture file the samples load, the same
+//cook Read_Scene_Texture does on a cache miss
+//
+//	TextureCook [options] <source.bmp> [<output.dds>]
+//
+//	-format bc1 | bc3 | bc7 | rgba8		block format, bc7 by default
+//	-quality fast | normal | high		encoder speed / quality, normal by default
+//	-nomips								top level only
+//	-linear								colors are not sRGB, mips are filtered as is
+//	-threads <n>						encoder threads, one per hardware thread by default
+//	-trace <trace.json>					writes the profiler markers of the cook
+//
+//without an output name the file goes to Cache/<name>-<key>.dds next to the
+//source, the name the samples look up when cooked with the default options
+
+#include "TextureFile.h"
+#include "CachePath.h"
+#include "Profiler.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+static void Print_Usage()
+{
+	fprintf(stderr,
+		"usage: TextureCook [options] <source.bmp> [<output.dds>]\n"
+		"  -format bc1 | bc3 | bc7 | rgba8   block format, bc7 by default\n"
+		"  -quality fast | normal | high     encoder speed / quality, normal by default\n"
+		"  -nomips                           top level only\n"
+		"  -linear                           colors are not sRGB\n"
+		"  -threads <n>                      encoder threads\n"
+		"  -trace <trace.json>               profiler markers of the cook\n");
+}
+
+static bool Parse_Format(const char* Name, TextureFormat& Format)
+{
+	if (strcmp(Name, "bc1") == 0)
+		Format = TEXTURE_FORMAT_BC1;
+	else if (strcmp(Name, "bc3") == 0)
+		Format = TEXTURE_FORMAT_BC3;
+	else if (strcmp(Name, "bc7") == 0)
+		Format = TEXTURE_FORMAT_BC7;
+	else if (strcmp(Name, "rgba8") == 0)
+		Format = TEXTURE_FORMAT_RGBA8;
+	else
+		return false;
+
+	return true;
+}
+
+static bool Parse_Quality(const char* Name, BlockQuality& Quality)
+{
+	if (strcmp(Name, "fast") == 0)
+		Quality = BLOCK_QUALITY_FAST;
+	else if (strcmp(Name, "normal") == 0)
+		Quality = BLOCK_QUALITY_NORMAL;
+	else if (strcmp(Name, "high") == 0)
+		Quality = BLOCK_QUALITY_HIGH;
+	else
+		return false;
+
+	return true;
+}
+
+static const char* Format_Name(TextureFormat Format)
+{
+	switch (Format)
+	{
+	case TEXTURE_FORMAT_BC1: return "BC1";
+	case TEXTURE_FORMAT_BC3: return "BC3";
+	case TEXTURE_FORMAT_BC7: return "BC7";
+	case TEXTURE_FORMAT_RGBA8: return "RGBA8";
+	default: return "unknown";
+	}
+}
+
+static void Print_Psnr(const char* Name, double Psnr)
+{
+	if (std::isinf(Psnr))
+		printf("%s lossless", Name);
+	else
+		printf("%s %.2f dB", Name, Psnr);
+}
+
+int main(int argc, char* argv[])
+{
+	TextureCookOptions Options;
+	unsigned ThreadCount = 0;
+	const char* TraceName = nullptr;
+
+	const char* Files[2] = { nullptr, nullptr };
+	int FileCount = 0;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const char* Arg = argv[i];
+		bool HasValue = i + 1 < argc;
+
+		if (strcmp(Arg, "-format") == 0 && HasValue)
+		{
+			if (!Parse_Format(argv[++i], Options.Format))
+			{
+				Print_Usage();
+				return 2;
+			}
+		}
+		else if (strcmp(Arg, "-quality") == 0 && HasValue)
+		{
+			if (!Parse_Quality(argv[++i], Options.Quality))
+			{
+				Print_Usage();
+				return 2;
+			}
+		}
+		else if (strcmp(Arg, "-threads") == 0 && HasValue)
+		{
+			ThreadCount = (unsigned)strtoul(argv[++i], NULL, 10);
+		}
+		else if (strcmp(Arg, "-trace") == 0 && HasValue)
+		{
+			TraceName = argv[++i];
+		}
+		else if (strcmp(Arg, "-nomips") == 0)
+		{
+			Options.Mips = false;
+		}
+		else if (strcmp(Arg, "-linear") == 0)
+		{
+			Options.Srgb = false;
+		}
+		else if (Arg[0] != '-' && FileCount < 2)
+		{
+			Files[FileCount++] = Arg;
+		}
+		else
+		{
+			Print_Usage();
+			return 2;
+		}
+	}
+
+	if (FileCount == 0)
+	{
+		Print_Usage();
+		return 2;
+	}
+
+	const char* SourceName = Files[0];
+
+	uint64_t SourceKey = 0;
+
+	{
+		CMappedFile Source;
+		if (!Source.Open(SourceName))
+		{
+			fprintf(stderr, "%s: can not open\n", SourceName);
+			return 1;
+		}
+
+		SourceKey = TextureCookKey(Source.Data(), Source.Size(), Options);
+	}
+
+	std::string OutputName;
+
+	if (FileCount == 2)
+	{
+		OutputName = Files[1];
+	}
+	else
+	{
+		std::string Dir;
+		OutputName = SourceCachePath(SourceName, SourceKey, "dds", Dir);
+
+		if (!CreateAssetCacheDir(Dir.c_str()))
+		{
+			fprintf(stderr, "%s: can not create\n", Dir.c_str());
+			return 1;
+		}
+	}
+
+	CThreadPool Pool(ThreadCount);
+
+	TextureCookStats Stats;
+	bool Cooked = CookTexture(SourceName, OutputName.c_str(), SourceKey, Options, Pool, Stats);
+
+	if (TraceName != nullptr && !CProfiler::Write_Trace(TraceName))
+		fprintf(stderr, "%s: can not write the trace\n", TraceName);
+
+	if (!Cooked)
+	{
+		fprintf(stderr, "%s: not a 24 or 32 bit BMP, or %s can not be written\n", SourceName, OutputName.c_str());
+		return 1;
+	}
+
+	CTextureFile TexFile;
+	if (!TexFile.Open(OutputName.c_str()))
+	{
+		fprintf(stderr, "%s: written file does not open\n", OutputName.c_str());
+		return 1;
+	}
+
+	const double MegaPixels = Stats.Width * (double)Stats.Height / 1000000.0;
+
+	printf("%s -> %s\n", SourceName, OutputName.c_str());
+	printf("  %ux%u, %u levels, %s", Stats.Width, Stats.Height, Stats.LevelCount, Format_Name(Stats.Format));
+	if (Stats.Format != Options.Format)
+		printf(" (size is not a multiple of 4)");
+	printf("\n");
+	printf("  decode %.2f ms, mips %.2f ms (%.2f ms/MP), encode %.2f ms (%.2f ms/MP) on %u threads\n",
+		Stats.DecodeTime, Stats.MipTime, Stats.MipTime / MegaPixels,
+		Stats.EncodeTime, Stats.EncodeTime / MegaPixels, Pool.ThreadCount() + 1);
+	printf("  PSNR ");
+	Print_Psnr("rgb", Stats.Psnr.Rgb);
+	printf(", ");
+	Print_Psnr("alpha", Stats.Psnr.Alpha);
+	printf("\n");
+	printf("  %.1f KB -> %.1f KB\n", Stats.RawByteSize / 1024.0, Stats.FileByteSize / 1024.0);
+
+	return 0;
+}
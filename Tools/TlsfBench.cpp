@@ -0,0 +1,44 @@
+//======================================================================================
+//	Ed Kurlyak 2023 TLSF Allocator Benchmark
+//======================================================================================
+
+//runs BenchmarkTlsf, the random allocation and free mix CGpuMemory
+//sees, over heaps of the GPU_MEMORY_BLOCK_SIZE of the sphere sample
+//and bigger ones, and reports ns per Allocate and Free, how often
+//the heap was full and how scattered the free space ended
+//
+//	TlsfBench [<operation count>]
+
+#include "TlsfAllocator.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+#define SEED 1
+
+int main(int argc, char* argv[])
+{
+	const uint32_t Operations = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : 1000000;
+
+	if (Operations == 0)
+	{
+		fprintf(stderr, "usage: TlsfBench [<operation count>]\n");
+		return 2;
+	}
+
+	static const uint64_t Capacities[] = { 16, 64, 256, 1024 };
+
+	printf("%u random operations per heap\n", Operations);
+
+	for (uint64_t Capacity : Capacities)
+	{
+		TlsfBenchResult Result = BenchmarkTlsf(Capacity * 1024 * 1024, Operations, SEED);
+
+		printf("  %4llu MB heap: %.1f ns per allocate, %.1f ns per free, %.1f%% failed, peak %.1f MB, fragmentation %.3f\n",
+			(unsigned long long)Capacity, Result.AllocateTime, Result.FreeTime,
+			100.0 * Result.Failed / Result.Operations,
+			Result.PeakUsed / (1024.0 * 1024.0), Result.Fragmentation);
+	}
+
+	return 0;
+}
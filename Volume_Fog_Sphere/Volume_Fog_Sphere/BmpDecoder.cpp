@@ -0,0 +1,311 @@
+//======================================================================================
+//	Ed Kurlyak 2023 BMP Decoder
+//======================================================================================
+
+#include "BmpDecoder.h"
+#include "Profiler.h"
+
+#include <cstring>
+#include <chrono>
+#include <vector>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define BMP_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define BMP_TARGET_SSSE3
+#define BMP_TARGET_AVX2
+#else
+#define BMP_TARGET_SSSE3 __attribute__((target("ssse3")))
+#define BMP_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+#define BMP_FILE_HEADER_SIZE 14
+#define BMP_INFO_HEADER_SIZE 40
+
+#define BMP_BI_RGB 0
+#define BMP_BI_BITFIELDS 3
+
+static uint16_t Read_U16(const unsigned char* p)
+{
+	return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t Read_U32(const unsigned char* p)
+{
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+BmpSimd BmpSimdSupport()
+{
+#ifdef BMP_X86
+	//loader threads ask at the same time, read once
+	static const BmpSimd Support = []()
+	{
+#ifdef _MSC_VER
+		int Info[4];
+		__cpuid(Info, 1);
+
+		bool Ssse3 = (Info[2] & (1 << 9)) != 0;
+		bool OsAvx = (Info[2] & (1 << 27)) && (Info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+
+		__cpuidex(Info, 7, 0);
+		bool Avx2 = OsAvx && (Info[1] & (1 << 5));
+#else
+		bool Ssse3 = __builtin_cpu_supports("ssse3");
+		bool Avx2 = __builtin_cpu_supports("avx2");
+#endif
+
+		if (Avx2)
+			return BMP_SIMD_AVX2;
+		if (Ssse3)
+			return BMP_SIMD_SSSE3;
+		return BMP_SIMD_NONE;
+	}();
+
+	return Support;
+#else
+	return BMP_SIMD_NONE;
+#endif
+}
+
+bool ParseBmpHeader(const unsigned char* Data, size_t Size, BmpInfo& Info)
+{
+	Info = BmpInfo();
+
+	if (Size < BMP_FILE_HEADER_SIZE + BMP_INFO_HEADER_SIZE || Data[0] != 'B' || Data[1] != 'M')
+		return false;
+
+	const unsigned char* Bih = Data + BMP_FILE_HEADER_SIZE;
+
+	uint32_t HeaderSize = Read_U32(Bih + 0);
+	int32_t Width = (int32_t)Read_U32(Bih + 4);
+	int32_t Height = (int32_t)Read_U32(Bih + 8);
+	uint16_t Planes = Read_U16(Bih + 12);
+	uint16_t BitCount = Read_U16(Bih + 14);
+	uint32_t Compression = Read_U32(Bih + 16);
+
+	if (HeaderSize < BMP_INFO_HEADER_SIZE || Planes != 1 ||
+		Width <= 0 || Height == 0 || Height == INT32_MIN ||
+		(BitCount != 24 && BitCount != 32))
+		return false;
+
+	//color masks go after 40 byte header or are part of V3 - V5 header
+	if (Compression == BMP_BI_BITFIELDS)
+	{
+		if (BitCount != 32 || Size < BMP_FILE_HEADER_SIZE + BMP_INFO_HEADER_SIZE + 12)
+			return false;
+
+		const unsigned char* Masks = Bih + BMP_INFO_HEADER_SIZE;
+
+		if (Read_U32(Masks + 0) != 0x00FF0000 ||
+			Read_U32(Masks + 4) != 0x0000FF00 ||
+			Read_U32(Masks + 8) != 0x000000FF)
+			return false;
+
+		if (HeaderSize >= BMP_INFO_HEADER_SIZE + 16)
+			Info.HasAlpha = Read_U32(Masks + 12) == 0xFF000000;
+	}
+	else if (Compression != BMP_BI_RGB)
+	{
+		return false;
+	}
+
+	Info.Width = (uint32_t)Width;
+	Info.Height = (uint32_t)(Height < 0 ? -Height : Height);
+	Info.BitCount = BitCount;
+	Info.BottomUp = Height > 0;
+	Info.DataOffset = Read_U32(Data + 10);
+
+	uint64_t RowPitch = (((uint64_t)Info.Width * BitCount / 8) + 3) & ~(uint64_t)3;
+
+	//a failed parse leaves no part of the header in Info
+	if (RowPitch > UINT32_MAX || Info.DataOffset + RowPitch * Info.Height > Size)
+	{
+		Info = BmpInfo();
+		return false;
+	}
+
+	Info.RowPitch = (uint32_t)RowPitch;
+
+	return true;
+}
+
+//row kernels return the number of pixels done, the rest goes to Row_Scalar
+
+static void Row_Scalar(const unsigned char* Src, unsigned char* Dst, uint32_t Count,
+	uint32_t BitCount, bool HasAlpha)
+{
+	const uint32_t Bpp = BitCount / 8;
+
+	for (uint32_t x = 0; x < Count; x++)
+	{
+		Dst[0] = Src[2];
+		Dst[1] = Src[1];
+		Dst[2] = Src[0];
+		Dst[3] = HasAlpha ? Src[3] : 255;
+
+		Src += Bpp;
+		Dst += 4;
+	}
+}
+
+#ifdef BMP_X86
+
+BMP_TARGET_SSSE3 static uint32_t Row_SSSE3(const unsigned char* Src, unsigned char* Dst, uint32_t Width,
+	uint32_t BitCount, bool HasAlpha)
+{
+	uint32_t x = 0;
+
+	if (BitCount == 24)
+	{
+		//4 pixels from 12 bytes, 16 byte load needs 6 pixels left in the row
+		const __m128i Shuffle = _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+		const __m128i Alpha = _mm_set1_epi32((int)0xFF000000);
+
+		for (; x + 6 <= Width; x += 4)
+		{
+			__m128i Bgr = _mm_loadu_si128((const __m128i*)(Src + x * 3));
+			__m128i Rgba = _mm_or_si128(_mm_shuffle_epi8(Bgr, Shuffle), Alpha);
+			_mm_storeu_si128((__m128i*)(Dst + x * 4), Rgba);
+		}
+	}
+	else
+	{
+		const __m128i Shuffle = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+		const __m128i Alpha = _mm_set1_epi32(HasAlpha ? 0 : (int)0xFF000000);
+
+		for (; x + 4 <= Width; x += 4)
+		{
+			__m128i Bgra = _mm_loadu_si128((const __m128i*)(Src + x * 4));
+			__m128i Rgba = _mm_or_si128(_mm_shuffle_epi8(Bgra, Shuffle), Alpha);
+			_mm_storeu_si128((__m128i*)(Dst + x * 4), Rgba);
+		}
+	}
+
+	return x;
+}
+
+BMP_TARGET_AVX2 static uint32_t Row_AVX2(const unsigned char* Src, unsigned char* Dst, uint32_t Width,
+	uint32_t BitCount, bool HasAlpha)
+{
+	uint32_t x = 0;
+
+	if (BitCount == 24)
+	{
+		//8 pixels, each 128 bit lane takes 4 pixels from its own 16 byte
+		//load, second load ends at byte 28 so 10 pixels must be left
+		const __m256i Shuffle = _mm256_setr_epi8(
+			2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1,
+			2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+		const __m256i Alpha = _mm256_set1_epi32((int)0xFF000000);
+
+		for (; x + 10 <= Width; x += 8)
+		{
+			const unsigned char* p = Src + x * 3;
+
+			__m256i Bgr = _mm256_inserti128_si256(
+				_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)p)),
+				_mm_loadu_si128((const __m128i*)(p + 12)), 1);
+
+			__m256i Rgba = _mm256_or_si256(_mm256_shuffle_epi8(Bgr, Shuffle), Alpha);
+			_mm256_storeu_si256((__m256i*)(Dst + x * 4), Rgba);
+		}
+	}
+	else
+	{
+		const __m256i Shuffle = _mm256_setr_epi8(
+			2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+			2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+		const __m256i Alpha = _mm256_set1_epi32(HasAlpha ? 0 : (int)0xFF000000);
+
+		for (; x + 8 <= Width; x += 8)
+		{
+			__m256i Bgra = _mm256_loadu_si256((const __m256i*)(Src + x * 4));
+			__m256i Rgba = _mm256_or_si256(_mm256_shuffle_epi8(Bgra, Shuffle), Alpha);
+			_mm256_storeu_si256((__m256i*)(Dst + x * 4), Rgba);
+		}
+	}
+
+	return x;
+}
+
+#endif
+
+void DecodeBmp(const unsigned char* Data, const BmpInfo& Info,
+	unsigned char* Dst, uint64_t DstRowPitch, bool BottomUpRows, BmpSimd Simd)
+{
+	PROFILE_FUNCTION();
+
+	const unsigned char* Pixels = Data + Info.DataOffset;
+	const uint32_t Bpp = Info.BitCount / 8;
+
+	//flip when the file row order is not the one asked for
+	const bool Flip = Info.BottomUp != BottomUpRows;
+
+	for (uint32_t y = 0; y < Info.Height; y++)
+	{
+		const unsigned char* Src = Pixels + (uint64_t)y * Info.RowPitch;
+		unsigned char* Row = Dst + (uint64_t)(Flip ? Info.Height - 1 - y : y) * DstRowPitch;
+
+		uint32_t Done = 0;
+
+#ifdef BMP_X86
+		if (Simd == BMP_SIMD_AVX2)
+			Done = Row_AVX2(Src, Row, Info.Width, Info.BitCount, Info.HasAlpha);
+		else if (Simd == BMP_SIMD_SSSE3)
+			Done = Row_SSSE3(Src, Row, Info.Width, Info.BitCount, Info.HasAlpha);
+#endif
+
+		Row_Scalar(Src + Done * Bpp, Row + Done * 4, Info.Width - Done, Info.BitCount, Info.HasAlpha);
+	}
+}
+
+BmpBenchResult BenchmarkBmpDecode(uint32_t Width, uint32_t Height, uint32_t BitCount, int Runs)
+{
+	BmpBenchResult Result;
+	Result.Width = Width;
+	Result.Height = Height;
+	Result.BitCount = BitCount;
+
+	const uint32_t RowPitch = ((Width * BitCount / 8) + 3) & ~3u;
+	const uint32_t DataOffset = BMP_FILE_HEADER_SIZE + BMP_INFO_HEADER_SIZE;
+
+	std::vector<unsigned char> File(DataOffset + (size_t)RowPitch * Height);
+
+	unsigned char* p = File.data();
+	p[0] = 'B';
+	p[1] = 'M';
+
+	uint32_t Header[] = { (uint32_t)File.size(), 0, DataOffset, BMP_INFO_HEADER_SIZE, Width, Height };
+	memcpy(p + 2, Header, sizeof(Header));
+
+	uint16_t PlanesBits[] = { 1, (uint16_t)BitCount };
+	memcpy(p + 26, PlanesBits, sizeof(PlanesBits));
+
+	for (size_t i = DataOffset; i < File.size(); i++)
+		File[i] = (unsigned char)(i * 131);
+
+	BmpInfo Info;
+	if (!ParseBmpHeader(File.data(), File.size(), Info))
+		return Result;
+
+	//upload footprint pitch, 256 byte aligned
+	const uint64_t DstRowPitch = ((uint64_t)Width * 4 + 255) & ~(uint64_t)255;
+	std::vector<unsigned char> Dst((size_t)(DstRowPitch * Height));
+
+	for (int Simd = BMP_SIMD_NONE; Simd <= (int)BmpSimdSupport(); Simd++)
+	{
+		auto Start = std::chrono::steady_clock::now();
+
+		for (int i = 0; i < Runs; i++)
+			DecodeBmp(File.data(), Info, Dst.data(), DstRowPitch, true, (BmpSimd)Simd);
+
+		std::chrono::duration<double, std::milli> Time = std::chrono::steady_clock::now() - Start;
+		Result.Time[Simd] = Time.count() / Runs;
+	}
+
+	return Result;
+}
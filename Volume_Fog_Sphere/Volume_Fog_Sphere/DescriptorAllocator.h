@@ -0,0 +1,57 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Descriptor Allocator
+//======================================================================================
+
+#ifndef _DESCRIPTORALLOCATOR_
+#define _DESCRIPTORALLOCATOR_
+
+#include <cstdint>
+#include <map>
+
+#include "UploadRing.h"
+
+//descriptor indices of one heap, [0, PersistentCount) is kept
+//on a free list of ranges, [PersistentCount, PersistentCount +
+//TransientCount) is a ring, transient ranges made since the last
+//Close_Frame are freed when the fence of that frame is reached,
+//no D3D here, the owner turns indices into handles
+class CDescriptorAllocator
+{
+public:
+	void Init(uint32_t PersistentCount, uint32_t TransientCount);
+
+	//false if no Count contiguous free descriptors are left,
+	//first fit, so long lived tables stay at the heap start
+	bool Allocate(uint32_t Count, uint32_t& Index);
+	void Free(uint32_t Index, uint32_t Count);
+
+	//false if the ring is full until older frames are released,
+	//a range never wraps, a table is always contiguous
+	bool Allocate_Transient(uint32_t Count, uint32_t& Index);
+
+	void Close_Frame(uint64_t FenceValue) { m_Ring.Close_Batch(FenceValue); }
+	void Release(uint64_t CompletedValue) { m_Ring.Release(CompletedValue); }
+
+	//Start plus Index descriptors of Increment bytes, the same
+	//math for the CPU and the GPU handles of a heap
+	static uint64_t Handle(uint64_t Start, uint32_t Index, uint32_t Increment)
+	{
+		return Start + (uint64_t)Index * Increment;
+	}
+
+	uint32_t Persistent_Count() const { return m_PersistentCount; }
+	uint32_t Persistent_Used() const { return m_PersistentUsed; }
+	uint32_t Transient_Count() const { return (uint32_t)m_Ring.Capacity(); }
+	uint32_t Transient_Used() const { return (uint32_t)m_Ring.Used(); }
+
+private:
+	uint32_t m_PersistentCount = 0;
+	uint32_t m_PersistentUsed = 0;
+
+	//free persistent ranges, start index to count, never adjacent
+	std::map<uint32_t, uint32_t> m_FreeRanges;
+
+	CUploadRing m_Ring;
+};
+
+#endif
@@ -0,0 +1,143 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Frame Pacer
+//======================================================================================
+
+#include "FramePacer.h"
+
+#ifdef _WIN32
+#pragma comment(lib, "winmm.lib")
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+#else
+#include <time.h>
+#include <errno.h>
+#endif
+
+//a wait that returns later than this is counted as late
+#define FRAME_PACER_LATE 1.0
+
+typedef std::chrono::duration<double, std::milli> Milliseconds;
+
+CFramePacer::CFramePacer()
+{
+#ifdef _WIN32
+	//Windows 10 1803 and later, older systems get a normal
+	//timer with 1 ms scheduler period and a wider spin margin
+	m_Timer = CreateWaitableTimerExW(nullptr, nullptr,
+		CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+
+	m_HighResolution = m_Timer != nullptr;
+
+	if (!m_HighResolution)
+	{
+		m_Timer = CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+		timeBeginPeriod(1);
+		m_SpinMargin = FRAME_PACER_SPIN_MAX;
+	}
+#endif
+}
+
+CFramePacer::~CFramePacer()
+{
+#ifdef _WIN32
+	if (!m_HighResolution)
+		timeEndPeriod(1);
+
+	if (m_Timer != nullptr)
+		CloseHandle(m_Timer);
+#endif
+}
+
+void CFramePacer::Wait(double Seconds)
+{
+	if (Seconds <= 0.0)
+		return;
+
+	auto Start = std::chrono::steady_clock::now();
+	auto Deadline = Start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+		std::chrono::duration<double>(Seconds));
+
+	auto SleepEnd = Deadline - std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+		Milliseconds(m_SpinMargin));
+
+	auto SpinStart = Start;
+
+	if (SleepEnd > Start)
+	{
+		Sleep_Until(SleepEnd);
+
+		SpinStart = std::chrono::steady_clock::now();
+
+		//the margin follows how late the timer wakes us up
+		double Oversleep = Milliseconds(SpinStart - SleepEnd).count();
+		if (Oversleep < 0.0)
+			Oversleep = 0.0;
+
+		m_Oversleep += (Oversleep - m_Oversleep) * 0.1;
+
+		m_SpinMargin = 2.0 * m_Oversleep;
+		if (m_SpinMargin < FRAME_PACER_SPIN_MIN)
+			m_SpinMargin = FRAME_PACER_SPIN_MIN;
+		if (m_SpinMargin > FRAME_PACER_SPIN_MAX)
+			m_SpinMargin = FRAME_PACER_SPIN_MAX;
+	}
+
+	auto Now = std::chrono::steady_clock::now();
+
+	while (Now < Deadline)
+	{
+#ifdef _WIN32
+		YieldProcessor();
+#endif
+		Now = std::chrono::steady_clock::now();
+	}
+
+	double Error = Milliseconds(Now - Deadline).count();
+
+	m_Stats.Waits++;
+	m_Stats.ErrorSum += Error;
+	if (Error > m_Stats.ErrorMax)
+		m_Stats.ErrorMax = Error;
+	if (Error > FRAME_PACER_LATE)
+		m_Stats.LateWaits++;
+
+	m_Stats.SleepTime += Milliseconds(SpinStart - Start).count();
+	m_Stats.SpinTime += Milliseconds(Now - SpinStart).count();
+}
+
+void CFramePacer::Sleep_Until(std::chrono::steady_clock::time_point Deadline)
+{
+	auto Now = std::chrono::steady_clock::now();
+	if (Deadline <= Now)
+		return;
+
+#ifdef _WIN32
+	//relative due time in 100 ns units
+	LARGE_INTEGER DueTime;
+	DueTime.QuadPart = -(LONGLONG)(std::chrono::duration_cast<std::chrono::nanoseconds>(Deadline - Now).count() / 100);
+
+	if (m_Timer != nullptr && SetWaitableTimerEx(m_Timer, &DueTime, 0, nullptr, nullptr, nullptr, 0))
+		WaitForSingleObject(m_Timer, INFINITE);
+	else
+		Sleep((DWORD)Milliseconds(Deadline - Now).count());
+#else
+	//steady_clock is CLOCK_MONOTONIC here, so an absolute
+	//deadline does not drift when the sleep is interrupted
+	timespec Ts;
+	clock_gettime(CLOCK_MONOTONIC, &Ts);
+
+	long long Ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Deadline - Now).count();
+	Ts.tv_sec += (time_t)(Ns / 1000000000LL);
+	Ts.tv_nsec += (long)(Ns % 1000000000LL);
+	if (Ts.tv_nsec >= 1000000000L)
+	{
+		Ts.tv_sec++;
+		Ts.tv_nsec -= 1000000000L;
+	}
+
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &Ts, nullptr) == EINTR)
+	{
+	}
+#endif
+}
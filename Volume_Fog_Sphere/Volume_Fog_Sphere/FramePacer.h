@@ -0,0 +1,67 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Frame Pacer
+//======================================================================================
+
+#ifndef _FRAMEPACER_
+#define _FRAMEPACER_
+
+#include <cstdint>
+#include <chrono>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+//the pacer spins at least this long before the deadline,
+//the margin grows with the oversleep the OS timer shows
+#define FRAME_PACER_SPIN_MIN 0.25
+#define FRAME_PACER_SPIN_MAX 2.0
+
+//times in ms, Error is how late Wait returned
+struct FramePacerStats
+{
+	uint32_t Waits = 0;
+	uint32_t LateWaits = 0;
+	double ErrorSum = 0.0;
+	double ErrorMax = 0.0;
+	double SleepTime = 0.0;
+	double SpinTime = 0.0;
+};
+
+//sleeps on a high resolution timer (clock_nanosleep outside
+//Windows) for most of the wait and spins only for the rest,
+//so a frame limit does not keep a core busy
+class CFramePacer
+{
+public:
+	CFramePacer();
+	~CFramePacer();
+
+	CFramePacer(const CFramePacer& rhs) = delete;
+	CFramePacer& operator=(const CFramePacer& rhs) = delete;
+
+	//blocks for Seconds, returns at once for 0 or less
+	void Wait(double Seconds);
+
+	const FramePacerStats& Stats() const { return m_Stats; }
+	void Reset_Stats() { m_Stats = FramePacerStats(); }
+
+	//ms the pacer keeps for spinning now
+	double Spin_Margin() const { return m_SpinMargin; }
+
+private:
+	void Sleep_Until(std::chrono::steady_clock::time_point Deadline);
+
+#ifdef _WIN32
+	HANDLE m_Timer = nullptr;
+	bool m_HighResolution = false;
+#endif
+
+	double m_SpinMargin = FRAME_PACER_SPIN_MIN;
+	//smoothed oversleep of the OS timer, ms
+	double m_Oversleep = 0.0;
+
+	FramePacerStats m_Stats;
+};
+
+#endif
@@ -0,0 +1,77 @@
+//======================================================================================
+//	Ed Kurlyak 2023 GPU Fence DirectX12
+//======================================================================================
+
+#ifndef _GPUFENCE_
+#define _GPUFENCE_
+
+#include <windows.h>
+#include <wrl.h>
+#include <d3d12.h>
+
+#include "d3dUtil.h"
+
+//timeline of one ID3D12Fence, values grow by one per Signal,
+//the event used for CPU waits is made once and reused,
+//time the CPU spends blocked in Wait is counted for telemetry
+class CGpuFence
+{
+public:
+	CGpuFence() = default;
+	~CGpuFence();
+
+	CGpuFence(const CGpuFence& rhs) = delete;
+	CGpuFence& operator=(const CGpuFence& rhs) = delete;
+
+	void Init(ID3D12Device* Device);
+
+	//signals the next value on Queue and returns it,
+	//the fence may be signalled from any queue type
+	UINT64 Signal(ID3D12CommandQueue* Queue);
+
+	//GPU side wait, Queue stalls until the fence reaches Value
+	void Gpu_Wait(ID3D12CommandQueue* Queue, UINT64 Value);
+
+	//does not block, value 0 is always complete
+	bool IsComplete(UINT64 Value);
+
+	//blocks the CPU until the fence reaches Value
+	void Wait(UINT64 Value);
+
+	//Signal on Queue and Wait for it
+	void Flush(ID3D12CommandQueue* Queue);
+
+	//blocks until every Fences[i] reaches Values[i], the fences
+	//may belong to different queues, one entry per fence and at
+	//most MAXIMUM_WAIT_OBJECTS, throws if the wait fails,
+	//each pending fence counts the whole blocked time
+	static void Wait_All(CGpuFence* const* Fences, const UINT64* Values, UINT Count);
+
+	UINT64 Completed_Value();
+	UINT64 Last_Signaled() const { return m_LastSignaled; }
+
+	ID3D12Fence* Get() const { return m_Fence.Get(); }
+
+	//ms blocked in Wait and Wait_All since the last Reset_Stats
+	double Blocked_Time() const { return m_BlockedTime; }
+	double Max_Blocked_Time() const { return m_MaxBlockedTime; }
+	UINT Blocked_Count() const { return m_BlockedCount; }
+	void Reset_Stats();
+
+private:
+	void Add_Blocked_Time(double Time);
+
+	Microsoft::WRL::ComPtr<ID3D12Fence> m_Fence;
+	HANDLE m_Event = nullptr;
+
+	UINT64 m_LastSignaled = 0;
+	//last value read from the fence, saves a call
+	//for values that are known to be done
+	UINT64 m_LastCompleted = 0;
+
+	double m_BlockedTime = 0.0;
+	double m_MaxBlockedTime = 0.0;
+	UINT m_BlockedCount = 0;
+};
+
+#endif
@@ -0,0 +1,36 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Linear Allocator
+//======================================================================================
+
+#ifndef _LINEARALLOCATOR_
+#define _LINEARALLOCATOR_
+
+#include <cstdint>
+
+//bump allocator over offsets [0, Capacity), everything is
+//freed at once by Reset, no D3D here, the owner maps
+//offsets to its buffer
+class CLinearAllocator
+{
+public:
+	//Align is a power of two, every offset is a multiple of it
+	void Init(uint64_t Capacity, uint64_t Align);
+
+	//false if Size does not fit in what is left
+	bool Allocate(uint64_t Size, uint64_t& Offset);
+
+	void Reset();
+
+	uint64_t Capacity() const { return m_Capacity; }
+	uint64_t Used() const { return m_Used; }
+	//most bytes used in one frame since Init, Reset keeps it
+	uint64_t Peak() const { return m_Peak; }
+
+private:
+	uint64_t m_Capacity = 0;
+	uint64_t m_Align = 1;
+	uint64_t m_Used = 0;
+	uint64_t m_Peak = 0;
+};
+
+#endif
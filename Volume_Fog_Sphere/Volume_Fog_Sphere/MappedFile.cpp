@@ -0,0 +1,122 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Mapped File
+//======================================================================================
+
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+CMappedFile::~CMappedFile()
+{
+	Close();
+}
+
+#ifdef _WIN32
+
+bool CMappedFile::Open(const char* FileName)
+{
+	Close();
+
+	HANDLE File = CreateFileA(FileName, GENERIC_READ, FILE_SHARE_READ, NULL,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (File == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER FileSize;
+	if (!GetFileSizeEx(File, &FileSize) || FileSize.QuadPart == 0)
+	{
+		CloseHandle(File);
+		return false;
+	}
+
+	HANDLE Mapping = CreateFileMappingA(File, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (Mapping == NULL)
+	{
+		CloseHandle(File);
+		return false;
+	}
+
+	void* View = MapViewOfFile(Mapping, FILE_MAP_READ, 0, 0, 0);
+	if (View == NULL)
+	{
+		CloseHandle(Mapping);
+		CloseHandle(File);
+		return false;
+	}
+
+	m_File = File;
+	m_Mapping = Mapping;
+	m_Data = (const unsigned char*)View;
+	m_Size = (size_t)FileSize.QuadPart;
+
+	return true;
+}
+
+void CMappedFile::Close()
+{
+	if (m_Data)
+		UnmapViewOfFile(m_Data);
+	if (m_Mapping)
+		CloseHandle(m_Mapping);
+	if (m_File)
+		CloseHandle(m_File);
+
+	m_Data = nullptr;
+	m_Size = 0;
+	m_Mapping = nullptr;
+	m_File = nullptr;
+}
+
+#else
+
+bool CMappedFile::Open(const char* FileName)
+{
+	Close();
+
+	int File = open(FileName, O_RDONLY);
+	if (File < 0)
+		return false;
+
+	struct stat St;
+	if (fstat(File, &St) != 0 || St.st_size == 0)
+	{
+		close(File);
+		return false;
+	}
+
+	void* View = mmap(nullptr, (size_t)St.st_size, PROT_READ, MAP_PRIVATE, File, 0);
+	if (View == MAP_FAILED)
+	{
+		close(File);
+		return false;
+	}
+
+	madvise(View, (size_t)St.st_size, MADV_SEQUENTIAL);
+
+	m_File = File;
+	m_Data = (const unsigned char*)View;
+	m_Size = (size_t)St.st_size;
+
+	return true;
+}
+
+void CMappedFile::Close()
+{
+	if (m_Data)
+		munmap((void*)m_Data, m_Size);
+	if (m_File >= 0)
+		close(m_File);
+
+	m_Data = nullptr;
+	m_Size = 0;
+	m_File = -1;
+}
+
+#endif
@@ -0,0 +1,283 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Mesh Clusters
+//======================================================================================
+
+#include "MeshCluster.h"
+#include "Profiler.h"
+
+#include <cmath>
+
+static const float* Position_At(const unsigned char* Positions, uint32_t Stride, uint32_t Vertex)
+{
+	return (const float*)(Positions + (size_t)Vertex * Stride);
+}
+
+static float Distance_Sq(const float* a, const float* b)
+{
+	float dx = a[0] - b[0];
+	float dy = a[1] - b[1];
+	float dz = a[2] - b[2];
+
+	return dx * dx + dy * dy + dz * dz;
+}
+
+//Ritter bounding sphere over cluster vertices
+static void Calc_Sphere(MeshCluster& Cluster, const unsigned char* Positions, uint32_t Stride,
+	const uint32_t* Vertices, uint32_t Count)
+{
+	const float* First = Position_At(Positions, Stride, Vertices[0]);
+
+	//farthest point from the first one, then farthest from that
+	const float* A = First;
+	float MaxDist = 0.0f;
+
+	for (uint32_t i = 0; i < Count; i++)
+	{
+		const float* P = Position_At(Positions, Stride, Vertices[i]);
+		float Dist = Distance_Sq(P, First);
+		if (Dist > MaxDist) { MaxDist = Dist; A = P; }
+	}
+
+	const float* B = A;
+	MaxDist = 0.0f;
+
+	for (uint32_t i = 0; i < Count; i++)
+	{
+		const float* P = Position_At(Positions, Stride, Vertices[i]);
+		float Dist = Distance_Sq(P, A);
+		if (Dist > MaxDist) { MaxDist = Dist; B = P; }
+	}
+
+	float Center[3] = { (A[0] + B[0]) * 0.5f, (A[1] + B[1]) * 0.5f, (A[2] + B[2]) * 0.5f };
+	float Radius = sqrtf(MaxDist) * 0.5f;
+
+	//grow the sphere to take in the points left outside
+	for (uint32_t i = 0; i < Count; i++)
+	{
+		const float* P = Position_At(Positions, Stride, Vertices[i]);
+		float Dist = sqrtf(Distance_Sq(P, Center));
+
+		if (Dist > Radius)
+		{
+			float NewRadius = (Radius + Dist) * 0.5f;
+			float k = (NewRadius - Radius) / Dist;
+
+			for (int j = 0; j < 3; j++)
+				Center[j] += (P[j] - Center[j]) * k;
+
+			Radius = NewRadius;
+		}
+	}
+
+	for (int j = 0; j < 3; j++)
+		Cluster.Center[j] = Center[j];
+
+	Cluster.Radius = Radius;
+}
+
+static void Calc_Cone(MeshCluster& Cluster, const unsigned char* Positions, uint32_t Stride,
+	const uint32_t* Indices)
+{
+	std::vector<float> Normals;
+	Normals.reserve(Cluster.TriangleCount * 3);
+
+	float Axis[3] = { 0.0f, 0.0f, 0.0f };
+
+	for (uint32_t t = 0; t < Cluster.TriangleCount; t++)
+	{
+		const uint32_t* Tri = &Indices[Cluster.IndexOffset + t * 3];
+
+		const float* A = Position_At(Positions, Stride, Tri[0]);
+		const float* B = Position_At(Positions, Stride, Tri[1]);
+		const float* C = Position_At(Positions, Stride, Tri[2]);
+
+		float E1[3] = { B[0] - A[0], B[1] - A[1], B[2] - A[2] };
+		float E2[3] = { C[0] - A[0], C[1] - A[1], C[2] - A[2] };
+
+		//clockwise front faces, the normal looks to the viewer
+		float N[3] = {
+			E1[1] * E2[2] - E1[2] * E2[1],
+			E1[2] * E2[0] - E1[0] * E2[2],
+			E1[0] * E2[1] - E1[1] * E2[0] };
+
+		float Len = sqrtf(N[0] * N[0] + N[1] * N[1] + N[2] * N[2]);
+
+		//degenerate triangles are never drawn
+		if (Len == 0.0f)
+			continue;
+
+		for (int j = 0; j < 3; j++)
+		{
+			N[j] /= Len;
+			Axis[j] += N[j];
+			Normals.push_back(N[j]);
+		}
+	}
+
+	Cluster.ConeCutoff = 1.0f;
+
+	float AxisLen = sqrtf(Axis[0] * Axis[0] + Axis[1] * Axis[1] + Axis[2] * Axis[2]);
+
+	if (Normals.empty() || AxisLen == 0.0f)
+		return;
+
+	for (int j = 0; j < 3; j++)
+		Cluster.ConeAxis[j] = Axis[j] / AxisLen;
+
+	float MinDot = 1.0f;
+
+	for (size_t i = 0; i < Normals.size(); i += 3)
+	{
+		float Dot = Normals[i + 0] * Cluster.ConeAxis[0] +
+			Normals[i + 1] * Cluster.ConeAxis[1] +
+			Normals[i + 2] * Cluster.ConeAxis[2];
+
+		if (Dot < MinDot)
+			MinDot = Dot;
+	}
+
+	//spread close to 90 degrees and wider, the cone test would never pass
+	if (MinDot <= 0.1f)
+		return;
+
+	Cluster.ConeCutoff = sqrtf(1.0f - MinDot * MinDot);
+}
+
+void BuildMeshClusters(const uint32_t* Indices, size_t IndexCount,
+	const void* Positions, uint32_t PositionStride, uint32_t VertexCount,
+	std::vector<MeshCluster>& OutClusters)
+{
+	PROFILE_FUNCTION();
+
+	const unsigned char* Pos = (const unsigned char*)Positions;
+
+	OutClusters.clear();
+
+	//Slot[v] - position of vertex in the current cluster or Unused
+	const uint32_t Unused = 0xFFFFFFFF;
+	std::vector<uint32_t> Slot(VertexCount, Unused);
+
+	uint32_t ClusterVertices[MESHCLUSTER_MAX_VERTICES];
+
+	MeshCluster Cluster;
+	const size_t TriCount = IndexCount / 3;
+
+	for (size_t t = 0; t <= TriCount; t++)
+	{
+		uint32_t NewVertices = 0;
+
+		if (t < TriCount)
+		{
+			const uint32_t* Tri = &Indices[t * 3];
+
+			NewVertices = (Slot[Tri[0]] == Unused) +
+				(Slot[Tri[1]] == Unused && Tri[1] != Tri[0]) +
+				(Slot[Tri[2]] == Unused && Tri[2] != Tri[0] && Tri[2] != Tri[1]);
+		}
+
+		//close the cluster at the end of the mesh or when the triangle does not fit
+		if (Cluster.TriangleCount && (t == TriCount ||
+			Cluster.VertexCount + NewVertices > MESHCLUSTER_MAX_VERTICES ||
+			Cluster.TriangleCount == MESHCLUSTER_MAX_TRIANGLES))
+		{
+			Calc_Sphere(Cluster, Pos, PositionStride, ClusterVertices, Cluster.VertexCount);
+			Calc_Cone(Cluster, Pos, PositionStride, Indices);
+
+			OutClusters.push_back(Cluster);
+
+			for (uint32_t i = 0; i < Cluster.VertexCount; i++)
+				Slot[ClusterVertices[i]] = Unused;
+
+			Cluster = MeshCluster();
+			Cluster.IndexOffset = (uint32_t)(t * 3);
+		}
+
+		if (t == TriCount)
+			break;
+
+		for (int k = 0; k < 3; k++)
+		{
+			uint32_t v = Indices[t * 3 + k];
+
+			if (Slot[v] == Unused)
+			{
+				Slot[v] = Cluster.VertexCount;
+				ClusterVertices[Cluster.VertexCount++] = v;
+			}
+		}
+
+		Cluster.TriangleCount++;
+	}
+}
+
+void SetClusterCullView(ClusterCullView& View, const float* WorldViewProj, const float* CamPos)
+{
+	//clip = v * M, plane coefficients are sums of matrix columns
+	const float* m = WorldViewProj;
+
+	for (int j = 0; j < 4; j++)
+	{
+		float c0 = m[j * 4 + 0];
+		float c1 = m[j * 4 + 1];
+		float c2 = m[j * 4 + 2];
+		float c3 = m[j * 4 + 3];
+
+		View.Planes[0][j] = c3 + c0;	//left
+		View.Planes[1][j] = c3 - c0;	//right
+		View.Planes[2][j] = c3 + c1;	//bottom
+		View.Planes[3][j] = c3 - c1;	//top
+		View.Planes[4][j] = c2;			//near, z from 0 to w
+		View.Planes[5][j] = c3 - c2;	//far
+	}
+
+	for (int i = 0; i < 6; i++)
+	{
+		float* p = View.Planes[i];
+		float Len = sqrtf(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+
+		if (Len > 0.0f)
+		{
+			for (int j = 0; j < 4; j++)
+				p[j] /= Len;
+		}
+	}
+
+	for (int j = 0; j < 3; j++)
+		View.CamPos[j] = CamPos[j];
+}
+
+uint32_t CullMeshClusters(const MeshCluster* Clusters, uint32_t ClusterCount,
+	const ClusterCullView& View, uint8_t* Visible)
+{
+	uint32_t VisibleCount = 0;
+
+	for (uint32_t i = 0; i < ClusterCount; i++)
+	{
+		const MeshCluster& Cluster = Clusters[i];
+		const float* c = Cluster.Center;
+
+		bool Inside = true;
+
+		for (int p = 0; p < 6 && Inside; p++)
+		{
+			const float* Plane = View.Planes[p];
+			Inside = Plane[0] * c[0] + Plane[1] * c[1] + Plane[2] * c[2] + Plane[3] >= -Cluster.Radius;
+		}
+
+		//all triangles face away when the camera is
+		//outside of the cone spread around -ConeAxis
+		if (Inside && Cluster.ConeCutoff < 1.0f)
+		{
+			float d[3] = { c[0] - View.CamPos[0], c[1] - View.CamPos[1], c[2] - View.CamPos[2] };
+			float Len = sqrtf(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+			float Dot = d[0] * Cluster.ConeAxis[0] + d[1] * Cluster.ConeAxis[1] + d[2] * Cluster.ConeAxis[2];
+
+			Inside = Dot < Cluster.ConeCutoff * Len + Cluster.Radius;
+		}
+
+		Visible[i] = Inside ? 1 : 0;
+		VisibleCount += Visible[i];
+	}
+
+	return VisibleCount;
+}
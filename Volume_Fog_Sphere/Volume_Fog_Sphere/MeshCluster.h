@@ -0,0 +1,58 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Mesh Clusters
+//======================================================================================
+
+#ifndef _MESHCLUSTER_
+#define _MESHCLUSTER_
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+//limits of one cluster (meshlet), 124 triangles keep
+//the primitive indices of a mesh shader in 372 bytes
+#define MESHCLUSTER_MAX_VERTICES 64
+#define MESHCLUSTER_MAX_TRIANGLES 124
+
+//run of triangles in the index buffer, stored in the mesh file as is
+struct MeshCluster
+{
+	uint32_t IndexOffset = 0;
+	uint32_t TriangleCount = 0;
+	uint32_t VertexCount = 0;
+	uint32_t Reserved = 0;
+
+	//bounding sphere
+	float Center[3] = { 0.0f, 0.0f, 0.0f };
+	float Radius = 0.0f;
+
+	//normal cone, ConeCutoff is sine of the cone spread,
+	//1 - the cone is too wide and the cluster is never back facing
+	float ConeAxis[3] = { 0.0f, 0.0f, 0.0f };
+	float ConeCutoff = 1.0f;
+};
+
+//object space frustum (ax + by + cz + d >= 0 inside)
+//and camera position the clusters are tested against
+struct ClusterCullView
+{
+	float Planes[6][4];
+	float CamPos[3];
+};
+
+//splits a triangle list into clusters in index buffer order, a new cluster
+//starts when the next triangle would exceed the vertex or triangle limit,
+//Positions points to float3 position of vertex 0, PositionStride in bytes
+void BuildMeshClusters(const uint32_t* Indices, size_t IndexCount,
+	const void* Positions, uint32_t PositionStride, uint32_t VertexCount,
+	std::vector<MeshCluster>& OutClusters);
+
+//WorldViewProj is row major for row vectors (DirectXMath), D3D clip space
+void SetClusterCullView(ClusterCullView& View, const float* WorldViewProj, const float* CamPos);
+
+//frustum and back face cone test, Visible gets 1 or 0 per
+//cluster, returns the number of visible clusters
+uint32_t CullMeshClusters(const MeshCluster* Clusters, uint32_t ClusterCount,
+	const ClusterCullView& View, uint8_t* Visible);
+
+#endif
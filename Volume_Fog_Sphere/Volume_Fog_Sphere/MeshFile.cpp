@@ -0,0 +1,352 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Mesh File DirectX12
+//======================================================================================
+
+#include "MeshFile.h"
+#include "MeshProcessing.h"
+#include "Profiler.h"
+
+#include <cstdio>
+#include <cstring>
+
+static FILE* Open_File(const char* FileName, const char* Mode)
+{
+	FILE* Fp = NULL;
+#ifdef _WIN32
+	fopen_s(&Fp, FileName, Mode);
+#else
+	Fp = fopen(FileName, Mode);
+#endif
+	return Fp;
+}
+
+static uint64_t Align16(uint64_t Offset)
+{
+	return (Offset + 15) & ~(uint64_t)15;
+}
+
+//true if Offset ... Offset + ByteSize is inside the file, written
+//so that a corrupt offset or size can not wrap around
+static bool In_File(uint64_t Offset, uint64_t ByteSize, uint64_t FileSize)
+{
+	return (Offset & 15) == 0 && Offset <= FileSize && ByteSize <= FileSize - Offset;
+}
+
+template <typename T>
+static bool Indices_In_Range(const void* Data, uint32_t IndexCount, uint32_t VertexCount)
+{
+	const T* Indices = (const T*)Data;
+
+	//or of the out of range flags, no branch per index
+	uint32_t OutOfRange = 0;
+
+	for (uint32_t i = 0; i < IndexCount; i++)
+		OutOfRange |= (uint32_t)(Indices[i] >= VertexCount);
+
+	return OutOfRange == 0;
+}
+
+bool CMeshFile::Open(const char* FileName)
+{
+	Close();
+
+	if (!m_File.Open(FileName))
+		return false;
+
+	const unsigned char* Data = m_File.Data();
+	const uint64_t Size = m_File.Size();
+
+	if (Size < sizeof(MeshFileHeader))
+	{
+		Close();
+		return false;
+	}
+
+	const MeshFileHeader* Header = (const MeshFileHeader*)Data;
+
+	if (Header->Magic != MESHFILE_MAGIC ||
+		Header->Version != MESHFILE_VERSION ||
+		Header->FileSize != Size ||
+		Header->StreamCount == 0 ||
+		Header->StreamCount > MESHFILE_MAX_STREAMS ||
+		sizeof(MeshFileHeader) + Header->StreamCount * sizeof(MeshFileStream) > Size)
+	{
+		Close();
+		return false;
+	}
+
+	const MeshFileStream* Streams = (const MeshFileStream*)(Data + sizeof(MeshFileHeader));
+
+	for (uint32_t i = 0; i < Header->StreamCount; i++)
+	{
+		if (Streams[i].Stride == 0 ||
+			Streams[i].ByteSize != (uint64_t)Streams[i].Stride * Header->VertexCount ||
+			!In_File(Streams[i].Offset, Streams[i].ByteSize, Size))
+		{
+			Close();
+			return false;
+		}
+	}
+
+	if (Header->IndexStride != 0)
+	{
+		if ((Header->IndexStride != 2 && Header->IndexStride != 4) ||
+			!In_File(Header->IndexOffset, (uint64_t)Header->IndexCount * Header->IndexStride, Size))
+		{
+			Close();
+			return false;
+		}
+
+		//an index past the vertex buffer would make the GPU
+		//read outside of it, check them once here
+		const void* Indices = Data + Header->IndexOffset;
+
+		bool InRange = Header->IndexStride == 2 ?
+			Indices_In_Range<uint16_t>(Indices, Header->IndexCount, Header->VertexCount) :
+			Indices_In_Range<uint32_t>(Indices, Header->IndexCount, Header->VertexCount);
+
+		if (!InRange)
+		{
+			Close();
+			return false;
+		}
+	}
+
+	if (Header->ClusterCount != 0)
+	{
+		if (Header->IndexStride == 0 ||
+			!In_File(Header->ClusterOffset, (uint64_t)Header->ClusterCount * sizeof(MeshCluster), Size))
+		{
+			Close();
+			return false;
+		}
+
+		//clusters are drawn as index ranges, each must be
+		//whole triangles inside the index buffer
+		const MeshCluster* Clusters = (const MeshCluster*)(Data + Header->ClusterOffset);
+
+		for (uint32_t i = 0; i < Header->ClusterCount; i++)
+		{
+			const MeshCluster& Cluster = Clusters[i];
+
+			if (Cluster.IndexOffset % 3 != 0 ||
+				Cluster.TriangleCount == 0 ||
+				Cluster.TriangleCount > MESHCLUSTER_MAX_TRIANGLES ||
+				Cluster.VertexCount > MESHCLUSTER_MAX_VERTICES ||
+				Cluster.IndexOffset > Header->IndexCount ||
+				(uint64_t)Cluster.TriangleCount * 3 > Header->IndexCount - Cluster.IndexOffset)
+			{
+				Close();
+				return false;
+			}
+		}
+	}
+
+	m_Header = Header;
+	m_Streams = Streams;
+
+	return true;
+}
+
+void CMeshFile::Close()
+{
+	m_File.Close();
+	m_Header = nullptr;
+	m_Streams = nullptr;
+}
+
+const void* CMeshFile::StreamData(uint32_t Stream) const
+{
+	return m_File.Data() + m_Streams[Stream].Offset;
+}
+
+uint32_t CMeshFile::StreamStride(uint32_t Stream) const
+{
+	return m_Streams[Stream].Stride;
+}
+
+uint64_t CMeshFile::StreamByteSize(uint32_t Stream) const
+{
+	return m_Streams[Stream].ByteSize;
+}
+
+const void* CMeshFile::IndexData() const
+{
+	if (m_Header->IndexStride == 0)
+		return nullptr;
+
+	return m_File.Data() + m_Header->IndexOffset;
+}
+
+uint64_t CMeshFile::IndexByteSize() const
+{
+	return (uint64_t)m_Header->IndexCount * m_Header->IndexStride;
+}
+
+const MeshCluster* CMeshFile::Clusters() const
+{
+	if (m_Header->ClusterCount == 0)
+		return nullptr;
+
+	return (const MeshCluster*)(m_File.Data() + m_Header->ClusterOffset);
+}
+
+bool WriteMeshFile(const char* FileName, const MeshFileDesc& Desc)
+{
+	if (Desc.StreamCount == 0 || Desc.StreamCount > MESHFILE_MAX_STREAMS)
+		return false;
+
+	MeshFileHeader Header;
+	Header.VertexCount = Desc.VertexCount;
+	Header.StreamCount = Desc.StreamCount;
+	memcpy(Header.BoundsMin, Desc.BoundsMin, sizeof(Header.BoundsMin));
+	memcpy(Header.BoundsMax, Desc.BoundsMax, sizeof(Header.BoundsMax));
+	Header.Decode = Desc.Decode;
+	Header.SourceKey = Desc.SourceKey;
+
+	MeshFileStream Streams[MESHFILE_MAX_STREAMS];
+
+	uint64_t Offset = Align16(sizeof(MeshFileHeader) + Desc.StreamCount * sizeof(MeshFileStream));
+
+	for (uint32_t i = 0; i < Desc.StreamCount; i++)
+	{
+		Streams[i].Stride = Desc.StreamStride[i];
+		Streams[i].Offset = Offset;
+		Streams[i].ByteSize = (uint64_t)Desc.StreamStride[i] * Desc.VertexCount;
+
+		Offset = Align16(Offset + Streams[i].ByteSize);
+	}
+
+	if (Desc.IndexData && Desc.IndexCount)
+	{
+		Header.IndexCount = Desc.IndexCount;
+		Header.IndexStride = Desc.IndexStride;
+		Header.IndexOffset = Offset;
+
+		Offset = Align16(Offset + (uint64_t)Desc.IndexCount * Desc.IndexStride);
+
+		if (Desc.Clusters && Desc.ClusterCount)
+		{
+			Header.ClusterCount = Desc.ClusterCount;
+			Header.ClusterOffset = Offset;
+
+			Offset = Align16(Offset + (uint64_t)Desc.ClusterCount * sizeof(MeshCluster));
+		}
+	}
+
+	Header.FileSize = Offset;
+
+	FILE* Fp = Open_File(FileName, "wb");
+	if (Fp == NULL)
+		return false;
+
+	static const unsigned char Zero[16] = {};
+
+	bool Result = fwrite(&Header, sizeof(Header), 1, Fp) == 1 &&
+		fwrite(Streams, sizeof(MeshFileStream), Desc.StreamCount, Fp) == Desc.StreamCount;
+
+	uint64_t Written = sizeof(Header) + Desc.StreamCount * sizeof(MeshFileStream);
+
+	for (uint32_t i = 0; i < Desc.StreamCount && Result; i++)
+	{
+		Result = fwrite(Zero, 1, (size_t)(Streams[i].Offset - Written), Fp) == Streams[i].Offset - Written &&
+			fwrite(Desc.StreamData[i], 1, (size_t)Streams[i].ByteSize, Fp) == Streams[i].ByteSize;
+
+		Written = Streams[i].Offset + Streams[i].ByteSize;
+	}
+
+	if (Header.IndexStride && Result)
+	{
+		uint64_t IndexByteSize = (uint64_t)Header.IndexCount * Header.IndexStride;
+
+		Result = fwrite(Zero, 1, (size_t)(Header.IndexOffset - Written), Fp) == Header.IndexOffset - Written &&
+			fwrite(Desc.IndexData, 1, (size_t)IndexByteSize, Fp) == IndexByteSize;
+
+		Written = Header.IndexOffset + IndexByteSize;
+	}
+
+	if (Header.ClusterCount && Result)
+	{
+		Result = fwrite(Zero, 1, (size_t)(Header.ClusterOffset - Written), Fp) == Header.ClusterOffset - Written &&
+			fwrite(Desc.Clusters, sizeof(MeshCluster), Header.ClusterCount, Fp) == Header.ClusterCount;
+
+		Written = Header.ClusterOffset + (uint64_t)Header.ClusterCount * sizeof(MeshCluster);
+	}
+
+	if (Result)
+		Result = fwrite(Zero, 1, (size_t)(Header.FileSize - Written), Fp) == Header.FileSize - Written;
+
+	fclose(Fp);
+
+	if (!Result)
+		remove(FileName);
+
+	return Result;
+}
+
+uint64_t MeshCookKey(const void* Source, size_t SourceSize)
+{
+	const uint32_t Options[] = { MESHFILE_VERSION, TEXTMESH_FLOATS_PER_VERTEX,
+		MESHCLUSTER_MAX_VERTICES, MESHCLUSTER_MAX_TRIANGLES, VERTEX_CACHE_SIZE };
+
+	return AssetCacheKey(Source, SourceSize, Options, sizeof(Options));
+}
+
+bool ConvertTextMeshToBinary(const char* TextFileName, const char* BinFileName, uint64_t SourceKey,
+	CThreadPool& Pool, TextMeshResult& Parsed, MeshCookStats& Stats)
+{
+	PROFILE_FUNCTION();
+
+	CMappedFile TextFile;
+	if (!TextFile.Open(TextFileName))
+		return false;
+
+	if (!ParseTextMesh((const char*)TextFile.Data(), TextFile.Size(), Pool, Parsed))
+		return false;
+
+	TextFile.Close();
+
+	const uint32_t Stride = TEXTMESH_FLOATS_PER_VERTEX * sizeof(float);
+
+	std::vector<unsigned char> Vertices;
+	std::vector<uint32_t> Indices;
+	WeldVertices(Parsed.Vertices.data(), Parsed.VertexCount, Stride, Vertices, Indices);
+
+	Stats.Optimize = OptimizeMesh(Vertices, Indices, Stride);
+
+	const uint32_t VertexCount = (uint32_t)(Vertices.size() / Stride);
+
+	std::vector<MeshCluster> Clusters;
+	BuildMeshClusters(Indices.data(), Indices.size(), Vertices.data(), Stride, VertexCount, Clusters);
+
+	MeshFileDesc Desc;
+
+	std::vector<QuantizedVertex> Quantized(VertexCount);
+	QuantizePosTex((const float*)Vertices.data(), VertexCount, Parsed.BoundsMin, Parsed.BoundsMax,
+		Quantized.data(), Desc.Decode, Stats.Quantize);
+
+	//cluster bounds are from the source positions
+	for (MeshCluster& Cluster : Clusters)
+		Cluster.Radius += Stats.Quantize.MaxPosError;
+
+	std::vector<unsigned char> PackedIndices;
+	PackIndices(Indices, VertexCount, PackedIndices);
+
+	Desc.VertexCount = VertexCount;
+	Desc.StreamCount = 1;
+	Desc.StreamData[0] = Quantized.data();
+	Desc.StreamStride[0] = sizeof(QuantizedVertex);
+	Desc.IndexCount = (uint32_t)Indices.size();
+	Desc.IndexStride = IndexStrideFor(VertexCount);
+	Desc.IndexData = PackedIndices.data();
+	Desc.ClusterCount = (uint32_t)Clusters.size();
+	Desc.Clusters = Clusters.data();
+	memcpy(Desc.BoundsMin, Parsed.BoundsMin, sizeof(Desc.BoundsMin));
+	memcpy(Desc.BoundsMax, Parsed.BoundsMax, sizeof(Desc.BoundsMax));
+	Desc.SourceKey = SourceKey;
+
+	std::string TempFileName = std::string(BinFileName) + ".tmp";
+
+	return WriteMeshFile(TempFileName.c_str(), Desc) &&
+		CommitCacheFile(TempFileName.c_str(), BinFileName);
+}
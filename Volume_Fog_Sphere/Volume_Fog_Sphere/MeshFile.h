@@ -0,0 +1,140 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Mesh File DirectX12
+//======================================================================================
+
+#ifndef _MESHFILE_
+#define _MESHFILE_
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include "MappedFile.h"
+#include "AssetCache.h"
+#include "TextMeshParser.h"
+#include "MeshOptimizer.h"
+#include "MeshCluster.h"
+#include "VertexQuantize.h"
+
+//binary mesh container, all offsets are from the start of the file
+//
+//	MeshFileHeader
+//	MeshFileStream[StreamCount]
+//	vertex stream data (16 byte aligned)
+//	index data (16 byte aligned, optional)
+//	MeshCluster[ClusterCount] (16 byte aligned, optional)
+
+#define MESHFILE_MAGIC 0x48534D4B	//'KMSH'
+#define MESHFILE_VERSION 6
+
+#define MESHFILE_MAX_STREAMS 4
+
+struct MeshFileStream
+{
+	uint32_t Stride = 0;
+	uint32_t Reserved = 0;
+	uint64_t Offset = 0;
+	uint64_t ByteSize = 0;
+};
+
+struct MeshFileHeader
+{
+	uint32_t Magic = MESHFILE_MAGIC;
+	uint32_t Version = MESHFILE_VERSION;
+	uint32_t VertexCount = 0;
+	uint32_t StreamCount = 0;
+
+	//IndexStride 0 - mesh has no index buffer, 2 or 4 - index size in bytes
+	uint32_t IndexCount = 0;
+	uint32_t IndexStride = 0;
+	uint64_t IndexOffset = 0;
+
+	//clusters cover the index buffer in order
+	uint32_t ClusterCount = 0;
+	uint32_t Reserved = 0;
+	uint64_t ClusterOffset = 0;
+
+	float BoundsMin[3] = { 0.0f, 0.0f, 0.0f };
+	float BoundsMax[3] = { 0.0f, 0.0f, 0.0f };
+
+	//decode of quantized vertex data, identity for float streams
+	VertexDequantize Decode;
+
+	//AssetCacheKey of the source and cook settings
+	uint64_t SourceKey = 0;
+
+	uint64_t FileSize = 0;
+};
+
+//source data for WriteMeshFile
+struct MeshFileDesc
+{
+	uint32_t VertexCount = 0;
+
+	uint32_t StreamCount = 0;
+	const void* StreamData[MESHFILE_MAX_STREAMS] = {};
+	uint32_t StreamStride[MESHFILE_MAX_STREAMS] = {};
+
+	uint32_t IndexCount = 0;
+	uint32_t IndexStride = 0;
+	const void* IndexData = nullptr;
+
+	uint32_t ClusterCount = 0;
+	const MeshCluster* Clusters = nullptr;
+
+	float BoundsMin[3] = { 0.0f, 0.0f, 0.0f };
+	float BoundsMax[3] = { 0.0f, 0.0f, 0.0f };
+
+	VertexDequantize Decode;
+
+	uint64_t SourceKey = 0;
+};
+
+class CMeshFile
+{
+public:
+	//maps the file and checks header, returns false if the file is
+	//missing, truncated, has other version, or an index or cluster
+	//points outside of the vertex or index buffer
+	bool Open(const char* FileName);
+	void Close();
+
+	const MeshFileHeader& Header() const { return *m_Header; }
+
+	const void* StreamData(uint32_t Stream) const;
+	uint32_t StreamStride(uint32_t Stream) const;
+	uint64_t StreamByteSize(uint32_t Stream) const;
+
+	const void* IndexData() const;
+	uint64_t IndexByteSize() const;
+
+	const MeshCluster* Clusters() const;
+	uint32_t ClusterCount() const { return m_Header->ClusterCount; }
+
+private:
+	CMappedFile m_File;
+	const MeshFileHeader* m_Header = nullptr;
+	const MeshFileStream* m_Streams = nullptr;
+};
+
+bool WriteMeshFile(const char* FileName, const MeshFileDesc& Desc);
+
+struct MeshCookStats
+{
+	MeshOptimizeStats Optimize;
+	VertexQuantizeError Quantize;
+};
+
+//cache key of a text mesh, changes with the source bytes,
+//the file version and the cluster limits
+uint64_t MeshCookKey(const void* Source, size_t SourceSize);
+
+//converts text mesh (see TextMeshParser.h) to indexed binary mesh
+//file with welded vertices, triangles reordered by OptimizeMesh and
+//split in clusters by BuildMeshClusters, vertices are stored as
+//QuantizedVertex, parse errors are returned in Parsed, the file is
+//written next to BinFileName and renamed when complete
+bool ConvertTextMeshToBinary(const char* TextFileName, const char* BinFileName, uint64_t SourceKey,
+	CThreadPool& Pool, TextMeshResult& Parsed, MeshCookStats& Stats);
+
+#endif
@@ -0,0 +1,465 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Mesh Optimizer
+//======================================================================================
+
+#include "MeshOptimizer.h"
+#include "Profiler.h"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+//Forsyth scoring, the cache is modelled as LRU of this size
+#define FORSYTH_CACHE_SIZE 32
+#define FORSYTH_MAX_VALENCE 32
+
+struct FifoCache
+{
+	std::vector<uint32_t> Timestamp;
+	uint32_t Time;
+	uint32_t Size;
+
+	FifoCache(uint32_t VertexCount, uint32_t CacheSize) :
+		Timestamp(VertexCount, 0), Time(CacheSize + 1), Size(CacheSize)
+	{
+	}
+
+	//returns true on miss
+	bool Access(uint32_t Vertex)
+	{
+		if (Time - Timestamp[Vertex] > Size)
+		{
+			Timestamp[Vertex] = Time++;
+			return true;
+		}
+
+		return false;
+	}
+
+	void Flush()
+	{
+		Time += Size + 1;
+	}
+};
+
+VertexCacheStats AnalyzeVertexCache(const uint32_t* Indices, size_t IndexCount,
+	uint32_t VertexCount, uint32_t CacheSize)
+{
+	VertexCacheStats Stats;
+
+	if (IndexCount == 0)
+		return Stats;
+
+	FifoCache Cache(VertexCount, CacheSize);
+	std::vector<char> Used(VertexCount, 0);
+	uint32_t UsedCount = 0;
+
+	for (size_t i = 0; i < IndexCount; i++)
+	{
+		uint32_t Vertex = Indices[i];
+
+		if (Cache.Access(Vertex))
+			Stats.Misses++;
+
+		if (!Used[Vertex])
+		{
+			Used[Vertex] = 1;
+			UsedCount++;
+		}
+	}
+
+	Stats.ACMR = (float)Stats.Misses / (float)(IndexCount / 3);
+	Stats.ATVR = (float)Stats.Misses / (float)UsedCount;
+
+	return Stats;
+}
+
+static float Forsyth_Vertex_Score(int CachePos, uint32_t Valence)
+{
+	static float CacheScore[FORSYTH_CACHE_SIZE];
+	static float ValenceScore[FORSYTH_MAX_VALENCE + 1];
+	static bool Init = false;
+
+	if (!Init)
+	{
+		for (int i = 0; i < FORSYTH_CACHE_SIZE; i++)
+		{
+			//the last triangle vertices get a fixed score so the
+			//next triangle does not just reuse its edge
+			if (i < 3)
+				CacheScore[i] = 0.75f;
+			else
+				CacheScore[i] = powf(1.0f - (float)(i - 3) / (FORSYTH_CACHE_SIZE - 3), 1.5f);
+		}
+
+		ValenceScore[0] = 0.0f;
+		for (int i = 1; i <= FORSYTH_MAX_VALENCE; i++)
+			ValenceScore[i] = 2.0f / sqrtf((float)i);
+
+		Init = true;
+	}
+
+	if (Valence == 0)
+		return -1.0f;
+
+	float Score = CachePos >= 0 ? CacheScore[CachePos] : 0.0f;
+
+	//vertices with few triangles left get a boost so they are finished off
+	Score += ValenceScore[Valence < FORSYTH_MAX_VALENCE ? Valence : FORSYTH_MAX_VALENCE];
+
+	return Score;
+}
+
+void OptimizeVertexCache(uint32_t* Dst, const uint32_t* Indices, size_t IndexCount,
+	uint32_t VertexCount)
+{
+	const size_t TriCount = IndexCount / 3;
+
+	if (TriCount == 0)
+		return;
+
+	//vertex -> triangles adjacency
+	std::vector<uint32_t> Valence(VertexCount, 0);
+	for (size_t i = 0; i < IndexCount; i++)
+		Valence[Indices[i]]++;
+
+	std::vector<uint32_t> AdjOffset(VertexCount + 1, 0);
+	for (uint32_t v = 0; v < VertexCount; v++)
+		AdjOffset[v + 1] = AdjOffset[v] + Valence[v];
+
+	std::vector<uint32_t> AdjTris(IndexCount);
+	std::vector<uint32_t> Fill(AdjOffset.begin(), AdjOffset.end() - 1);
+
+	for (size_t i = 0; i < IndexCount; i++)
+		AdjTris[Fill[Indices[i]]++] = (uint32_t)(i / 3);
+
+	std::vector<int> CachePos(VertexCount, -1);
+	std::vector<float> VertexScore(VertexCount);
+	for (uint32_t v = 0; v < VertexCount; v++)
+		VertexScore[v] = Forsyth_Vertex_Score(-1, Valence[v]);
+
+	std::vector<float> TriScore(TriCount);
+	std::vector<char> Emitted(TriCount, 0);
+
+	for (size_t t = 0; t < TriCount; t++)
+	{
+		TriScore[t] = VertexScore[Indices[t * 3 + 0]] +
+			VertexScore[Indices[t * 3 + 1]] +
+			VertexScore[Indices[t * 3 + 2]];
+	}
+
+	uint32_t Cache[FORSYTH_CACHE_SIZE + 3];
+	uint32_t CacheCount = 0;
+
+	size_t BestTri = std::max_element(TriScore.begin(), TriScore.end()) - TriScore.begin();
+	size_t NextInput = 0;
+
+	for (size_t Out = 0; Out < TriCount; Out++)
+	{
+		//nothing adjacent to the cache, continue with next triangle in input order
+		if (BestTri == (size_t)-1)
+		{
+			while (Emitted[NextInput])
+				NextInput++;
+
+			BestTri = NextInput;
+		}
+
+		const uint32_t* Tri = &Indices[BestTri * 3];
+
+		Dst[Out * 3 + 0] = Tri[0];
+		Dst[Out * 3 + 1] = Tri[1];
+		Dst[Out * 3 + 2] = Tri[2];
+
+		Emitted[BestTri] = 1;
+
+		//triangle vertices go to the front of LRU cache
+		uint32_t NewCache[FORSYTH_CACHE_SIZE + 3];
+		uint32_t NewCount = 0;
+
+		for (int k = 0; k < 3; k++)
+			NewCache[NewCount++] = Tri[k];
+
+		for (uint32_t i = 0; i < CacheCount; i++)
+		{
+			uint32_t v = Cache[i];
+			if (v != Tri[0] && v != Tri[1] && v != Tri[2])
+				NewCache[NewCount++] = v;
+		}
+
+		//remove emitted triangle from adjacency
+		for (int k = 0; k < 3; k++)
+		{
+			uint32_t v = Tri[k];
+			uint32_t* Adj = &AdjTris[AdjOffset[v]];
+
+			for (uint32_t i = 0; i < Valence[v]; i++)
+			{
+				if (Adj[i] == BestTri)
+				{
+					Adj[i] = Adj[Valence[v] - 1];
+					Valence[v]--;
+					break;
+				}
+			}
+		}
+
+		//new cache positions and scores, vertices pushed out get -1
+		for (uint32_t i = 0; i < NewCount; i++)
+		{
+			uint32_t v = NewCache[i];
+			CachePos[v] = i < FORSYTH_CACHE_SIZE ? (int)i : -1;
+			VertexScore[v] = Forsyth_Vertex_Score(CachePos[v], Valence[v]);
+		}
+
+		//rescore triangles touching the cache and pick the best one
+		BestTri = (size_t)-1;
+		float BestScore = -1.0f;
+
+		for (uint32_t i = 0; i < NewCount; i++)
+		{
+			uint32_t v = NewCache[i];
+			const uint32_t* Adj = &AdjTris[AdjOffset[v]];
+
+			for (uint32_t j = 0; j < Valence[v]; j++)
+			{
+				uint32_t t = Adj[j];
+
+				float Score = VertexScore[Indices[t * 3 + 0]] +
+					VertexScore[Indices[t * 3 + 1]] +
+					VertexScore[Indices[t * 3 + 2]];
+
+				TriScore[t] = Score;
+
+				if (Score > BestScore)
+				{
+					BestScore = Score;
+					BestTri = t;
+				}
+			}
+		}
+
+		CacheCount = NewCount < FORSYTH_CACHE_SIZE ? NewCount : FORSYTH_CACHE_SIZE;
+		memcpy(Cache, NewCache, CacheCount * sizeof(uint32_t));
+	}
+}
+
+struct TriCluster
+{
+	size_t Start = 0;
+	size_t Count = 0;
+	float SortKey = 0.0f;
+};
+
+static const float* Position_At(const unsigned char* Positions, uint32_t Stride, uint32_t Vertex)
+{
+	return (const float*)(Positions + (size_t)Vertex * Stride);
+}
+
+void OptimizeOverdraw(uint32_t* Dst, const uint32_t* Indices, size_t IndexCount,
+	const void* Positions, uint32_t PositionStride, uint32_t VertexCount,
+	float Threshold)
+{
+	const size_t TriCount = IndexCount / 3;
+
+	if (TriCount == 0)
+		return;
+
+	const unsigned char* Pos = (const unsigned char*)Positions;
+
+	//hard boundaries - triangles where the cache starts over (all three miss)
+	std::vector<size_t> Hard;
+	{
+		FifoCache Cache(VertexCount, VERTEX_CACHE_SIZE);
+
+		for (size_t t = 0; t < TriCount; t++)
+		{
+			int Misses = 0;
+			for (int k = 0; k < 3; k++)
+				Misses += Cache.Access(Indices[t * 3 + k]);
+
+			if (t == 0 || Misses == 3)
+				Hard.push_back(t);
+		}
+
+		Hard.push_back(TriCount);
+	}
+
+	//soft boundaries - split a hard cluster once the part so far
+	//is within Threshold of the whole cluster ACMR
+	std::vector<TriCluster> Clusters;
+	{
+		FifoCache Cache(VertexCount, VERTEX_CACHE_SIZE);
+
+		for (size_t h = 0; h + 1 < Hard.size(); h++)
+		{
+			size_t Start = Hard[h];
+			size_t End = Hard[h + 1];
+
+			Cache.Flush();
+
+			uint32_t ClusterMisses = 0;
+			for (size_t i = Start * 3; i < End * 3; i++)
+				ClusterMisses += Cache.Access(Indices[i]);
+
+			float ClusterThreshold = Threshold * (float)ClusterMisses / (float)(End - Start);
+
+			Cache.Flush();
+
+			size_t SoftStart = Start;
+			uint32_t Misses = 0;
+
+			for (size_t t = Start; t < End; t++)
+			{
+				for (int k = 0; k < 3; k++)
+					Misses += Cache.Access(Indices[t * 3 + k]);
+
+				if (t + 1 == End || (float)Misses <= (float)(t - SoftStart + 1) * ClusterThreshold)
+				{
+					TriCluster Cluster;
+					Cluster.Start = SoftStart;
+					Cluster.Count = t + 1 - SoftStart;
+					Clusters.push_back(Cluster);
+
+					Cache.Flush();
+					SoftStart = t + 1;
+					Misses = 0;
+				}
+			}
+		}
+	}
+
+	//mesh centroid
+	double MeshCenter[3] = { 0.0, 0.0, 0.0 };
+	double MeshArea = 0.0;
+
+	std::vector<float> ClusterData(Clusters.size() * 7);
+
+	for (size_t c = 0; c < Clusters.size(); c++)
+	{
+		float Center[3] = { 0.0f, 0.0f, 0.0f };
+		float Normal[3] = { 0.0f, 0.0f, 0.0f };
+		float Area = 0.0f;
+
+		for (size_t t = Clusters[c].Start; t < Clusters[c].Start + Clusters[c].Count; t++)
+		{
+			const float* A = Position_At(Pos, PositionStride, Indices[t * 3 + 0]);
+			const float* B = Position_At(Pos, PositionStride, Indices[t * 3 + 1]);
+			const float* C = Position_At(Pos, PositionStride, Indices[t * 3 + 2]);
+
+			float E1[3] = { B[0] - A[0], B[1] - A[1], B[2] - A[2] };
+			float E2[3] = { C[0] - A[0], C[1] - A[1], C[2] - A[2] };
+
+			float N[3] = {
+				E1[1] * E2[2] - E1[2] * E2[1],
+				E1[2] * E2[0] - E1[0] * E2[2],
+				E1[0] * E2[1] - E1[1] * E2[0] };
+
+			float TriArea = sqrtf(N[0] * N[0] + N[1] * N[1] + N[2] * N[2]);
+
+			for (int j = 0; j < 3; j++)
+			{
+				Center[j] += (A[j] + B[j] + C[j]) * (TriArea / 3.0f);
+				Normal[j] += N[j];
+			}
+
+			Area += TriArea;
+		}
+
+		for (int j = 0; j < 3; j++)
+			MeshCenter[j] += Center[j];
+
+		MeshArea += Area;
+
+		float InvArea = Area > 0.0f ? 1.0f / Area : 0.0f;
+		float* Data = &ClusterData[c * 7];
+
+		for (int j = 0; j < 3; j++)
+		{
+			Data[j] = Center[j] * InvArea;
+			Data[3 + j] = Normal[j];
+		}
+	}
+
+	for (int j = 0; j < 3; j++)
+		MeshCenter[j] = MeshArea > 0.0 ? MeshCenter[j] / MeshArea : 0.0;
+
+	//clusters facing away from the center are likely to occlude the others
+	for (size_t c = 0; c < Clusters.size(); c++)
+	{
+		const float* Data = &ClusterData[c * 7];
+
+		float Len = sqrtf(Data[3] * Data[3] + Data[4] * Data[4] + Data[5] * Data[5]);
+		float InvLen = Len > 0.0f ? 1.0f / Len : 0.0f;
+
+		float Key = 0.0f;
+		for (int j = 0; j < 3; j++)
+			Key += (Data[j] - (float)MeshCenter[j]) * Data[3 + j] * InvLen;
+
+		Clusters[c].SortKey = Key;
+	}
+
+	std::stable_sort(Clusters.begin(), Clusters.end(),
+		[](const TriCluster& a, const TriCluster& b) { return a.SortKey > b.SortKey; });
+
+	size_t Out = 0;
+
+	for (const TriCluster& Cluster : Clusters)
+	{
+		memcpy(&Dst[Out], &Indices[Cluster.Start * 3], Cluster.Count * 3 * sizeof(uint32_t));
+		Out += Cluster.Count * 3;
+	}
+}
+
+uint32_t OptimizeVertexFetch(std::vector<unsigned char>& Vertices, std::vector<uint32_t>& Indices,
+	uint32_t Stride)
+{
+	const uint32_t VertexCount = (uint32_t)(Vertices.size() / Stride);
+	const uint32_t Unused = 0xFFFFFFFF;
+
+	std::vector<uint32_t> Remap(VertexCount, Unused);
+	std::vector<unsigned char> Reordered;
+	Reordered.reserve(Vertices.size());
+
+	uint32_t NewCount = 0;
+
+	for (uint32_t& Index : Indices)
+	{
+		if (Remap[Index] == Unused)
+		{
+			Remap[Index] = NewCount++;
+
+			const unsigned char* Vertex = &Vertices[(size_t)Index * Stride];
+			Reordered.insert(Reordered.end(), Vertex, Vertex + Stride);
+		}
+
+		Index = Remap[Index];
+	}
+
+	Vertices.swap(Reordered);
+
+	return NewCount;
+}
+
+MeshOptimizeStats OptimizeMesh(std::vector<unsigned char>& Vertices, std::vector<uint32_t>& Indices,
+	uint32_t Stride)
+{
+	PROFILE_FUNCTION();
+
+	MeshOptimizeStats Stats;
+
+	const uint32_t VertexCount = (uint32_t)(Vertices.size() / Stride);
+
+	Stats.Before = AnalyzeVertexCache(Indices.data(), Indices.size(), VertexCount);
+
+	std::vector<uint32_t> Temp(Indices.size());
+
+	OptimizeVertexCache(Temp.data(), Indices.data(), Indices.size(), VertexCount);
+	OptimizeOverdraw(Indices.data(), Temp.data(), Temp.size(), Vertices.data(), Stride, VertexCount);
+
+	uint32_t NewCount = OptimizeVertexFetch(Vertices, Indices, Stride);
+
+	Stats.After = AnalyzeVertexCache(Indices.data(), Indices.size(), NewCount);
+
+	return Stats;
+}
@@ -0,0 +1,57 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Mesh Optimizer
+//======================================================================================
+
+#ifndef _MESHOPTIMIZER_
+#define _MESHOPTIMIZER_
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+//post transform cache size the stats are measured with
+#define VERTEX_CACHE_SIZE 16
+
+struct VertexCacheStats
+{
+	uint32_t Misses = 0;
+
+	//average cache miss ratio, misses per triangle (0.5 ... 3)
+	float ACMR = 0.0f;
+	//average transformed vertex ratio, misses per used vertex (1 is the best)
+	float ATVR = 0.0f;
+};
+
+struct MeshOptimizeStats
+{
+	VertexCacheStats Before;
+	VertexCacheStats After;
+};
+
+//simulates FIFO post transform cache over a triangle list
+VertexCacheStats AnalyzeVertexCache(const uint32_t* Indices, size_t IndexCount,
+	uint32_t VertexCount, uint32_t CacheSize = VERTEX_CACHE_SIZE);
+
+//reorders triangles for vertex cache locality (Forsyth, linear speed
+//vertex cache optimisation), Dst and Indices must not overlap
+void OptimizeVertexCache(uint32_t* Dst, const uint32_t* Indices, size_t IndexCount,
+	uint32_t VertexCount);
+
+//splits cache optimized triangles into clusters without hurting ACMR more
+//than Threshold times and sorts the clusters outside in (Tipsify), Positions
+//points to float3 position of vertex 0, PositionStride in bytes
+void OptimizeOverdraw(uint32_t* Dst, const uint32_t* Indices, size_t IndexCount,
+	const void* Positions, uint32_t PositionStride, uint32_t VertexCount,
+	float Threshold = 1.05f);
+
+//renumbers vertices in first use order so vertex fetch walks memory
+//forward, drops unused vertices, returns new vertex count
+uint32_t OptimizeVertexFetch(std::vector<unsigned char>& Vertices, std::vector<uint32_t>& Indices,
+	uint32_t Stride);
+
+//cache, overdraw and fetch passes in order, float3 position
+//must be at the start of each vertex
+MeshOptimizeStats OptimizeMesh(std::vector<unsigned char>& Vertices, std::vector<uint32_t>& Indices,
+	uint32_t Stride);
+
+#endif
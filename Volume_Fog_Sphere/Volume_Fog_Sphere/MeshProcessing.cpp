@@ -0,0 +1,117 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Mesh Processing
+//======================================================================================
+
+#include "MeshProcessing.h"
+#include "Profiler.h"
+
+#include <cstring>
+
+static uint32_t Hash_Vertex(const unsigned char* Vertex, uint32_t Stride)
+{
+	//FNV-1a over the vertex bytes
+	uint32_t Hash = 2166136261u;
+
+	for (uint32_t i = 0; i < Stride; i++)
+	{
+		Hash ^= Vertex[i];
+		Hash *= 16777619u;
+	}
+
+	return Hash;
+}
+
+void WeldVertices(const void* Vertices, uint32_t VertexCount, uint32_t Stride,
+	std::vector<unsigned char>& OutVertices, std::vector<uint32_t>& OutIndices)
+{
+	PROFILE_FUNCTION();
+
+	const unsigned char* Src = (const unsigned char*)Vertices;
+
+	//no bytes to tell vertices apart, all of them are the first
+	if (Stride == 0)
+	{
+		OutVertices.clear();
+		OutIndices.assign(VertexCount, 0);
+		return;
+	}
+
+	//open addressing table of unique vertex indices, at most half full
+	uint32_t TableSize = 1;
+	while (TableSize < (uint64_t)VertexCount * 2)
+		TableSize <<= 1;
+
+	const uint32_t Empty = 0xFFFFFFFF;
+	std::vector<uint32_t> Table(TableSize, Empty);
+
+	OutVertices.clear();
+	OutVertices.reserve((size_t)VertexCount * Stride);
+	OutIndices.resize(VertexCount);
+
+	uint32_t UniqueCount = 0;
+
+	for (uint32_t i = 0; i < VertexCount; i++)
+	{
+		const unsigned char* Vertex = Src + (size_t)i * Stride;
+
+		uint32_t Slot = Hash_Vertex(Vertex, Stride) & (TableSize - 1);
+
+		for (;;)
+		{
+			uint32_t Unique = Table[Slot];
+
+			if (Unique == Empty)
+			{
+				Table[Slot] = UniqueCount;
+				OutVertices.insert(OutVertices.end(), Vertex, Vertex + Stride);
+				OutIndices[i] = UniqueCount++;
+				break;
+			}
+
+			if (memcmp(&OutVertices[(size_t)Unique * Stride], Vertex, Stride) == 0)
+			{
+				OutIndices[i] = Unique;
+				break;
+			}
+
+			Slot = (Slot + 1) & (TableSize - 1);
+		}
+	}
+}
+
+uint32_t IndexStrideFor(uint32_t VertexCount)
+{
+	return VertexCount <= 0x10000 ? 2 : 4;
+}
+
+void PackIndices(const std::vector<uint32_t>& Indices, uint32_t VertexCount,
+	std::vector<unsigned char>& OutIndices)
+{
+	const uint32_t IndexStride = IndexStrideFor(VertexCount);
+
+	OutIndices.resize(Indices.size() * IndexStride);
+
+	if (IndexStride == 4)
+	{
+		memcpy(OutIndices.data(), Indices.data(), OutIndices.size());
+		return;
+	}
+
+	uint16_t* Dst = (uint16_t*)OutIndices.data();
+
+	for (size_t i = 0; i < Indices.size(); i++)
+		Dst[i] = (uint16_t)Indices[i];
+}
+
+MeshWeldStats CalcWeldStats(uint32_t SourceVertexCount, uint32_t VertexCount,
+	uint32_t IndexCount, uint32_t Stride)
+{
+	MeshWeldStats Stats;
+	Stats.SourceVertexCount = SourceVertexCount;
+	Stats.VertexCount = VertexCount;
+	Stats.IndexStride = IndexStrideFor(VertexCount);
+	Stats.SourceByteSize = (uint64_t)SourceVertexCount * Stride;
+	Stats.ByteSize = (uint64_t)VertexCount * Stride + (uint64_t)IndexCount * Stats.IndexStride;
+
+	return Stats;
+}
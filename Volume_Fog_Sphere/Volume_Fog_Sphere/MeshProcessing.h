@@ -0,0 +1,42 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Mesh Processing
+//======================================================================================
+
+#ifndef _MESHPROCESSING_
+#define _MESHPROCESSING_
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+struct MeshWeldStats
+{
+	uint32_t SourceVertexCount = 0;
+	uint32_t VertexCount = 0;
+	uint32_t IndexStride = 0;
+
+	//vertex buffer before, vertex + index buffer after
+	uint64_t SourceByteSize = 0;
+	uint64_t ByteSize = 0;
+
+	float ReductionRatio() const { return VertexCount ? (float)SourceVertexCount / VertexCount : 0.0f; }
+	int64_t BytesSaved() const { return (int64_t)SourceByteSize - (int64_t)ByteSize; }
+};
+
+//merges bitwise identical vertices of a triangle list, OutVertices gets
+//unique vertices in first use order, OutIndices one index per source vertex,
+//with a zero Stride every vertex gets index 0
+void WeldVertices(const void* Vertices, uint32_t VertexCount, uint32_t Stride,
+	std::vector<unsigned char>& OutVertices, std::vector<uint32_t>& OutIndices);
+
+//16 bit indices when every vertex can be addressed, 32 bit otherwise
+uint32_t IndexStrideFor(uint32_t VertexCount);
+
+//packs indices to IndexStrideFor(VertexCount) bytes each
+void PackIndices(const std::vector<uint32_t>& Indices, uint32_t VertexCount,
+	std::vector<unsigned char>& OutIndices);
+
+MeshWeldStats CalcWeldStats(uint32_t SourceVertexCount, uint32_t VertexCount,
+	uint32_t IndexCount, uint32_t Stride);
+
+#endif
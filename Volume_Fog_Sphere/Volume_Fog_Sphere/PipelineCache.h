@@ -0,0 +1,83 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Pipeline Cache DirectX12
+//======================================================================================
+
+#ifndef _PIPELINECACHE_
+#define _PIPELINECACHE_
+
+#include <windows.h>
+#include <wrl.h>
+#include <dxgi1_4.h>
+#include <d3d12.h>
+#include "d3dx12.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "d3dUtil.h"
+#include "AssetCache.h"
+#include "PipelineCacheFile.h"
+
+//pipeline states of the last run, next to the cooked assets
+#define PIPELINE_CACHE_FILE ASSET_CACHE_DIR "/pipelines.bin"
+
+//graphics pipeline states are looked up by a hash of the whole
+//description, shader bytecode, input layout, states and formats,
+//hits come from an ID3D12PipelineLibrary or, where the driver
+//has no library support, from CachedPSO blobs, both kept in
+//one file that is thrown away when the adapter or driver
+//changes, the library may also refuse its data after a driver
+//update, then it starts empty. Main thread only
+class CPipelineCache
+{
+public:
+	CPipelineCache() = default;
+
+	CPipelineCache(const CPipelineCache& rhs) = delete;
+	CPipelineCache& operator=(const CPipelineCache& rhs) = delete;
+
+	//Adapter gives the cache id, FileName is in ASSET_CACHE_DIR
+	void Init(ID3D12Device* Device, IDXGIAdapter* Adapter, const char* FileName);
+
+	//Blob is the serialized root signature, pipelines that use
+	//Root get it in their key, so a changed root signature is a miss
+	void Add_Root_Signature(ID3D12RootSignature* Root, const void* Blob, size_t Size);
+
+	Microsoft::WRL::ComPtr<ID3D12PipelineState> Create_Graphics(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& Desc);
+
+	//writes the file if there were misses
+	void Save();
+
+	//hits, misses and the compile time the hits saved
+	void Log_Stats();
+
+private:
+	uint64_t Pipeline_Key(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& Desc) const;
+
+	bool Load(uint64_t Key, const PipelineCacheEntry& Entry, const D3D12_GRAPHICS_PIPELINE_STATE_DESC& Desc,
+		Microsoft::WRL::ComPtr<ID3D12PipelineState>& Pso);
+	void Store(uint64_t Key, double CompileTime, ID3D12PipelineState* Pso);
+
+	Microsoft::WRL::ComPtr<ID3D12Device> m_Device;
+	Microsoft::WRL::ComPtr<ID3D12PipelineLibrary> m_Library;
+
+	std::string m_FileName;
+	PipelineCacheId m_Id;
+
+	//the library reads from this memory as long as it lives
+	std::vector<uint8_t> m_LibraryData;
+	PipelineCacheEntries m_Entries;
+
+	std::unordered_map<ID3D12RootSignature*, uint64_t> m_RootKeys;
+
+	bool m_Dirty = false;
+
+	UINT m_Hits = 0;
+	UINT m_Misses = 0;
+	double m_HitTime = 0.0;
+	double m_MissTime = 0.0;
+	double m_SavedTime = 0.0;
+};
+
+#endif
@@ -12,12 +12,18 @@ cbuffer cbPerObject : register(b0)
 {
 	float4x4 gWorldViewProj;
 	float3 gCamPos;
+
+	//vertices are quantized, value = encoded * scale + offset
+	float3 gPosScale;
+	float3 gPosOffset;
+	float2 gTexScale;
+	float2 gTexOffset;
 };
 
 struct VertexIn
 {
-	float3 PosL  : POSITION;
-    float2 Tex : TEXCOORD;
+	float4 PosQ  : POSITION;
+    float2 TexQ : TEXCOORD;
 };
 
 struct VertexOut
@@ -130,13 +136,15 @@ VertexOut VS(VertexIn vin)
 {
 	VertexOut vout;
 
-	float fog_val = Check_Sphere(vin.PosL, gCamPos);
+	float3 PosL = vin.PosQ.xyz * gPosScale + gPosOffset;
+
+	float fog_val = Check_Sphere(PosL, gCamPos);
 	vout.fog_val = fog_val;
 	
 	// Transform to homogeneous clip space.
-	vout.PosH = mul(float4(vin.PosL, 1.0f), gWorldViewProj);
+	vout.PosH = mul(float4(PosL, 1.0f), gWorldViewProj);
 
-	vout.Tex = vin.Tex;
+	vout.Tex = vin.TexQ * gTexScale + gTexOffset;
 
 	
     
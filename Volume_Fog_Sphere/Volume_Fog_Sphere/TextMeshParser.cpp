@@ -0,0 +1,263 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Text Mesh Parser
+//======================================================================================
+
+#include "TextMeshParser.h"
+#include "Profiler.h"
+
+#include <charconv>
+#include <cfloat>
+#include <cstring>
+
+#define TEXTMESH_MIN_CHUNK_SIZE (64 * 1024)
+#define TEXTMESH_CHUNK_ERRORS 8
+#define TEXTMESH_MAX_ERRORS 64
+
+struct TextChunk
+{
+	const char* Begin = nullptr;
+	const char* End = nullptr;
+
+	uint64_t LineCount = 0;
+	uint64_t VertexCount = 0;
+
+	uint64_t FirstLine = 0;
+	uint64_t FirstVertex = 0;
+
+	float BoundsMin[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+	float BoundsMax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+	TextMeshError Errors[TEXTMESH_CHUNK_ERRORS];
+	uint64_t ErrorCount = 0;
+};
+
+static bool Is_Space(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+static const char* Skip_Spaces(const char* p, const char* End)
+{
+	while (p < End && Is_Space(*p))
+		p++;
+
+	return p;
+}
+
+static const char* Line_End(const char* p, const char* End)
+{
+	const char* Eol = (const char*)memchr(p, '\n', (size_t)(End - p));
+	return Eol ? Eol : End;
+}
+
+static void Add_Error(TextChunk& Chunk, uint64_t Line, const char* Message)
+{
+	if (Chunk.ErrorCount < TEXTMESH_CHUNK_ERRORS)
+	{
+		Chunk.Errors[Chunk.ErrorCount].Line = Line;
+		Chunk.Errors[Chunk.ErrorCount].Message = Message;
+	}
+
+	Chunk.ErrorCount++;
+}
+
+//counts lines and non blank (vertex) lines
+static void Count_Lines(TextChunk& Chunk)
+{
+	const char* p = Chunk.Begin;
+
+	while (p < Chunk.End)
+	{
+		const char* Eol = Line_End(p, Chunk.End);
+
+		if (Skip_Spaces(p, Eol) != Eol)
+			Chunk.VertexCount++;
+
+		Chunk.LineCount++;
+		p = Eol + 1;
+	}
+}
+
+//returns nullptr on success or error message
+static const char* Parse_Vertex(const char* p, const char* Eol, float* V)
+{
+	for (int i = 0; i < TEXTMESH_FLOATS_PER_VERTEX; i++)
+	{
+		p = Skip_Spaces(p, Eol);
+		if (p == Eol)
+			return "expected 5 numbers per line";
+
+		std::from_chars_result Res = std::from_chars(p, Eol, V[i]);
+		if (Res.ec != std::errc())
+			return "bad number";
+
+		p = Res.ptr;
+		if (p < Eol && !Is_Space(*p))
+			return "bad number";
+	}
+
+	if (Skip_Spaces(p, Eol) != Eol)
+		return "extra data after 5 numbers";
+
+	return nullptr;
+}
+
+static void Parse_Chunk(TextChunk& Chunk, uint64_t ExpectedVertices, float* Vertices)
+{
+	const char* p = Chunk.Begin;
+	uint64_t Line = Chunk.FirstLine;
+	uint64_t VertexIndex = Chunk.FirstVertex;
+
+	while (p < Chunk.End)
+	{
+		const char* Eol = Line_End(p, Chunk.End);
+
+		if (Skip_Spaces(p, Eol) != Eol)
+		{
+			if (VertexIndex < ExpectedVertices)
+			{
+				float* V = &Vertices[VertexIndex * TEXTMESH_FLOATS_PER_VERTEX];
+
+				const char* Error = Parse_Vertex(p, Eol, V);
+				if (Error)
+				{
+					Add_Error(Chunk, Line, Error);
+				}
+				else
+				{
+					for (int j = 0; j < 3; j++)
+					{
+						if (V[j] < Chunk.BoundsMin[j]) Chunk.BoundsMin[j] = V[j];
+						if (V[j] > Chunk.BoundsMax[j]) Chunk.BoundsMax[j] = V[j];
+					}
+				}
+			}
+			else if (VertexIndex == ExpectedVertices)
+			{
+				Add_Error(Chunk, Line, "more vertices than triangles count in first line");
+			}
+
+			VertexIndex++;
+		}
+
+		Line++;
+		p = Eol + 1;
+	}
+}
+
+bool ParseTextMesh(const char* Data, size_t Size, CThreadPool& Pool, TextMeshResult& Result)
+{
+	PROFILE_FUNCTION();
+
+	Result = TextMeshResult();
+	Result.ByteSize = Size;
+
+	const char* End = Data + Size;
+
+	//first line - triangles count
+	const char* Eol = Line_End(Data, End);
+	const char* p = Skip_Spaces(Data, Eol);
+
+	uint64_t TriCount = 0;
+	std::from_chars_result Res = std::from_chars(p, Eol, TriCount);
+
+	if (Res.ec != std::errc() || Skip_Spaces(Res.ptr, Eol) != Eol ||
+		TriCount == 0 || TriCount > UINT32_MAX / 3)
+	{
+		Result.Errors.push_back({ 1, "bad triangles count" });
+		Result.ErrorCount = 1;
+		return false;
+	}
+
+	const uint64_t ExpectedVertices = TriCount * 3;
+
+	const char* Body = Eol < End ? Eol + 1 : End;
+	const size_t BodySize = (size_t)(End - Body);
+
+	//newline aligned chunks, a few per worker to even out the load
+	size_t ChunkSize = BodySize / ((size_t)(Pool.ThreadCount() + 1) * 4) + 1;
+	if (ChunkSize < TEXTMESH_MIN_CHUNK_SIZE)
+		ChunkSize = TEXTMESH_MIN_CHUNK_SIZE;
+
+	std::vector<TextChunk> Chunks;
+	Chunks.reserve(BodySize / ChunkSize + 1);
+
+	for (const char* Begin = Body; Begin < End;)
+	{
+		const char* ChunkEnd = Begin + ChunkSize < End ? Begin + ChunkSize : End;
+		ChunkEnd = Line_End(ChunkEnd, End);
+		if (ChunkEnd < End)
+			ChunkEnd++;
+
+		TextChunk Chunk;
+		Chunk.Begin = Begin;
+		Chunk.End = ChunkEnd;
+		Chunks.push_back(Chunk);
+
+		Begin = ChunkEnd;
+	}
+
+	Pool.ParallelFor((unsigned)Chunks.size(), [&](unsigned i)
+	{
+		Count_Lines(Chunks[i]);
+	}, "Count Lines");
+
+	uint64_t Line = 2;
+	uint64_t VertexCount = 0;
+
+	for (TextChunk& Chunk : Chunks)
+	{
+		Chunk.FirstLine = Line;
+		Chunk.FirstVertex = VertexCount;
+
+		Line += Chunk.LineCount;
+		VertexCount += Chunk.VertexCount;
+	}
+
+	Result.VertexCount = (uint32_t)ExpectedVertices;
+	Result.Vertices.resize((size_t)ExpectedVertices * TEXTMESH_FLOATS_PER_VERTEX);
+
+	float* Vertices = Result.Vertices.data();
+
+	Pool.ParallelFor((unsigned)Chunks.size(), [&](unsigned i)
+	{
+		Parse_Chunk(Chunks[i], ExpectedVertices, Vertices);
+	}, "Parse Chunks");
+
+	for (int j = 0; j < 3; j++)
+	{
+		Result.BoundsMin[j] = FLT_MAX;
+		Result.BoundsMax[j] = -FLT_MAX;
+	}
+
+	//once a chunk has dropped errors the ones of later chunks
+	//are not the first in file order, only the count goes on
+	bool ErrorsInOrder = true;
+
+	for (const TextChunk& Chunk : Chunks)
+	{
+		for (int j = 0; j < 3; j++)
+		{
+			if (Chunk.BoundsMin[j] < Result.BoundsMin[j]) Result.BoundsMin[j] = Chunk.BoundsMin[j];
+			if (Chunk.BoundsMax[j] > Result.BoundsMax[j]) Result.BoundsMax[j] = Chunk.BoundsMax[j];
+		}
+
+		uint64_t Stored = Chunk.ErrorCount < TEXTMESH_CHUNK_ERRORS ? Chunk.ErrorCount : TEXTMESH_CHUNK_ERRORS;
+		for (uint64_t i = 0; i < Stored && ErrorsInOrder && Result.Errors.size() < TEXTMESH_MAX_ERRORS; i++)
+			Result.Errors.push_back(Chunk.Errors[i]);
+
+		if (Stored < Chunk.ErrorCount)
+			ErrorsInOrder = false;
+
+		Result.ErrorCount += Chunk.ErrorCount;
+	}
+
+	if (VertexCount < ExpectedVertices)
+	{
+		if (ErrorsInOrder && Result.Errors.size() < TEXTMESH_MAX_ERRORS)
+			Result.Errors.push_back({ Line, "file ends before all vertices are read" });
+		Result.ErrorCount++;
+	}
+
+	return Result.ErrorCount == 0;
+}
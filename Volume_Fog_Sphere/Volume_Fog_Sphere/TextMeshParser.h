@@ -0,0 +1,46 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Text Mesh Parser
+//======================================================================================
+
+#ifndef _TEXTMESHPARSER_
+#define _TEXTMESHPARSER_
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include "ThreadPool.h"
+
+//text mesh format (room.txt):
+//	first line - triangles count
+//	then three lines "x y z u v" per triangle
+
+#define TEXTMESH_FLOATS_PER_VERTEX 5
+
+struct TextMeshError
+{
+	uint64_t Line = 0;	//1 based line number in the file
+	const char* Message = "";
+};
+
+struct TextMeshResult
+{
+	uint64_t ByteSize = 0;
+	uint32_t VertexCount = 0;
+
+	//x y z u v per vertex
+	std::vector<float> Vertices;
+
+	float BoundsMin[3] = { 0.0f, 0.0f, 0.0f };
+	float BoundsMax[3] = { 0.0f, 0.0f, 0.0f };
+
+	//first errors in file order, ErrorCount has the total
+	std::vector<TextMeshError> Errors;
+	uint64_t ErrorCount = 0;
+};
+
+//splits Data into newline aligned chunks and parses them on Pool,
+//Vertices is sized once from the first line, nothing is allocated per line
+bool ParseTextMesh(const char* Data, size_t Size, CThreadPool& Pool, TextMeshResult& Result);
+
+#endif
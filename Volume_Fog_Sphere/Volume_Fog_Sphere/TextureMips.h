@@ -0,0 +1,39 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Texture Mips
+//======================================================================================
+
+#ifndef _TEXTUREMIPS_
+#define _TEXTUREMIPS_
+
+#include <cstdint>
+#include <cstddef>
+
+#include "ThreadPool.h"
+
+#define TEXTURE_MAX_MIPS 16
+
+//one RGBA8 level inside the mip chain buffer
+struct MipLevel
+{
+	uint32_t Width = 0;
+	uint32_t Height = 0;
+	uint64_t Offset = 0;
+	uint64_t RowPitch = 0;
+};
+
+//full chain down to 1x1
+uint32_t MipLevelCount(uint32_t Width, uint32_t Height);
+
+//levels packed one after another with tight rows,
+//returns the size of the whole chain in bytes
+uint64_t MipChainLayout(uint32_t Width, uint32_t Height, uint32_t LevelCount, MipLevel* Levels);
+
+//fills levels 1 ... LevelCount - 1 from level 0 with 2x2 box filter,
+//an odd width or height is filtered with 3 taps weighted by coverage
+//so the last row and column are not dropped, Srgb - color channels are
+//averaged in linear space, alpha is linear, rows of each level are
+//split into tiles run on Pool
+void GenerateMips(unsigned char* Chain, const MipLevel* Levels, uint32_t LevelCount,
+	bool Srgb, CThreadPool& Pool);
+
+#endif
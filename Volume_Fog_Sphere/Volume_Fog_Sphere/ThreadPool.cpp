@@ -0,0 +1,139 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Thread Pool
+//======================================================================================
+
+#include "ThreadPool.h"
+#include "Profiler.h"
+
+#include <atomic>
+#include <memory>
+
+CThreadPool::CThreadPool(unsigned ThreadCount)
+{
+	if (ThreadCount == 0)
+		ThreadCount = std::thread::hardware_concurrency();
+	if (ThreadCount == 0)
+		ThreadCount = 1;
+
+	for (unsigned i = 0; i < ThreadCount; i++)
+		m_Threads.emplace_back(&CThreadPool::Worker_Loop, this);
+}
+
+CThreadPool::~CThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> Lock(m_Mutex);
+		m_Quit = true;
+	}
+
+	m_Cond.notify_all();
+
+	for (std::thread& Thread : m_Threads)
+		Thread.join();
+}
+
+void CThreadPool::Worker_Loop()
+{
+	PROFILE_THREAD_NAME("Worker");
+
+	for (;;)
+	{
+		std::function<void()> Task;
+
+		{
+			std::unique_lock<std::mutex> Lock(m_Mutex);
+			m_Cond.wait(Lock, [this] { return m_Quit || !m_Tasks.empty(); });
+
+			if (m_Tasks.empty())
+				return;
+
+			Task = std::move(m_Tasks.front());
+			m_Tasks.pop_front();
+		}
+
+		Task();
+	}
+}
+
+std::future<void> CThreadPool::Submit(std::function<void()> Task)
+{
+	auto Packaged = std::make_shared<std::packaged_task<void()>>(std::move(Task));
+	std::future<void> Result = Packaged->get_future();
+
+	{
+		std::lock_guard<std::mutex> Lock(m_Mutex);
+		m_Tasks.emplace_back([Packaged] { (*Packaged)(); });
+	}
+
+	m_Cond.notify_one();
+
+	return Result;
+}
+
+void CThreadPool::ParallelFor(unsigned Count, const std::function<void(unsigned)>& Func,
+	const char* Name)
+{
+	if (Count == 0)
+		return;
+
+	if (Count == 1)
+	{
+		PROFILE_SCOPE(Name);
+		Func(0);
+		return;
+	}
+
+	//helpers may start after the loop is over, so the
+	//shared state lives as long as the last helper
+	struct LoopState
+	{
+		std::atomic<unsigned> Next{ 0 };
+		std::atomic<unsigned> Done{ 0 };
+		unsigned Count = 0;
+		const std::function<void(unsigned)>* Func = nullptr;
+		const char* Name = nullptr;
+		std::mutex Mutex;
+		std::condition_variable Cond;
+	};
+
+	auto State = std::make_shared<LoopState>();
+	State->Count = Count;
+	State->Func = &Func;
+	State->Name = Name;
+
+	auto Run = [](LoopState& S)
+	{
+		unsigned i = S.Next.fetch_add(1);
+		if (i >= S.Count)
+			return;
+
+		//helpers that come late record nothing
+		PROFILE_SCOPE(S.Name);
+
+		for (; i < S.Count; i = S.Next.fetch_add(1))
+		{
+			(*S.Func)(i);
+
+			if (S.Done.fetch_add(1) + 1 == S.Count)
+			{
+				std::lock_guard<std::mutex> Lock(S.Mutex);
+				S.Cond.notify_all();
+			}
+		}
+	};
+
+	unsigned Helpers = Count - 1 < ThreadCount() ? Count - 1 : ThreadCount();
+
+	{
+		std::lock_guard<std::mutex> Lock(m_Mutex);
+		for (unsigned i = 0; i < Helpers; i++)
+			m_Tasks.emplace_back([State, Run] { Run(*State); });
+	}
+
+	m_Cond.notify_all();
+
+	Run(*State);
+
+	std::unique_lock<std::mutex> Lock(State->Mutex);
+	State->Cond.wait(Lock, [&] { return State->Done.load() == State->Count; });
+}
@@ -0,0 +1,377 @@
+//======================================================================================
+//	Ed Kurlyak 2023 TLSF Allocator
+//======================================================================================
+
+#include "TlsfAllocator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+static uint32_t Lowest_Bit(uint64_t Value)
+{
+#ifdef _MSC_VER
+	unsigned long Index;
+	_BitScanForward64(&Index, Value);
+	return (uint32_t)Index;
+#else
+	return (uint32_t)__builtin_ctzll(Value);
+#endif
+}
+
+static uint32_t Highest_Bit(uint64_t Value)
+{
+#ifdef _MSC_VER
+	unsigned long Index;
+	_BitScanReverse64(&Index, Value);
+	return (uint32_t)Index;
+#else
+	return 63 - (uint32_t)__builtin_clzll(Value);
+#endif
+}
+
+void CTlsfAllocator::Init(uint64_t Capacity, uint64_t Granularity)
+{
+	m_Granularity = Granularity;
+	m_GranularityShift = Highest_Bit(Granularity);
+	m_Capacity = Capacity & ~(Granularity - 1);
+	m_Used = 0;
+	m_FreeCount = 0;
+
+	m_FlBitmap = 0;
+	for (uint32_t Fl = 0; Fl < TLSF_FL_COUNT; Fl++)
+	{
+		m_SlBitmap[Fl] = 0;
+		for (uint32_t Sl = 0; Sl < TLSF_SL_COUNT; Sl++)
+			m_Heads[Fl][Sl] = TLSF_NONE;
+	}
+
+	m_Blocks.clear();
+	m_Spare.clear();
+	m_Allocated.clear();
+
+	if (m_Capacity != 0)
+		Insert_Free(New_Block(0, m_Capacity));
+}
+
+void CTlsfAllocator::Mapping(uint64_t Size, uint32_t& Fl, uint32_t& Sl) const
+{
+	//in granules, the first level holds the sizes below
+	//TLSF_SL_COUNT granules one list per size
+	uint64_t Units = Size >> m_GranularityShift;
+
+	if (Units < TLSF_SL_COUNT)
+	{
+		Fl = 0;
+		Sl = (uint32_t)Units;
+		return;
+	}
+
+	uint32_t High = Highest_Bit(Units);
+
+	Fl = High - TLSF_SL_BITS + 1;
+	Sl = (uint32_t)(Units >> (High - TLSF_SL_BITS)) - TLSF_SL_COUNT;
+}
+
+uint32_t CTlsfAllocator::New_Block(uint64_t Offset, uint64_t Size)
+{
+	Block NewBlock = { Offset, Size, TLSF_NONE, TLSF_NONE, TLSF_NONE, TLSF_NONE, false };
+
+	if (!m_Spare.empty())
+	{
+		uint32_t Index = m_Spare.back();
+		m_Spare.pop_back();
+		m_Blocks[Index] = NewBlock;
+		return Index;
+	}
+
+	m_Blocks.push_back(NewBlock);
+
+	return (uint32_t)m_Blocks.size() - 1;
+}
+
+void CTlsfAllocator::Insert_Free(uint32_t Index)
+{
+	Block& B = m_Blocks[Index];
+
+	uint32_t Fl, Sl;
+	Mapping(B.Size, Fl, Sl);
+
+	B.Free = true;
+	B.PrevFree = TLSF_NONE;
+	B.NextFree = m_Heads[Fl][Sl];
+
+	if (B.NextFree != TLSF_NONE)
+		m_Blocks[B.NextFree].PrevFree = Index;
+
+	m_Heads[Fl][Sl] = Index;
+	m_SlBitmap[Fl] |= 1u << Sl;
+	m_FlBitmap |= 1ull << Fl;
+
+	m_FreeCount++;
+}
+
+void CTlsfAllocator::Remove_Free(uint32_t Index)
+{
+	Block& B = m_Blocks[Index];
+
+	uint32_t Fl, Sl;
+	Mapping(B.Size, Fl, Sl);
+
+	if (B.PrevFree != TLSF_NONE)
+		m_Blocks[B.PrevFree].NextFree = B.NextFree;
+	else
+		m_Heads[Fl][Sl] = B.NextFree;
+
+	if (B.NextFree != TLSF_NONE)
+		m_Blocks[B.NextFree].PrevFree = B.PrevFree;
+
+	if (m_Heads[Fl][Sl] == TLSF_NONE)
+	{
+		m_SlBitmap[Fl] &= ~(1u << Sl);
+		if (m_SlBitmap[Fl] == 0)
+			m_FlBitmap &= ~(1ull << Fl);
+	}
+
+	B.Free = false;
+	m_FreeCount--;
+}
+
+uint32_t CTlsfAllocator::Find_Free(uint64_t Size) const
+{
+	//rounded up to the next list, any block there fits
+	uint64_t Units = Size >> m_GranularityShift;
+	if (Units >= TLSF_SL_COUNT)
+		Units += (1ull << (Highest_Bit(Units) - TLSF_SL_BITS)) - 1;
+
+	uint32_t Fl, Sl;
+	Mapping(Units << m_GranularityShift, Fl, Sl);
+
+	if (Fl >= TLSF_FL_COUNT)
+		return TLSF_NONE;
+
+	uint32_t SlMap = m_SlBitmap[Fl] & (~0u << Sl);
+
+	if (SlMap == 0)
+	{
+		uint64_t FlMap = Fl + 1 < 64 ? m_FlBitmap & (~0ull << (Fl + 1)) : 0;
+		if (FlMap == 0)
+			return TLSF_NONE;
+
+		Fl = Lowest_Bit(FlMap);
+		SlMap = m_SlBitmap[Fl];
+	}
+
+	return m_Heads[Fl][Lowest_Bit(SlMap)];
+}
+
+void CTlsfAllocator::Split(uint32_t Index, uint64_t Size)
+{
+	if (m_Blocks[Index].Size <= Size)
+		return;
+
+	uint32_t Rest = New_Block(m_Blocks[Index].Offset + Size, m_Blocks[Index].Size - Size);
+
+	//New_Block may have moved m_Blocks
+	Block& B = m_Blocks[Index];
+	Block& R = m_Blocks[Rest];
+
+	R.PrevPhys = Index;
+	R.NextPhys = B.NextPhys;
+	if (B.NextPhys != TLSF_NONE)
+		m_Blocks[B.NextPhys].PrevPhys = Rest;
+
+	B.NextPhys = Rest;
+	B.Size = Size;
+
+	Insert_Free(Rest);
+}
+
+uint32_t CTlsfAllocator::Merge(uint32_t Index)
+{
+	uint32_t Next = m_Blocks[Index].NextPhys;
+
+	if (Next != TLSF_NONE && m_Blocks[Next].Free)
+	{
+		Remove_Free(Next);
+
+		m_Blocks[Index].Size += m_Blocks[Next].Size;
+		m_Blocks[Index].NextPhys = m_Blocks[Next].NextPhys;
+		if (m_Blocks[Next].NextPhys != TLSF_NONE)
+			m_Blocks[m_Blocks[Next].NextPhys].PrevPhys = Index;
+
+		m_Spare.push_back(Next);
+	}
+
+	uint32_t Prev = m_Blocks[Index].PrevPhys;
+
+	if (Prev != TLSF_NONE && m_Blocks[Prev].Free)
+	{
+		Remove_Free(Prev);
+
+		m_Blocks[Prev].Size += m_Blocks[Index].Size;
+		m_Blocks[Prev].NextPhys = m_Blocks[Index].NextPhys;
+		if (m_Blocks[Index].NextPhys != TLSF_NONE)
+			m_Blocks[m_Blocks[Index].NextPhys].PrevPhys = Prev;
+
+		m_Spare.push_back(Index);
+		Index = Prev;
+	}
+
+	return Index;
+}
+
+bool CTlsfAllocator::Allocate(uint64_t Size, uint64_t Align, uint64_t& Offset)
+{
+	if (Size == 0 || Size > m_Capacity)
+		return false;
+
+	Size = (Size + m_Granularity - 1) & ~(m_Granularity - 1);
+	if (Align < m_Granularity)
+		Align = m_Granularity;
+
+	//a block this big holds Size at Align wherever it starts
+	uint64_t Search = Size + Align - m_Granularity;
+
+	uint32_t Index = Find_Free(Search);
+	if (Index == TLSF_NONE)
+		return false;
+
+	Remove_Free(Index);
+
+	//the gap in front of an aligned start goes back to the lists
+	uint64_t Start = (m_Blocks[Index].Offset + Align - 1) & ~(Align - 1);
+	uint64_t Pad = Start - m_Blocks[Index].Offset;
+
+	if (Pad != 0)
+	{
+		Split(Index, Pad);
+
+		uint32_t Aligned = m_Blocks[Index].NextPhys;
+		Remove_Free(Aligned);
+
+		//Index stays free, it may merge with a free block before it
+		Insert_Free(Merge(Index));
+
+		Index = Aligned;
+	}
+
+	Split(Index, Size);
+
+	m_Used += Size;
+	m_Allocated[Start] = Index;
+
+	Offset = Start;
+
+	return true;
+}
+
+void CTlsfAllocator::Free(uint64_t Offset)
+{
+	auto It = m_Allocated.find(Offset);
+	if (It == m_Allocated.end())
+		return;
+
+	uint32_t Index = It->second;
+	m_Allocated.erase(It);
+
+	m_Used -= m_Blocks[Index].Size;
+
+	Insert_Free(Merge(Index));
+}
+
+uint64_t CTlsfAllocator::Largest_Free() const
+{
+	if (m_FlBitmap == 0)
+		return 0;
+
+	//the top list is not sorted, look at every block in it
+	uint32_t Fl = Highest_Bit(m_FlBitmap);
+	uint32_t Sl = Highest_Bit(m_SlBitmap[Fl]);
+
+	uint64_t Largest = 0;
+	for (uint32_t i = m_Heads[Fl][Sl]; i != TLSF_NONE; i = m_Blocks[i].NextFree)
+		Largest = std::max(Largest, m_Blocks[i].Size);
+
+	return Largest;
+}
+
+double CTlsfAllocator::Fragmentation() const
+{
+	uint64_t FreeSize = Free_Size();
+	if (FreeSize == 0)
+		return 0.0;
+
+	return 1.0 - (double)Largest_Free() / (double)FreeSize;
+}
+
+TlsfBenchResult BenchmarkTlsf(uint64_t Capacity, uint32_t Operations, uint32_t Seed)
+{
+	TlsfBenchResult Result;
+	Result.Operations = Operations;
+
+	CTlsfAllocator Allocator;
+	Allocator.Init(Capacity, 256);
+
+	std::mt19937 Random(Seed);
+	std::vector<uint64_t> Live;
+	Live.reserve(Operations);
+
+	std::chrono::steady_clock::duration AllocateTime(0);
+	std::chrono::steady_clock::duration FreeTime(0);
+	uint32_t Allocations = 0;
+	uint32_t Frees = 0;
+
+	for (uint32_t i = 0; i < Operations; i++)
+	{
+		//frees get more likely as the range fills up
+		bool DoFree = !Live.empty() &&
+			Random() % 1000 < 300 + 700 * Allocator.Used() / Capacity;
+
+		if (DoFree)
+		{
+			size_t Pick = Random() % Live.size();
+			uint64_t Offset = Live[Pick];
+			Live[Pick] = Live.back();
+			Live.pop_back();
+
+			auto Start = std::chrono::steady_clock::now();
+			Allocator.Free(Offset);
+			FreeTime += std::chrono::steady_clock::now() - Start;
+			Frees++;
+		}
+		else
+		{
+			//mostly small buffers, now and then a texture size
+			uint64_t Size = Random() % 8 != 0 ? 256 + Random() % (64 * 1024) : 64 * 1024 + Random() % (4 * 1024 * 1024);
+			uint64_t Align = 256ull << (Random() % 3 == 0 ? 8 : 0);
+
+			uint64_t Offset = 0;
+
+			auto Start = std::chrono::steady_clock::now();
+			bool Done = Allocator.Allocate(Size, Align, Offset);
+			AllocateTime += std::chrono::steady_clock::now() - Start;
+			Allocations++;
+
+			if (Done)
+				Live.push_back(Offset);
+			else
+				Result.Failed++;
+		}
+
+		Result.PeakUsed = std::max(Result.PeakUsed, Allocator.Used());
+	}
+
+	Result.Fragmentation = Allocator.Fragmentation();
+
+	std::chrono::duration<double, std::nano> AllocateNs = AllocateTime;
+	std::chrono::duration<double, std::nano> FreeNs = FreeTime;
+	Result.AllocateTime = Allocations ? AllocateNs.count() / Allocations : 0.0;
+	Result.FreeTime = Frees ? FreeNs.count() / Frees : 0.0;
+
+	return Result;
+}
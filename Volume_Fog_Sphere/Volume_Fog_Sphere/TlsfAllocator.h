@@ -0,0 +1,102 @@
+//======================================================================================
+//	Ed Kurlyak 2023 TLSF Allocator
+//======================================================================================
+
+#ifndef _TLSFALLOCATOR_
+#define _TLSFALLOCATOR_
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+//second level lists per power of two, 2^TLSF_SL_BITS of them
+#define TLSF_SL_BITS 5
+#define TLSF_SL_COUNT (1 << TLSF_SL_BITS)
+#define TLSF_FL_COUNT 48
+
+#define TLSF_NONE 0xffffffff
+
+//two level segregated fit over offsets [0, Capacity), Allocate
+//and Free take constant time, a freed block merges with free
+//neighbours at once, no D3D here, the owner maps offsets to
+//its heap or buffer
+class CTlsfAllocator
+{
+public:
+	//Granularity is a power of two, sizes are rounded up to it
+	//and every offset is a multiple of it
+	void Init(uint64_t Capacity, uint64_t Granularity);
+
+	//false if no free block holds Size at Align, Align is a
+	//power of two, the granularity is used when it is smaller
+	bool Allocate(uint64_t Size, uint64_t Align, uint64_t& Offset);
+
+	//Offset as Allocate returned it
+	void Free(uint64_t Offset);
+
+	uint64_t Capacity() const { return m_Capacity; }
+	uint64_t Used() const { return m_Used; }
+	uint64_t Free_Size() const { return m_Capacity - m_Used; }
+	uint32_t Allocation_Count() const { return (uint32_t)m_Allocated.size(); }
+	uint32_t Free_Block_Count() const { return m_FreeCount; }
+
+	uint64_t Largest_Free() const;
+
+	//0 when the free space is one block, close to 1 when it is
+	//scattered in pieces too small for a big allocation
+	double Fragmentation() const;
+
+private:
+	struct Block
+	{
+		uint64_t Offset;
+		uint64_t Size;
+		//neighbours in memory and in the free list, TLSF_NONE if none
+		uint32_t PrevPhys;
+		uint32_t NextPhys;
+		uint32_t PrevFree;
+		uint32_t NextFree;
+		bool Free;
+	};
+
+	uint32_t New_Block(uint64_t Offset, uint64_t Size);
+	void Insert_Free(uint32_t Index);
+	void Remove_Free(uint32_t Index);
+	void Split(uint32_t Index, uint64_t Size);
+	uint32_t Merge(uint32_t Index);
+	uint32_t Find_Free(uint64_t Size) const;
+
+	void Mapping(uint64_t Size, uint32_t& Fl, uint32_t& Sl) const;
+
+	uint64_t m_Capacity = 0;
+	uint64_t m_Granularity = 1;
+	uint32_t m_GranularityShift = 0;
+	uint64_t m_Used = 0;
+	uint32_t m_FreeCount = 0;
+
+	uint64_t m_FlBitmap = 0;
+	uint32_t m_SlBitmap[TLSF_FL_COUNT] = {};
+	uint32_t m_Heads[TLSF_FL_COUNT][TLSF_SL_COUNT];
+
+	std::vector<Block> m_Blocks;
+	//unused entries of m_Blocks
+	std::vector<uint32_t> m_Spare;
+	//offset of every allocated block to its entry
+	std::unordered_map<uint64_t, uint32_t> m_Allocated;
+};
+
+//random allocations and frees of 256 bytes to 4 MB with
+//alignments up to 64 KB in a Capacity range, times in ns per call
+struct TlsfBenchResult
+{
+	uint32_t Operations = 0;
+	uint32_t Failed = 0;
+	double AllocateTime = 0.0;
+	double FreeTime = 0.0;
+	uint64_t PeakUsed = 0;
+	double Fragmentation = 0.0;
+};
+
+TlsfBenchResult BenchmarkTlsf(uint64_t Capacity, uint32_t Operations, uint32_t Seed);
+
+#endif
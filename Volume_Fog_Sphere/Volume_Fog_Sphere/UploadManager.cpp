@@ -0,0 +1,243 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Upload Manager DirectX12
+//======================================================================================
+
+#include "UploadManager.h"
+
+//buffer copies have no placement rule, keep them 16 byte aligned
+#define UPLOAD_BUFFER_ALIGNMENT 16
+
+CUploadManager::~CUploadManager()
+{
+	//the copy queue may still read the ring
+	if (m_Fence.Get() != nullptr)
+		Flush();
+
+	if (m_RingBuffer != nullptr)
+		m_RingBuffer->Unmap(0, nullptr);
+
+	m_RingBuffer = nullptr;
+
+	if (m_Memory != nullptr)
+		m_Memory->Free(m_RingMemory);
+}
+
+void CUploadManager::Init(ID3D12Device* Device, CGpuMemory* Memory, UINT64 RingSize)
+{
+	m_Device = Device;
+	m_Memory = Memory;
+
+	D3D12_COMMAND_QUEUE_DESC QueueDesc = {};
+	QueueDesc.Type = D3D12_COMMAND_LIST_TYPE_COPY;
+	QueueDesc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
+	ThrowIfFailed(m_Device->CreateCommandQueue(&QueueDesc, IID_PPV_ARGS(&m_CopyQueue)));
+
+	m_Fence.Init(m_Device.Get());
+
+	ThrowIfFailed(m_Device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COPY,
+		IID_PPV_ARGS(m_CurrentAlloc.GetAddressOf())));
+
+	ThrowIfFailed(m_Device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_COPY,
+		m_CurrentAlloc.Get(), nullptr, IID_PPV_ARGS(m_CopyList.GetAddressOf())));
+
+	//the first Begin_Commands resets it
+	ThrowIfFailed(m_CopyList->Close());
+	m_Allocators.push_back({ m_CurrentAlloc, 0 });
+	m_CurrentAlloc = nullptr;
+
+	m_RingMemory = m_Memory->Create_Buffer(D3D12_HEAP_TYPE_UPLOAD, RingSize, D3D12_RESOURCE_STATE_GENERIC_READ);
+	m_RingBuffer = m_RingMemory.Resource;
+
+	//stays mapped, the CPU only writes to it
+	CD3DX12_RANGE ReadRange(0, 0);
+	ThrowIfFailed(m_RingBuffer->Map(0, &ReadRange, reinterpret_cast<void**>(&m_RingData)));
+
+	m_Ring.Init(RingSize);
+}
+
+GpuAllocation CUploadManager::CreateBuffer(const void* Data, UINT64 ByteSize)
+{
+	GpuAllocation DefaultBuffer = m_Memory->Create_Buffer(D3D12_HEAP_TYPE_DEFAULT, ByteSize, D3D12_RESOURCE_STATE_COMMON);
+
+	Staging Block = Stage(ByteSize, UPLOAD_BUFFER_ALIGNMENT);
+
+	memcpy(Block.Data, Data, (size_t)ByteSize);
+
+	m_CopyList->CopyBufferRegion(DefaultBuffer.Resource.Get(), DefaultBuffer.Offset, Block.Buffer, Block.Offset, ByteSize);
+
+	return DefaultBuffer;
+}
+
+void CUploadManager::UploadTexture(ID3D12Resource* Resource, UINT NumSubresources, const D3D12_SUBRESOURCE_DATA* SrcData)
+{
+	D3D12_RESOURCE_DESC Desc = Resource->GetDesc();
+
+	std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> Layouts(NumSubresources);
+	std::vector<UINT> NumRows(NumSubresources);
+	std::vector<UINT64> RowSizes(NumSubresources);
+	UINT64 TotalBytes = 0;
+
+	m_Device->GetCopyableFootprints(&Desc, 0, NumSubresources, 0,
+		Layouts.data(), NumRows.data(), RowSizes.data(), &TotalBytes);
+
+	//all levels in one block, offsets from GetCopyableFootprints
+	//keep their placement alignment when the block is aligned
+	Staging Block = Stage(TotalBytes, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+
+	for (UINT i = 0; i < NumSubresources; i++)
+	{
+		D3D12_MEMCPY_DEST DestData = { Block.Data + Layouts[i].Offset,
+			Layouts[i].Footprint.RowPitch,
+			SIZE_T(Layouts[i].Footprint.RowPitch) * SIZE_T(NumRows[i]) };
+
+		MemcpySubresource(&DestData, &SrcData[i], (SIZE_T)RowSizes[i], NumRows[i], Layouts[i].Footprint.Depth);
+
+		Layouts[i].Offset += Block.Offset;
+
+		CD3DX12_TEXTURE_COPY_LOCATION Dst(Resource, i);
+		CD3DX12_TEXTURE_COPY_LOCATION Src(Block.Buffer, Layouts[i]);
+		m_CopyList->CopyTextureRegion(&Dst, 0, 0, 0, &Src, nullptr);
+	}
+}
+
+UINT64 CUploadManager::Submit()
+{
+	if (!m_Recording)
+		return m_SubmittedFence;
+
+	ThrowIfFailed(m_CopyList->Close());
+	ID3D12CommandList* cmdsLists[] = { m_CopyList.Get() };
+	m_CopyQueue->ExecuteCommandLists(_countof(cmdsLists), cmdsLists);
+
+	m_SubmittedFence = m_Fence.Signal(m_CopyQueue.Get());
+
+	//everything the list used is released with this fence value
+	m_Ring.Close_Batch(m_SubmittedFence);
+
+	for (auto& Buffer : m_OpenDedicated)
+		m_Dedicated.push_back({ Buffer, m_SubmittedFence });
+	m_OpenDedicated.clear();
+
+	m_Allocators.push_back({ m_CurrentAlloc, m_SubmittedFence });
+	m_CurrentAlloc = nullptr;
+
+	m_Recording = false;
+
+	return m_SubmittedFence;
+}
+
+void CUploadManager::Queue_Wait(ID3D12CommandQueue* Queue)
+{
+	if (m_WaitedFence >= m_SubmittedFence)
+		return;
+
+	//GPU side wait, the CPU goes on recording
+	m_Fence.Gpu_Wait(Queue, m_SubmittedFence);
+
+	m_WaitedFence = m_SubmittedFence;
+}
+
+void CUploadManager::Flush()
+{
+	Submit();
+
+	m_Fence.Wait(m_SubmittedFence);
+
+	Release_Completed();
+}
+
+void CUploadManager::Begin_Commands()
+{
+	if (m_Recording)
+		return;
+
+	//allocators go back in submit order, the oldest is reused
+	//once the copy queue is done with its list
+	if (m_Fence.IsComplete(m_Allocators.front().FenceValue))
+	{
+		m_CurrentAlloc = m_Allocators.front().CmdAlloc;
+		m_Allocators.pop_front();
+	}
+	else
+	{
+		ThrowIfFailed(m_Device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COPY,
+			IID_PPV_ARGS(m_CurrentAlloc.GetAddressOf())));
+	}
+
+	ThrowIfFailed(m_CurrentAlloc->Reset());
+	ThrowIfFailed(m_CopyList->Reset(m_CurrentAlloc.Get(), nullptr));
+
+	m_Recording = true;
+}
+
+CUploadManager::Staging CUploadManager::Stage(UINT64 Size, UINT64 Align)
+{
+	Release_Completed();
+
+	Begin_Commands();
+
+	Staging Block = {};
+
+	if (Size > m_Ring.Capacity())
+	{
+		//too big for the ring, a buffer of its own that is
+		//released with the ring space of the same submit
+		Microsoft::WRL::ComPtr<ID3D12Resource> Buffer;
+
+		ThrowIfFailed(m_Device->CreateCommittedResource(
+			&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+			D3D12_HEAP_FLAG_NONE,
+			&CD3DX12_RESOURCE_DESC::Buffer(Size),
+			D3D12_RESOURCE_STATE_GENERIC_READ,
+			nullptr,
+			IID_PPV_ARGS(&Buffer)));
+
+		CD3DX12_RANGE ReadRange(0, 0);
+		ThrowIfFailed(Buffer->Map(0, &ReadRange, reinterpret_cast<void**>(&Block.Data)));
+
+		Block.Buffer = Buffer.Get();
+		Block.Offset = 0;
+
+		m_OpenDedicated.push_back(Buffer);
+
+		return Block;
+	}
+
+	UINT64 Offset = 0;
+
+	while (!m_Ring.Allocate(Size, Align, Offset))
+	{
+		//only the list being recorded holds the ring,
+		//send it so its space can be waited for
+		if (m_Ring.Oldest_Fence() == 0)
+		{
+			Submit();
+			Begin_Commands();
+		}
+
+		m_Fence.Wait(m_Ring.Oldest_Fence());
+
+		Release_Completed();
+	}
+
+	Block.Buffer = m_RingBuffer.Get();
+	Block.Offset = Offset;
+	Block.Data = m_RingData + Offset;
+
+	return Block;
+}
+
+void CUploadManager::Release_Completed()
+{
+	UINT64 Completed = m_Fence.Completed_Value();
+
+	m_Ring.Release(Completed);
+
+	size_t Count = 0;
+	for (size_t i = 0; i < m_Dedicated.size(); i++)
+	{
+		if (m_Dedicated[i].FenceValue > Completed)
+			m_Dedicated[Count++] = m_Dedicated[i];
+	}
+	m_Dedicated.resize(Count);
+}
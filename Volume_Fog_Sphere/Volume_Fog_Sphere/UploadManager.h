@@ -0,0 +1,109 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Upload Manager DirectX12
+//======================================================================================
+
+#ifndef _UPLOADMANAGER_
+#define _UPLOADMANAGER_
+
+#include <windows.h>
+#include <wrl.h>
+#include <d3d12.h>
+#include "d3dx12.h"
+#include <deque>
+#include <vector>
+
+#include "d3dUtil.h"
+#include "UploadRing.h"
+#include "GpuFence.h"
+#include "GpuMemory.h"
+
+//copies buffers and textures to default heap resources on a copy
+//queue, the data is staged in one mapped upload buffer used as a
+//ring, ring space is reused after the copy fence passes it.
+//Resources are made in COMMON state and go back to COMMON when
+//the copy list is done, the direct queue promotes them on first
+//use, so no barriers are recorded on either queue. Default heap
+//buffers and the ring are placed by the CGpuMemory of the owner
+class CUploadManager
+{
+public:
+	CUploadManager() = default;
+	~CUploadManager();
+
+	CUploadManager(const CUploadManager& rhs) = delete;
+	CUploadManager& operator=(const CUploadManager& rhs) = delete;
+
+	void Init(ID3D12Device* Device, CGpuMemory* Memory, UINT64 RingSize);
+
+	//small buffers are packed, use GpuAddress of the result
+	GpuAllocation CreateBuffer(const void* Data, UINT64 ByteSize);
+
+	//Resource is a default heap texture in COMMON state,
+	//SrcData holds NumSubresources levels starting at 0
+	void UploadTexture(ID3D12Resource* Resource, UINT NumSubresources, const D3D12_SUBRESOURCE_DATA* SrcData);
+
+	//executes the recorded copies, returns the fence value they signal
+	UINT64 Submit();
+
+	//makes Queue wait on the GPU for everything submitted so far,
+	//call before executing a list that uses uploaded resources,
+	//does nothing if there was no new submit since the last call
+	void Queue_Wait(ID3D12CommandQueue* Queue);
+
+	//blocks until all submitted copies are done
+	void Flush();
+
+	//fence of the copy queue, Submit returns its values, to wait
+	//on it together with other queues in CGpuFence::Wait_All
+	CGpuFence& Fence() { return m_Fence; }
+
+private:
+	//Size bytes of mapped upload memory for the list being recorded
+	struct Staging
+	{
+		ID3D12Resource* Buffer;
+		UINT64 Offset;
+		BYTE* Data;
+	};
+
+	void Begin_Commands();
+	Staging Stage(UINT64 Size, UINT64 Align);
+	void Release_Completed();
+
+	struct Allocator
+	{
+		Microsoft::WRL::ComPtr<ID3D12CommandAllocator> CmdAlloc;
+		UINT64 FenceValue;
+	};
+
+	//upload buffer for a copy that does not fit the ring
+	struct DedicatedUpload
+	{
+		Microsoft::WRL::ComPtr<ID3D12Resource> Buffer;
+		UINT64 FenceValue;
+	};
+
+	Microsoft::WRL::ComPtr<ID3D12Device> m_Device;
+	CGpuMemory* m_Memory = nullptr;
+	Microsoft::WRL::ComPtr<ID3D12CommandQueue> m_CopyQueue;
+	Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> m_CopyList;
+	CGpuFence m_Fence;
+
+	std::deque<Allocator> m_Allocators;
+	Microsoft::WRL::ComPtr<ID3D12CommandAllocator> m_CurrentAlloc;
+	bool m_Recording = false;
+
+	GpuAllocation m_RingMemory;
+	Microsoft::WRL::ComPtr<ID3D12Resource> m_RingBuffer;
+	BYTE* m_RingData = nullptr;
+	CUploadRing m_Ring;
+
+	std::vector<DedicatedUpload> m_Dedicated;
+	//dedicated buffers used by the list being recorded
+	std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>> m_OpenDedicated;
+
+	UINT64 m_SubmittedFence = 0;
+	UINT64 m_WaitedFence = 0;
+};
+
+#endif
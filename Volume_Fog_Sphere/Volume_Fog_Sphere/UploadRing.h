@@ -0,0 +1,56 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Upload Ring
+//======================================================================================
+
+#ifndef _UPLOADRING_
+#define _UPLOADRING_
+
+#include <cstdint>
+#include <deque>
+
+//offsets inside one staging buffer that is used as a ring,
+//allocations since the last Close_Batch are freed together
+//when the fence value of their batch is reached,
+//no D3D here, the owner maps offsets to its upload buffer
+class CUploadRing
+{
+public:
+	void Init(uint64_t Capacity);
+
+	//false if there is no room until older batches are released,
+	//Align is a power of two
+	bool Allocate(uint64_t Size, uint64_t Align, uint64_t& Offset);
+
+	//allocations made since the previous call are freed
+	//once the fence reaches FenceValue
+	void Close_Batch(uint64_t FenceValue);
+
+	//frees batches with fence value <= CompletedValue
+	void Release(uint64_t CompletedValue);
+
+	//fence value of the oldest batch still in flight, 0 if none
+	uint64_t Oldest_Fence() const;
+
+	bool Has_Open_Allocations() const { return m_OpenBytes != 0; }
+
+	uint64_t Capacity() const { return m_Capacity; }
+	uint64_t Used() const { return m_Used; }
+
+private:
+	struct Batch
+	{
+		uint64_t FenceValue;
+		//allocated bytes with alignment padding and the tail skipped on wrap
+		uint64_t Bytes;
+	};
+
+	uint64_t m_Capacity = 0;
+	uint64_t m_Head = 0;
+	uint64_t m_Tail = 0;
+	uint64_t m_Used = 0;
+	uint64_t m_OpenBytes = 0;
+
+	std::deque<Batch> m_Batches;
+};
+
+#endif
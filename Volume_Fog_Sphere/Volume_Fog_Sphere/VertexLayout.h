@@ -0,0 +1,84 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Vertex Layout DirectX12
+//======================================================================================
+
+#ifndef _VERTEXLAYOUT_
+#define _VERTEXLAYOUT_
+
+#include <d3d12.h>
+#include <array>
+
+//vertex element encodings, Size in bytes
+template<DXGI_FORMAT F, UINT S>
+struct VertexEncoding
+{
+	static constexpr DXGI_FORMAT Format = F;
+	static constexpr UINT Size = S;
+};
+
+typedef VertexEncoding<DXGI_FORMAT_R32G32B32_FLOAT, 12> EncodingFloat3;
+typedef VertexEncoding<DXGI_FORMAT_R32G32_FLOAT, 8> EncodingFloat2;
+
+//position as 16 bit float, w is unused
+typedef VertexEncoding<DXGI_FORMAT_R16G16B16A16_FLOAT, 8> EncodingHalf4;
+//position relative to the mesh bounds, w is unused
+typedef VertexEncoding<DXGI_FORMAT_R16G16B16A16_SNORM, 8> EncodingSnorm16x4;
+//octahedral normal (see EncodeOctahedral)
+typedef VertexEncoding<DXGI_FORMAT_R16G16_SNORM, 4> EncodingOct16;
+//uv relative to the uv bounds
+typedef VertexEncoding<DXGI_FORMAT_R16G16_UNORM, 4> EncodingUnorm16x2;
+
+struct SemanticPosition { static constexpr const char* Name = "POSITION"; };
+struct SemanticNormal { static constexpr const char* Name = "NORMAL"; };
+struct SemanticTexCoord { static constexpr const char* Name = "TEXCOORD"; };
+
+template<typename SemanticType, typename EncodingType, UINT SemanticIndex = 0>
+struct VertexElement
+{
+	typedef SemanticType Semantic;
+	typedef EncodingType Encoding;
+	static constexpr UINT Index = SemanticIndex;
+};
+
+//elements are packed in order without padding, InputLayout()
+//gives matching input elements for one vertex buffer slot
+template<typename... Elements>
+struct VertexLayout
+{
+	static constexpr UINT ElementCount = sizeof...(Elements);
+	static constexpr UINT Stride = (Elements::Encoding::Size + ...);
+
+	static constexpr std::array<D3D12_INPUT_ELEMENT_DESC, sizeof...(Elements)> InputLayout(UINT Slot = 0)
+	{
+		std::array<D3D12_INPUT_ELEMENT_DESC, sizeof...(Elements)> Desc = {};
+
+		UINT Offset = 0;
+		UINT i = 0;
+
+		((Desc[i++] = { Elements::Semantic::Name, Elements::Index, Elements::Encoding::Format, Slot,
+			Offset, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+			Offset += Elements::Encoding::Size), ...);
+
+		return Desc;
+	}
+};
+
+//full precision layouts of the samples
+typedef VertexLayout<
+	VertexElement<SemanticPosition, EncodingFloat3>,
+	VertexElement<SemanticTexCoord, EncodingFloat2>> VertexLayoutPosTex;
+
+typedef VertexLayout<
+	VertexElement<SemanticPosition, EncodingFloat3>,
+	VertexElement<SemanticNormal, EncodingFloat3>> VertexLayoutPosNormal;
+
+//quantized layouts, 12 bytes instead of 20 and 24
+typedef VertexLayout<
+	VertexElement<SemanticPosition, EncodingSnorm16x4>,
+	VertexElement<SemanticTexCoord, EncodingUnorm16x2>> VertexLayoutPosTexQ;
+
+typedef VertexLayout<
+	VertexElement<SemanticPosition, EncodingSnorm16x4>,
+	VertexElement<SemanticNormal, EncodingOct16>> VertexLayoutPosNormalQ;
+
+#endif
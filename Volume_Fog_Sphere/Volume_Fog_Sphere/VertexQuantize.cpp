@@ -0,0 +1,194 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Vertex Quantization
+//======================================================================================
+
+#include "VertexQuantize.h"
+#include "Profiler.h"
+
+#include <cmath>
+#include <cstring>
+#include <cfloat>
+
+int16_t QuantizeSnorm16(float v)
+{
+	v = v < -1.0f ? -1.0f : (v > 1.0f ? 1.0f : v);
+	return (int16_t)lrintf(v * 32767.0f);
+}
+
+uint16_t QuantizeUnorm16(float v)
+{
+	v = v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v);
+	return (uint16_t)lrintf(v * 65535.0f);
+}
+
+static float Snorm16_To_Float(int16_t v)
+{
+	float f = v / 32767.0f;
+	return f < -1.0f ? -1.0f : f;
+}
+
+static float Unorm16_To_Float(uint16_t v)
+{
+	return v / 65535.0f;
+}
+
+uint16_t QuantizeHalf(float v)
+{
+	uint32_t Bits;
+	memcpy(&Bits, &v, sizeof(Bits));
+
+	uint32_t Sign = (Bits >> 16) & 0x8000;
+	int32_t Exp = (int32_t)((Bits >> 23) & 0xFF) - 127 + 15;
+	uint32_t Mantissa = Bits & 0x7FFFFF;
+
+	//NaN and infinity
+	if (((Bits >> 23) & 0xFF) == 0xFF)
+		return (uint16_t)(Sign | 0x7C00 | (Mantissa ? 0x200 : 0));
+
+	//overflow goes to infinity
+	if (Exp >= 31)
+		return (uint16_t)(Sign | 0x7C00);
+
+	//denormal or zero
+	if (Exp <= 0)
+	{
+		if (Exp < -10)
+			return (uint16_t)Sign;
+
+		Mantissa |= 0x800000;
+
+		uint32_t Shift = (uint32_t)(14 - Exp);
+		uint32_t Half = Mantissa >> Shift;
+		uint32_t Rest = Mantissa & ((1u << Shift) - 1);
+		uint32_t HalfWay = 1u << (Shift - 1);
+
+		//round to nearest even
+		if (Rest > HalfWay || (Rest == HalfWay && (Half & 1)))
+			Half++;
+
+		return (uint16_t)(Sign | Half);
+	}
+
+	uint32_t Half = ((uint32_t)Exp << 10) | (Mantissa >> 13);
+	uint32_t Rest = Mantissa & 0x1FFF;
+
+	//carry into exponent is the right result, up to infinity
+	if (Rest > 0x1000 || (Rest == 0x1000 && (Half & 1)))
+		Half++;
+
+	return (uint16_t)(Sign | Half);
+}
+
+void EncodeOctahedral(const float* Normal, int16_t* Oct)
+{
+	//project to octahedron |x| + |y| + |z| = 1, fold lower half over
+	float Len = fabsf(Normal[0]) + fabsf(Normal[1]) + fabsf(Normal[2]);
+	float x = Normal[0] / Len;
+	float y = Normal[1] / Len;
+
+	if (Normal[2] < 0.0f)
+	{
+		float fx = (1.0f - fabsf(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+		float fy = (1.0f - fabsf(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+		x = fx;
+		y = fy;
+	}
+
+	Oct[0] = QuantizeSnorm16(x);
+	Oct[1] = QuantizeSnorm16(y);
+}
+
+void DecodeOctahedral(const int16_t* Oct, float* Normal)
+{
+	float x = Snorm16_To_Float(Oct[0]);
+	float y = Snorm16_To_Float(Oct[1]);
+	float z = 1.0f - fabsf(x) - fabsf(y);
+
+	float t = z < 0.0f ? -z : 0.0f;
+	x += x >= 0.0f ? -t : t;
+	y += y >= 0.0f ? -t : t;
+
+	float Len = sqrtf(x * x + y * y + z * z);
+
+	Normal[0] = x / Len;
+	Normal[1] = y / Len;
+	Normal[2] = z / Len;
+}
+
+void QuantizePosTex(const float* Vertices, uint32_t VertexCount,
+	const float* BoundsMin, const float* BoundsMax,
+	QuantizedVertex* Dst, VertexDequantize& Decode, VertexQuantizeError& Error)
+{
+	PROFILE_FUNCTION();
+
+	Decode = VertexDequantize();
+	Error = VertexQuantizeError();
+
+	float TexMin[2] = { FLT_MAX, FLT_MAX };
+	float TexMax[2] = { -FLT_MAX, -FLT_MAX };
+
+	for (uint32_t i = 0; i < VertexCount; i++)
+	{
+		const float* Tex = &Vertices[i * 5 + 3];
+
+		for (int j = 0; j < 2; j++)
+		{
+			if (Tex[j] < TexMin[j]) TexMin[j] = Tex[j];
+			if (Tex[j] > TexMax[j]) TexMax[j] = Tex[j];
+		}
+	}
+
+	//positions map to -1 ... 1 around the bounds center
+	for (int j = 0; j < 3; j++)
+	{
+		float HalfSize = (BoundsMax[j] - BoundsMin[j]) * 0.5f;
+
+		Decode.PosScale[j] = HalfSize > 0.0f ? HalfSize : 1.0f;
+		Decode.PosOffset[j] = (BoundsMax[j] + BoundsMin[j]) * 0.5f;
+	}
+
+	//uv map to 0 ... 1, so tiling uv do not lose the range
+	for (int j = 0; j < 2; j++)
+	{
+		float Size = TexMax[j] - TexMin[j];
+
+		Decode.TexScale[j] = Size > 0.0f ? Size : 1.0f;
+		Decode.TexOffset[j] = TexMin[j];
+	}
+
+	for (uint32_t i = 0; i < VertexCount; i++)
+	{
+		const float* Pos = &Vertices[i * 5];
+		const float* Tex = &Vertices[i * 5 + 3];
+
+		QuantizedVertex& Q = Dst[i];
+
+		float PosError = 0.0f;
+
+		for (int j = 0; j < 3; j++)
+		{
+			Q.Pos[j] = QuantizeSnorm16((Pos[j] - Decode.PosOffset[j]) / Decode.PosScale[j]);
+
+			float d = Snorm16_To_Float(Q.Pos[j]) * Decode.PosScale[j] + Decode.PosOffset[j] - Pos[j];
+			PosError += d * d;
+		}
+
+		Q.Pos[3] = 0;
+
+		float TexError = 0.0f;
+
+		for (int j = 0; j < 2; j++)
+		{
+			Q.Tex[j] = QuantizeUnorm16((Tex[j] - Decode.TexOffset[j]) / Decode.TexScale[j]);
+
+			float d = Unorm16_To_Float(Q.Tex[j]) * Decode.TexScale[j] + Decode.TexOffset[j] - Tex[j];
+			TexError += d * d;
+		}
+
+		PosError = sqrtf(PosError);
+		TexError = sqrtf(TexError);
+
+		if (PosError > Error.MaxPosError) Error.MaxPosError = PosError;
+		if (TexError > Error.MaxTexError) Error.MaxTexError = TexError;
+	}
+}
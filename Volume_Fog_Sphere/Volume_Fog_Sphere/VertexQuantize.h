@@ -0,0 +1,50 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Vertex Quantization
+//======================================================================================
+
+#ifndef _VERTEXQUANTIZE_
+#define _VERTEXQUANTIZE_
+
+#include <cstdint>
+#include <cstddef>
+
+//position and uv of text mesh vertex packed for VertexLayoutPosTexQ
+//(see VertexLayout.h), 12 bytes instead of 20
+struct QuantizedVertex
+{
+	//snorm16 relative to the mesh bounds, w is 0
+	int16_t Pos[4];
+	//unorm16 relative to the uv bounds
+	uint16_t Tex[2];
+};
+
+//value = encoded * Scale + Offset, goes to the shader
+struct VertexDequantize
+{
+	float PosScale[3] = { 1.0f, 1.0f, 1.0f };
+	float PosOffset[3] = { 0.0f, 0.0f, 0.0f };
+	float TexScale[2] = { 1.0f, 1.0f };
+	float TexOffset[2] = { 0.0f, 0.0f };
+};
+
+//largest distance between source and decoded value
+struct VertexQuantizeError
+{
+	float MaxPosError = 0.0f;
+	float MaxTexError = 0.0f;
+};
+
+int16_t QuantizeSnorm16(float v);
+uint16_t QuantizeUnorm16(float v);
+uint16_t QuantizeHalf(float v);
+
+//octahedral normal encoding, Normal must be unit length
+void EncodeOctahedral(const float* Normal, int16_t* Oct);
+void DecodeOctahedral(const int16_t* Oct, float* Normal);
+
+//Vertices - 3 position and 2 uv floats per vertex as TextMeshParser outputs
+void QuantizePosTex(const float* Vertices, uint32_t VertexCount,
+	const float* BoundsMin, const float* BoundsMax,
+	QuantizedVertex* Dst, VertexDequantize& Decode, VertexQuantizeError& Error);
+
+#endif
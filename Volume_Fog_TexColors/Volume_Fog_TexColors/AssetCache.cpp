@@ -0,0 +1,149 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Asset Cache
+//======================================================================================
+
+#include "AssetCache.h"
+
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <errno.h>
+#include <sys/stat.h>
+#endif
+
+#define XXH_PRIME1 11400714785074694791ULL
+#define XXH_PRIME2 14029467366897019727ULL
+#define XXH_PRIME3 1609587929392839161ULL
+#define XXH_PRIME4 9650029242287828579ULL
+#define XXH_PRIME5 2870177450012600261ULL
+
+static uint64_t Rotl64(uint64_t x, int r)
+{
+	return (x << r) | (x >> (64 - r));
+}
+
+static uint64_t Read_U64(const unsigned char* p)
+{
+	uint64_t v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static uint32_t Read_U32(const unsigned char* p)
+{
+	uint32_t v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static uint64_t Xxh_Round(uint64_t Acc, uint64_t Input)
+{
+	Acc += Input * XXH_PRIME2;
+	Acc = Rotl64(Acc, 31);
+	return Acc * XXH_PRIME1;
+}
+
+static uint64_t Xxh_Merge(uint64_t Acc, uint64_t Value)
+{
+	Acc ^= Xxh_Round(0, Value);
+	return Acc * XXH_PRIME1 + XXH_PRIME4;
+}
+
+uint64_t HashBytes(const void* Data, size_t Size, uint64_t Seed)
+{
+	const unsigned char* p = (const unsigned char*)Data;
+	const unsigned char* End = p + Size;
+
+	uint64_t h;
+
+	if (Size >= 32)
+	{
+		//four lanes over 32 byte stripes
+		uint64_t v1 = Seed + XXH_PRIME1 + XXH_PRIME2;
+		uint64_t v2 = Seed + XXH_PRIME2;
+		uint64_t v3 = Seed;
+		uint64_t v4 = Seed - XXH_PRIME1;
+
+		const unsigned char* Limit = End - 32;
+
+		do
+		{
+			v1 = Xxh_Round(v1, Read_U64(p));
+			v2 = Xxh_Round(v2, Read_U64(p + 8));
+			v3 = Xxh_Round(v3, Read_U64(p + 16));
+			v4 = Xxh_Round(v4, Read_U64(p + 24));
+			p += 32;
+		} while (p <= Limit);
+
+		h = Rotl64(v1, 1) + Rotl64(v2, 7) + Rotl64(v3, 12) + Rotl64(v4, 18);
+		h = Xxh_Merge(h, v1);
+		h = Xxh_Merge(h, v2);
+		h = Xxh_Merge(h, v3);
+		h = Xxh_Merge(h, v4);
+	}
+	else
+	{
+		h = Seed + XXH_PRIME5;
+	}
+
+	h += (uint64_t)Size;
+
+	for (; p + 8 <= End; p += 8)
+		h = Rotl64(h ^ Xxh_Round(0, Read_U64(p)), 27) * XXH_PRIME1 + XXH_PRIME4;
+
+	if (p + 4 <= End)
+	{
+		h = Rotl64(h ^ (Read_U32(p) * XXH_PRIME1), 23) * XXH_PRIME2 + XXH_PRIME3;
+		p += 4;
+	}
+
+	for (; p < End; p++)
+		h = Rotl64(h ^ (*p * XXH_PRIME5), 11) * XXH_PRIME1;
+
+	h ^= h >> 33;
+	h *= XXH_PRIME2;
+	h ^= h >> 29;
+	h *= XXH_PRIME3;
+	h ^= h >> 32;
+
+	return h;
+}
+
+uint64_t AssetCacheKey(const void* Source, size_t SourceSize, const void* Options, size_t OptionsSize)
+{
+	return HashBytes(Source, SourceSize, HashBytes(Options, OptionsSize));
+}
+
+std::string AssetCachePath(const char* Dir, const char* Name, uint64_t Key, const char* Ext)
+{
+	char KeyText[17];
+	snprintf(KeyText, sizeof(KeyText), "%016llx", (unsigned long long)Key);
+
+	return std::string(Dir) + "/" + Name + "-" + KeyText + "." + Ext;
+}
+
+bool CreateAssetCacheDir(const char* Dir)
+{
+#ifdef _WIN32
+	return CreateDirectoryA(Dir, NULL) || GetLastError() == ERROR_ALREADY_EXISTS;
+#else
+	return mkdir(Dir, 0755) == 0 || errno == EEXIST;
+#endif
+}
+
+bool CommitCacheFile(const char* TempFileName, const char* FileName)
+{
+#ifdef _WIN32
+	bool Result = MoveFileExA(TempFileName, FileName, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+	bool Result = rename(TempFileName, FileName) == 0;
+#endif
+
+	if (!Result)
+		remove(TempFileName);
+
+	return Result;
+}
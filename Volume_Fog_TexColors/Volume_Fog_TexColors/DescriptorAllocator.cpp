@@ -0,0 +1,89 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Descriptor Allocator
+//======================================================================================
+
+#include "DescriptorAllocator.h"
+
+#include <iterator>
+
+void CDescriptorAllocator::Init(uint32_t PersistentCount, uint32_t TransientCount)
+{
+	m_PersistentCount = PersistentCount;
+	m_PersistentUsed = 0;
+
+	m_FreeRanges.clear();
+	if (PersistentCount != 0)
+		m_FreeRanges[0] = PersistentCount;
+
+	m_Ring.Init(TransientCount);
+}
+
+bool CDescriptorAllocator::Allocate(uint32_t Count, uint32_t& Index)
+{
+	if (Count == 0)
+		return false;
+
+	for (auto It = m_FreeRanges.begin(); It != m_FreeRanges.end(); ++It)
+	{
+		if (It->second < Count)
+			continue;
+
+		Index = It->first;
+
+		uint32_t Left = It->second - Count;
+		m_FreeRanges.erase(It);
+
+		if (Left != 0)
+			m_FreeRanges[Index + Count] = Left;
+
+		m_PersistentUsed += Count;
+
+		return true;
+	}
+
+	return false;
+}
+
+void CDescriptorAllocator::Free(uint32_t Index, uint32_t Count)
+{
+	if (Count == 0)
+		return;
+
+	m_PersistentUsed -= Count;
+
+	auto Next = m_FreeRanges.lower_bound(Index);
+
+	//merge with the free range that ends at Index
+	if (Next != m_FreeRanges.begin())
+	{
+		auto Prev = std::prev(Next);
+
+		if (Prev->first + Prev->second == Index)
+		{
+			Index = Prev->first;
+			Count += Prev->second;
+			m_FreeRanges.erase(Prev);
+		}
+	}
+
+	//and with the one that starts where this one ends
+	if (Next != m_FreeRanges.end() && Next->first == Index + Count)
+	{
+		Count += Next->second;
+		m_FreeRanges.erase(Next);
+	}
+
+	m_FreeRanges[Index] = Count;
+}
+
+bool CDescriptorAllocator::Allocate_Transient(uint32_t Count, uint32_t& Index)
+{
+	uint64_t Offset = 0;
+
+	if (!m_Ring.Allocate(Count, 1, Offset))
+		return false;
+
+	Index = m_PersistentCount + (uint32_t)Offset;
+
+	return true;
+}
@@ -0,0 +1,149 @@
+//======================================================================================
+//	Ed Kurlyak 2023 GPU Fence DirectX12
+//======================================================================================
+
+#include "GpuFence.h"
+#include "Profiler.h"
+
+#include <cassert>
+#include <chrono>
+#include <vector>
+
+CGpuFence::~CGpuFence()
+{
+	if (m_Event != nullptr)
+		CloseHandle(m_Event);
+}
+
+void CGpuFence::Init(ID3D12Device* Device)
+{
+	ThrowIfFailed(Device->CreateFence(0, D3D12_FENCE_FLAG_NONE,
+		IID_PPV_ARGS(&m_Fence)));
+
+	//auto reset, every SetEventOnCompletion is followed by a wait
+	m_Event = CreateEventEx(nullptr, nullptr, 0, EVENT_ALL_ACCESS);
+	if (m_Event == nullptr)
+		ThrowIfFailed(HRESULT_FROM_WIN32(GetLastError()));
+
+	m_LastSignaled = 0;
+	m_LastCompleted = 0;
+}
+
+UINT64 CGpuFence::Signal(ID3D12CommandQueue* Queue)
+{
+	m_LastSignaled++;
+
+	ThrowIfFailed(Queue->Signal(m_Fence.Get(), m_LastSignaled));
+
+	return m_LastSignaled;
+}
+
+void CGpuFence::Gpu_Wait(ID3D12CommandQueue* Queue, UINT64 Value)
+{
+	if (Value <= m_LastCompleted)
+		return;
+
+	ThrowIfFailed(Queue->Wait(m_Fence.Get(), Value));
+}
+
+UINT64 CGpuFence::Completed_Value()
+{
+	m_LastCompleted = m_Fence->GetCompletedValue();
+
+	return m_LastCompleted;
+}
+
+bool CGpuFence::IsComplete(UINT64 Value)
+{
+	if (Value <= m_LastCompleted)
+		return true;
+
+	return Value <= Completed_Value();
+}
+
+void CGpuFence::Wait(UINT64 Value)
+{
+	if (IsComplete(Value))
+		return;
+
+	PROFILE_SCOPE("Fence Wait");
+
+	auto WaitStart = std::chrono::steady_clock::now();
+
+	ThrowIfFailed(m_Fence->SetEventOnCompletion(Value, m_Event));
+
+	if (WaitForSingleObject(m_Event, INFINITE) != WAIT_OBJECT_0)
+		ThrowIfFailed(HRESULT_FROM_WIN32(GetLastError()));
+
+	std::chrono::duration<double, std::milli> WaitTime = std::chrono::steady_clock::now() - WaitStart;
+	Add_Blocked_Time(WaitTime.count());
+
+	Completed_Value();
+}
+
+void CGpuFence::Flush(ID3D12CommandQueue* Queue)
+{
+	Wait(Signal(Queue));
+}
+
+void CGpuFence::Wait_All(CGpuFence* const* Fences, const UINT64* Values, UINT Count)
+{
+	//WaitForMultipleObjects fails at once on a handle given twice
+	//or on more than MAXIMUM_WAIT_OBJECTS handles
+	assert(Count <= MAXIMUM_WAIT_OBJECTS);
+
+	std::vector<HANDLE> Events;
+	std::vector<CGpuFence*> Pending;
+
+	for (UINT i = 0; i < Count; i++)
+	{
+		for (UINT j = 0; j < i; j++)
+			assert(Fences[j] != Fences[i]);
+
+		if (Fences[i]->IsComplete(Values[i]))
+			continue;
+
+		ThrowIfFailed(Fences[i]->m_Fence->SetEventOnCompletion(Values[i], Fences[i]->m_Event));
+
+		Events.push_back(Fences[i]->m_Event);
+		Pending.push_back(Fences[i]);
+	}
+
+	if (Events.empty())
+		return;
+
+	PROFILE_SCOPE("Fence Wait All");
+
+	auto WaitStart = std::chrono::steady_clock::now();
+
+	//with bWaitAll any WAIT_OBJECT_0 + i means all are signaled,
+	//on anything else the fences are not done, so no stats either
+	DWORD Result = WaitForMultipleObjects((DWORD)Events.size(), Events.data(), TRUE, INFINITE);
+
+	if (Result >= WAIT_OBJECT_0 + Events.size())
+		ThrowIfFailed(Result == WAIT_FAILED ? HRESULT_FROM_WIN32(GetLastError()) : E_FAIL);
+
+	std::chrono::duration<double, std::milli> WaitTime = std::chrono::steady_clock::now() - WaitStart;
+
+	for (CGpuFence* Fence : Pending)
+	{
+		Fence->Add_Blocked_Time(WaitTime.count());
+		Fence->Completed_Value();
+	}
+}
+
+void CGpuFence::Reset_Stats()
+{
+	m_BlockedTime = 0.0;
+	m_MaxBlockedTime = 0.0;
+	m_BlockedCount = 0;
+}
+
+void CGpuFence::Add_Blocked_Time(double Time)
+{
+	m_BlockedTime += Time;
+	m_BlockedCount++;
+
+	if (Time > m_MaxBlockedTime)
+		m_MaxBlockedTime = Time;
+}
@@ -36,6 +36,14 @@ LRESULT CMyApp::WndProc(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
 			PostQuitMessage(0);
 			break;
 
+		case WM_KEYDOWN:
+			//first press only, not the key repeat
+			if (wParam == VK_F9 && !(lParam & 0x40000000))
+				m_MeshManager.Export_Frame_Stats();
+			if (wParam == VK_F8 && !(lParam & 0x40000000))
+				CProfiler::Write_Trace(PROFILER_TRACE_FILE);
+			break;
+
 		default:
 			return DefWindowProc(hWnd, uMsg, wParam, lParam);
 	}
@@ -0,0 +1,61 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Profiler
+//======================================================================================
+
+#ifndef _PROFILER_
+#define _PROFILER_
+
+#include <cstdint>
+
+//comment out to compile every PROFILE_ marker away
+#define PROFILER_ENABLED
+
+//events kept per thread, older ones are overwritten
+#define PROFILER_RING_SIZE 8192
+#define PROFILER_MAX_DEPTH 64
+
+//written at shutdown and on F8, open in chrome://tracing or Perfetto
+#define PROFILER_TRACE_FILE "profile_trace.json"
+
+//scoped CPU markers, each thread writes its own ring with no
+//locks, names must be string literals or otherwise outlive
+//the export, PIX events are emitted when pix3.h is available
+class CProfiler
+{
+public:
+	static void Begin(const char* Name);
+	static void End();
+
+	//name of the calling thread in the trace, kept by pointer
+	static void Set_Thread_Name(const char* Name);
+
+	//Chrome trace_event JSON of every thread, best taken while
+	//the markers are idle, false when nothing was recorded
+	//or the file can not be opened
+	static bool Write_Trace(const char* FileName);
+};
+
+class CProfileScope
+{
+public:
+	explicit CProfileScope(const char* Name) { CProfiler::Begin(Name); }
+	~CProfileScope() { CProfiler::End(); }
+
+	CProfileScope(const CProfileScope& rhs) = delete;
+	CProfileScope& operator=(const CProfileScope& rhs) = delete;
+};
+
+#define PROFILE_JOIN_INNER(a, b) a##b
+#define PROFILE_JOIN(a, b) PROFILE_JOIN_INNER(a, b)
+
+#ifdef PROFILER_ENABLED
+#define PROFILE_SCOPE(Name) CProfileScope PROFILE_JOIN(ProfileScope, __LINE__)(Name)
+#define PROFILE_THREAD_NAME(Name) CProfiler::Set_Thread_Name(Name)
+#else
+#define PROFILE_SCOPE(Name)
+#define PROFILE_THREAD_NAME(Name)
+#endif
+
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__FUNCTION__)
+
+#endif
@@ -0,0 +1,145 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Render Graph
+//======================================================================================
+
+#ifndef _RENDERGRAPH_
+#define _RENDERGRAPH_
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#define RG_INVALID 0xffffffff
+
+//API neutral resource states, the device side maps them
+enum RGState
+{
+	RG_STATE_COMMON,
+	RG_STATE_RENDER_TARGET,
+	RG_STATE_DEPTH_WRITE,
+	RG_STATE_DEPTH_READ,
+	RG_STATE_SHADER_READ,
+	RG_STATE_COPY_SOURCE,
+	RG_STATE_COPY_DEST,
+	RG_STATE_PRESENT,
+	//Before of the first barrier of an import, the owner
+	//of the resource knows its state
+	RG_STATE_UNKNOWN
+};
+
+struct RGBarrier
+{
+	uint32_t Resource;
+	//an aliasing barrier makes Resource the owner of memory
+	//other resources used earlier in the frame, Before and
+	//After are not used then
+	bool Aliasing;
+	RGState Before;
+	RGState After;
+};
+
+//passes run in the order they are added and declare what
+//they read and write, Compile culls passes nothing needs,
+//gives each pass its barriers and places transient textures
+//in one heap, textures that are never alive at the same time
+//share memory, so the first pass writing a transient must
+//clear or discard it, no device calls, so it runs anywhere
+class CRenderGraph
+{
+public:
+	//Size and Alignment as the device reports them
+	uint32_t Create_Texture(const char* Name, uint64_t Size, uint64_t Alignment);
+
+	//lives outside the graph and its state is kept by the owner,
+	//the first barrier of a frame moves it from whatever state it
+	//is in, Final is where the frame leaves it, a pass writing it
+	//is never culled
+	uint32_t Import(const char* Name, RGState Final);
+
+	uint32_t Add_Pass(const char* Name, std::function<void()> Execute);
+
+	void Read(uint32_t Pass, uint32_t Resource, RGState State);
+	void Write(uint32_t Pass, uint32_t Resource, RGState State);
+
+	//false when a pass needs one resource in two states
+	bool Compile();
+
+	//Barriers gets each pass batch before the pass runs and
+	//the batch that puts imports back at the end
+	void Execute(const std::function<void(const RGBarrier* Barriers, uint32_t Count)>& Barriers) const;
+
+	uint32_t Pass_Count() const { return (uint32_t)m_Passes.size(); }
+	uint32_t Resource_Count() const { return (uint32_t)m_Resources.size(); }
+
+	bool Is_Culled(uint32_t Pass) const { return m_Passes[Pass].Culled; }
+	uint32_t Culled_Count() const;
+	const std::vector<RGBarrier>& Pass_Barriers(uint32_t Pass) const { return m_Passes[Pass].Barriers; }
+	const std::vector<RGBarrier>& Final_Barriers() const { return m_FinalBarriers; }
+
+	bool Is_Imported(uint32_t Resource) const { return m_Resources[Resource].Imported; }
+	//transient textures with at least one pass left after culling
+	bool Is_Allocated(uint32_t Resource) const { return m_Resources[Resource].Allocated; }
+	uint64_t Offset(uint32_t Resource) const { return m_Resources[Resource].Offset; }
+	//state to create a transient in, the last one it is used in
+	//each frame, so every frame starts the same way
+	RGState Create_State(uint32_t Resource) const { return m_Resources[Resource].LastState; }
+	const char* Name(uint32_t Resource) const { return m_Resources[Resource].Name.c_str(); }
+
+	uint64_t Heap_Size() const { return m_HeapSize; }
+	uint64_t Heap_Alignment() const { return m_HeapAlignment; }
+	//what the transients would take without aliasing
+	uint64_t Unaliased_Size() const { return m_UnaliasedSize; }
+
+private:
+	struct Access
+	{
+		uint32_t Resource;
+		RGState State;
+		bool Write;
+	};
+
+	struct Pass
+	{
+		std::string Name;
+		std::function<void()> Execute;
+		std::vector<Access> Accesses;
+
+		bool Culled = false;
+		std::vector<RGBarrier> Barriers;
+	};
+
+	struct Resource
+	{
+		std::string Name;
+		bool Imported = false;
+		uint64_t Size = 0;
+		uint64_t Alignment = 1;
+		RGState Final = RG_STATE_COMMON;
+
+		//filled by Compile, first and last alive pass
+		uint32_t First = RG_INVALID;
+		uint32_t Last = RG_INVALID;
+		bool Allocated = false;
+		bool Aliased = false;
+		uint64_t Offset = 0;
+		RGState LastState = RG_STATE_COMMON;
+	};
+
+	void Add_Access(uint32_t Pass, uint32_t Resource, RGState State, bool Write);
+
+	void Cull_Passes();
+	void Find_Lifetimes();
+	void Place_Transients();
+	void Build_Barriers();
+
+	std::vector<Pass> m_Passes;
+	std::vector<Resource> m_Resources;
+	std::vector<RGBarrier> m_FinalBarriers;
+
+	uint64_t m_HeapSize = 0;
+	uint64_t m_HeapAlignment = 1;
+	uint64_t m_UnaliasedSize = 0;
+};
+
+#endif
@@ -0,0 +1,240 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Resource State Tracker DirectX12
+//======================================================================================
+
+#include "ResourceStateTracker.h"
+
+//states a resource may hold at once, all read only
+static const D3D12_RESOURCE_STATES g_ReadStates =
+	D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER |
+	D3D12_RESOURCE_STATE_INDEX_BUFFER |
+	D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE |
+	D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE |
+	D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT |
+	D3D12_RESOURCE_STATE_COPY_SOURCE |
+	D3D12_RESOURCE_STATE_DEPTH_READ;
+
+void CResourceStateTracker::Register(ID3D12Resource* Resource, D3D12_RESOURCE_STATES State, UINT Subresources)
+{
+	ResourceState& Entry = m_Resources[Resource];
+	Entry.State = State;
+	Entry.Subresources = Subresources;
+	Entry.PerSubresource.clear();
+}
+
+void CResourceStateTracker::Unregister(ID3D12Resource* Resource)
+{
+	m_Resources.erase(Resource);
+
+	//a released resource must not reach the command list
+	for (size_t i = 0; i < m_Pending.size();)
+	{
+		if (Names_Resource(m_Pending[i], Resource))
+			m_Pending.erase(m_Pending.begin() + i);
+		else
+			i++;
+	}
+}
+
+bool CResourceStateTracker::Names_Resource(const D3D12_RESOURCE_BARRIER& Barrier, ID3D12Resource* Resource)
+{
+	if (Barrier.Type == D3D12_RESOURCE_BARRIER_TYPE_ALIASING)
+		return Barrier.Aliasing.pResourceAfter == Resource;
+
+	return Barrier.Transition.pResource == Resource;
+}
+
+bool CResourceStateTracker::Is_Satisfied(D3D12_RESOURCE_STATES Current, D3D12_RESOURCE_STATES Required)
+{
+	if (Current == Required)
+		return true;
+
+	//a read state already part of a combined read state
+	if (Required != 0 && (Required & ~g_ReadStates) == 0 && (Current & ~g_ReadStates) == 0)
+		return (Current & Required) == Required;
+
+	return false;
+}
+
+void CResourceStateTracker::Transition(ID3D12Resource* Resource, D3D12_RESOURCE_STATES State, UINT Subresource)
+{
+	auto It = m_Resources.find(Resource);
+	assert(It != m_Resources.end() && "resource is not registered");
+	if (It == m_Resources.end())
+		return;
+
+	ResourceState& Entry = It->second;
+
+	if (Subresource == D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES)
+	{
+		if (Entry.PerSubresource.empty())
+		{
+			if (Is_Satisfied(Entry.State, State))
+			{
+				m_DroppedCount++;
+				return;
+			}
+
+			Add_Barrier(Resource, Subresource, Entry.State, State);
+		}
+		else
+		{
+			//subresources went apart, each one moves on its own
+			for (UINT i = 0; i < Entry.Subresources; i++)
+			{
+				if (Entry.PerSubresource[i] != State)
+					Add_Barrier(Resource, i, Entry.PerSubresource[i], State);
+			}
+
+			Entry.PerSubresource.clear();
+		}
+
+		Entry.State = State;
+		return;
+	}
+
+	assert(Subresource < Entry.Subresources);
+	if (Subresource >= Entry.Subresources)
+		return;
+
+	//the only subresource is the whole resource, so its
+	//barriers fold with whole resource ones
+	if (Entry.Subresources == 1)
+	{
+		Transition(Resource, State);
+		return;
+	}
+
+	D3D12_RESOURCE_STATES Current = Entry.PerSubresource.empty() ?
+		Entry.State : Entry.PerSubresource[Subresource];
+
+	if (Is_Satisfied(Current, State))
+	{
+		m_DroppedCount++;
+		return;
+	}
+
+	Add_Barrier(Resource, Subresource, Current, State);
+
+	if (Entry.PerSubresource.empty())
+		Entry.PerSubresource.assign(Entry.Subresources, Entry.State);
+
+	Entry.PerSubresource[Subresource] = State;
+
+	//back to one state for the whole resource
+	for (UINT i = 0; i < Entry.Subresources; i++)
+	{
+		if (Entry.PerSubresource[i] != State)
+			return;
+	}
+
+	Entry.PerSubresource.clear();
+	Entry.State = State;
+}
+
+void CResourceStateTracker::Add_Barrier(ID3D12Resource* Resource, UINT Subresource,
+	D3D12_RESOURCE_STATES Before, D3D12_RESOURCE_STATES After)
+{
+	//a second move of the same subresource before Flush folds
+	//into the last barrier that touched it, or cancels it, a
+	//whole resource barrier and a subresource one stay apart
+	for (size_t i = m_Pending.size(); i-- > 0;)
+	{
+		if (!Names_Resource(m_Pending[i], Resource))
+			continue;
+
+		if (m_Pending[i].Type != D3D12_RESOURCE_BARRIER_TYPE_TRANSITION)
+			break;
+
+		D3D12_RESOURCE_TRANSITION_BARRIER& Pending = m_Pending[i].Transition;
+
+		if (Pending.Subresource != Subresource &&
+			Pending.Subresource != D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES &&
+			Subresource != D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES)
+			continue;
+
+		if (Pending.Subresource != Subresource)
+			break;
+
+		assert(Pending.StateAfter == Before);
+
+		if (Pending.StateBefore == After)
+		{
+			m_Pending.erase(m_Pending.begin() + i);
+			m_DroppedCount += 2;
+		}
+		else
+		{
+			Pending.StateAfter = After;
+			m_DroppedCount++;
+		}
+
+		return;
+	}
+
+	D3D12_RESOURCE_BARRIER Barrier = {};
+	Barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+	Barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+	Barrier.Transition.pResource = Resource;
+	Barrier.Transition.Subresource = Subresource;
+	Barrier.Transition.StateBefore = Before;
+	Barrier.Transition.StateAfter = After;
+
+	m_Pending.push_back(Barrier);
+}
+
+void CResourceStateTracker::Aliasing(ID3D12Resource* Resource)
+{
+	assert(m_Resources.find(Resource) != m_Resources.end() && "resource is not registered");
+
+	//no before resource, any placed resource sharing the
+	//memory may have been used last
+	D3D12_RESOURCE_BARRIER Barrier = {};
+	Barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_ALIASING;
+	Barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+	Barrier.Aliasing.pResourceBefore = nullptr;
+	Barrier.Aliasing.pResourceAfter = Resource;
+
+	m_Pending.push_back(Barrier);
+}
+
+D3D12_RESOURCE_STATES CResourceStateTracker::State(ID3D12Resource* Resource, UINT Subresource) const
+{
+	auto It = m_Resources.find(Resource);
+	assert(It != m_Resources.end() && "resource is not registered");
+	if (It == m_Resources.end())
+		return D3D12_RESOURCE_STATE_COMMON;
+
+	const ResourceState& Entry = It->second;
+
+	if (Entry.PerSubresource.empty() || Subresource >= Entry.Subresources)
+		return Entry.State;
+
+	return Entry.PerSubresource[Subresource];
+}
+
+void CResourceStateTracker::Assert_State(ID3D12Resource* Resource, D3D12_RESOURCE_STATES State) const
+{
+#if defined(DEBUG) || defined(_DEBUG)
+	auto It = m_Resources.find(Resource);
+	assert(It != m_Resources.end() && "resource is not registered");
+	if (It == m_Resources.end())
+		return;
+
+	const ResourceState& Entry = It->second;
+
+	assert(Entry.State == State && "resource state mismatch");
+	for (D3D12_RESOURCE_STATES Sub : Entry.PerSubresource)
+		assert(Sub == State && "subresource state mismatch");
+#else
+	(void)Resource;
+	(void)State;
+#endif
+}
+
+void CResourceStateTracker::Reset_Stats()
+{
+	m_BarrierCount = 0;
+	m_BatchCount = 0;
+	m_DroppedCount = 0;
+}
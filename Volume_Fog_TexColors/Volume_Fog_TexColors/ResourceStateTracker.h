@@ -0,0 +1,90 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Resource State Tracker DirectX12
+//======================================================================================
+
+#ifndef _RESOURCESTATETRACKER_
+#define _RESOURCESTATETRACKER_
+
+#include <d3d12.h>
+
+#include <cassert>
+#include <unordered_map>
+#include <vector>
+
+//known state of every registered resource, per subresource
+//once they differ, Transition only records the barrier and
+//drops it when the state is already right, Flush issues all
+//pending barriers in one ResourceBarrier call, the state
+//follows recording order, one queue runs the lists in order
+class CResourceStateTracker
+{
+public:
+	void Register(ID3D12Resource* Resource, D3D12_RESOURCE_STATES State, UINT Subresources = 1);
+	void Unregister(ID3D12Resource* Resource);
+
+	void Transition(ID3D12Resource* Resource, D3D12_RESOURCE_STATES State,
+		UINT Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES);
+
+	//records an aliasing barrier that makes the placed Resource
+	//the owner of its heap memory, goes out in order with the
+	//transitions, barriers of Resource never fold across it
+	void Aliasing(ID3D12Resource* Resource);
+
+	//state after the pending barriers
+	D3D12_RESOURCE_STATES State(ID3D12Resource* Resource, UINT Subresource = 0) const;
+
+	//asserts in debug builds the resource is in State, for the
+	//places that hand the resource to something outside the tracker
+	void Assert_State(ID3D12Resource* Resource, D3D12_RESOURCE_STATES State) const;
+
+	//call right before a draw, clear or copy, any command
+	//list with ResourceBarrier(UINT, const D3D12_RESOURCE_BARRIER*)
+	template<class CommandList>
+	void Flush(CommandList* List);
+
+	UINT Pending_Count() const { return (UINT)m_Pending.size(); }
+
+	//barriers issued, ResourceBarrier calls and dropped transitions
+	UINT Barrier_Count() const { return m_BarrierCount; }
+	UINT Batch_Count() const { return m_BatchCount; }
+	UINT Dropped_Count() const { return m_DroppedCount; }
+	void Reset_Stats();
+
+private:
+	struct ResourceState
+	{
+		D3D12_RESOURCE_STATES State;
+		UINT Subresources;
+		//empty while every subresource is in State
+		std::vector<D3D12_RESOURCE_STATES> PerSubresource;
+	};
+
+	void Add_Barrier(ID3D12Resource* Resource, UINT Subresource,
+		D3D12_RESOURCE_STATES Before, D3D12_RESOURCE_STATES After);
+
+	static bool Names_Resource(const D3D12_RESOURCE_BARRIER& Barrier, ID3D12Resource* Resource);
+	static bool Is_Satisfied(D3D12_RESOURCE_STATES Current, D3D12_RESOURCE_STATES Required);
+
+	std::unordered_map<ID3D12Resource*, ResourceState> m_Resources;
+	std::vector<D3D12_RESOURCE_BARRIER> m_Pending;
+
+	UINT m_BarrierCount = 0;
+	UINT m_BatchCount = 0;
+	UINT m_DroppedCount = 0;
+};
+
+template<class CommandList>
+void CResourceStateTracker::Flush(CommandList* List)
+{
+	if (m_Pending.empty())
+		return;
+
+	List->ResourceBarrier((UINT)m_Pending.size(), m_Pending.data());
+
+	m_BarrierCount += (UINT)m_Pending.size();
+	m_BatchCount++;
+
+	m_Pending.clear();
+}
+
+#endif
@@ -4,32 +4,43 @@
 
 #include "Timer.h"
 
+#include <stdio.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
 int CTimer::CalculateFPS()
 {
-	QueryPerformanceCounter((LARGE_INTEGER *)&m_CurrentTime);
-
-	float TimeElapsed; 
-	
-	TimeElapsed = (m_CurrentTime - m_LastTime) * m_TimeScale;
+	m_CurrentTime = m_Clock->Ticks();
 
 	if(m_LimitFPS > 0.0f)
 	{
-	while ( TimeElapsed < (1.0f / m_LimitFPS))
-        {
-		    QueryPerformanceCounter((LARGE_INTEGER*)&m_CurrentTime);
-		    //     
-	        TimeElapsed = (m_CurrentTime - m_LastTime) * m_TimeScale;
-        }
+		//sleeps most of the frame, spins only the last part
+		m_Pacer.Wait(1.0 / m_LimitFPS - To_Seconds(m_CurrentTime - m_LastTime));
+
+		m_CurrentTime = m_Clock->Ticks();
 	}
+
+	int64_t FrameTicks = m_CurrentTime - m_LastTime;
 	m_LastTime = m_CurrentTime;
 
+	m_FrameStats.Record(To_Microseconds(FrameTicks));
+
 	m_FPSFrameCount++;
-	m_FPSTimeElapsed += TimeElapsed;
-	if ( m_FPSTimeElapsed > 1.0f) 
+	m_FPSTicks += FrameTicks;
+	if ( m_FPSTicks > m_PerfFreq) 
     {
 	m_FrameRate			= m_FPSFrameCount;
 	m_FPSFrameCount		= 0;
-	m_FPSTimeElapsed	= 0.0f;
+	m_FPSTicks			= 0;
+	}
+
+	m_PacerLogTicks += FrameTicks;
+	if (m_LimitFPS > 0.0f && m_PacerLogTicks > FRAME_PACER_LOG_SECONDS * m_PerfFreq)
+	{
+		Log_Pacer_Stats();
+		m_PacerLogTicks = 0;
 	}
    	
 	return m_FrameRate;
@@ -39,42 +50,92 @@ void CTimer::TimerStart(float LimitFPS)
 {
 	m_LimitFPS = LimitFPS;
 
-	QueryPerformanceFrequency((LARGE_INTEGER *)&m_PerfFreq);
-	QueryPerformanceCounter((LARGE_INTEGER *) &m_LastTime); 
+	m_PerfFreq = m_Clock->Frequency();
+	m_LastTime = m_Clock->Ticks();
 	m_StartTime= m_LastTime;
 	m_AppStartTime= m_LastTime;
-			
-	m_TimeScale			= 1.0f / m_PerfFreq;
 
 	m_FrameRate			= 0;
 	m_FPSFrameCount		= 0;
-	m_FPSTimeElapsed	= 0.0f;
+	m_FPSTicks			= 0;
 
+	m_PacerLogTicks = 0;
+	m_Pacer.Reset_Stats();
+
+	float BudgetFPS = LimitFPS > 0.0f ? LimitFPS : FRAME_BUDGET_FPS;
+	m_FrameStats.Reset();
+	m_FrameStats.Set_Budget((int64_t)(1000000.0f / BudgetFPS) + FRAME_BUDGET_SLACK_US);
 }
 
-float CTimer::GetAbsoluteTime()
+double CTimer::To_Seconds(int64_t Ticks) const
 {
-	__int64 nowTime;
-    QueryPerformanceCounter((LARGE_INTEGER*)&nowTime);
-	m_AbsoluteTime = nowTime * m_TimeScale;
-    return (FLOAT) m_AbsoluteTime;
+	return CMonotonicClock::To_Seconds(Ticks, m_PerfFreq);
 }
 
-float CTimer::GetAppTime()
+int64_t CTimer::To_Microseconds(int64_t Ticks) const
 {
-	__int64 nowTime;
-    QueryPerformanceCounter((LARGE_INTEGER*)&nowTime);
-	m_AppTime = ((nowTime - m_AppStartTime)*m_TimeScale);
+	return CMonotonicClock::To_Microseconds(Ticks, m_PerfFreq);
+}
+
+double CTimer::GetAbsoluteTime()
+{
+	m_AbsoluteTime = To_Seconds(m_Clock->Ticks());
+    return m_AbsoluteTime;
+}
+
+double CTimer::GetAppTime()
+{
+	m_AppTime = To_Seconds(m_Clock->Ticks() - m_AppStartTime);
     return  m_AppTime;
 
 }
 
 float CTimer::GetElaspedTime()
 {
-	__int64 nowTime;
-	QueryPerformanceCounter((LARGE_INTEGER*)&nowTime);
-	m_ElapsedTime = (nowTime - m_StartTime)*m_TimeScale;
+	int64_t nowTime = m_Clock->Ticks();
+	//a frame delta is small, float is enough here
+	m_ElapsedTime = (float)To_Seconds(nowTime - m_StartTime);
 	m_StartTime=nowTime;
 	return m_ElapsedTime;
 
-}
\ No newline at end of file
+}
+
+void CTimer::Log_Pacer_Stats()
+{
+	const FramePacerStats& Stats = m_Pacer.Stats();
+	if (Stats.Waits == 0)
+		return;
+
+	char Buff[256];
+	snprintf(Buff, sizeof(Buff), "frame pacer: %u waits, error avg %.3f ms max %.3f ms, %u late, sleep %.1f ms spin %.1f ms, margin %.3f ms\n",
+		Stats.Waits, Stats.ErrorSum / Stats.Waits, Stats.ErrorMax, Stats.LateWaits,
+		Stats.SleepTime, Stats.SpinTime, m_Pacer.Spin_Margin());
+#ifdef _WIN32
+	OutputDebugStringA(Buff);
+#else
+	fputs(Buff, stderr);
+#endif
+
+	m_Pacer.Reset_Stats();
+}
+
+void CTimer::Export_Frame_Stats()
+{
+	if (m_FrameStats.Count() == 0)
+		return;
+
+	char Buff[256];
+	snprintf(Buff, sizeof(Buff), "frame times: %llu frames, p50 %.2f ms p95 %.2f ms p99 %.2f ms max %.2f ms, %llu over budget\n",
+		(unsigned long long)m_FrameStats.Count(),
+		m_FrameStats.Percentile(50.0) / 1000.0, m_FrameStats.Percentile(95.0) / 1000.0,
+		m_FrameStats.Percentile(99.0) / 1000.0, m_FrameStats.Max() / 1000.0,
+		(unsigned long long)m_FrameStats.Over_Budget());
+#ifdef _WIN32
+	OutputDebugStringA(Buff);
+#else
+	fputs(Buff, stderr);
+#endif
+
+	m_FrameStats.Write_CSV(FRAME_STATS_CSV);
+	m_FrameStats.Write_JSON(FRAME_STATS_JSON);
+}
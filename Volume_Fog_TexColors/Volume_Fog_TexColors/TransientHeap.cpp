@@ -0,0 +1,137 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Transient Heap DirectX12
+//======================================================================================
+
+#include "TransientHeap.h"
+
+uint32_t CTransientHeap::Create_Texture(ID3D12Device* Device, CRenderGraph& Graph, const char* Name,
+	const D3D12_RESOURCE_DESC& Desc, const D3D12_CLEAR_VALUE* Clear)
+{
+	D3D12_RESOURCE_ALLOCATION_INFO Info = Device->GetResourceAllocationInfo(0, 1, &Desc);
+
+	uint32_t Id = Graph.Create_Texture(Name, Info.SizeInBytes, Info.Alignment);
+
+	Texture& Tex = Slot(Id);
+	Tex.Desc = Desc;
+	Tex.HasClear = Clear != nullptr;
+	if (Clear != nullptr)
+		Tex.Clear = *Clear;
+
+	return Id;
+}
+
+void CTransientHeap::Allocate(ID3D12Device* Device, const CRenderGraph& Graph, CResourceStateTracker& States)
+{
+	if (Graph.Heap_Size() == 0)
+		return;
+
+	//every transient is a render target or depth texture,
+	//so the heap works on resource heap tier 1 too
+	CD3DX12_HEAP_DESC HeapDesc(Graph.Heap_Size(), D3D12_HEAP_TYPE_DEFAULT,
+		Graph.Heap_Alignment(), D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES);
+
+	ThrowIfFailed(Device->CreateHeap(&HeapDesc, IID_PPV_ARGS(m_Heap.GetAddressOf())));
+
+	for (uint32_t Id = 0; Id < Graph.Resource_Count(); Id++)
+	{
+		if (!Graph.Is_Allocated(Id))
+			continue;
+
+		Texture& Tex = Slot(Id);
+
+		//made in the state of its last use, the barriers of
+		//every frame start from there
+		ThrowIfFailed(Device->CreatePlacedResource(
+			m_Heap.Get(),
+			Graph.Offset(Id),
+			&Tex.Desc,
+			D3D_State(Graph.Create_State(Id)),
+			Tex.HasClear ? &Tex.Clear : nullptr,
+			IID_PPV_ARGS(Tex.Resource.GetAddressOf())));
+
+		Tex.Placed = true;
+		States.Register(Tex.Resource.Get(), D3D_State(Graph.Create_State(Id)));
+	}
+}
+
+void CTransientHeap::Bind(uint32_t Id, ID3D12Resource* Resource)
+{
+	Slot(Id).Resource = Resource;
+}
+
+ID3D12Resource* CTransientHeap::Resource(uint32_t Id) const
+{
+	if (Id >= m_Textures.size())
+		return nullptr;
+
+	return m_Textures[Id].Resource.Get();
+}
+
+void CTransientHeap::Execute(const CRenderGraph& Graph, CResourceStateTracker& States, ID3D12GraphicsCommandList* CommandList)
+{
+	Graph.Execute([this, &States, CommandList](const RGBarrier* Barriers, uint32_t Count)
+	{
+		for (uint32_t i = 0; i < Count; i++)
+		{
+			ID3D12Resource* Res = Resource(Barriers[i].Resource);
+
+			if (Barriers[i].Aliasing)
+			{
+				States.Aliasing(Res);
+				continue;
+			}
+
+			//the graph knows the transients, they never leave it,
+			//an import comes in from the state its owner left it in
+			assert(Barriers[i].Before == RG_STATE_UNKNOWN ||
+				States.State(Res) == D3D_State(Barriers[i].Before));
+
+			States.Transition(Res, D3D_State(Barriers[i].After));
+		}
+
+		States.Flush(CommandList);
+	});
+}
+
+void CTransientHeap::Release(CResourceStateTracker& States)
+{
+	for (Texture& Tex : m_Textures)
+	{
+		if (Tex.Placed)
+			States.Unregister(Tex.Resource.Get());
+	}
+
+	m_Textures.clear();
+	m_Heap.Reset();
+}
+
+D3D12_RESOURCE_STATES CTransientHeap::D3D_State(RGState State)
+{
+	switch (State)
+	{
+	case RG_STATE_RENDER_TARGET:
+		return D3D12_RESOURCE_STATE_RENDER_TARGET;
+	case RG_STATE_DEPTH_WRITE:
+		return D3D12_RESOURCE_STATE_DEPTH_WRITE;
+	case RG_STATE_DEPTH_READ:
+		return D3D12_RESOURCE_STATE_DEPTH_READ;
+	case RG_STATE_SHADER_READ:
+		return D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
+	case RG_STATE_COPY_SOURCE:
+		return D3D12_RESOURCE_STATE_COPY_SOURCE;
+	case RG_STATE_COPY_DEST:
+		return D3D12_RESOURCE_STATE_COPY_DEST;
+	case RG_STATE_PRESENT:
+		return D3D12_RESOURCE_STATE_PRESENT;
+	default:
+		return D3D12_RESOURCE_STATE_COMMON;
+	}
+}
+
+CTransientHeap::Texture& CTransientHeap::Slot(uint32_t Id)
+{
+	if (Id >= m_Textures.size())
+		m_Textures.resize(Id + 1);
+
+	return m_Textures[Id];
+}
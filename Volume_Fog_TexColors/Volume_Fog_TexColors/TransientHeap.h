@@ -0,0 +1,63 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Transient Heap DirectX12
+//======================================================================================
+
+#ifndef _TRANSIENTHEAP_
+#define _TRANSIENTHEAP_
+
+#include <windows.h>
+#include <wrl.h>
+#include <d3d12.h>
+
+#include <vector>
+
+#include "d3dUtil.h"
+#include "RenderGraph.h"
+#include "ResourceStateTracker.h"
+
+//D3D12 side of CRenderGraph, textures of the graph become
+//placed resources in one heap at the offsets Compile picked
+//and are registered with the state tracker, imported ones are
+//bound from outside and registered by their owner, Execute
+//hands the graph barriers to the tracker, it has the states
+//before and flushes them in one batch per pass
+class CTransientHeap
+{
+public:
+	//sizes the texture on Device and declares it in Graph,
+	//Clear may be nullptr
+	uint32_t Create_Texture(ID3D12Device* Device, CRenderGraph& Graph, const char* Name,
+		const D3D12_RESOURCE_DESC& Desc, const D3D12_CLEAR_VALUE* Clear);
+
+	//after Graph.Compile, culled textures get no resource
+	void Allocate(ID3D12Device* Device, const CRenderGraph& Graph, CResourceStateTracker& States);
+
+	//imports, the back buffer changes every frame
+	void Bind(uint32_t Id, ID3D12Resource* Resource);
+
+	ID3D12Resource* Resource(uint32_t Id) const;
+
+	void Execute(const CRenderGraph& Graph, CResourceStateTracker& States, ID3D12GraphicsCommandList* CommandList);
+
+	void Release(CResourceStateTracker& States);
+
+	static D3D12_RESOURCE_STATES D3D_State(RGState State);
+
+private:
+	struct Texture
+	{
+		D3D12_RESOURCE_DESC Desc = {};
+		D3D12_CLEAR_VALUE Clear = {};
+		bool HasClear = false;
+		//placed in the heap, not bound
+		bool Placed = false;
+		Microsoft::WRL::ComPtr<ID3D12Resource> Resource;
+	};
+
+	Texture& Slot(uint32_t Id);
+
+	Microsoft::WRL::ComPtr<ID3D12Heap> m_Heap;
+	std::vector<Texture> m_Textures;
+};
+
+#endif
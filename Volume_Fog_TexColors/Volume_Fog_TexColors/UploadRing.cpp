@@ -0,0 +1,97 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Upload Ring
+//======================================================================================
+
+#include "UploadRing.h"
+
+static uint64_t Align_Up(uint64_t Value, uint64_t Align)
+{
+	return (Value + Align - 1) & ~(Align - 1);
+}
+
+void CUploadRing::Init(uint64_t Capacity)
+{
+	m_Capacity = Capacity;
+	m_Head = 0;
+	m_Tail = 0;
+	m_Used = 0;
+	m_OpenBytes = 0;
+	m_Batches.clear();
+}
+
+bool CUploadRing::Allocate(uint64_t Size, uint64_t Align, uint64_t& Offset)
+{
+	if (Size == 0 || Size > m_Capacity)
+		return false;
+
+	//empty ring starts over, so big blocks do not have to wrap
+	if (m_Used == 0)
+		m_Head = m_Tail = 0;
+
+	uint64_t Start = Align_Up(m_Head, Align);
+	uint64_t Taken;
+
+	if (m_Used == 0 || m_Head > m_Tail)
+	{
+		//free space is [Head, Capacity) and [0, Tail)
+		if (Start + Size <= m_Capacity)
+		{
+			Taken = Start + Size - m_Head;
+		}
+		else if (Size <= m_Tail)
+		{
+			Start = 0;
+			Taken = m_Capacity - m_Head + Size;
+		}
+		else
+		{
+			return false;
+		}
+	}
+	else
+	{
+		//wrapped, free space is [Head, Tail), Head == Tail means full
+		if (Start + Size > m_Tail)
+			return false;
+
+		Taken = Start + Size - m_Head;
+	}
+
+	m_Head = Start + Size;
+	if (m_Head == m_Capacity)
+		m_Head = 0;
+
+	m_Used += Taken;
+	m_OpenBytes += Taken;
+
+	Offset = Start;
+
+	return true;
+}
+
+void CUploadRing::Close_Batch(uint64_t FenceValue)
+{
+	if (m_OpenBytes == 0)
+		return;
+
+	m_Batches.push_back({ FenceValue, m_OpenBytes });
+	m_OpenBytes = 0;
+}
+
+void CUploadRing::Release(uint64_t CompletedValue)
+{
+	while (!m_Batches.empty() && m_Batches.front().FenceValue <= CompletedValue)
+	{
+		const Batch& Front = m_Batches.front();
+
+		m_Tail = (m_Tail + Front.Bytes) % m_Capacity;
+		m_Used -= Front.Bytes;
+
+		m_Batches.pop_front();
+	}
+}
+
+uint64_t CUploadRing::Oldest_Fence() const
+{
+	return m_Batches.empty() ? 0 : m_Batches.front().FenceValue;
+}
@@ -0,0 +1,83 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Descriptor Heap DirectX12
+//======================================================================================
+
+#include "DescriptorHeap.h"
+
+void CDescriptorHeap::Init(ID3D12Device* Device, D3D12_DESCRIPTOR_HEAP_TYPE Type,
+	UINT PersistentCount, UINT TransientCount, bool ShaderVisible)
+{
+	D3D12_DESCRIPTOR_HEAP_DESC HeapDesc = {};
+	HeapDesc.NumDescriptors = PersistentCount + TransientCount;
+	HeapDesc.Type = Type;
+	HeapDesc.Flags = ShaderVisible ? D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE : D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+	HeapDesc.NodeMask = 0;
+	ThrowIfFailed(Device->CreateDescriptorHeap(&HeapDesc, IID_PPV_ARGS(m_Heap.GetAddressOf())));
+
+	m_CpuStart = m_Heap->GetCPUDescriptorHandleForHeapStart();
+
+	//GetGPUDescriptorHandleForHeapStart is invalid for CPU only heaps
+	m_ShaderVisible = ShaderVisible;
+	if (ShaderVisible)
+		m_GpuStart = m_Heap->GetGPUDescriptorHandleForHeapStart();
+
+	m_Increment = Device->GetDescriptorHandleIncrementSize(Type);
+
+	m_Allocator.Init(PersistentCount, TransientCount);
+}
+
+DescriptorRange CDescriptorHeap::Make_Range(UINT Index, UINT Count) const
+{
+	DescriptorRange Range;
+	Range.Index = Index;
+	Range.Count = Count;
+	Range.CpuHandle = Cpu_Handle(Index);
+	Range.GpuHandle = Gpu_Handle(Index);
+
+	return Range;
+}
+
+DescriptorRange CDescriptorHeap::Allocate(UINT Count)
+{
+	uint32_t Index = 0;
+
+	if (!m_Allocator.Allocate(Count, Index))
+		ThrowIfFailed(E_OUTOFMEMORY);
+
+	return Make_Range(Index, Count);
+}
+
+DescriptorRange CDescriptorHeap::Allocate_Transient(UINT Count)
+{
+	uint32_t Index = 0;
+
+	if (!m_Allocator.Allocate_Transient(Count, Index))
+		ThrowIfFailed(E_OUTOFMEMORY);
+
+	return Make_Range(Index, Count);
+}
+
+void CDescriptorHeap::Free(DescriptorRange& Range)
+{
+	m_Allocator.Free(Range.Index, Range.Count);
+
+	Range = DescriptorRange();
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE CDescriptorHeap::Cpu_Handle(UINT Index) const
+{
+	D3D12_CPU_DESCRIPTOR_HANDLE Handle;
+	Handle.ptr = (SIZE_T)CDescriptorAllocator::Handle(m_CpuStart.ptr, Index, m_Increment);
+
+	return Handle;
+}
+
+D3D12_GPU_DESCRIPTOR_HANDLE CDescriptorHeap::Gpu_Handle(UINT Index) const
+{
+	D3D12_GPU_DESCRIPTOR_HANDLE Handle = {};
+
+	if (m_ShaderVisible)
+		Handle.ptr = CDescriptorAllocator::Handle(m_GpuStart.ptr, Index, m_Increment);
+
+	return Handle;
+}
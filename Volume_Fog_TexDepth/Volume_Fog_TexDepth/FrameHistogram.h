@@ -0,0 +1,75 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Frame Histogram
+//======================================================================================
+
+#ifndef _FRAMEHISTOGRAM_
+#define _FRAMEHISTOGRAM_
+
+#include <cstdint>
+#include <atomic>
+
+//last frames kept for export, power of two
+#define FRAME_HISTORY_SIZE 1024
+
+//each power of two of microseconds is split in this many
+//linear buckets, worst bucket error is 1/32, about 3%
+#define FRAME_HISTOGRAM_SUB_BITS 5
+#define FRAME_HISTOGRAM_SUB_COUNT (1 << FRAME_HISTOGRAM_SUB_BITS)
+//up to 2^28 us, longer frames land in the last bucket
+#define FRAME_HISTOGRAM_MAGNITUDES 23
+#define FRAME_HISTOGRAM_BUCKETS ((FRAME_HISTOGRAM_MAGNITUDES + 1) * FRAME_HISTOGRAM_SUB_COUNT)
+
+//frame times in microseconds, one thread calls Record,
+//any thread may read or export, all storage is fixed
+//so the frame path never allocates
+class CFrameHistogram
+{
+public:
+	CFrameHistogram();
+
+	CFrameHistogram(const CFrameHistogram& rhs) = delete;
+	CFrameHistogram& operator=(const CFrameHistogram& rhs) = delete;
+
+	void Record(int64_t Microseconds);
+
+	//frames longer than Budget count as over budget, 0 turns it off
+	void Set_Budget(int64_t Microseconds) { m_Budget.store(Microseconds, std::memory_order_relaxed); }
+
+	//P in 0..100, upper edge of the bucket holding the P-th
+	//percentile frame, 0 when nothing was recorded
+	int64_t Percentile(double P) const;
+
+	uint64_t Count() const { return m_Count.load(std::memory_order_acquire); }
+	uint64_t Over_Budget() const { return m_OverBudget.load(std::memory_order_relaxed); }
+	int64_t Max() const { return m_Max.load(std::memory_order_relaxed); }
+	double Average() const;
+
+	//from the thread that calls Record
+	void Reset();
+
+	//summary, percentiles, histogram and the recent frames,
+	//false when the file can not be opened
+	bool Write_CSV(const char* FileName) const;
+	bool Write_JSON(const char* FileName) const;
+
+	//bucket of a frame time, times past the last magnitude
+	//go to the last bucket, and the longest time it holds
+	static int Bucket_Index(int64_t Microseconds);
+	static int64_t Bucket_Upper(int Index);
+
+private:
+	//copies the recent frames oldest first, returns how many
+	uint32_t Copy_History(int64_t* Frames) const;
+
+	std::atomic<uint32_t> m_Buckets[FRAME_HISTOGRAM_BUCKETS];
+
+	std::atomic<int64_t> m_History[FRAME_HISTORY_SIZE];
+	std::atomic<uint64_t> m_Count;
+
+	std::atomic<int64_t> m_Sum;
+	std::atomic<int64_t> m_Max;
+	std::atomic<uint64_t> m_OverBudget;
+	std::atomic<int64_t> m_Budget;
+};
+
+#endif
@@ -0,0 +1,272 @@
+//======================================================================================
+//	Ed Kurlyak 2023 GPU Memory DirectX12
+//======================================================================================
+
+#include "GpuMemory.h"
+
+#include <algorithm>
+
+static UINT64 Align_Up(UINT64 Value, UINT64 Alignment)
+{
+	return (Value + Alignment - 1) & ~(Alignment - 1);
+}
+
+void CGpuMemory::Init(ID3D12Device* Device, IDXGIAdapter* Adapter)
+{
+	m_Device = Device;
+
+	//QueryVideoMemoryInfo needs IDXGIAdapter3, Windows 10
+	if (Adapter != nullptr)
+		Adapter->QueryInterface(IID_PPV_ARGS(m_Adapter.GetAddressOf()));
+
+	m_Pools[GPU_POOL_BUFFERS] = { D3D12_HEAP_TYPE_DEFAULT, D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS,
+		D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT };
+	m_Pools[GPU_POOL_TEXTURES] = { D3D12_HEAP_TYPE_DEFAULT, D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES,
+		D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT };
+	//MSAA targets need 4 MB alignment
+	m_Pools[GPU_POOL_TARGETS] = { D3D12_HEAP_TYPE_DEFAULT, D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES,
+		D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT };
+	m_Pools[GPU_POOL_UPLOAD] = { D3D12_HEAP_TYPE_UPLOAD, D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS,
+		D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT };
+}
+
+void CGpuMemory::Place(int PoolIndex, UINT64 Size, UINT64 Align, GpuAllocation& Allocation)
+{
+	Pool& P = m_Pools[PoolIndex];
+
+	Allocation.Pool = PoolIndex;
+
+	for (UINT i = 0; i < (UINT)P.Blocks.size(); i++)
+	{
+		if (P.Blocks[i]->Allocator.Allocate(Size, Align, Allocation.BlockOffset))
+		{
+			Allocation.Block = i;
+			return;
+		}
+	}
+
+	//room for Size at Align wherever the free block starts
+	UINT64 BlockSize = std::max<UINT64>(GPU_MEMORY_BLOCK_SIZE, Align_Up(Size + Align, P.Alignment));
+
+	Check_Budget(BlockSize);
+
+	std::unique_ptr<Block> NewBlock = std::make_unique<Block>();
+
+	CD3DX12_HEAP_DESC HeapDesc(BlockSize, P.Type, P.Alignment, P.Flags);
+	ThrowIfFailed(m_Device->CreateHeap(&HeapDesc, IID_PPV_ARGS(NewBlock->Heap.GetAddressOf())));
+
+	NewBlock->Allocator.Init(BlockSize, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
+
+	if (!NewBlock->Allocator.Allocate(Size, Align, Allocation.BlockOffset))
+		ThrowIfFailed(E_OUTOFMEMORY);
+
+	Allocation.Block = (UINT)P.Blocks.size();
+	P.Blocks.push_back(std::move(NewBlock));
+}
+
+GpuAllocation CGpuMemory::Create_Buffer(D3D12_HEAP_TYPE HeapType, UINT64 Size, D3D12_RESOURCE_STATES State)
+{
+	int PoolIndex = HeapType == D3D12_HEAP_TYPE_UPLOAD ? GPU_POOL_UPLOAD : GPU_POOL_BUFFERS;
+
+	D3D12_RESOURCE_STATES SharedState = HeapType == D3D12_HEAP_TYPE_UPLOAD ?
+		D3D12_RESOURCE_STATE_GENERIC_READ : D3D12_RESOURCE_STATE_COMMON;
+
+	if (Size <= GPU_MEMORY_SMALL_BUFFER && State == SharedState)
+		return Create_Packed(PoolIndex, Size);
+
+	GpuAllocation Allocation;
+	Allocation.Size = Size;
+
+	Place(PoolIndex, Align_Up(Size, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT),
+		D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT, Allocation);
+
+	ThrowIfFailed(m_Device->CreatePlacedResource(
+		m_Pools[PoolIndex].Blocks[Allocation.Block]->Heap.Get(),
+		Allocation.BlockOffset,
+		&CD3DX12_RESOURCE_DESC::Buffer(Size),
+		State,
+		nullptr,
+		IID_PPV_ARGS(Allocation.Resource.GetAddressOf())));
+
+	Allocation.GpuAddress = Allocation.Resource->GetGPUVirtualAddress();
+
+	return Allocation;
+}
+
+GpuAllocation CGpuMemory::Create_Packed(int PoolIndex, UINT64 Size)
+{
+	Pool& P = m_Pools[PoolIndex];
+
+	GpuAllocation Allocation;
+	Allocation.Pool = PoolIndex;
+	Allocation.Size = Size;
+	Allocation.Packed = true;
+
+	//placement of constant buffers, vertex and index data need less
+	const UINT64 Align = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT;
+
+	UINT PageIndex = 0;
+	for (; PageIndex < (UINT)P.Pages.size(); PageIndex++)
+	{
+		if (P.Pages[PageIndex]->Allocator.Allocate(Size, Align, Allocation.Offset))
+			break;
+	}
+
+	if (PageIndex == (UINT)P.Pages.size())
+	{
+		std::unique_ptr<Page> NewPage = std::make_unique<Page>();
+
+		D3D12_RESOURCE_STATES SharedState = P.Type == D3D12_HEAP_TYPE_UPLOAD ?
+			D3D12_RESOURCE_STATE_GENERIC_READ : D3D12_RESOURCE_STATE_COMMON;
+
+		//bigger than GPU_MEMORY_SMALL_BUFFER, never packed itself
+		NewPage->Memory = Create_Buffer(P.Type, GPU_MEMORY_PAGE_SIZE, SharedState);
+		NewPage->Allocator.Init(GPU_MEMORY_PAGE_SIZE, Align);
+
+		if (!NewPage->Allocator.Allocate(Size, Align, Allocation.Offset))
+			ThrowIfFailed(E_OUTOFMEMORY);
+
+		P.Pages.push_back(std::move(NewPage));
+	}
+
+	const GpuAllocation& PageMemory = P.Pages[PageIndex]->Memory;
+
+	Allocation.Resource = PageMemory.Resource;
+	Allocation.GpuAddress = PageMemory.GpuAddress + Allocation.Offset;
+	Allocation.Block = PageIndex;
+
+	return Allocation;
+}
+
+GpuAllocation CGpuMemory::Create_Texture(const D3D12_RESOURCE_DESC& Desc, D3D12_RESOURCE_STATES State,
+	const D3D12_CLEAR_VALUE* Clear)
+{
+	int PoolIndex = (Desc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL)) ?
+		GPU_POOL_TARGETS : GPU_POOL_TEXTURES;
+
+	D3D12_RESOURCE_ALLOCATION_INFO Info = m_Device->GetResourceAllocationInfo(0, 1, &Desc);
+
+	GpuAllocation Allocation;
+	Allocation.Size = Info.SizeInBytes;
+
+	Place(PoolIndex, Info.SizeInBytes, Info.Alignment, Allocation);
+
+	ThrowIfFailed(m_Device->CreatePlacedResource(
+		m_Pools[PoolIndex].Blocks[Allocation.Block]->Heap.Get(),
+		Allocation.BlockOffset,
+		&Desc,
+		State,
+		Clear,
+		IID_PPV_ARGS(Allocation.Resource.GetAddressOf())));
+
+	return Allocation;
+}
+
+void CGpuMemory::Free(GpuAllocation& Allocation)
+{
+	if (Allocation.Pool < 0)
+		return;
+
+	Pool& P = m_Pools[Allocation.Pool];
+
+	if (Allocation.Packed)
+		P.Pages[Allocation.Block]->Allocator.Free(Allocation.Offset);
+	else
+		P.Blocks[Allocation.Block]->Allocator.Free(Allocation.BlockOffset);
+
+	//heaps and pages stay for the next allocations
+	Allocation = GpuAllocation();
+}
+
+void CGpuMemory::Check_Budget(UINT64 Size)
+{
+	GpuMemoryStats Current = Stats();
+
+	if (Current.Budget == 0 || Current.Usage + Size <= Current.Budget)
+		return;
+
+	char Msg[256];
+	sprintf_s(Msg, "GPU memory: a %.1f MB heap goes over the budget, %.1f of %.1f MB in use\n",
+		Size / (1024.0 * 1024.0), Current.Usage / (1024.0 * 1024.0), Current.Budget / (1024.0 * 1024.0));
+	OutputDebugStringA(Msg);
+}
+
+void CGpuMemory::Add_Stats(GpuPoolStats& Stats, const CTlsfAllocator& Allocator, UINT64& FreeSize, UINT64& LargestFree)
+{
+	Stats.Blocks++;
+	Stats.Reserved += Allocator.Capacity();
+	Stats.Used += Allocator.Used();
+	Stats.Allocations += Allocator.Allocation_Count();
+
+	FreeSize += Allocator.Free_Size();
+	LargestFree = std::max(LargestFree, Allocator.Largest_Free());
+}
+
+GpuMemoryStats CGpuMemory::Stats()
+{
+	GpuMemoryStats Result;
+
+	UINT64 PackedFree = 0;
+	UINT64 PackedLargest = 0;
+
+	for (int i = 0; i < GPU_POOL_COUNT; i++)
+	{
+		UINT64 FreeSize = 0;
+		UINT64 LargestFree = 0;
+
+		for (const auto& B : m_Pools[i].Blocks)
+			Add_Stats(Result.Pools[i], B->Allocator, FreeSize, LargestFree);
+
+		for (const auto& Pg : m_Pools[i].Pages)
+			Add_Stats(Result.Packed, Pg->Allocator, PackedFree, PackedLargest);
+
+		if (FreeSize != 0)
+			Result.Pools[i].Fragmentation = 1.0 - (double)LargestFree / (double)FreeSize;
+	}
+
+	if (PackedFree != 0)
+		Result.Packed.Fragmentation = 1.0 - (double)PackedLargest / (double)PackedFree;
+
+	if (m_Adapter != nullptr)
+	{
+		DXGI_QUERY_VIDEO_MEMORY_INFO Info;
+		if (SUCCEEDED(m_Adapter->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &Info)))
+		{
+			Result.Budget = Info.Budget;
+			Result.Usage = Info.CurrentUsage;
+		}
+	}
+
+	return Result;
+}
+
+void CGpuMemory::Log_Stats()
+{
+	static const char* PoolNames[GPU_POOL_COUNT] = { "buffers", "textures", "targets", "upload" };
+
+	GpuMemoryStats Current = Stats();
+
+	char Msg[256];
+
+	for (int i = 0; i < GPU_POOL_COUNT; i++)
+	{
+		const GpuPoolStats& P = Current.Pools[i];
+
+		sprintf_s(Msg, "GPU memory %s: %u heaps, %.2f of %.2f MB used, %u resources, fragmentation %.2f\n",
+			PoolNames[i], P.Blocks, P.Used / (1024.0 * 1024.0), P.Reserved / (1024.0 * 1024.0),
+			P.Allocations, P.Fragmentation);
+		OutputDebugStringA(Msg);
+	}
+
+	sprintf_s(Msg, "GPU memory packed buffers: %u pages, %.1f of %.1f KB used, %u buffers, fragmentation %.2f\n",
+		Current.Packed.Blocks, Current.Packed.Used / 1024.0, Current.Packed.Reserved / 1024.0,
+		Current.Packed.Allocations, Current.Packed.Fragmentation);
+	OutputDebugStringA(Msg);
+
+	if (Current.Budget != 0)
+	{
+		sprintf_s(Msg, "GPU memory budget: %.1f of %.1f MB in use\n",
+			Current.Usage / (1024.0 * 1024.0), Current.Budget / (1024.0 * 1024.0));
+		OutputDebugStringA(Msg);
+	}
+}
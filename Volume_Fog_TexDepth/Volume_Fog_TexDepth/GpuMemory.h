@@ -0,0 +1,140 @@
+//======================================================================================
+//	Ed Kurlyak 2023 GPU Memory DirectX12
+//======================================================================================
+
+#ifndef _GPUMEMORY_
+#define _GPUMEMORY_
+
+#include <windows.h>
+#include <wrl.h>
+#include <dxgi1_4.h>
+#include <d3d12.h>
+#include "d3dx12.h"
+
+#include <memory>
+#include <vector>
+
+#include "d3dUtil.h"
+#include "TlsfAllocator.h"
+
+//heaps are made this big, a bigger resource gets a heap of its own size
+#define GPU_MEMORY_BLOCK_SIZE (16ull * 1024 * 1024)
+
+//buffers up to this size share placed buffers of GPU_MEMORY_PAGE_SIZE
+#define GPU_MEMORY_SMALL_BUFFER (64 * 1024)
+#define GPU_MEMORY_PAGE_SIZE (2 * 1024 * 1024)
+
+//heap kinds kept apart, resource heap tier 1 cannot mix them
+enum GpuMemoryPool
+{
+	GPU_POOL_BUFFERS,
+	GPU_POOL_TEXTURES,
+	GPU_POOL_TARGETS,
+	GPU_POOL_UPLOAD,
+	GPU_POOL_COUNT
+};
+
+//a placed resource or a range of a shared buffer, give it back
+//to Free once the GPU is done with it
+struct GpuAllocation
+{
+	Microsoft::WRL::ComPtr<ID3D12Resource> Resource;
+	//bytes into Resource, not 0 for packed buffers only
+	UINT64 Offset = 0;
+	UINT64 Size = 0;
+	//buffers only, Resource address plus Offset
+	D3D12_GPU_VIRTUAL_ADDRESS GpuAddress = 0;
+
+	int Pool = -1;
+	//heap block, or page for packed buffers
+	UINT Block = 0;
+	UINT64 BlockOffset = 0;
+	bool Packed = false;
+};
+
+struct GpuPoolStats
+{
+	UINT Blocks = 0;
+	UINT64 Reserved = 0;
+	UINT64 Used = 0;
+	UINT Allocations = 0;
+	//0 - free space in one piece, see CTlsfAllocator
+	double Fragmentation = 0.0;
+};
+
+struct GpuMemoryStats
+{
+	GpuPoolStats Pools[GPU_POOL_COUNT];
+	//small buffers in the pages of the buffer and upload pools
+	GpuPoolStats Packed;
+	//local video memory of the process as DXGI reports it,
+	//0 without an IDXGIAdapter3
+	UINT64 Budget = 0;
+	UINT64 Usage = 0;
+};
+
+//places resources in big ID3D12Heap blocks instead of one
+//committed resource each, offsets in a block come from a TLSF
+//allocator, small buffers are packed in shared placed buffers,
+//they share the resource state, so packing is done only for
+//buffers made in COMMON (default heap) or GENERIC_READ (upload
+//heap) that rely on promotion and decay. One thread only
+class CGpuMemory
+{
+public:
+	CGpuMemory() = default;
+
+	CGpuMemory(const CGpuMemory& rhs) = delete;
+	CGpuMemory& operator=(const CGpuMemory& rhs) = delete;
+
+	//Adapter gives the budget, may be nullptr
+	void Init(ID3D12Device* Device, IDXGIAdapter* Adapter);
+
+	//HeapType DEFAULT or UPLOAD
+	GpuAllocation Create_Buffer(D3D12_HEAP_TYPE HeapType, UINT64 Size, D3D12_RESOURCE_STATES State);
+
+	//Clear may be nullptr
+	GpuAllocation Create_Texture(const D3D12_RESOURCE_DESC& Desc, D3D12_RESOURCE_STATES State,
+		const D3D12_CLEAR_VALUE* Clear);
+
+	void Free(GpuAllocation& Allocation);
+
+	GpuMemoryStats Stats();
+	void Log_Stats();
+
+private:
+	struct Block
+	{
+		Microsoft::WRL::ComPtr<ID3D12Heap> Heap;
+		CTlsfAllocator Allocator;
+	};
+
+	struct Page
+	{
+		GpuAllocation Memory;
+		CTlsfAllocator Allocator;
+	};
+
+	struct Pool
+	{
+		D3D12_HEAP_TYPE Type;
+		D3D12_HEAP_FLAGS Flags;
+		UINT64 Alignment;
+		std::vector<std::unique_ptr<Block>> Blocks;
+		std::vector<std::unique_ptr<Page>> Pages;
+	};
+
+	//heap range for Size at Align, a new block if none has room
+	void Place(int PoolIndex, UINT64 Size, UINT64 Align, GpuAllocation& Allocation);
+	GpuAllocation Create_Packed(int PoolIndex, UINT64 Size);
+	void Check_Budget(UINT64 Size);
+
+	static void Add_Stats(GpuPoolStats& Stats, const CTlsfAllocator& Allocator, UINT64& FreeSize, UINT64& LargestFree);
+
+	Microsoft::WRL::ComPtr<ID3D12Device> m_Device;
+	Microsoft::WRL::ComPtr<IDXGIAdapter3> m_Adapter;
+
+	Pool m_Pools[GPU_POOL_COUNT];
+};
+
+#endif
@@ -0,0 +1,35 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Linear Allocator
+//======================================================================================
+
+#include "LinearAllocator.h"
+
+void CLinearAllocator::Init(uint64_t Capacity, uint64_t Align)
+{
+	m_Capacity = Capacity;
+	m_Align = Align;
+	m_Used = 0;
+	m_Peak = 0;
+}
+
+bool CLinearAllocator::Allocate(uint64_t Size, uint64_t& Offset)
+{
+	uint64_t Start = (m_Used + m_Align - 1) & ~(m_Align - 1);
+
+	if (Size == 0 || Start > m_Capacity || Size > m_Capacity - Start)
+		return false;
+
+	m_Used = Start + Size;
+
+	if (m_Used > m_Peak)
+		m_Peak = m_Used;
+
+	Offset = Start;
+
+	return true;
+}
+
+void CLinearAllocator::Reset()
+{
+	m_Used = 0;
+}
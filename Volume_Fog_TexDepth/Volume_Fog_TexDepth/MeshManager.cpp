@@ -12,6 +12,14 @@ CMeshManager::~CMeshManager()
 {
 	if (m_d3dDevice != nullptr)
 		FlushCommandQueue();
+
+	Export_Frame_Stats();
+	CProfiler::Write_Trace(PROFILER_TRACE_FILE);
+}
+
+void CMeshManager::Export_Frame_Stats()
+{
+	m_Timer.Export_Frame_Stats();
 }
 
 void CMeshManager::EnableDebugLayer_CreateFactory()
@@ -29,6 +37,8 @@ void CMeshManager::EnableDebugLayer_CreateFactory()
 
 void CMeshManager::Create_Device()
 {
+	PROFILE_FUNCTION();
+
 	HRESULT hardwareResult = D3D12CreateDevice(
 		nullptr,             // default adapter
 		D3D_FEATURE_LEVEL_11_0,
@@ -49,12 +59,16 @@ void CMeshManager::Create_Device()
 
 void CMeshManager::CreateFence_GetDescriptorsSize()
 {
-	ThrowIfFailed(m_d3dDevice->CreateFence(0, D3D12_FENCE_FLAG_NONE,
-		IID_PPV_ARGS(&m_Fence)));
+	m_Fence.Init(m_d3dDevice.Get());
 
 	m_RtvDescriptorSize = m_d3dDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
 	m_DsvDescriptorSize = m_d3dDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_DSV);
 	m_CbvSrvUavDescriptorSize = m_d3dDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+	m_SrvHeap.Init(m_d3dDevice.Get(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV,
+		SRV_HEAP_PERSISTENT, SRV_HEAP_TRANSIENT, true);
+	m_RtvHeap.Init(m_d3dDevice.Get(), D3D12_DESCRIPTOR_HEAP_TYPE_RTV, RTV_HEAP_SIZE, 0, false);
+	m_DsvHeap.Init(m_d3dDevice.Get(), D3D12_DESCRIPTOR_HEAP_TYPE_DSV, DSV_HEAP_SIZE, 0, false);
 }
 
 void CMeshManager::Check_Multisample_Quality()
@@ -96,6 +110,8 @@ void CMeshManager::Create_CommandList_Allocator_Queue()
 
 void CMeshManager::Create_SwapChain()
 {
+	PROFILE_FUNCTION();
+
 	m_SwapChain.Reset();
 
 	DXGI_SWAP_CHAIN_DESC sd;
@@ -132,9 +148,14 @@ void CMeshManager::Resize_SwapChainBuffers()
 	ThrowIfFailed(m_CommandList->Reset(m_DirectCmdListAlloc.Get(), nullptr));
 
 	for (int i = 0; i < m_SwapChainBufferCount; ++i)
+	{
+		m_States.Unregister(m_SwapChainBuffer[i].Get());
 		m_SwapChainBuffer[i].Reset();
+	}
 
+	m_States.Unregister(m_DepthStencilBuffer.Get());
 	m_DepthStencilBuffer.Reset();
+	m_GpuMemory.Free(m_DepthStencilMemory);
 
 	ThrowIfFailed(m_SwapChain->ResizeBuffers(
 		m_SwapChainBufferCount,
@@ -145,35 +166,34 @@ void CMeshManager::Resize_SwapChainBuffers()
 
 void CMeshManager::FlushCommandQueue()
 {
-	m_CurrentFence++;
+	PROFILE_FUNCTION();
 
-	ThrowIfFailed(m_CommandQueue->Signal(m_Fence.Get(), m_CurrentFence));
-
-	if (m_Fence->GetCompletedValue() < m_CurrentFence)
-	{
-		HANDLE eventHandle = CreateEventEx(nullptr, false, false, EVENT_ALL_ACCESS);
-
-		ThrowIfFailed(m_Fence->SetEventOnCompletion(m_CurrentFence, eventHandle));
-
-		WaitForSingleObject(eventHandle, INFINITE);
-		CloseHandle(eventHandle);
-	}
+	m_Fence.Flush(m_CommandQueue.Get());
 }
 
 void CMeshManager::Create_Dsv_DescriptorHeaps_And_View_Pass1_Pass2()
 {
-	D3D12_DESCRIPTOR_HEAP_DESC dsvHeapDesc;
-	dsvHeapDesc.NumDescriptors = 2;
-	dsvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_DSV;
-	dsvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
-	dsvHeapDesc.NodeMask = 0;
-	ThrowIfFailed(m_d3dDevice->CreateDescriptorHeap(
-		&dsvHeapDesc, IID_PPV_ARGS(m_DsvHeapPass1Pass2.GetAddressOf())));
-
-	m_DSViewHandle_Pass1 = CD3DX12_CPU_DESCRIPTOR_HANDLE(m_DsvHeapPass1Pass2->GetCPUDescriptorHandleForHeapStart());
+	m_DSViewHandle_Pass1 = CD3DX12_CPU_DESCRIPTOR_HANDLE(m_DsvHeap.Allocate(2).CpuHandle);
 
 	m_DSViewHandle_Pass2 = m_DSViewHandle_Pass1;
 
+	//the depth targets are placed by Build_Render_Graph
+	D3D12_DEPTH_STENCIL_VIEW_DESC dsvDesc;
+	dsvDesc.Flags = D3D12_DSV_FLAG_NONE;
+	dsvDesc.ViewDimension = D3D12_DSV_DIMENSION_TEXTURE2D;
+	dsvDesc.Format = m_DepthStencilFormatPass1Pass2;
+	dsvDesc.Texture2D.MipSlice = 0;
+	m_d3dDevice->CreateDepthStencilView(m_DepthTargetTex_Pass1.Get(), &dsvDesc, m_DSViewHandle_Pass1);
+
+	m_DSViewHandle_Pass2.Offset(1, m_DsvDescriptorSize);
+
+	m_d3dDevice->CreateDepthStencilView(m_DepthTargetTex_Pass2.Get(), &dsvDesc, m_DSViewHandle_Pass2);
+}
+
+void CMeshManager::Create_Dsv_DescriptorHeaps_And_View_Pass3()
+{
+	m_DSViewHandle_Pass3 = CD3DX12_CPU_DESCRIPTOR_HANDLE(m_DsvHeap.Allocate().CpuHandle);
+
 	D3D12_RESOURCE_DESC depthStencilDesc;
 	depthStencilDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
 	depthStencilDesc.Alignment = 0;
@@ -181,61 +201,33 @@ void CMeshManager::Create_Dsv_DescriptorHeaps_And_View_Pass1_Pass2()
 	depthStencilDesc.Height = m_ClientHeight;
 	depthStencilDesc.DepthOrArraySize = 1;
 	depthStencilDesc.MipLevels = 1;
-	depthStencilDesc.Format = DXGI_FORMAT_D32_FLOAT;
+	depthStencilDesc.Format = DXGI_FORMAT_R24G8_TYPELESS;
 	depthStencilDesc.SampleDesc.Count = m_4xMsaaState ? 4 : 1;
 	depthStencilDesc.SampleDesc.Quality = m_4xMsaaState ? (m_4xMsaaQuality - 1) : 0;
 	depthStencilDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
 	depthStencilDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
 
 	D3D12_CLEAR_VALUE optClear;
-	optClear.Format = m_DepthStencilFormatPass1Pass2;
+	optClear.Format = m_DepthStencilFormatPass3;
 	optClear.DepthStencil.Depth = 1.0f;
 	optClear.DepthStencil.Stencil = 0;
-	ThrowIfFailed(m_d3dDevice->CreateCommittedResource(
-		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
-		D3D12_HEAP_FLAG_NONE,
-		&depthStencilDesc,
-		D3D12_RESOURCE_STATE_COMMON,
-		&optClear,
-		IID_PPV_ARGS(m_DepthTargetTex_Pass1.GetAddressOf())));
+	m_DepthStencilMemory = m_GpuMemory.Create_Texture(depthStencilDesc, D3D12_RESOURCE_STATE_COMMON, &optClear);
+	m_DepthStencilBuffer = m_DepthStencilMemory.Resource;
 
 	D3D12_DEPTH_STENCIL_VIEW_DESC dsvDesc;
 	dsvDesc.Flags = D3D12_DSV_FLAG_NONE;
 	dsvDesc.ViewDimension = D3D12_DSV_DIMENSION_TEXTURE2D;
-	dsvDesc.Format = m_DepthStencilFormatPass1Pass2;
+	dsvDesc.Format = m_DepthStencilFormatPass3;
 	dsvDesc.Texture2D.MipSlice = 0;
-	m_d3dDevice->CreateDepthStencilView(m_DepthTargetTex_Pass1.Get(), &dsvDesc, m_DSViewHandle_Pass1);
-
-	m_CommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_DepthTargetTex_Pass1.Get(),
-		D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_DEPTH_WRITE));
-
-	m_DSViewHandle_Pass2.Offset(1, m_DsvDescriptorSize);
-
-	ThrowIfFailed(m_d3dDevice->CreateCommittedResource(
-		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
-		D3D12_HEAP_FLAG_NONE,
-		&depthStencilDesc,
-		D3D12_RESOURCE_STATE_COMMON,
-		&optClear,
-		IID_PPV_ARGS(m_DepthTargetTex_Pass2.GetAddressOf())));
-
-	m_d3dDevice->CreateDepthStencilView(m_DepthTargetTex_Pass2.Get(), &dsvDesc, m_DSViewHandle_Pass2);
+	m_d3dDevice->CreateDepthStencilView(m_DepthStencilBuffer.Get(), &dsvDesc, m_DSViewHandle_Pass3);
 
-	m_CommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_DepthTargetTex_Pass2.Get(),
-		D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_DEPTH_WRITE));
+	m_States.Register(m_DepthStencilBuffer.Get(), D3D12_RESOURCE_STATE_COMMON);
+	m_States.Transition(m_DepthStencilBuffer.Get(), D3D12_RESOURCE_STATE_DEPTH_WRITE);
 }
 
-void CMeshManager::Create_Dsv_DescriptorHeaps_And_View_Pass3()
+void CMeshManager::Build_Render_Graph()
 {
-	D3D12_DESCRIPTOR_HEAP_DESC dsvHeapDesc;
-	dsvHeapDesc.NumDescriptors = 1;
-	dsvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_DSV;
-	dsvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
-	dsvHeapDesc.NodeMask = 0;
-	ThrowIfFailed(m_d3dDevice->CreateDescriptorHeap(
-		&dsvHeapDesc, IID_PPV_ARGS(m_DsvHeapPass3.GetAddressOf())));
-
-	m_DSViewHandle_Pass3 = CD3DX12_CPU_DESCRIPTOR_HANDLE(m_DsvHeapPass3->GetCPUDescriptorHandleForHeapStart());
+	PROFILE_FUNCTION();
 
 	D3D12_RESOURCE_DESC depthStencilDesc;
 	depthStencilDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
@@ -244,42 +236,86 @@ void CMeshManager::Create_Dsv_DescriptorHeaps_And_View_Pass3()
 	depthStencilDesc.Height = m_ClientHeight;
 	depthStencilDesc.DepthOrArraySize = 1;
 	depthStencilDesc.MipLevels = 1;
-	depthStencilDesc.Format = DXGI_FORMAT_R24G8_TYPELESS;
+	depthStencilDesc.Format = DXGI_FORMAT_D32_FLOAT;
 	depthStencilDesc.SampleDesc.Count = m_4xMsaaState ? 4 : 1;
 	depthStencilDesc.SampleDesc.Quality = m_4xMsaaState ? (m_4xMsaaQuality - 1) : 0;
 	depthStencilDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
 	depthStencilDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
 
 	D3D12_CLEAR_VALUE optClear;
-	optClear.Format = m_DepthStencilFormatPass3;
+	optClear.Format = m_DepthStencilFormatPass1Pass2;
 	optClear.DepthStencil.Depth = 1.0f;
 	optClear.DepthStencil.Stencil = 0;
-	ThrowIfFailed(m_d3dDevice->CreateCommittedResource(
-		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
-		D3D12_HEAP_FLAG_NONE,
-		&depthStencilDesc,
-		D3D12_RESOURCE_STATE_COMMON,
-		&optClear,
-		IID_PPV_ARGS(m_DepthStencilBuffer.GetAddressOf())));
 
-	D3D12_DEPTH_STENCIL_VIEW_DESC dsvDesc;
-	dsvDesc.Flags = D3D12_DSV_FLAG_NONE;
-	dsvDesc.ViewDimension = D3D12_DSV_DIMENSION_TEXTURE2D;
-	dsvDesc.Format = m_DepthStencilFormatPass3;
-	dsvDesc.Texture2D.MipSlice = 0;
-	m_d3dDevice->CreateDepthStencilView(m_DepthStencilBuffer.Get(), &dsvDesc, m_DSViewHandle_Pass3);
+	D3D12_RESOURCE_DESC textureDesc = {};
+	textureDesc.MipLevels = 1;
+	textureDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	textureDesc.Width = 800;
+	textureDesc.Height = 600;
+	textureDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET;
+	textureDesc.DepthOrArraySize = 1;
+	textureDesc.SampleDesc.Count = 1;
+	textureDesc.SampleDesc.Quality = 0;
+	textureDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+
+	D3D12_CLEAR_VALUE clearValue = { DXGI_FORMAT_R8G8B8A8_UNORM, { } };
 
-	m_CommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_DepthStencilBuffer.Get(),
-		D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_DEPTH_WRITE));
+	m_RGDepthPass1 = m_Transients.Create_Texture(m_d3dDevice.Get(), m_Graph, "Depth Pass1", depthStencilDesc, &optClear);
+	m_RGDepthPass2 = m_Transients.Create_Texture(m_d3dDevice.Get(), m_Graph, "Depth Pass2", depthStencilDesc, &optClear);
+	m_RGRenderTargetPass1 = m_Transients.Create_Texture(m_d3dDevice.Get(), m_Graph, "Color Pass1", textureDesc, &clearValue);
+	m_RGRenderTargetPass2 = m_Transients.Create_Texture(m_d3dDevice.Get(), m_Graph, "Color Pass2", textureDesc, &clearValue);
+
+	//m_States has the state of both, the graph moves them from there
+	m_RGBackBuffer = m_Graph.Import("Back Buffer", RG_STATE_PRESENT);
+	m_RGDepthStencil = m_Graph.Import("Depth Stencil", RG_STATE_DEPTH_WRITE);
+
+	//the SAQ samples only the depth, the color targets of
+	//pass1 and pass2 are never read and share memory
+	uint32_t Pass1 = m_Graph.Add_Pass("Pass1", [this]() { Draw_Pass1(); });
+	m_Graph.Write(Pass1, m_RGDepthPass1, RG_STATE_DEPTH_WRITE);
+	m_Graph.Write(Pass1, m_RGRenderTargetPass1, RG_STATE_RENDER_TARGET);
+
+	uint32_t Pass2 = m_Graph.Add_Pass("Pass2", [this]() { Draw_Pass2(); });
+	m_Graph.Write(Pass2, m_RGDepthPass2, RG_STATE_DEPTH_WRITE);
+	m_Graph.Write(Pass2, m_RGRenderTargetPass2, RG_STATE_RENDER_TARGET);
+
+	uint32_t SAQ = m_Graph.Add_Pass("SAQ", [this]() { Draw_SAQ(); });
+	m_Graph.Read(SAQ, m_RGDepthPass1, RG_STATE_SHADER_READ);
+	m_Graph.Read(SAQ, m_RGDepthPass2, RG_STATE_SHADER_READ);
+	m_Graph.Write(SAQ, m_RGBackBuffer, RG_STATE_RENDER_TARGET);
+	m_Graph.Write(SAQ, m_RGDepthStencil, RG_STATE_DEPTH_WRITE);
+
+	if (!m_Graph.Compile())
+		ThrowIfFailed(E_INVALIDARG);
+
+	m_Transients.Allocate(m_d3dDevice.Get(), m_Graph, m_States);
+
+	m_DepthTargetTex_Pass1 = m_Transients.Resource(m_RGDepthPass1);
+	m_DepthTargetTex_Pass2 = m_Transients.Resource(m_RGDepthPass2);
+	m_RenderTargetTexPass1 = m_Transients.Resource(m_RGRenderTargetPass1);
+	m_RenderTargetTexPass2 = m_Transients.Resource(m_RGRenderTargetPass2);
+
+	char Msg[256];
+	sprintf_s(Msg,
+		"Render graph: %u of %u passes culled, transient heap %.2f MB, %.2f MB without aliasing, %.2f MB saved\n",
+		m_Graph.Culled_Count(), m_Graph.Pass_Count(),
+		m_Graph.Heap_Size() / (1024.0 * 1024.0),
+		m_Graph.Unaliased_Size() / (1024.0 * 1024.0),
+		(m_Graph.Unaliased_Size() - m_Graph.Heap_Size()) / (1024.0 * 1024.0));
+	OutputDebugStringA(Msg);
 }
 
 D3D12_CPU_DESCRIPTOR_HANDLE CMeshManager::DepthStencilView()
 {
-	return m_DsvHeapPass3->GetCPUDescriptorHandleForHeapStart();
+	return m_DSViewHandle_Pass3;
 }
 
 void CMeshManager::Execute_Init_Commands()
 {
+	PROFILE_FUNCTION();
+
+	m_States.Flush(m_CommandList.Get());
+
 	ThrowIfFailed(m_CommandList->Close());
 	ID3D12CommandList* cmdsLists[] = { m_CommandList.Get() };
 	m_CommandQueue->ExecuteCommandLists(_countof(cmdsLists), cmdsLists);
@@ -303,26 +339,22 @@ void CMeshManager::Create_Constant_Buffer_Pass1_Pass2()
 {
 	ThrowIfFailed(m_CommandList->Reset(m_DirectCmdListAlloc.Get(), nullptr));
 
-	m_ObjectCB = std::make_unique<UploadBuffer<ObjectConstants>>(m_d3dDevice.Get(), 1, true);
+	for (int i = 0; i < FRAME_RESOURCE_COUNT; i++)
+		m_FrameResources.push_back(std::make_unique<FrameResource>(m_d3dDevice.Get()));
 }
 
 void CMeshManager::Create_Main_RenderTargetHeap_And_View_Pass3()
 {
-	D3D12_DESCRIPTOR_HEAP_DESC rtvHeapDesc;
-	rtvHeapDesc.NumDescriptors = m_SwapChainBufferCount;
-	rtvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
-	rtvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
-	rtvHeapDesc.NodeMask = 0;
-	ThrowIfFailed(m_d3dDevice->CreateDescriptorHeap(
-		&rtvHeapDesc, IID_PPV_ARGS(m_RtvHeap.GetAddressOf())));
+	m_BackBufferRtv = m_RtvHeap.Allocate(m_SwapChainBufferCount);
 
 	m_CurrBackBuffer = 0;
 
-	CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHeapHandle(m_RtvHeap->GetCPUDescriptorHandleForHeapStart());
+	CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHeapHandle(m_BackBufferRtv.CpuHandle);
 
 	for (UINT i = 0; i < m_SwapChainBufferCount; i++)
 	{
 		ThrowIfFailed(m_SwapChain->GetBuffer(i, IID_PPV_ARGS(&m_SwapChainBuffer[i])));
+		m_States.Register(m_SwapChainBuffer[i].Get(), D3D12_RESOURCE_STATE_PRESENT);
 		m_d3dDevice->CreateRenderTargetView(m_SwapChainBuffer[i].Get(), nullptr, rtvHeapHandle);
 		rtvHeapHandle.Offset(1, m_RtvDescriptorSize);
 	}
@@ -330,6 +362,8 @@ void CMeshManager::Create_Main_RenderTargetHeap_And_View_Pass3()
 
 void CMeshManager::Create_RootSignature()
 {
+	PROFILE_FUNCTION();
+
 	CD3DX12_ROOT_PARAMETER slotRootParameter[2];
 
 	CD3DX12_DESCRIPTOR_RANGE cbvTable;
@@ -359,6 +393,9 @@ void CMeshManager::Create_RootSignature()
 		SerializedRootSig->GetBufferPointer(),
 		SerializedRootSig->GetBufferSize(),
 		IID_PPV_ARGS(&m_RootSignature)));
+
+	m_PipelineCache.Add_Root_Signature(m_RootSignature.Get(),
+		SerializedRootSig->GetBufferPointer(), SerializedRootSig->GetBufferSize());
 }
 
 std::array<const CD3DX12_STATIC_SAMPLER_DESC, 6> CMeshManager::GetStaticSamplers()
@@ -417,17 +454,42 @@ std::array<const CD3DX12_STATIC_SAMPLER_DESC, 6> CMeshManager::GetStaticSamplers
 
 void CMeshManager::Create_Cube_Shaders_And_InputLayout_Pass1_Pass2()
 {
+	PROFILE_FUNCTION();
+
 	m_VsByteCode = d3dUtil::CompileShader(L"Shaders\\depth.hlsl", nullptr, "VS", "vs_5_0");
 	m_PsByteCode = d3dUtil::CompileShader(L"Shaders\\depth.hlsl", nullptr, "PS", "ps_5_0");
 
+	//position stream only
 	m_InputLayout =
 	{
-		{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }
+		{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, VERTEX_STREAM_POSITION, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }
 	};
 }
 
+GpuAllocation CMeshManager::Create_Default_Buffer(const void* Data, UINT64 ByteSize, GpuAllocation& Uploader)
+{
+	//buffers promote to COPY_DEST for the copy and decay back to
+	//COMMON when the init list is done, so no barriers, small ones
+	//share a placed buffer with others and must not have any
+	GpuAllocation Buffer = m_GpuMemory.Create_Buffer(D3D12_HEAP_TYPE_DEFAULT, ByteSize, D3D12_RESOURCE_STATE_COMMON);
+	Uploader = m_GpuMemory.Create_Buffer(D3D12_HEAP_TYPE_UPLOAD, ByteSize, D3D12_RESOURCE_STATE_GENERIC_READ);
+
+	BYTE* Mapped = nullptr;
+	CD3DX12_RANGE ReadRange(0, 0);
+	ThrowIfFailed(Uploader.Resource->Map(0, &ReadRange, (void**)&Mapped));
+	memcpy(Mapped + Uploader.Offset, Data, (size_t)ByteSize);
+	Uploader.Resource->Unmap(0, nullptr);
+
+	m_CommandList->CopyBufferRegion(Buffer.Resource.Get(), Buffer.Offset,
+		Uploader.Resource.Get(), Uploader.Offset, ByteSize);
+
+	return Buffer;
+}
+
 void CMeshManager::Create_Cube_Geometry_Pass1_Pass2()
 {
+	PROFILE_FUNCTION();
+
 	std::array<Vertex, 8> Vertices =
 	{
 		Vertex({ DirectX::XMFLOAT3(-4.0, -4.0, -4.0) }),	//A
@@ -475,11 +537,9 @@ void CMeshManager::Create_Cube_Geometry_Pass1_Pass2()
 	m_Cube = std::make_unique<MeshGeometry>();
 	m_Cube->Name = "Cube";
 
-	m_Cube->VertexBufferGPU = d3dUtil::CreateDefaultBuffer(m_d3dDevice.Get(),
-		m_CommandList.Get(), Vertices.data(), VbByteSize, m_Cube->VertexBufferUploader);
+	m_Cube->VertexBufferGPU = Create_Default_Buffer(Vertices.data(), VbByteSize, m_Cube->VertexBufferUploader);
 
-	m_Cube->IndexBufferGPU = d3dUtil::CreateDefaultBuffer(m_d3dDevice.Get(),
-		m_CommandList.Get(), Indices.data(), IbByteSize, m_Cube->IndexBufferUploader);
+	m_Cube->IndexBufferGPU = Create_Default_Buffer(Indices.data(), IbByteSize, m_Cube->IndexBufferUploader);
 
 	m_Cube->VertexByteStride = sizeof(Vertex);
 	m_Cube->VertexBufferByteSize = VbByteSize;
@@ -497,6 +557,8 @@ void CMeshManager::Create_Cube_Geometry_Pass1_Pass2()
 
 void CMeshManager::Create_PipelineStateObject_Pass1()
 {
+	PROFILE_FUNCTION();
+
 	//BuildPSO Pass1();
 	D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDescPass1;
 	ZeroMemory(&psoDescPass1, sizeof(D3D12_GRAPHICS_PIPELINE_STATE_DESC));
@@ -522,11 +584,13 @@ void CMeshManager::Create_PipelineStateObject_Pass1()
 	psoDescPass1.SampleDesc.Count = m_4xMsaaState ? 4 : 1;
 	psoDescPass1.SampleDesc.Quality = m_4xMsaaState ? (m_4xMsaaQuality - 1) : 0;
 	psoDescPass1.DSVFormat = m_DepthStencilFormatPass1Pass2;
-	ThrowIfFailed(m_d3dDevice->CreateGraphicsPipelineState(&psoDescPass1, IID_PPV_ARGS(&m_PSOPass1)));
+	m_PSOPass1 = m_PipelineCache.Create_Graphics(psoDescPass1);
 }
 
 void CMeshManager::Create_PipelineStateObject_Pass2()
 {
+	PROFILE_FUNCTION();
+
 	CD3DX12_RASTERIZER_DESC desc2 = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);;
 	desc2.CullMode = D3D12_CULL_MODE_FRONT;
 
@@ -556,73 +620,38 @@ void CMeshManager::Create_PipelineStateObject_Pass2()
 	psoDescPass2.SampleDesc.Count = m_4xMsaaState ? 4 : 1;
 	psoDescPass2.SampleDesc.Quality = m_4xMsaaState ? (m_4xMsaaQuality - 1) : 0;
 	psoDescPass2.DSVFormat = m_DepthStencilFormatPass1Pass2;
-	ThrowIfFailed(m_d3dDevice->CreateGraphicsPipelineState(&psoDescPass2, IID_PPV_ARGS(&m_PSOPass2)));
+	m_PSOPass2 = m_PipelineCache.Create_Graphics(psoDescPass2);
 }
 
 void CMeshManager::Create_RTVDescriptorHeap_Pass1_Pass2()
 {
-	D3D12_DESCRIPTOR_HEAP_DESC rtvHeapDesc;
-	rtvHeapDesc.NumDescriptors = 2; //2 our render Target front back
-	rtvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
-	rtvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
-	rtvHeapDesc.NodeMask = 0;
-	ThrowIfFailed(m_d3dDevice->CreateDescriptorHeap(
-		&rtvHeapDesc, IID_PPV_ARGS(m_RtvHeapRTTex.GetAddressOf())));
+	//2 our render Target pass1 pass2
+	m_RTVTexHandle_Pass1 = CD3DX12_CPU_DESCRIPTOR_HANDLE(m_RtvHeap.Allocate(2).CpuHandle);
 }
 
 void CMeshManager::Create_RTView_Pass1_Pass2()
 {
-	m_RTVTexHandle_Pass1 = CD3DX12_CPU_DESCRIPTOR_HANDLE(m_RtvHeapRTTex->GetCPUDescriptorHandleForHeapStart());
-
 	m_RTVTexHandle_Pass2 = m_RTVTexHandle_Pass1;
 	m_RTVTexHandle_Pass2.Offset(1, m_RtvDescriptorSize);
 
-	D3D12_RESOURCE_DESC textureDesc = {};
-	textureDesc.MipLevels = 1;
-	textureDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-	textureDesc.Width = 800;
-	textureDesc.Height = 600;
-	textureDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET;
-	textureDesc.DepthOrArraySize = 1;
-	textureDesc.SampleDesc.Count = 1;
-	textureDesc.SampleDesc.Quality = 0;
-	textureDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
-
-	D3D12_CLEAR_VALUE clearValue = { DXGI_FORMAT_R8G8B8A8_UNORM, { } };
-
-	//tex for pass1
-	ThrowIfFailed(m_d3dDevice->CreateCommittedResource(
-		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
-		D3D12_HEAP_FLAG_ALLOW_ALL_BUFFERS_AND_TEXTURES,
-		&textureDesc,
-		D3D12_RESOURCE_STATE_RENDER_TARGET,
-		&clearValue,
-		IID_PPV_ARGS(m_RenderTargetTexPass1.GetAddressOf())));
-
+	//tex for pass1, placed by Build_Render_Graph
 	m_d3dDevice->CreateRenderTargetView(m_RenderTargetTexPass1.Get(), nullptr, m_RTVTexHandle_Pass1);
 	
 	//tex for pass2
-	ThrowIfFailed(m_d3dDevice->CreateCommittedResource(
-		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
-		D3D12_HEAP_FLAG_ALLOW_ALL_BUFFERS_AND_TEXTURES,
-		&textureDesc,
-		D3D12_RESOURCE_STATE_RENDER_TARGET,
-		&clearValue,
-		IID_PPV_ARGS(m_RenderTargetTexPass2.GetAddressOf())));
-
 	m_d3dDevice->CreateRenderTargetView(m_RenderTargetTexPass2.Get(), nullptr, m_RTVTexHandle_Pass2);
 }
 
-void CMeshManager::Create_SRDescriptorHead_And_View_For_Pass3()
+D3D12_GPU_DESCRIPTOR_HANDLE CMeshManager::Create_SRView_Table_Pass3()
 {
-	D3D12_DESCRIPTOR_HEAP_DESC srvHeapDesc1 = {};
-	srvHeapDesc1.NumDescriptors = 2;
-	srvHeapDesc1.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-	srvHeapDesc1.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-	ThrowIfFailed(m_d3dDevice->CreateDescriptorHeap(&srvHeapDesc1, IID_PPV_ARGS(&m_SrvDescriptorHeapSAQ)));
+	//views of the textures the graph placed for this frame, the
+	//range is reused once the GPU is past the frame fence
+	DescriptorRange Table = m_SrvHeap.Allocate_Transient(2);
+
+	ID3D12Resource* DepthTex_Pass1 = m_Transients.Resource(m_RGDepthPass1);
+	ID3D12Resource* DepthTex_Pass2 = m_Transients.Resource(m_RGDepthPass2);
 
 	//srv pass1
-	CD3DX12_CPU_DESCRIPTOR_HANDLE hDescriptor1(m_SrvDescriptorHeapSAQ->GetCPUDescriptorHandleForHeapStart());
+	CD3DX12_CPU_DESCRIPTOR_HANDLE hDescriptor1(Table.CpuHandle);
 
 	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc1 = {};
 	srvDesc1.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
@@ -630,10 +659,10 @@ void CMeshManager::Create_SRDescriptorHead_And_View_For_Pass3()
 	srvDesc1.Format = DXGI_FORMAT_R32_FLOAT;
 	srvDesc1.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
 	srvDesc1.Texture2D.MostDetailedMip = 0;
-	srvDesc1.Texture2D.MipLevels = m_DepthTargetTex_Pass1->GetDesc().MipLevels;
+	srvDesc1.Texture2D.MipLevels = DepthTex_Pass1->GetDesc().MipLevels;
 	srvDesc1.Texture2D.ResourceMinLODClamp = 0.0f;
 
-	m_d3dDevice->CreateShaderResourceView(m_DepthTargetTex_Pass1.Get(), &srvDesc1, hDescriptor1);
+	m_d3dDevice->CreateShaderResourceView(DepthTex_Pass1, &srvDesc1, hDescriptor1);
 
 	//srv pass2
 	hDescriptor1.Offset(1, m_CbvSrvUavDescriptorSize);
@@ -644,14 +673,18 @@ void CMeshManager::Create_SRDescriptorHead_And_View_For_Pass3()
 	srvDesc2.Format = DXGI_FORMAT_R32_FLOAT;
 	srvDesc2.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
 	srvDesc2.Texture2D.MostDetailedMip = 0;
-	srvDesc2.Texture2D.MipLevels = m_DepthTargetTex_Pass2->GetDesc().MipLevels;
+	srvDesc2.Texture2D.MipLevels = DepthTex_Pass2->GetDesc().MipLevels;
 	srvDesc2.Texture2D.ResourceMinLODClamp = 0.0f;
 
-	m_d3dDevice->CreateShaderResourceView(m_DepthTargetTex_Pass2.Get(), &srvDesc2, hDescriptor1);
+	m_d3dDevice->CreateShaderResourceView(DepthTex_Pass2, &srvDesc2, hDescriptor1);
+
+	return Table.GpuHandle;
 }
 
 void CMeshManager::Create_ScreenAlighedQuad_Shaders_And_InputLayout_Pass3()
 {
+	PROFILE_FUNCTION();
+
 	m_VsByteCodeSAQ = d3dUtil::CompileShader(L"Shaders\\saq.hlsl", nullptr, "VS", "vs_5_0");
 	m_PsByteCodeSAQ = d3dUtil::CompileShader(L"Shaders\\saq.hlsl", nullptr, "PS", "ps_5_0");
 
@@ -663,6 +696,8 @@ void CMeshManager::Create_ScreenAlighedQuad_Shaders_And_InputLayout_Pass3()
 
 void CMeshManager::Create_ScreenAlighedQuad_Geometry_Pass3()
 {
+	PROFILE_FUNCTION();
+
 	std::array<Vertex, 4> VerticesSAQ =
 	{
 		Vertex({ DirectX::XMFLOAT3(1.0f,   1.0f, 0.5f) }),
@@ -676,8 +711,7 @@ void CMeshManager::Create_ScreenAlighedQuad_Geometry_Pass3()
 	m_SQABuff = std::make_unique<MeshGeometry>();
 	m_SQABuff->Name = "SAQ";
 
-	m_SQABuff->VertexBufferGPU = d3dUtil::CreateDefaultBuffer(m_d3dDevice.Get(),
-		m_CommandList.Get(), VerticesSAQ.data(), vbSAQByteSize, m_SQABuff->VertexBufferUploader);
+	m_SQABuff->VertexBufferGPU = Create_Default_Buffer(VerticesSAQ.data(), vbSAQByteSize, m_SQABuff->VertexBufferUploader);
 
 	m_SQABuff->VertexByteStride = sizeof(Vertex);
 	m_SQABuff->VertexBufferByteSize = vbSAQByteSize;
@@ -685,6 +719,8 @@ void CMeshManager::Create_ScreenAlighedQuad_Geometry_Pass3()
 
 void CMeshManager::Create_PipelineStateObject_Pass3()
 {
+	PROFILE_FUNCTION();
+
 	//BuildPSO SAQ
 	CD3DX12_BLEND_DESC blend = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
 	blend.RenderTarget[0].BlendEnable = true;
@@ -721,13 +757,13 @@ void CMeshManager::Create_PipelineStateObject_Pass3()
 	psoDescSAQ.SampleDesc.Count = m_4xMsaaState ? 4 : 1;
 	psoDescSAQ.SampleDesc.Quality = m_4xMsaaState ? (m_4xMsaaQuality - 1) : 0;
 	psoDescSAQ.DSVFormat = m_DepthStencilFormatPass3;
-	ThrowIfFailed(m_d3dDevice->CreateGraphicsPipelineState(&psoDescSAQ, IID_PPV_ARGS(&m_PSOSAQ)));
+	m_PSOSAQ = m_PipelineCache.Create_Graphics(psoDescSAQ);
 }
 
 D3D12_CPU_DESCRIPTOR_HANDLE CMeshManager::CurrentBackBufferView()
 {
 	return CD3DX12_CPU_DESCRIPTOR_HANDLE(
-		m_RtvHeap->GetCPUDescriptorHandleForHeapStart(),
+		m_BackBufferRtv.CpuHandle,
 		m_CurrBackBuffer,
 		m_RtvDescriptorSize);
 }
@@ -739,12 +775,24 @@ ID3D12Resource* CMeshManager::CurrentBackBuffer()
 
 void CMeshManager::Init_MeshManager(HWND hWnd)
 {
+	PROFILE_THREAD_NAME("Main");
+	PROFILE_FUNCTION();
+
 	m_hWnd = hWnd;
 
 	EnableDebugLayer_CreateFactory();
 
 	Create_Device();
 
+	//the adapter of the device, for the pipeline cache id
+	//and the memory budget
+	Microsoft::WRL::ComPtr<IDXGIAdapter> Adapter;
+	m_dxgiFactory->EnumAdapterByLuid(m_d3dDevice->GetAdapterLuid(), IID_PPV_ARGS(&Adapter));
+
+	m_PipelineCache.Init(m_d3dDevice.Get(), Adapter.Get(), PIPELINE_CACHE_FILE);
+
+	m_GpuMemory.Init(m_d3dDevice.Get(), Adapter.Get());
+
 	CreateFence_GetDescriptorsSize();
 
 	Check_Multisample_Quality();
@@ -755,10 +803,12 @@ void CMeshManager::Init_MeshManager(HWND hWnd)
 
 	Resize_SwapChainBuffers();
 
-	Create_Dsv_DescriptorHeaps_And_View_Pass1_Pass2();
-
 	Create_Dsv_DescriptorHeaps_And_View_Pass3();
 
+	Build_Render_Graph();
+
+	Create_Dsv_DescriptorHeaps_And_View_Pass1_Pass2();
+
 	Execute_Init_Commands();
 
 	Update_ViewPort_And_Scissor();
@@ -781,16 +831,24 @@ void CMeshManager::Init_MeshManager(HWND hWnd)
 
 	Create_RTView_Pass1_Pass2();
 
-	Create_SRDescriptorHead_And_View_For_Pass3();
-
 	Create_ScreenAlighedQuad_Shaders_And_InputLayout_Pass3();
 
 	Create_ScreenAlighedQuad_Geometry_Pass3();
 
 	Create_PipelineStateObject_Pass3();
 
+	//the next run loads what was compiled here
+	m_PipelineCache.Save();
+	m_PipelineCache.Log_Stats();
+
 	Execute_Init_Commands();
 
+	//the copies are done, their upload heap buffers can go
+	m_Cube->DisposeUploaders(m_GpuMemory);
+	m_SQABuff->DisposeUploaders(m_GpuMemory);
+
+	m_GpuMemory.Log_Stats();
+
 	DirectX::XMVECTOR Pos = DirectX::XMVectorSet(0, 0.0f, -25.0f, 1.0f);
 	DirectX::XMVECTOR Target = DirectX::XMVectorZero();
 	DirectX::XMVECTOR Up = DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
@@ -801,11 +859,20 @@ void CMeshManager::Init_MeshManager(HWND hWnd)
 	DirectX::XMMATRIX MatProj = DirectX::XMMatrixPerspectiveFovLH(0.25f * DirectX::XM_PI, 4.0f / 3.0f, 1.0f, m_ZFar);
 	XMStoreFloat4x4(&m_Proj, MatProj);
 
+#ifdef FRAME_TIME_COMPARE
+	//the 30 fps cap would hide the difference
+	m_Timer.TimerStart(0);
+#else
 	m_Timer.TimerStart(30);
+#endif
 }
 
 void CMeshManager::Update_MeshManager()
 {
+	PROFILE_FUNCTION();
+
+	Next_Frame_Resource();
+
 	m_Timer.CalculateFPS();
 	float ElapsedTime = m_Timer.GetElaspedTime();
 
@@ -835,23 +902,14 @@ void CMeshManager::Update_MeshManager()
 	DirectX::XMStoreFloat4x4(&ObjConstants.WorldViewProj, DirectX::XMMatrixTranspose(WorldViewProj));
 	ObjConstants.ZFar = m_ZFar;
 	
-	m_ObjectCB->CopyData(0, ObjConstants);
+	m_ObjectCBAddress = m_CurrFrameResource->Constants.Push(ObjConstants);
 }
 
-void CMeshManager::Draw_MeshManager()
+void CMeshManager::Draw_Pass1()
 {
-	ThrowIfFailed(m_DirectCmdListAlloc->Reset());
-
-	ThrowIfFailed(m_CommandList->Reset(m_DirectCmdListAlloc.Get(), m_PSOPass1.Get()));
+	PROFILE_FUNCTION();
 
-	m_CommandList->RSSetViewports(1, &m_ScreenViewport);
-	m_CommandList->RSSetScissorRects(1, &m_ScissorRect);
-
-	//pass1
-	//------------------------------
-
-	//m_CommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_RenderTargetTexPass1.Get(),
-		//D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET));
+	m_CommandList->SetPipelineState(m_PSOPass1.Get());
 
 	const FLOAT ClearColor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
 	m_CommandList->ClearRenderTargetView(m_RTVTexHandle_Pass1, ClearColor, 0, nullptr);
@@ -862,28 +920,29 @@ void CMeshManager::Draw_MeshManager()
 
 	m_CommandList->SetGraphicsRootSignature(m_RootSignature.Get());
 
-	D3D12_GPU_VIRTUAL_ADDRESS cbAddress = m_ObjectCB->Resource()->GetGPUVirtualAddress();
+	D3D12_GPU_VIRTUAL_ADDRESS cbAddress = m_ObjectCBAddress;
 	m_CommandList->SetGraphicsRootConstantBufferView(1, cbAddress);
 
-	m_CommandList->IASetVertexBuffers(0, 1, &m_Cube->VertexBufferView());
+	//both passes only read POSITION, the cube goes with position stream alone
+	D3D12_VERTEX_BUFFER_VIEW Streams[VERTEX_STREAM_COUNT];
+	UINT StreamCount = m_Cube->VertexBufferViews(Streams, 1);
+
+	m_CommandList->IASetVertexBuffers(0, StreamCount, Streams);
 	m_CommandList->IASetIndexBuffer(&m_Cube->IndexBufferView());
 	m_CommandList->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
 	m_CommandList->DrawIndexedInstanced(
 		m_Cube->DrawArgs["box"].IndexCount,
 		1, 0, 0, 0);
+}
 
-	//m_CommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_RenderTargetTexPass1.Get(),
-	//		D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE));
-
-	m_CommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_DepthTargetTex_Pass1.Get(),
-		D3D12_RESOURCE_STATE_DEPTH_WRITE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE));
-	
-	//------------------------------------------
-	//pass 2
+void CMeshManager::Draw_Pass2()
+{
+	PROFILE_FUNCTION();
 
 	m_CommandList->SetPipelineState(m_PSOPass2.Get());
 
+	const FLOAT ClearColor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
 	m_CommandList->ClearRenderTargetView(m_RTVTexHandle_Pass2, ClearColor, 0, nullptr);
 	m_CommandList->ClearDepthStencilView(m_DSViewHandle_Pass2, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
 
@@ -891,27 +950,24 @@ void CMeshManager::Draw_MeshManager()
 
 	m_CommandList->SetGraphicsRootSignature(m_RootSignature.Get());
 
+	D3D12_GPU_VIRTUAL_ADDRESS cbAddress = m_ObjectCBAddress;
 	m_CommandList->SetGraphicsRootConstantBufferView(1, cbAddress);
 
-	m_CommandList->IASetVertexBuffers(0, 1, &m_Cube->VertexBufferView());
+	D3D12_VERTEX_BUFFER_VIEW Streams[VERTEX_STREAM_COUNT];
+	UINT StreamCount = m_Cube->VertexBufferViews(Streams, 1);
+
+	m_CommandList->IASetVertexBuffers(0, StreamCount, Streams);
 	m_CommandList->IASetIndexBuffer(&m_Cube->IndexBufferView());
 	m_CommandList->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
 	m_CommandList->DrawIndexedInstanced(
 		m_Cube->DrawArgs["box"].IndexCount,
 		1, 0, 0, 0);
+}
 
-	//m_CommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_RenderTargetTexPass2.Get(),
-	//D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE));
-
-	m_CommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_DepthTargetTex_Pass2.Get(),
-		D3D12_RESOURCE_STATE_DEPTH_WRITE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE));
-
-	//------------------------------------------
-	//Render SAQ
-
-	m_CommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(CurrentBackBuffer(),
-		D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET));
+void CMeshManager::Draw_SAQ()
+{
+	PROFILE_FUNCTION();
 
 	m_CommandList->SetPipelineState(m_PSOSAQ.Get());
 
@@ -923,31 +979,37 @@ void CMeshManager::Draw_MeshManager()
 
 	m_CommandList->SetGraphicsRootSignature(m_RootSignature.Get());
 
-	ID3D12DescriptorHeap* descriptorHeapsSAQ[] = { m_SrvDescriptorHeapSAQ.Get() };
-	m_CommandList->SetDescriptorHeaps(_countof(descriptorHeapsSAQ), descriptorHeapsSAQ);
-
-	m_CommandList->SetGraphicsRootDescriptorTable(0, m_SrvDescriptorHeapSAQ->GetGPUDescriptorHandleForHeapStart());
+	m_CommandList->SetGraphicsRootDescriptorTable(0, Create_SRView_Table_Pass3());
 
 	m_CommandList->IASetVertexBuffers(0, 1, &m_SQABuff->VertexBufferView());
 	m_CommandList->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
 
 	// 4     2 
 	m_CommandList->DrawInstanced(4, 2, 0, 0);
+}
+
+void CMeshManager::Draw_MeshManager()
+{
+	PROFILE_FUNCTION();
 
-	//m_CommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_RenderTargetTexPass1.Get(),
-		//D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET));
+	//the GPU is done with this allocator, Next_Frame_Resource waited for it
+	ThrowIfFailed(m_CurrFrameResource->CmdListAlloc->Reset());
 
-	//m_CommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_RenderTargetTexPass2.Get(),
-		//D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET));
+	ThrowIfFailed(m_CommandList->Reset(m_CurrFrameResource->CmdListAlloc.Get(), m_PSOPass1.Get()));
 
-	m_CommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_DepthTargetTex_Pass1.Get(),
-		D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_DEPTH_WRITE));
+	m_CommandList->RSSetViewports(1, &m_ScreenViewport);
+	m_CommandList->RSSetScissorRects(1, &m_ScissorRect);
 
-	m_CommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_DepthTargetTex_Pass2.Get(),
-		D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_DEPTH_WRITE));
+	//the only heap switch of the frame, the SAQ table is in it
+	ID3D12DescriptorHeap* descriptorHeaps[] = { m_SrvHeap.Heap() };
+	m_CommandList->SetDescriptorHeaps(_countof(descriptorHeaps), descriptorHeaps);
 
-	m_CommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(CurrentBackBuffer(),
-		D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT));
+	//the graph records the passes, its barriers go through
+	//m_States, the back buffer ends in PRESENT again, both
+	//imports are bound every frame, a resize makes new ones
+	m_Transients.Bind(m_RGBackBuffer, CurrentBackBuffer());
+	m_Transients.Bind(m_RGDepthStencil, m_DepthStencilBuffer.Get());
+	m_Transients.Execute(m_Graph, m_States, m_CommandList.Get());
 
 	ThrowIfFailed(m_CommandList->Close());
 
@@ -958,7 +1020,66 @@ void CMeshManager::Draw_MeshManager()
 
 	m_CurrBackBuffer = (m_CurrBackBuffer + 1) % m_SwapChainBufferCount;
 
-	FlushCommandQueue();
+	//no wait here, the frame resource is reused once the GPU gets to this fence
+	m_CurrFrameResource->Fence = m_Fence.Signal(m_CommandQueue.Get());
+
+	//transient tables of this frame are reused after the same fence
+	m_SrvHeap.Close_Frame(m_CurrFrameResource->Fence);
+
+#ifdef FRAME_TIME_COMPARE
+	Compare_Frame_Time();
+#endif
+}
+
+void CMeshManager::Next_Frame_Resource()
+{
+	PROFILE_FUNCTION();
+
+	m_CurrFrameResourceIndex = (m_CurrFrameResourceIndex + 1) % FRAME_RESOURCE_COUNT;
+	m_CurrFrameResource = m_FrameResources[m_CurrFrameResourceIndex].get();
+
+	//blocks only if the CPU is FRAME_RESOURCE_COUNT frames ahead of the GPU
+	m_Fence.Wait(m_CurrFrameResource->Fence);
+
+	//the GPU has read every block of that frame
+	m_CurrFrameResource->Constants.Reset();
+
+	//and every transient descriptor of the frames before it
+	m_SrvHeap.Release(m_Fence.Completed_Value());
+}
+
+void CMeshManager::Compare_Frame_Time()
+{
+	//the old way, CPU waits for the GPU to go idle every frame
+	if (m_CompareFlush)
+		FlushCommandQueue();
+
+	auto Now = std::chrono::steady_clock::now();
+
+	if (m_CompareFrames++ > 0)
+	{
+		std::chrono::duration<double, std::milli> FrameTime = Now - m_CompareLast;
+		m_CompareFrameTime += FrameTime.count();
+	}
+
+	m_CompareLast = Now;
+
+	if (m_CompareFrames == FRAME_COMPARE_FRAMES)
+	{
+		char Msg[128];
+		if (m_CompareFlush)
+			sprintf_s(Msg, "Frames: flush per frame, %.3f ms per frame, %.3f ms waiting for the GPU\n",
+				m_CompareFrameTime / (FRAME_COMPARE_FRAMES - 1), m_Fence.Blocked_Time() / FRAME_COMPARE_FRAMES);
+		else
+			sprintf_s(Msg, "Frames: %d in flight, %.3f ms per frame, %.3f ms waiting for the GPU\n",
+				FRAME_RESOURCE_COUNT, m_CompareFrameTime / (FRAME_COMPARE_FRAMES - 1), m_Fence.Blocked_Time() / FRAME_COMPARE_FRAMES);
+		OutputDebugStringA(Msg);
+
+		m_CompareFlush = !m_CompareFlush;
+		m_CompareFrames = 0;
+		m_CompareFrameTime = 0.0;
+		m_Fence.Reset_Stats();
+	}
 }
 
 
@@ -22,77 +22,46 @@
 #include <array>
 #include <unordered_map>
 #include <DirectXCollision.h>
+#include <chrono>
 
 #include <directxmath.h>
 
 #include "d3dUtil.h"
+#include "ConstantAllocator.h"
+#include "GpuFence.h"
+#include "GpuMemory.h"
+#include "ResourceStateTracker.h"
+#include "TransientHeap.h"
+#include "Profiler.h"
+#include "PipelineCache.h"
+#include "DescriptorHeap.h"
 
 #include "Timer.h"
 
-#pragma comment(lib,"d3dcompiler.lib")
-#pragma comment(lib, "D3D12.lib")
-#pragma comment(lib, "dxgi.lib")
+//frames the CPU may record ahead of the GPU, 2 or 3
+#define FRAME_RESOURCE_COUNT 3
 
-template<typename T>
-class UploadBuffer
-{
-public:
-	UploadBuffer(ID3D12Device* device, UINT elementCount, bool isConstantBuffer) :
-		mIsConstantBuffer(isConstantBuffer)
-	{
-		mElementByteSize = sizeof(T);
-
-		// Constant buffer elements need to be multiples of 256 bytes.
-		// This is because the hardware can only MatView constant data 
-		// at m*256 byte offsets and of n*256 byte lengths. 
-		// typedef struct D3D12_CONSTANT_BUFFER_VIEW_DESC {
-		// UINT64 OffsetInBytes; // multiple of 256
-		// UINT   SizeInBytes;   // multiple of 256
-		// } D3D12_CONSTANT_BUFFER_VIEW_DESC;
-		if (isConstantBuffer)
-			mElementByteSize = d3dUtil::CalcConstantBufferByteSize(sizeof(T));
-
-		ThrowIfFailed(device->CreateCommittedResource(
-			&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
-			D3D12_HEAP_FLAG_NONE,
-			&CD3DX12_RESOURCE_DESC::Buffer(mElementByteSize * elementCount),
-			D3D12_RESOURCE_STATE_GENERIC_READ,
-			nullptr,
-			IID_PPV_ARGS(&mUploadBuffer)));
-
-		ThrowIfFailed(mUploadBuffer->Map(0, nullptr, reinterpret_cast<void**>(&mMappedData)));
-
-		// We do not need to unmap until we are done with the resource.  However, we must not write to
-		// the resource while it is in use by the GPU (so we must use synchronization techniques).
-	}
+//constant blocks one frame can allocate, in bytes
+#define FRAME_CONSTANT_SIZE (64 * 1024)
 
-	UploadBuffer(const UploadBuffer& rhs) = delete;
-	UploadBuffer& operator=(const UploadBuffer& rhs) = delete;
-	~UploadBuffer()
-	{
-		if (mUploadBuffer != nullptr)
-			mUploadBuffer->Unmap(0, nullptr);
+//descriptors of the one shader visible heap, the SAQ table is
+//made again every frame from the graph textures, so all of it
+//is the transient part
+#define SRV_HEAP_PERSISTENT 0
+#define SRV_HEAP_TRANSIENT 64
 
-		mMappedData = nullptr;
-	}
-
-	ID3D12Resource* Resource()const
-	{
-		return mUploadBuffer.Get();
-	}
-
-	void CopyData(int elementIndex, const T& data)
-	{
-		memcpy(&mMappedData[elementIndex * mElementByteSize], &data, sizeof(T));
-	}
+//CPU only heaps of the render target and depth views
+#define RTV_HEAP_SIZE 16
+#define DSV_HEAP_SIZE 4
 
-private:
-	Microsoft::WRL::ComPtr<ID3D12Resource> mUploadBuffer;
-	BYTE* mMappedData = nullptr;
+//switches between a flush per frame and frames in flight every
+//FRAME_COMPARE_FRAMES frames and logs the frame time of each
+//#define FRAME_TIME_COMPARE
+#define FRAME_COMPARE_FRAMES 256
 
-	UINT mElementByteSize = 0;
-	bool mIsConstantBuffer = false;
-};
+#pragma comment(lib,"d3dcompiler.lib")
+#pragma comment(lib, "D3D12.lib")
+#pragma comment(lib, "dxgi.lib")
 
 static DirectX::XMFLOAT4X4 Identity4x4()
 {
@@ -112,11 +81,21 @@ struct ObjectConstants
 	float ZFar = 0.0f;
 };
 
+//position stream (stream 0) vertex
 struct Vertex
 {
 	DirectX::XMFLOAT3 Pos;
 };
 
+//vertex buffer slots of split stream meshes, depth only
+//passes bind just the position stream
+enum
+{
+	VERTEX_STREAM_POSITION = 0,
+	VERTEX_STREAM_ATTRIB = 1,
+	VERTEX_STREAM_COUNT = 2
+};
+
 struct SubmeshGeometry
 {
 	UINT IndexCount = 0;
@@ -139,11 +118,15 @@ struct MeshGeometry
 	Microsoft::WRL::ComPtr<ID3DBlob> VertexBufferCPU = nullptr;
 	Microsoft::WRL::ComPtr<ID3DBlob> IndexBufferCPU = nullptr;
 
-	Microsoft::WRL::ComPtr<ID3D12Resource> VertexBufferGPU = nullptr;
-	Microsoft::WRL::ComPtr<ID3D12Resource> IndexBufferGPU = nullptr;
+	GpuAllocation VertexBufferGPU;
+	GpuAllocation IndexBufferGPU;
 
-	Microsoft::WRL::ComPtr<ID3D12Resource> VertexBufferUploader = nullptr;
-	Microsoft::WRL::ComPtr<ID3D12Resource> IndexBufferUploader = nullptr;
+	GpuAllocation VertexBufferUploader;
+	GpuAllocation IndexBufferUploader;
+
+	//optional second stream with everything but the position
+	GpuAllocation AttribBufferGPU;
+	GpuAllocation AttribBufferUploader;
 
 	// Data about the buffers.
 	UINT VertexByteStride = 0;
@@ -151,6 +134,9 @@ struct MeshGeometry
 	DXGI_FORMAT IndexFormat = DXGI_FORMAT_R16_UINT;
 	UINT IndexBufferByteSize = 0;
 
+	UINT AttribByteStride = 0;
+	UINT AttribBufferByteSize = 0;
+
 	// A MeshGeometry may store multiple geometries in one vertex/index buffer.
 	// Use this container to define the Submesh geometries so we can draw
 	// the Submeshes individually.
@@ -159,7 +145,7 @@ struct MeshGeometry
 	D3D12_VERTEX_BUFFER_VIEW VertexBufferView()const
 	{
 		D3D12_VERTEX_BUFFER_VIEW vbv;
-		vbv.BufferLocation = VertexBufferGPU->GetGPUVirtualAddress();
+		vbv.BufferLocation = VertexBufferGPU.GpuAddress;
 		vbv.StrideInBytes = VertexByteStride;
 		vbv.SizeInBytes = VertexBufferByteSize;
 
@@ -169,23 +155,70 @@ struct MeshGeometry
 	D3D12_INDEX_BUFFER_VIEW IndexBufferView()const
 	{
 		D3D12_INDEX_BUFFER_VIEW ibv;
-		ibv.BufferLocation = IndexBufferGPU->GetGPUVirtualAddress();
+		ibv.BufferLocation = IndexBufferGPU.GpuAddress;
 		ibv.Format = IndexFormat;
 		ibv.SizeInBytes = IndexBufferByteSize;
 
 		return ibv;
 	}
 
+	D3D12_VERTEX_BUFFER_VIEW AttribBufferView()const
+	{
+		D3D12_VERTEX_BUFFER_VIEW vbv;
+		vbv.BufferLocation = AttribBufferGPU.GpuAddress;
+		vbv.StrideInBytes = AttribByteStride;
+		vbv.SizeInBytes = AttribBufferByteSize;
+
+		return vbv;
+	}
+
+	//fills views for IASetVertexBuffers, StreamCount 1 - position
+	//only, 2 - position and attributes, returns views filled
+	UINT VertexBufferViews(D3D12_VERTEX_BUFFER_VIEW* Views, UINT StreamCount)const
+	{
+		Views[VERTEX_STREAM_POSITION] = VertexBufferView();
+
+		if (StreamCount < VERTEX_STREAM_COUNT || AttribBufferGPU.Resource == nullptr)
+			return 1;
+
+		Views[VERTEX_STREAM_ATTRIB] = AttribBufferView();
+
+		return VERTEX_STREAM_COUNT;
+	}
+
 	// We can free this memory after we finish upload to the GPU.
-	void DisposeUploaders()
+	void DisposeUploaders(CGpuMemory& Memory)
 	{
-		VertexBufferUploader = nullptr;
-		IndexBufferUploader = nullptr;
+		Memory.Free(VertexBufferUploader);
+		Memory.Free(IndexBufferUploader);
+		Memory.Free(AttribBufferUploader);
 	}
 };
 
 enum { A, B, C, D, E, F, G, H };
 
+//what one frame in flight owns, reused when
+//the GPU has passed Fence
+struct FrameResource
+{
+	FrameResource(ID3D12Device* device)
+	{
+		ThrowIfFailed(device->CreateCommandAllocator(
+			D3D12_COMMAND_LIST_TYPE_DIRECT,
+			IID_PPV_ARGS(CmdListAlloc.GetAddressOf())));
+
+		Constants.Init(device, FRAME_CONSTANT_SIZE);
+	}
+
+	FrameResource(const FrameResource& rhs) = delete;
+	FrameResource& operator=(const FrameResource& rhs) = delete;
+
+	Microsoft::WRL::ComPtr<ID3D12CommandAllocator> CmdListAlloc;
+	CConstantAllocator Constants;
+
+	UINT64 Fence = 0;
+};
+
 class CMeshManager
 {
 public:
@@ -197,6 +230,9 @@ public:
 	void Update_MeshManager();
 	void Draw_MeshManager();
 
+	//frame time percentiles to the debug output and files
+	void Export_Frame_Stats();
+
 private:
 
 	void EnableDebugLayer_CreateFactory();
@@ -207,8 +243,11 @@ private:
 	void Create_SwapChain();
 	void Resize_SwapChainBuffers();
 	void FlushCommandQueue();
+	void Next_Frame_Resource();
+	void Compare_Frame_Time();
 	void Create_Dsv_DescriptorHeaps_And_View_Pass1_Pass2();
 	void Create_Dsv_DescriptorHeaps_And_View_Pass3();
+	void Build_Render_Graph();
 	D3D12_CPU_DESCRIPTOR_HANDLE DepthStencilView();
 	void Execute_Init_Commands();
 	void Update_ViewPort_And_Scissor();
@@ -218,27 +257,45 @@ private:
 	std::array<const CD3DX12_STATIC_SAMPLER_DESC, 6> GetStaticSamplers();
 	void Create_Cube_Shaders_And_InputLayout_Pass1_Pass2();
 	void Create_Cube_Geometry_Pass1_Pass2();
+	//buffer and its upload buffer, the copy is recorded on m_CommandList
+	GpuAllocation Create_Default_Buffer(const void* Data, UINT64 ByteSize, GpuAllocation& Uploader);
 	void Create_PipelineStateObject_Pass1();
 	void Create_PipelineStateObject_Pass2();
 	void Create_RTVDescriptorHeap_Pass1_Pass2();
 	void Create_RTView_Pass1_Pass2();
-	void Create_SRDescriptorHead_And_View_For_Pass3();
+	//table of the SAQ pass in the transient part of m_SrvHeap
+	D3D12_GPU_DESCRIPTOR_HANDLE Create_SRView_Table_Pass3();
 	void Create_ScreenAlighedQuad_Shaders_And_InputLayout_Pass3();
 	void Create_ScreenAlighedQuad_Geometry_Pass3();
 	void Create_PipelineStateObject_Pass3();
 	D3D12_CPU_DESCRIPTOR_HANDLE CurrentBackBufferView();
 	ID3D12Resource* CurrentBackBuffer();
+	void Draw_Pass1();
+	void Draw_Pass2();
+	void Draw_SAQ();
 
 	CTimer m_Timer;
 
 	Microsoft::WRL::ComPtr<IDXGIFactory4> m_dxgiFactory;
 	Microsoft::WRL::ComPtr<ID3D12Device> m_d3dDevice;
-	Microsoft::WRL::ComPtr<ID3D12Fence> m_Fence;
+	CGpuFence m_Fence;
+
+	//pipeline states of the last run, goes before the states it makes
+	CPipelineCache m_PipelineCache;
+
+	//heaps of the placed resources, goes after everything placed in it
+	CGpuMemory m_GpuMemory;
 
 	UINT m_RtvDescriptorSize = 0;
 	UINT m_DsvDescriptorSize = 0;
 	UINT m_CbvSrvUavDescriptorSize = 0;
 
+	//every view of the sample, SetDescriptorHeaps is called
+	//once per command list
+	CDescriptorHeap m_SrvHeap;
+	CDescriptorHeap m_RtvHeap;
+	CDescriptorHeap m_DsvHeap;
+
 	DXGI_FORMAT m_BackBufferFormat = DXGI_FORMAT_R8G8B8A8_UNORM;
 
 	bool      m_4xMsaaState = false;    // 4X MSAA enabled
@@ -257,17 +314,28 @@ private:
 
 	Microsoft::WRL::ComPtr<ID3D12Resource> m_SwapChainBuffer[m_SwapChainBufferCount];
 	Microsoft::WRL::ComPtr<ID3D12Resource> m_DepthStencilBuffer;
+	GpuAllocation m_DepthStencilMemory;
 
-	HWND m_hWnd;
+	//every barrier of the samples goes through here
+	CResourceStateTracker m_States;
+
+	//passes of a frame, the depth and color targets of
+	//pass1 and pass2 are transient textures of the graph
+	CRenderGraph m_Graph;
+	CTransientHeap m_Transients;
 
-	UINT64 m_CurrentFence = 0;
+	uint32_t m_RGBackBuffer = RG_INVALID;
+	uint32_t m_RGDepthStencil = RG_INVALID;
+	uint32_t m_RGDepthPass1 = RG_INVALID;
+	uint32_t m_RGDepthPass2 = RG_INVALID;
+	uint32_t m_RGRenderTargetPass1 = RG_INVALID;
+	uint32_t m_RGRenderTargetPass2 = RG_INVALID;
+
+	HWND m_hWnd;
 
 	DXGI_FORMAT m_DepthStencilFormatPass1Pass2 = DXGI_FORMAT_D32_FLOAT;
 	DXGI_FORMAT m_DepthStencilFormatPass3 = DXGI_FORMAT_D24_UNORM_S8_UINT;
 
-	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> m_DsvHeapPass1Pass2;
-	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> m_DsvHeapPass3;
-
 	CD3DX12_CPU_DESCRIPTOR_HANDLE m_DSViewHandle_Pass1;
 	CD3DX12_CPU_DESCRIPTOR_HANDLE m_DSViewHandle_Pass2;
 	CD3DX12_CPU_DESCRIPTOR_HANDLE m_DSViewHandle_Pass3;
@@ -280,9 +348,19 @@ private:
 	D3D12_VIEWPORT m_ScreenViewport;
 	D3D12_RECT m_ScissorRect;
 
-	std::unique_ptr<UploadBuffer<ObjectConstants>> m_ObjectCB = nullptr;
+	std::vector<std::unique_ptr<FrameResource>> m_FrameResources;
+	FrameResource* m_CurrFrameResource = nullptr;
+	int m_CurrFrameResourceIndex = 0;
+
+	//object constants of the current frame
+	D3D12_GPU_VIRTUAL_ADDRESS m_ObjectCBAddress = 0;
 
-	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> m_RtvHeap;
+	bool m_CompareFlush = false;
+	UINT m_CompareFrames = 0;
+	double m_CompareFrameTime = 0.0;
+	std::chrono::steady_clock::time_point m_CompareLast;
+
+	DescriptorRange m_BackBufferRtv;
 
 	int m_CurrBackBuffer = 0;
 
@@ -298,16 +376,12 @@ private:
 	Microsoft::WRL::ComPtr<ID3D12PipelineState> m_PSOPass1 = nullptr;
 	Microsoft::WRL::ComPtr<ID3D12PipelineState> m_PSOPass2 = nullptr;
 
-	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> m_RtvHeapRTTex;
-
 	CD3DX12_CPU_DESCRIPTOR_HANDLE m_RTVTexHandle_Pass1;
 	CD3DX12_CPU_DESCRIPTOR_HANDLE m_RTVTexHandle_Pass2;
 
 	Microsoft::WRL::ComPtr<ID3D12Resource> m_RenderTargetTexPass1;
 	Microsoft::WRL::ComPtr<ID3D12Resource> m_RenderTargetTexPass2;
 
-	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> m_SrvDescriptorHeapSAQ = nullptr;
-
 	Microsoft::WRL::ComPtr<ID3DBlob> m_VsByteCodeSAQ = nullptr;
 	Microsoft::WRL::ComPtr<ID3DBlob> m_PsByteCodeSAQ = nullptr;
 
@@ -0,0 +1,63 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Monotonic Clock
+//======================================================================================
+
+#include "MonotonicClock.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#ifndef CLOCK_MONOTONIC_RAW
+#define CLOCK_MONOTONIC_RAW CLOCK_MONOTONIC
+#endif
+#endif
+
+int64_t CMonotonicClock::Ticks() const
+{
+#ifdef _WIN32
+	LARGE_INTEGER Counter;
+	QueryPerformanceCounter(&Counter);
+	return Counter.QuadPart;
+#else
+	timespec Ts;
+	clock_gettime(CLOCK_MONOTONIC_RAW, &Ts);
+	return (int64_t)Ts.tv_sec * 1000000000LL + Ts.tv_nsec;
+#endif
+}
+
+int64_t CMonotonicClock::Frequency() const
+{
+#ifdef _WIN32
+	//fixed at boot, read once
+	static const int64_t Freq = []()
+	{
+		LARGE_INTEGER Freq;
+		QueryPerformanceFrequency(&Freq);
+		return Freq.QuadPart;
+	}();
+
+	return Freq;
+#else
+	return 1000000000LL;
+#endif
+}
+
+const CMonotonicClock& CMonotonicClock::System()
+{
+	static const CMonotonicClock Clock;
+	return Clock;
+}
+
+double CMonotonicClock::To_Seconds(int64_t Ticks, int64_t Frequency)
+{
+	int64_t Whole = Ticks / Frequency;
+	int64_t Rest = Ticks % Frequency;
+
+	return (double)Whole + (double)Rest / (double)Frequency;
+}
+
+int64_t CMonotonicClock::To_Microseconds(int64_t Ticks, int64_t Frequency)
+{
+	return Ticks / Frequency * 1000000 + Ticks % Frequency * 1000000 / Frequency;
+}
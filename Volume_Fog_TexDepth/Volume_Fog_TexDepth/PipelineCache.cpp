@@ -0,0 +1,324 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Pipeline Cache DirectX12
+//======================================================================================
+
+#include "PipelineCache.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+//description fields one by one, struct padding is never hashed
+class CKeyWriter
+{
+public:
+	template<typename T>
+	void Add(const T& Value)
+	{
+		const uint8_t* p = reinterpret_cast<const uint8_t*>(&Value);
+		m_Bytes.insert(m_Bytes.end(), p, p + sizeof(T));
+	}
+
+	void Add_String(const char* Text)
+	{
+		uint32_t Length = Text ? (uint32_t)strlen(Text) : 0;
+		Add(Length);
+		m_Bytes.insert(m_Bytes.end(), Text, Text + Length);
+	}
+
+	void Add_Shader(const D3D12_SHADER_BYTECODE& Shader)
+	{
+		Add((uint64_t)Shader.BytecodeLength);
+		Add(Shader.BytecodeLength ? HashBytes(Shader.pShaderBytecode, Shader.BytecodeLength) : 0);
+	}
+
+	uint64_t Key() const { return HashBytes(m_Bytes.data(), m_Bytes.size()); }
+
+private:
+	std::vector<uint8_t> m_Bytes;
+};
+
+static void Pipeline_Name(uint64_t Key, wchar_t (&Name)[17])
+{
+	swprintf_s(Name, L"%016llx", (unsigned long long)Key);
+}
+
+void CPipelineCache::Init(ID3D12Device* Device, IDXGIAdapter* Adapter, const char* FileName)
+{
+	m_Device = Device;
+	m_FileName = FileName;
+
+	if (Adapter != nullptr)
+	{
+		DXGI_ADAPTER_DESC AdapterDesc;
+		if (SUCCEEDED(Adapter->GetDesc(&AdapterDesc)))
+		{
+			m_Id.VendorId = AdapterDesc.VendorId;
+			m_Id.DeviceId = AdapterDesc.DeviceId;
+			m_Id.SubSysId = AdapterDesc.SubSysId;
+			m_Id.Revision = AdapterDesc.Revision;
+		}
+
+		//user mode driver version
+		LARGE_INTEGER Version;
+		if (SUCCEEDED(Adapter->CheckInterfaceSupport(__uuidof(IDXGIDevice), &Version)))
+			m_Id.DriverVersion = (uint64_t)Version.QuadPart;
+	}
+
+	ReadPipelineCache(m_FileName.c_str(), m_Id, m_LibraryData, m_Entries);
+
+	//ID3D12PipelineLibrary needs ID3D12Device1 and driver support
+	Microsoft::WRL::ComPtr<ID3D12Device1> Device1;
+	if (FAILED(Device->QueryInterface(IID_PPV_ARGS(Device1.GetAddressOf()))))
+		return;
+
+	HRESULT hr = Device1->CreatePipelineLibrary(m_LibraryData.data(), m_LibraryData.size(),
+		IID_PPV_ARGS(m_Library.GetAddressOf()));
+
+	if (FAILED(hr) && !m_LibraryData.empty())
+	{
+		//D3D12_ERROR_DRIVER_VERSION_MISMATCH and the like,
+		//the blobs were made by the same driver, drop them too
+		OutputDebugStringA("Pipeline cache: the driver refused the pipeline library, starting over\n");
+
+		m_LibraryData.clear();
+		m_Entries.clear();
+		m_Dirty = true;
+
+		hr = Device1->CreatePipelineLibrary(nullptr, 0, IID_PPV_ARGS(m_Library.GetAddressOf()));
+	}
+
+	//DXGI_ERROR_UNSUPPORTED, CachedPSO blobs only
+	if (FAILED(hr))
+		m_Library = nullptr;
+}
+
+void CPipelineCache::Add_Root_Signature(ID3D12RootSignature* Root, const void* Blob, size_t Size)
+{
+	m_RootKeys[Root] = HashBytes(Blob, Size);
+}
+
+uint64_t CPipelineCache::Pipeline_Key(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& Desc) const
+{
+	CKeyWriter Writer;
+
+	auto Root = m_RootKeys.find(Desc.pRootSignature);
+	Writer.Add(Root != m_RootKeys.end() ? Root->second : (uint64_t)0);
+
+	Writer.Add_Shader(Desc.VS);
+	Writer.Add_Shader(Desc.PS);
+	Writer.Add_Shader(Desc.DS);
+	Writer.Add_Shader(Desc.HS);
+	Writer.Add_Shader(Desc.GS);
+
+	const D3D12_STREAM_OUTPUT_DESC& StreamOutput = Desc.StreamOutput;
+	Writer.Add(StreamOutput.NumEntries);
+	for (UINT i = 0; i < StreamOutput.NumEntries; i++)
+	{
+		const D3D12_SO_DECLARATION_ENTRY& Entry = StreamOutput.pSODeclaration[i];
+		Writer.Add(Entry.Stream);
+		Writer.Add_String(Entry.SemanticName);
+		Writer.Add(Entry.SemanticIndex);
+		Writer.Add(Entry.StartComponent);
+		Writer.Add(Entry.ComponentCount);
+		Writer.Add(Entry.OutputSlot);
+	}
+	Writer.Add(StreamOutput.NumStrides);
+	for (UINT i = 0; i < StreamOutput.NumStrides; i++)
+		Writer.Add(StreamOutput.pBufferStrides[i]);
+	Writer.Add(StreamOutput.RasterizedStream);
+
+	const D3D12_BLEND_DESC& Blend = Desc.BlendState;
+	Writer.Add(Blend.AlphaToCoverageEnable);
+	Writer.Add(Blend.IndependentBlendEnable);
+	for (int i = 0; i < D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT; i++)
+	{
+		const D3D12_RENDER_TARGET_BLEND_DESC& Target = Blend.RenderTarget[i];
+		Writer.Add(Target.BlendEnable);
+		Writer.Add(Target.LogicOpEnable);
+		Writer.Add(Target.SrcBlend);
+		Writer.Add(Target.DestBlend);
+		Writer.Add(Target.BlendOp);
+		Writer.Add(Target.SrcBlendAlpha);
+		Writer.Add(Target.DestBlendAlpha);
+		Writer.Add(Target.BlendOpAlpha);
+		Writer.Add(Target.LogicOp);
+		Writer.Add(Target.RenderTargetWriteMask);
+	}
+
+	Writer.Add(Desc.SampleMask);
+
+	const D3D12_RASTERIZER_DESC& Rasterizer = Desc.RasterizerState;
+	Writer.Add(Rasterizer.FillMode);
+	Writer.Add(Rasterizer.CullMode);
+	Writer.Add(Rasterizer.FrontCounterClockwise);
+	Writer.Add(Rasterizer.DepthBias);
+	Writer.Add(Rasterizer.DepthBiasClamp);
+	Writer.Add(Rasterizer.SlopeScaledDepthBias);
+	Writer.Add(Rasterizer.DepthClipEnable);
+	Writer.Add(Rasterizer.MultisampleEnable);
+	Writer.Add(Rasterizer.AntialiasedLineEnable);
+	Writer.Add(Rasterizer.ForcedSampleCount);
+	Writer.Add(Rasterizer.ConservativeRaster);
+
+	const D3D12_DEPTH_STENCIL_DESC& DepthStencil = Desc.DepthStencilState;
+	Writer.Add(DepthStencil.DepthEnable);
+	Writer.Add(DepthStencil.DepthWriteMask);
+	Writer.Add(DepthStencil.DepthFunc);
+	Writer.Add(DepthStencil.StencilEnable);
+	Writer.Add(DepthStencil.StencilReadMask);
+	Writer.Add(DepthStencil.StencilWriteMask);
+	for (const D3D12_DEPTH_STENCILOP_DESC* Face : { &DepthStencil.FrontFace, &DepthStencil.BackFace })
+	{
+		Writer.Add(Face->StencilFailOp);
+		Writer.Add(Face->StencilDepthFailOp);
+		Writer.Add(Face->StencilPassOp);
+		Writer.Add(Face->StencilFunc);
+	}
+
+	const D3D12_INPUT_LAYOUT_DESC& Layout = Desc.InputLayout;
+	Writer.Add(Layout.NumElements);
+	for (UINT i = 0; i < Layout.NumElements; i++)
+	{
+		const D3D12_INPUT_ELEMENT_DESC& Element = Layout.pInputElementDescs[i];
+		Writer.Add_String(Element.SemanticName);
+		Writer.Add(Element.SemanticIndex);
+		Writer.Add(Element.Format);
+		Writer.Add(Element.InputSlot);
+		Writer.Add(Element.AlignedByteOffset);
+		Writer.Add(Element.InputSlotClass);
+		Writer.Add(Element.InstanceDataStepRate);
+	}
+
+	Writer.Add(Desc.IBStripCutValue);
+	Writer.Add(Desc.PrimitiveTopologyType);
+	Writer.Add(Desc.NumRenderTargets);
+	for (int i = 0; i < D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT; i++)
+		Writer.Add(Desc.RTVFormats[i]);
+	Writer.Add(Desc.DSVFormat);
+	Writer.Add(Desc.SampleDesc.Count);
+	Writer.Add(Desc.SampleDesc.Quality);
+	Writer.Add(Desc.NodeMask);
+	Writer.Add(Desc.Flags);
+
+	return Writer.Key();
+}
+
+bool CPipelineCache::Load(uint64_t Key, const PipelineCacheEntry& Entry, const D3D12_GRAPHICS_PIPELINE_STATE_DESC& Desc,
+	Microsoft::WRL::ComPtr<ID3D12PipelineState>& Pso)
+{
+	if (Entry.Blob.empty())
+	{
+		if (m_Library == nullptr)
+			return false;
+
+		wchar_t Name[17];
+		Pipeline_Name(Key, Name);
+
+		return SUCCEEDED(m_Library->LoadGraphicsPipeline(Name, &Desc, IID_PPV_ARGS(Pso.GetAddressOf())));
+	}
+
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC CachedDesc = Desc;
+	CachedDesc.CachedPSO.pCachedBlob = Entry.Blob.data();
+	CachedDesc.CachedPSO.CachedBlobSizeInBytes = Entry.Blob.size();
+
+	//D3D12_ERROR_DRIVER_VERSION_MISMATCH if the blob is stale
+	return SUCCEEDED(m_Device->CreateGraphicsPipelineState(&CachedDesc, IID_PPV_ARGS(Pso.GetAddressOf())));
+}
+
+void CPipelineCache::Store(uint64_t Key, double CompileTime, ID3D12PipelineState* Pso)
+{
+	PipelineCacheEntry Entry;
+	Entry.CompileTime = CompileTime;
+
+	if (m_Library != nullptr)
+	{
+		wchar_t Name[17];
+		Pipeline_Name(Key, Name);
+
+		if (SUCCEEDED(m_Library->StorePipeline(Name, Pso)))
+		{
+			m_Entries[Key] = Entry;
+			m_Dirty = true;
+			return;
+		}
+	}
+
+	//no library, or the name is taken by a pipeline it would not load
+	Microsoft::WRL::ComPtr<ID3DBlob> Blob;
+	if (FAILED(Pso->GetCachedBlob(Blob.GetAddressOf())))
+		return;
+
+	const uint8_t* Data = reinterpret_cast<const uint8_t*>(Blob->GetBufferPointer());
+	Entry.Blob.assign(Data, Data + Blob->GetBufferSize());
+
+	m_Entries[Key] = std::move(Entry);
+	m_Dirty = true;
+}
+
+Microsoft::WRL::ComPtr<ID3D12PipelineState> CPipelineCache::Create_Graphics(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& Desc)
+{
+	uint64_t Key = Pipeline_Key(Desc);
+
+	Microsoft::WRL::ComPtr<ID3D12PipelineState> Pso;
+
+	auto Start = std::chrono::steady_clock::now();
+
+	auto It = m_Entries.find(Key);
+	if (It != m_Entries.end() && Load(Key, It->second, Desc, Pso))
+	{
+		std::chrono::duration<double, std::milli> HitTime = std::chrono::steady_clock::now() - Start;
+
+		m_Hits++;
+		m_HitTime += HitTime.count();
+		m_SavedTime += std::max(0.0, It->second.CompileTime - HitTime.count());
+
+		return Pso;
+	}
+
+	ThrowIfFailed(m_Device->CreateGraphicsPipelineState(&Desc, IID_PPV_ARGS(Pso.GetAddressOf())));
+
+	std::chrono::duration<double, std::milli> MissTime = std::chrono::steady_clock::now() - Start;
+
+	m_Misses++;
+	m_MissTime += MissTime.count();
+
+	Store(Key, MissTime.count(), Pso.Get());
+
+	return Pso;
+}
+
+void CPipelineCache::Save()
+{
+	if (!m_Dirty)
+		return;
+
+	m_Dirty = false;
+
+	std::vector<uint8_t> Library;
+
+	if (m_Library != nullptr)
+	{
+		Library.resize(m_Library->GetSerializedSize());
+
+		//entries without a blob miss next time, nothing worse
+		if (!Library.empty() && FAILED(m_Library->Serialize(Library.data(), Library.size())))
+			Library.clear();
+	}
+
+	if (!CreateAssetCacheDir(ASSET_CACHE_DIR) ||
+		!WritePipelineCache(m_FileName.c_str(), m_Id, Library.data(), Library.size(), m_Entries))
+		OutputDebugStringA("Pipeline cache: could not write the cache file\n");
+}
+
+void CPipelineCache::Log_Stats()
+{
+	UINT Total = m_Hits + m_Misses;
+
+	char Msg[256];
+	sprintf_s(Msg, "Pipeline cache: %u of %u hits (%.0f%%) from %s, %.2f ms loading, %.2f ms compiling, about %.2f ms saved\n",
+		m_Hits, Total, Total ? 100.0 * m_Hits / Total : 0.0,
+		m_Library != nullptr ? "the pipeline library" : "cached blobs",
+		m_HitTime, m_MissTime, m_SavedTime);
+	OutputDebugStringA(Msg);
+}
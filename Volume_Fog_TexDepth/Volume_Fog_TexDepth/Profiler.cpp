@@ -0,0 +1,220 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Profiler
+//======================================================================================
+
+#include "Profiler.h"
+#include "MonotonicClock.h"
+
+#include <cstdio>
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <vector>
+
+#if defined(_WIN32) && defined(__has_include)
+#if __has_include(<pix3.h>)
+#define USE_PIX
+#include <windows.h>
+#include <pix3.h>
+#pragma comment(lib, "WinPixEventRuntime.lib")
+#define PROFILER_PIX
+#endif
+#endif
+
+static FILE* Open_File(const char* FileName, const char* Mode)
+{
+	FILE* Fp = NULL;
+#ifdef _WIN32
+	fopen_s(&Fp, FileName, Mode);
+#else
+	Fp = fopen(FileName, Mode);
+#endif
+	return Fp;
+}
+
+struct ProfileEvent
+{
+	const char* Name;
+	int64_t Begin;
+	int64_t End;
+};
+
+struct ProfileOpen
+{
+	const char* Name;
+	int64_t Begin;
+};
+
+//written only by its own thread, Written is published with
+//release so the exporter sees whole events
+struct ProfileThread
+{
+	uint32_t Id = 0;
+	const char* Name = nullptr;
+
+	ProfileOpen Stack[PROFILER_MAX_DEPTH];
+	uint32_t Depth = 0;
+
+	ProfileEvent Events[PROFILER_RING_SIZE];
+	std::atomic<uint64_t> Written{ 0 };
+};
+
+//buffers live until exit, so a finished thread still exports
+static std::mutex g_ThreadsMutex;
+static std::vector<std::unique_ptr<ProfileThread>> g_Threads;
+
+static thread_local ProfileThread* t_Thread = nullptr;
+static thread_local const char* t_ThreadName = nullptr;
+
+static ProfileThread* Get_Thread()
+{
+	if (t_Thread != nullptr)
+		return t_Thread;
+
+	//first marker on this thread, the only allocation it makes
+	std::unique_ptr<ProfileThread> Thread(new ProfileThread());
+	Thread->Name = t_ThreadName;
+
+	std::lock_guard<std::mutex> Lock(g_ThreadsMutex);
+
+	Thread->Id = (uint32_t)g_Threads.size() + 1;
+	t_Thread = Thread.get();
+	g_Threads.push_back(std::move(Thread));
+
+	return t_Thread;
+}
+
+void CProfiler::Begin(const char* Name)
+{
+	ProfileThread* Thread = Get_Thread();
+
+	//too deep scopes are counted but not recorded
+	if (Thread->Depth < PROFILER_MAX_DEPTH)
+	{
+		Thread->Stack[Thread->Depth].Name = Name;
+		Thread->Stack[Thread->Depth].Begin = CMonotonicClock::System().Ticks();
+	}
+
+	Thread->Depth++;
+
+#ifdef PROFILER_PIX
+	PIXBeginEvent(PIX_COLOR_INDEX(Thread->Depth), Name);
+#endif
+}
+
+void CProfiler::End()
+{
+	ProfileThread* Thread = t_Thread;
+	if (Thread == nullptr || Thread->Depth == 0)
+		return;
+
+#ifdef PROFILER_PIX
+	PIXEndEvent();
+#endif
+
+	Thread->Depth--;
+
+	if (Thread->Depth >= PROFILER_MAX_DEPTH)
+		return;
+
+	uint64_t Index = Thread->Written.load(std::memory_order_relaxed);
+
+	ProfileEvent& Event = Thread->Events[Index % PROFILER_RING_SIZE];
+	Event.Name = Thread->Stack[Thread->Depth].Name;
+	Event.Begin = Thread->Stack[Thread->Depth].Begin;
+	Event.End = CMonotonicClock::System().Ticks();
+
+	Thread->Written.store(Index + 1, std::memory_order_release);
+}
+
+void CProfiler::Set_Thread_Name(const char* Name)
+{
+	t_ThreadName = Name;
+
+	if (t_Thread != nullptr)
+		t_Thread->Name = Name;
+}
+
+static void Write_String(FILE* Fp, const char* Str)
+{
+	fputc('"', Fp);
+
+	for (; *Str; Str++)
+	{
+		if (*Str == '"' || *Str == '\\')
+			fputc('\\', Fp);
+
+		if ((unsigned char)*Str >= 0x20)
+			fputc(*Str, Fp);
+	}
+
+	fputc('"', Fp);
+}
+
+bool CProfiler::Write_Trace(const char* FileName)
+{
+	std::lock_guard<std::mutex> Lock(g_ThreadsMutex);
+
+	if (g_Threads.empty())
+		return false;
+
+	//times are relative to the earliest event in the trace
+	int64_t Base = INT64_MAX;
+	for (const auto& Thread : g_Threads)
+	{
+		uint64_t Written = Thread->Written.load(std::memory_order_acquire);
+		uint64_t First = Written > PROFILER_RING_SIZE ? Written - PROFILER_RING_SIZE : 0;
+
+		for (uint64_t i = First; i < Written; i++)
+		{
+			int64_t Begin = Thread->Events[i % PROFILER_RING_SIZE].Begin;
+			if (Begin < Base)
+				Base = Begin;
+		}
+	}
+
+	if (Base == INT64_MAX)
+		return false;
+
+	FILE* Fp = Open_File(FileName, "w");
+	if (Fp == NULL)
+		return false;
+
+	int64_t Freq = CMonotonicClock::System().Frequency();
+
+	fprintf(Fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+	bool First = true;
+	for (const auto& Thread : g_Threads)
+	{
+		if (Thread->Name != nullptr)
+		{
+			fprintf(Fp, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":",
+				First ? "" : ",\n", Thread->Id);
+			Write_String(Fp, Thread->Name);
+			fprintf(Fp, "}}");
+			First = false;
+		}
+
+		uint64_t Written = Thread->Written.load(std::memory_order_acquire);
+		uint64_t Start = Written > PROFILER_RING_SIZE ? Written - PROFILER_RING_SIZE : 0;
+
+		for (uint64_t i = Start; i < Written; i++)
+		{
+			const ProfileEvent& Event = Thread->Events[i % PROFILER_RING_SIZE];
+
+			double Ts = CMonotonicClock::To_Seconds(Event.Begin - Base, Freq) * 1000000.0;
+			double Dur = CMonotonicClock::To_Seconds(Event.End - Event.Begin, Freq) * 1000000.0;
+
+			fprintf(Fp, "%s{\"name\":", First ? "" : ",\n");
+			Write_String(Fp, Event.Name);
+			fprintf(Fp, ",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", Thread->Id, Ts, Dur);
+			First = false;
+		}
+	}
+
+	fprintf(Fp, "\n]}\n");
+	fclose(Fp);
+
+	return true;
+}
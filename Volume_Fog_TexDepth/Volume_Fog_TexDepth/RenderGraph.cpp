@@ -0,0 +1,337 @@
+//======================================================================================
+//	Ed Kurlyak 2023 Render Graph
+//======================================================================================
+
+#include "RenderGraph.h"
+
+#include <algorithm>
+
+static uint64_t Align_Up(uint64_t Value, uint64_t Alignment)
+{
+	return (Value + Alignment - 1) / Alignment * Alignment;
+}
+
+uint32_t CRenderGraph::Create_Texture(const char* Name, uint64_t Size, uint64_t Alignment)
+{
+	Resource Res;
+	Res.Name = Name;
+	Res.Size = Size;
+	Res.Alignment = Alignment ? Alignment : 1;
+
+	m_Resources.push_back(Res);
+
+	return (uint32_t)m_Resources.size() - 1;
+}
+
+uint32_t CRenderGraph::Import(const char* Name, RGState Final)
+{
+	Resource Res;
+	Res.Name = Name;
+	Res.Imported = true;
+	Res.Final = Final;
+
+	m_Resources.push_back(Res);
+
+	return (uint32_t)m_Resources.size() - 1;
+}
+
+uint32_t CRenderGraph::Add_Pass(const char* Name, std::function<void()> Execute)
+{
+	Pass NewPass;
+	NewPass.Name = Name;
+	NewPass.Execute = std::move(Execute);
+
+	m_Passes.push_back(std::move(NewPass));
+
+	return (uint32_t)m_Passes.size() - 1;
+}
+
+void CRenderGraph::Read(uint32_t Pass, uint32_t Resource, RGState State)
+{
+	Add_Access(Pass, Resource, State, false);
+}
+
+void CRenderGraph::Write(uint32_t Pass, uint32_t Resource, RGState State)
+{
+	Add_Access(Pass, Resource, State, true);
+}
+
+void CRenderGraph::Add_Access(uint32_t Pass, uint32_t Resource, RGState State, bool Write)
+{
+	Access NewAccess;
+	NewAccess.Resource = Resource;
+	NewAccess.State = State;
+	NewAccess.Write = Write;
+
+	m_Passes[Pass].Accesses.push_back(NewAccess);
+}
+
+uint32_t CRenderGraph::Culled_Count() const
+{
+	uint32_t Count = 0;
+
+	for (const Pass& P : m_Passes)
+	{
+		if (P.Culled)
+			Count++;
+	}
+
+	return Count;
+}
+
+bool CRenderGraph::Compile()
+{
+	for (const Pass& P : m_Passes)
+	{
+		for (size_t i = 0; i < P.Accesses.size(); i++)
+		{
+			for (size_t j = i + 1; j < P.Accesses.size(); j++)
+			{
+				if (P.Accesses[i].Resource == P.Accesses[j].Resource &&
+					P.Accesses[i].State != P.Accesses[j].State)
+					return false;
+			}
+		}
+	}
+
+	Cull_Passes();
+	Find_Lifetimes();
+	Place_Transients();
+	Build_Barriers();
+
+	return true;
+}
+
+void CRenderGraph::Cull_Passes()
+{
+	//walks back from the end, a pass stays when it writes an
+	//import or something a later pass that stays reads
+	std::vector<bool> Needed(m_Resources.size(), false);
+
+	for (size_t p = m_Passes.size(); p-- > 0;)
+	{
+		Pass& P = m_Passes[p];
+
+		bool Keep = false;
+		for (const Access& A : P.Accesses)
+		{
+			if (A.Write && (m_Resources[A.Resource].Imported || Needed[A.Resource]))
+				Keep = true;
+		}
+
+		P.Culled = !Keep;
+		if (P.Culled)
+			continue;
+
+		for (const Access& A : P.Accesses)
+		{
+			if (!A.Write)
+				Needed[A.Resource] = true;
+		}
+	}
+}
+
+void CRenderGraph::Find_Lifetimes()
+{
+	for (Resource& Res : m_Resources)
+	{
+		Res.First = RG_INVALID;
+		Res.Last = RG_INVALID;
+		Res.Allocated = false;
+		Res.Aliased = false;
+		Res.Offset = 0;
+	}
+
+	for (uint32_t p = 0; p < (uint32_t)m_Passes.size(); p++)
+	{
+		if (m_Passes[p].Culled)
+			continue;
+
+		for (const Access& A : m_Passes[p].Accesses)
+		{
+			Resource& Res = m_Resources[A.Resource];
+
+			if (Res.First == RG_INVALID)
+				Res.First = p;
+
+			Res.Last = p;
+			Res.LastState = A.State;
+		}
+	}
+
+	for (Resource& Res : m_Resources)
+		Res.Allocated = !Res.Imported && Res.First != RG_INVALID;
+}
+
+void CRenderGraph::Place_Transients()
+{
+	std::vector<uint32_t> Order;
+
+	m_UnaliasedSize = 0;
+	m_HeapAlignment = 1;
+
+	for (uint32_t r = 0; r < (uint32_t)m_Resources.size(); r++)
+	{
+		if (!m_Resources[r].Allocated)
+			continue;
+
+		Order.push_back(r);
+
+		m_HeapAlignment = std::max(m_HeapAlignment, m_Resources[r].Alignment);
+	}
+
+	//largest alignment and then largest size first, less padding
+	//and the small ones fill the gaps
+	std::stable_sort(Order.begin(), Order.end(), [this](uint32_t a, uint32_t b)
+	{
+		if (m_Resources[a].Alignment != m_Resources[b].Alignment)
+			return m_Resources[a].Alignment > m_Resources[b].Alignment;
+
+		return m_Resources[a].Size > m_Resources[b].Size;
+	});
+
+	//the same order back to back, each resource below lands at
+	//or under its offset here, so aliasing never takes more
+	for (uint32_t r : Order)
+		m_UnaliasedSize = Align_Up(m_UnaliasedSize, m_Resources[r].Alignment) + m_Resources[r].Size;
+
+	std::vector<uint32_t> Placed;
+	m_HeapSize = 0;
+
+	for (uint32_t r : Order)
+	{
+		Resource& Res = m_Resources[r];
+
+		//candidate offsets are 0 and the end of every placed
+		//resource alive at the same time, lowest that fits wins
+		std::vector<uint64_t> Candidates(1, 0);
+		for (uint32_t o : Placed)
+		{
+			const Resource& Other = m_Resources[o];
+			if (Other.Last >= Res.First && Other.First <= Res.Last)
+				Candidates.push_back(Other.Offset + Other.Size);
+		}
+
+		std::sort(Candidates.begin(), Candidates.end());
+
+		uint64_t Offset = 0;
+		for (uint64_t Candidate : Candidates)
+		{
+			Offset = Align_Up(Candidate, Res.Alignment);
+
+			bool Fits = true;
+			for (uint32_t o : Placed)
+			{
+				const Resource& Other = m_Resources[o];
+
+				bool Alive = Other.Last >= Res.First && Other.First <= Res.Last;
+				bool Overlap = Offset < Other.Offset + Other.Size && Other.Offset < Offset + Res.Size;
+
+				if (Alive && Overlap)
+				{
+					Fits = false;
+					break;
+				}
+			}
+
+			if (Fits)
+				break;
+		}
+
+		Res.Offset = Offset;
+		Placed.push_back(r);
+
+		m_HeapSize = std::max(m_HeapSize, Offset + Res.Size);
+	}
+
+	//memory shared with any other transient needs an aliasing
+	//barrier on first use every frame
+	for (uint32_t r : Placed)
+	{
+		for (uint32_t o : Placed)
+		{
+			const Resource& Res = m_Resources[r];
+			const Resource& Other = m_Resources[o];
+
+			if (o != r && Res.Offset < Other.Offset + Other.Size && Other.Offset < Res.Offset + Res.Size)
+				m_Resources[r].Aliased = true;
+		}
+	}
+}
+
+void CRenderGraph::Build_Barriers()
+{
+	std::vector<RGState> Current(m_Resources.size());
+
+	for (uint32_t r = 0; r < (uint32_t)m_Resources.size(); r++)
+		Current[r] = m_Resources[r].Imported ? RG_STATE_UNKNOWN : m_Resources[r].LastState;
+
+	for (uint32_t p = 0; p < (uint32_t)m_Passes.size(); p++)
+	{
+		Pass& P = m_Passes[p];
+		P.Barriers.clear();
+
+		if (P.Culled)
+			continue;
+
+		for (const Access& A : P.Accesses)
+		{
+			const Resource& Res = m_Resources[A.Resource];
+
+			//one access per resource makes the barriers
+			bool Seen = false;
+			for (const RGBarrier& B : P.Barriers)
+			{
+				if (B.Resource == A.Resource)
+					Seen = true;
+			}
+			if (Seen || (Current[A.Resource] == A.State && !(Res.Aliased && Res.First == p)))
+				continue;
+
+			if (Res.Aliased && Res.First == p)
+			{
+				RGBarrier Barrier = { A.Resource, true, Current[A.Resource], Current[A.Resource] };
+				P.Barriers.push_back(Barrier);
+			}
+
+			if (Current[A.Resource] != A.State)
+			{
+				RGBarrier Barrier = { A.Resource, false, Current[A.Resource], A.State };
+				P.Barriers.push_back(Barrier);
+			}
+
+			Current[A.Resource] = A.State;
+		}
+	}
+
+	m_FinalBarriers.clear();
+
+	for (uint32_t r = 0; r < (uint32_t)m_Resources.size(); r++)
+	{
+		const Resource& Res = m_Resources[r];
+
+		if (Res.Imported && Current[r] != Res.Final)
+		{
+			RGBarrier Barrier = { r, false, Current[r], Res.Final };
+			m_FinalBarriers.push_back(Barrier);
+		}
+	}
+}
+
+void CRenderGraph::Execute(const std::function<void(const RGBarrier* Barriers, uint32_t Count)>& Barriers) const
+{
+	for (const Pass& P : m_Passes)
+	{
+		if (P.Culled)
+			continue;
+
+		if (!P.Barriers.empty())
+			Barriers(P.Barriers.data(), (uint32_t)P.Barriers.size());
+
+		if (P.Execute)
+			P.Execute();
+	}
+
+	if (!m_FinalBarriers.empty())
+		Barriers(m_FinalBarriers.data(), (uint32_t)m_FinalBarriers.size());
+}